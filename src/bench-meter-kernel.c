@@ -0,0 +1,108 @@
+/*
+ * bench-meter-kernel.c - Benchmark of the level meter sample kernels.
+ * Copyright (c) 2016 Martin Roesch <martin.roesch79@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sm-meter-kernel.h"
+
+#define BENCH_FRAMES (1024) ///< Frames per scan, about the period of the meter.
+#define BENCH_DURATION (G_USEC_PER_SEC / 2) ///< Minimal duration of a measurement in microseconds.
+
+/**
+ * @brief Function scanning the benchmark buffer once.
+ */
+typedef void (*BenchScanFunc)(gconstpointer frames, guint channels, SmMeterAccu *accu);
+
+static void
+bench_scan_reference(gconstpointer frames, guint channels, SmMeterAccu *accu)
+{
+    sm_meter_kernel_scan_s32_reference(frames, channels, BENCH_FRAMES, accu);
+}
+
+static void
+bench_scan_s32(gconstpointer frames, guint channels, SmMeterAccu *accu)
+{
+    sm_meter_kernel_scan_s32(frames, channels, BENCH_FRAMES, accu);
+}
+
+static void
+bench_scan_s24_3le(gconstpointer frames, guint channels, SmMeterAccu *accu)
+{
+    sm_meter_kernel_scan_s24_3le(frames, channels, BENCH_FRAMES, accu);
+}
+
+static void
+bench_scan_s16(gconstpointer frames, guint channels, SmMeterAccu *accu)
+{
+    sm_meter_kernel_scan_s16(frames, channels, BENCH_FRAMES, accu);
+}
+
+/*
+ * Repeat the scan until the duration is reached and print the frame rate.
+ */
+static void
+bench_run(const gchar *name, BenchScanFunc scan, gconstpointer frames, guint channels)
+{
+    SmMeterAccu accu[SM_METER_KERNEL_MAX_CHANNELS];
+    gint64 start, elapsed;
+    guint64 scans;
+
+    memset(accu, 0, sizeof(accu));
+    scans = 0;
+    start = g_get_monotonic_time();
+    do
+    {
+        scan(frames, channels, accu);
+        scans++;
+        elapsed = g_get_monotonic_time() - start;
+    } while (elapsed < BENCH_DURATION);
+    printf("%-12s %10.2f Mframes/s %8.1f ns/scan\n", name,
+            (gdouble)(scans * BENCH_FRAMES) / elapsed,
+            (gdouble)elapsed * 1000.0 / scans);
+}
+
+int
+main(int argc, char **argv)
+{
+    guint8 *frames;
+    guint channels;
+    gsize idx;
+
+    channels = argc > 1 ? (guint)atoi(argv[1]) : 20;
+    if (channels < 1 || channels > SM_METER_KERNEL_MAX_CHANNELS)
+    {
+        fprintf(stderr, "Usage: %s [channels (1-%d)]\n", argv[0], SM_METER_KERNEL_MAX_CHANNELS);
+        return EXIT_FAILURE;
+    }
+    // Large enough for every format, filled with noise.
+    frames = g_malloc(BENCH_FRAMES * channels * sizeof(gint32));
+    for (idx = 0; idx < BENCH_FRAMES * channels * sizeof(gint32); idx++)
+    {
+        frames[idx] = (guint8)g_random_int();
+    }
+    printf("Kernel: %s, channels: %u, frames per scan: %d\n",
+            sm_meter_kernel_get_name(), channels, BENCH_FRAMES);
+    bench_run("reference", bench_scan_reference, frames, channels);
+    bench_run("s32", bench_scan_s32, frames, channels);
+    bench_run("s24_3le", bench_scan_s24_3le, frames, channels);
+    bench_run("s16", bench_scan_s16, frames, channels);
+    g_free(frames);
+    return EXIT_SUCCESS;
+}
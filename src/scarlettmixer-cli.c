@@ -0,0 +1,410 @@
+/*
+ * scarlettmixer-cli - Command line client for scarlett audio interfaces.
+ * Copyright (c) 2016 Martin Roesch <martin.roesch79@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <json-glib/json-glib.h>
+
+#include "config.h"
+#include "sm-app.h"
+#include "sm-controls.h"
+
+/**
+ * @brief Structure holding the state of the command line client.
+ */
+typedef struct
+{
+    SmApp *app; ///< The application object with the open mixer.
+    GHashTable *state; ///< Current value of every control.
+    gboolean written; ///< Indicates if a control was written.
+} SmCli;
+
+static gint card_number = -1; ///< Card number given on the command line, or -1.
+static gboolean read_stdin = FALSE; ///< Indicates if commands are read from standard input.
+
+static GOptionEntry cli_options[] =
+{
+    { "card", 'c', 0, G_OPTION_ARG_INT, &card_number, "Number of the sound card (default: the first " SM_APP_CARD_PREFIX " interface)", "N" },
+    { "stdin", 0, 0, G_OPTION_ARG_NONE, &read_stdin, "Read commands from standard input, one per line", NULL },
+    { NULL }
+};
+
+static void
+sm_cli_load_state(SmCli *cli)
+{
+    GVariant *state, *value;
+    GVariantIter iter;
+    gchar *name;
+
+    g_hash_table_remove_all(cli->state);
+    state = g_variant_ref_sink(sm_controls_get_state(cli->app));
+    g_variant_iter_init(&iter, state);
+    while (g_variant_iter_next(&iter, "{sv}", &name, &value))
+    {
+        g_hash_table_replace(cli->state, name, value);
+    }
+    g_variant_unref(state);
+}
+
+static GVariant*
+sm_cli_lookup(SmCli *cli, const gchar *name, GError **err)
+{
+    GVariant *value;
+
+    value = g_hash_table_lookup(cli->state, name);
+    if (!value)
+    {
+        g_set_error(err, SM_CONTROLS_ERROR, SM_CONTROLS_ERROR_NOT_FOUND,
+                "No control %s.", name);
+    }
+    return value;
+}
+
+static gchar*
+sm_cli_format_value(GVariant *value)
+{
+    gchar buf[G_ASCII_DTOSTR_BUF_SIZE];
+
+    if (g_variant_is_of_type(value, G_VARIANT_TYPE_DOUBLE))
+    {
+        return g_strdup(g_ascii_formatd(buf, sizeof(buf), "%.2f", g_variant_get_double(value)));
+    }
+    if (g_variant_is_of_type(value, G_VARIANT_TYPE_BOOLEAN))
+    {
+        return g_strdup(g_variant_get_boolean(value) ? "true" : "false");
+    }
+    return g_variant_dup_string(value, NULL);
+}
+
+/*
+ * Parse the text of a value by the type of the current value of the control.
+ */
+static GVariant*
+sm_cli_parse_value(const gchar *name, const gchar *text, GVariant *current, GError **err)
+{
+    gdouble vol_db;
+    gchar *end;
+
+    if (g_variant_is_of_type(current, G_VARIANT_TYPE_DOUBLE))
+    {
+        vol_db = g_ascii_strtod(text, &end);
+        if (end != text && *end == '\0')
+        {
+            return g_variant_new_double(vol_db);
+        }
+    }
+    else if (g_variant_is_of_type(current, G_VARIANT_TYPE_BOOLEAN))
+    {
+        if (g_strcmp0(text, "true") == 0 || g_strcmp0(text, "on") == 0 || g_strcmp0(text, "1") == 0)
+        {
+            return g_variant_new_boolean(TRUE);
+        }
+        if (g_strcmp0(text, "false") == 0 || g_strcmp0(text, "off") == 0 || g_strcmp0(text, "0") == 0)
+        {
+            return g_variant_new_boolean(FALSE);
+        }
+    }
+    else
+    {
+        return g_variant_new_string(text);
+    }
+    g_set_error(err, SM_CONTROLS_ERROR, SM_CONTROLS_ERROR_INVALID_VALUE,
+            "Invalid value \"%s\" of %s.", text, name);
+    return NULL;
+}
+
+static gboolean
+sm_cli_dump(SmCli *cli, GError **err)
+{
+    JsonGenerator *generator;
+    JsonNode *root;
+    GVariant *state;
+    gchar *data;
+
+    state = g_variant_ref_sink(sm_controls_get_state(cli->app));
+    root = json_gvariant_serialize(state);
+    g_variant_unref(state);
+    generator = json_generator_new();
+    json_generator_set_pretty(generator, TRUE);
+    json_generator_set_root(generator, root);
+    data = json_generator_to_data(generator, NULL);
+    g_print("%s\n", data);
+    g_free(data);
+    json_node_unref(root);
+    g_object_unref(generator);
+    return TRUE;
+}
+
+static gboolean
+sm_cli_get(SmCli *cli, gchar **names, GError **err)
+{
+    GVariant *value;
+    gchar *text;
+    guint idx;
+
+    for (idx = 0; names[idx]; idx++)
+    {
+        value = sm_cli_lookup(cli, names[idx], err);
+        if (!value)
+        {
+            return FALSE;
+        }
+        text = sm_cli_format_value(value);
+        g_print("%s=%s\n", names[idx], text);
+        g_free(text);
+    }
+    return TRUE;
+}
+
+/*
+ * Set the controls of NAME=VALUE assignments as one transaction. Controls
+ * which already have the value are not written. Afterwards the values are
+ * read back from the mixer objects, as written (rounded to the volume steps)
+ * or as left by a failed transaction.
+ */
+static gboolean
+sm_cli_set(SmCli *cli, gchar **assignments, GError **err)
+{
+    GVariantBuilder builder;
+    GVariant *controls, *current, *value;
+    gchar *sep, *control;
+    guint idx;
+    gboolean ret;
+
+    g_variant_builder_init(&builder, G_VARIANT_TYPE_VARDICT);
+    for (idx = 0; assignments[idx]; idx++)
+    {
+        sep = strchr(assignments[idx], '=');
+        if (!sep)
+        {
+            g_set_error(err, SM_CONTROLS_ERROR, SM_CONTROLS_ERROR_INVALID_VALUE,
+                    "Expected NAME=VALUE, not \"%s\".", assignments[idx]);
+            g_variant_builder_clear(&builder);
+            return FALSE;
+        }
+        control = g_strndup(assignments[idx], sep - assignments[idx]);
+        current = sm_cli_lookup(cli, control, err);
+        value = current ? sm_cli_parse_value(control, sep + 1, current, err) : NULL;
+        if (!value)
+        {
+            g_free(control);
+            g_variant_builder_clear(&builder);
+            return FALSE;
+        }
+        g_variant_ref_sink(value);
+        if (!g_variant_equal(value, current))
+        {
+            g_variant_builder_add(&builder, "{sv}", control, value);
+        }
+        g_variant_unref(value);
+        g_free(control);
+    }
+    controls = g_variant_ref_sink(g_variant_builder_end(&builder));
+    if (g_variant_n_children(controls) == 0)
+    {
+        g_variant_unref(controls);
+        return TRUE;
+    }
+    ret = sm_controls_set(cli->app, controls, err);
+    cli->written = TRUE;
+    sm_cli_load_state(cli);
+    g_variant_unref(controls);
+    return ret;
+}
+
+static gboolean
+sm_cli_apply(SmCli *cli, const gchar *filename, GError **err)
+{
+    gboolean ret;
+
+    // The configuration is compared with the mixer, only differences are written.
+    ret = sm_app_read_config_file(cli->app, filename, err);
+    cli->written = TRUE;
+    sm_cli_load_state(cli);
+    return ret;
+}
+
+static gboolean
+sm_cli_topology(SmCli *cli, const gchar *filename, GError **err)
+{
+    return sm_app_write_topology(cli->app, filename, err);
+}
+
+/*
+ * Run a command, args holds the command and its arguments.
+ */
+static gboolean
+sm_cli_run(SmCli *cli, gchar **args, GError **err)
+{
+    guint n_args;
+
+    n_args = g_strv_length(args);
+    if (n_args == 1 && g_strcmp0(args[0], "dump") == 0)
+    {
+        return sm_cli_dump(cli, err);
+    }
+    if (n_args >= 2 && g_strcmp0(args[0], "get") == 0)
+    {
+        return sm_cli_get(cli, args + 1, err);
+    }
+    if (n_args >= 2 && g_strcmp0(args[0], "set") == 0)
+    {
+        return sm_cli_set(cli, args + 1, err);
+    }
+    if (n_args == 2 && g_strcmp0(args[0], "apply") == 0)
+    {
+        return sm_cli_apply(cli, args[1], err);
+    }
+    if (n_args == 2 && g_strcmp0(args[0], "topology") == 0)
+    {
+        return sm_cli_topology(cli, args[1], err);
+    }
+    g_set_error(err, G_OPTION_ERROR, G_OPTION_ERROR_FAILED,
+            "Unknown command \"%s\".", n_args > 0 ? args[0] : "");
+    return FALSE;
+}
+
+/*
+ * Run the commands read from standard input. Control names contain spaces,
+ * so a line holds a command and a single argument.
+ */
+static gboolean
+sm_cli_run_stdin(SmCli *cli)
+{
+    GIOChannel *gioch;
+    gchar *line, *args[3];
+    gsize terminator;
+    guint line_number;
+    gboolean ret;
+    GError *err = NULL;
+
+    ret = TRUE;
+    line_number = 0;
+    gioch = g_io_channel_unix_new(STDIN_FILENO);
+    while (g_io_channel_read_line(gioch, &line, NULL, &terminator, &err) == G_IO_STATUS_NORMAL)
+    {
+        line_number++;
+        line[terminator] = '\0';
+        g_strstrip(line);
+        if (line[0] == '\0' || line[0] == '#')
+        {
+            g_free(line);
+            continue;
+        }
+        // Follow the changes made by others since the last command.
+        if (sm_app_handle_mixer_events(cli->app) > 0)
+        {
+            sm_cli_load_state(cli);
+        }
+        args[0] = line;
+        args[1] = strchr(line, ' ');
+        args[2] = NULL;
+        if (args[1])
+        {
+            *args[1]++ = '\0';
+            g_strchug(args[1]);
+        }
+        if (!sm_cli_run(cli, args, &err))
+        {
+            g_printerr("Line %u: %s\n", line_number, err->message);
+            g_clear_error(&err);
+            ret = FALSE;
+        }
+        g_free(line);
+    }
+    if (err)
+    {
+        g_printerr("Could not read standard input: %s\n", err->message);
+        g_error_free(err);
+        ret = FALSE;
+    }
+    g_io_channel_unref(gioch);
+    return ret;
+}
+
+int main(int argc, char *argv[]) {
+    GOptionContext *context;
+    SmCli cli = { 0 };
+    GError *err = NULL;
+    gint status;
+    gboolean ret;
+
+    context = g_option_context_new("[dump | get NAME... | set NAME=VALUE... | apply FILE | topology FILE]");
+    g_option_context_set_summary(context,
+            "Read and write the controls of the mixer without a window.\n"
+            "Control names are the names of the D-Bus interface, e.g. \"Master 1/left/volume\".");
+    g_option_context_add_main_entries(context, cli_options, NULL);
+    if (!g_option_context_parse(context, &argc, &argv, &err) || (argc < 2 && !read_stdin))
+    {
+        if (err)
+        {
+            g_printerr("%s\n", err->message);
+            g_error_free(err);
+        }
+        g_printerr("%s", g_option_context_get_help(context, TRUE, NULL));
+        g_option_context_free(context);
+        return 2;
+    }
+    g_option_context_free(context);
+
+    cli.app = sm_app_new();
+    if (card_number < 0)
+    {
+        card_number = sm_app_find_card(SM_APP_CARD_PREFIX);
+        if (card_number < 0)
+        {
+            g_printerr("No %s audio interface found.\n", SM_APP_CARD_PREFIX);
+            g_object_unref(cli.app);
+            return 1;
+        }
+    }
+    if (!sm_app_open_mixer(cli.app, card_number))
+    {
+        g_object_unref(cli.app);
+        return 1;
+    }
+    cli.state = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+            (GDestroyNotify)g_variant_unref);
+    sm_cli_load_state(&cli);
+
+    if (read_stdin)
+    {
+        ret = sm_cli_run_stdin(&cli);
+    }
+    else
+    {
+        ret = sm_cli_run(&cli, argv + 1, &err);
+        if (!ret)
+        {
+            g_printerr("%s\n", err->message);
+            g_error_free(err);
+        }
+    }
+    status = ret ? 0 : 1;
+    if (cli.written && !sm_app_write_snapshot(cli.app, &err))
+    {
+        // Keep the snapshot current, so the next window starts with the written values.
+        g_warning("Could not write snapshot: %s", err->message);
+        g_error_free(err);
+    }
+    sm_app_close_mixer(cli.app);
+    g_hash_table_unref(cli.state);
+    g_object_unref(cli.app);
+    return status;
+}
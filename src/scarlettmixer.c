@@ -18,11 +18,13 @@
 
 #include "config.h"
 #include "sm-app.h"
+#include "sm-timing.h"
 
 int main(int argc, char *argv[]) {
     SmApp *app;
     int status;
 
+    sm_timing_init();
 #if DEBUG
   /* Use local GSettings schema directory.
    * configure with --enable-debug switch to enable this section.
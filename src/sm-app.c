@@ -16,7 +16,10 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <signal.h>
+#include <string.h>
 #include <gtk/gtk.h>
+#include <glib-unix.h>
 #include <alsa/asoundlib.h>
 #include <json-glib/json-glib.h>
 #define G_SETTINGS_ENABLE_BACKEND
@@ -26,9 +29,18 @@
 #include "sm-app.h"
 #include "sm-appwin.h"
 #include "sm-channel.h"
+#include "sm-dbus.h"
+#include "sm-fake-card.h"
+#include "sm-http.h"
+#include "sm-metrics.h"
+#include "sm-midi.h"
+#include "sm-osc.h"
+#include "sm-shm.h"
 #include "sm-prefs.h"
 #include "sm-source.h"
 #include "sm-switch.h"
+#include "sm-timing.h"
+#include "sm-trace.h"
 
 /**
  * @brief Structure representing the application class.
@@ -48,19 +60,74 @@ struct _SmApp
     GSettings *settings; ///< GLib GSettings object.
     snd_hctl_t *hctl; ///< ALSA control handle (initialized by @ref sm_app_open_mixer()).
     snd_ctl_card_info_t *card_info; ///< ALSA card info (initialized by @ref sm_app_open_mixer()).
-    const char *card_name; ///< ALSA card name (initialized by @ref sm_app_open_mixer()).
+    gchar *card_name; ///< ALSA card name (initialized by @ref sm_app_open_mixer() or @ref sm_app_read_snapshot()).
     snd_mixer_t *mixer; ///< ALSA mixer (initialized by @ref sm_app_open_mixer()).
+    GArray *mixer_watches; ///< Source IDs of the watches of the mixer poll descriptors.
     GList *channels; ///< List of @ref _SmChannel mixer channels (initialized by @ref sm_app_open_mixer()).
     GList *input_sources; ///< List of @ref _SmSource mixer input sources (initialized by @ref sm_app_open_mixer()).
     GList *input_switches; ///< List of @ref _SmSwitch mixer input switches (initialized by @ref sm_app_open_mixer()).
     SmSwitch *clock_source; ///< Clock source @ref _SmSwitch (initialized by @ref sm_app_open_mixer()).
     SmSwitch *sync_status; ///< Sync status @ref _SmSwitch (initialized by @ref sm_app_open_mixer()).
     SmSwitch *usb_sync; ///< USB sync @ref _SmSwitch (initialized by @ref sm_app_open_mixer()).
+    gboolean snapshot; ///< Indicates if the mixer objects are read from the snapshot and not yet attached to the mixer.
+    gboolean snapshot_adopted; ///< Indicates if the mixer objects read from the snapshot were reconciled with the mixer.
+    gboolean mixer_lost; ///< Indicates if the poll descriptors of the mixer reported an error (e.g. the interface was unplugged).
+    GMainLoop *loop; ///< Main loop of the headless daemon (initialized by @ref sm_app_restore()).
+    gchar *restore_filename; ///< Configuration file applied by the headless daemon (initialized by @ref sm_app_restore()).
+    gchar *config_filename; ///< Configuration file last read or written, or NULL.
+    gboolean held; ///< Indicates if the application is held to keep running without a window.
+    SmDBusService *dbus; ///< D-Bus control interface (initialized by the dbus_register vfunc).
+    SmOscServer *osc; ///< OSC server, or NULL if disabled in the preferences.
+    SmHttpServer *http; ///< HTTP and WebSocket server, or NULL if disabled in the preferences.
+    SmMidiClient *midi; ///< MIDI control surface client, or NULL if disabled in the preferences.
+    SmShmExport *shm; ///< Shared memory state export, or NULL if disabled in the preferences.
+    gchar *metrics_filename; ///< File the metrics are written to, or NULL.
+    guint metrics_id; ///< Source ID writing the metrics file, or 0.
 };
 
+/**
+ * @brief Type definition for the mixer objects of a sound card.
+ */
+typedef struct _SmAppModel SmAppModel;
+
+/**
+ * @brief Structure holding the mixer objects of a sound card.
+ * Used to keep the snapshot objects aside while the mixer is opened.
+ */
+struct _SmAppModel
+{
+    gchar *card_name; ///< Card name.
+    GList *channels; ///< List of @ref _SmChannel mixer channels.
+    GList *input_sources; ///< List of @ref _SmSource mixer input sources.
+    GList *input_switches; ///< List of @ref _SmSwitch mixer input switches.
+    SmSwitch *clock_source; ///< Clock source @ref _SmSwitch.
+    SmSwitch *sync_status; ///< Sync status @ref _SmSwitch.
+    SmSwitch *usb_sync; ///< USB sync @ref _SmSwitch.
+};
+
+/**
+ * @brief Function to reconcile a snapshot object with a live object.
+ */
+typedef gboolean (*SmAppReconcileFunc)(gpointer self, gpointer live);
+
+/**
+ * @brief Enumeration of the application signals.
+ */
+enum
+{
+    SM_APP_SIGNAL_MODEL_CHANGED, ///< Mixer objects replaced signal.
+    SM_APP_SIGNAL_MIXER_LOST, ///< Mixer connection lost signal.
+    N_SIGNALS ///< Number of signals.
+};
+
+static int sm_app_signals[N_SIGNALS] = {0};
+
 G_DEFINE_TYPE(SmApp, sm_app, GTK_TYPE_APPLICATION);
 
-static const gchar *prefix = "Scarlett";
+static const gchar *prefix = SM_APP_CARD_PREFIX;
+
+#define SM_APP_SNAPSHOT_VERSION (1)
+#define SM_APP_METRICS_INTERVAL (15) ///< Interval of writing the metrics file in seconds.
 
 #define SM_CONFIG_ERROR sm_config_error_quark()
 GQuark
@@ -75,6 +142,66 @@ enum SmConfigError
     SM_CONFIG_ERROR_COMPATIBLE
 };
 
+static void
+sm_app_take_model(SmApp *app, SmAppModel *model)
+{
+    model->card_name = app->card_name;
+    model->channels = app->channels;
+    model->input_sources = app->input_sources;
+    model->input_switches = app->input_switches;
+    model->clock_source = app->clock_source;
+    model->sync_status = app->sync_status;
+    model->usb_sync = app->usb_sync;
+    app->card_name = NULL;
+    app->channels = NULL;
+    app->input_sources = NULL;
+    app->input_switches = NULL;
+    app->clock_source = NULL;
+    app->sync_status = NULL;
+    app->usb_sync = NULL;
+}
+
+static void
+sm_app_set_model(SmApp *app, SmAppModel *model)
+{
+    app->card_name = model->card_name;
+    app->channels = model->channels;
+    app->input_sources = model->input_sources;
+    app->input_switches = model->input_switches;
+    app->clock_source = model->clock_source;
+    app->sync_status = model->sync_status;
+    app->usb_sync = model->usb_sync;
+    memset(model, 0, sizeof(SmAppModel));
+}
+
+static void
+sm_app_model_clear(SmAppModel *model)
+{
+    g_free(model->card_name);
+    g_list_free_full(model->channels, g_object_unref);
+    g_list_free_full(model->input_sources, g_object_unref);
+    g_list_free_full(model->input_switches, g_object_unref);
+    if (model->clock_source)
+    {
+        g_object_unref(model->clock_source);
+    }
+    if (model->sync_status)
+    {
+        g_object_unref(model->sync_status);
+    }
+    if (model->usb_sync)
+    {
+        g_object_unref(model->usb_sync);
+    }
+    memset(model, 0, sizeof(SmAppModel));
+}
+
+static gchar*
+sm_app_get_snapshot_filename()
+{
+    return g_build_filename(g_get_user_cache_dir(), PACKAGE, "snapshot.json", NULL);
+}
+
 static void
 sm_app_open_activated(GSimpleAction *action,
         GVariant *parameter,
@@ -86,7 +213,7 @@ sm_app_open_activated(GSimpleAction *action,
     g_debug("sm_app_open_activated.");
     sm_app = SM_APP(app);
     // Only run if interface is present
-    if (sm_app->card_name == NULL)
+    if (sm_app->card_name == NULL || sm_app->snapshot)
     {
         return;
     }
@@ -106,7 +233,7 @@ sm_app_save_activated(GSimpleAction *action,
     g_debug("sm_app_save_activated.");
     sm_app = SM_APP(app);
     // Only run if interface is present
-    if (sm_app->card_name == NULL)
+    if (sm_app->card_name == NULL || sm_app->snapshot)
     {
         return;
     }
@@ -126,7 +253,7 @@ sm_app_saveas_activated(GSimpleAction *action,
     g_debug("sm_app_saveas_activated.");
     sm_app = SM_APP(app);
     // Only run if interface is present
-    if (sm_app->card_name == NULL)
+    if (sm_app->card_name == NULL || sm_app->snapshot)
     {
         return;
     }
@@ -185,6 +312,36 @@ sm_app_quit_activated(GSimpleAction *action,
   g_application_quit(G_APPLICATION(app));
 }
 
+static void
+sm_app_midi_learn_activated(GSimpleAction *action,
+        GVariant *parameter,
+        gpointer app)
+{
+    SmApp *sm_app;
+
+    g_debug("sm_app_midi_learn_activated.");
+    sm_app = SM_APP(app);
+    if (sm_app->midi)
+    {
+        sm_midi_client_learn(sm_app->midi, g_variant_get_string(parameter, NULL));
+    }
+}
+
+static void
+sm_app_midi_forget_activated(GSimpleAction *action,
+        GVariant *parameter,
+        gpointer app)
+{
+    SmApp *sm_app;
+
+    g_debug("sm_app_midi_forget_activated.");
+    sm_app = SM_APP(app);
+    if (sm_app->midi)
+    {
+        sm_midi_client_forget(sm_app->midi, g_variant_get_string(parameter, NULL));
+    }
+}
+
 static GActionEntry app_actions[] =
 {
     { "open", sm_app_open_activated, NULL, NULL, NULL },
@@ -192,9 +349,104 @@ static GActionEntry app_actions[] =
     { "saveas", sm_app_saveas_activated, NULL, NULL, NULL },
     { "preferences", sm_app_preferences_activated, NULL, NULL, NULL },
     { "about", sm_app_about_activated, NULL, NULL, NULL },
+    { "midi-learn", sm_app_midi_learn_activated, "s", NULL, NULL },
+    { "midi-forget", sm_app_midi_forget_activated, "s", NULL, NULL },
     { "quit", sm_app_quit_activated, NULL, NULL, NULL }
 };
 
+static GOptionEntry app_options[] =
+{
+    { "timing", 0, 0, G_OPTION_ARG_NONE, NULL, "Print the startup timing report", NULL },
+    { "restore", 0, 0, G_OPTION_ARG_NONE, NULL, "Apply the configuration file to the audio interface without opening a window", NULL },
+    { "daemon", 0, 0, G_OPTION_ARG_NONE, NULL, "Like --restore, but keep running until SIGINT or SIGTERM", NULL },
+    { "config", 0, 0, G_OPTION_ARG_FILENAME, NULL, "Configuration file to apply instead of the one set in the preferences", "FILE" },
+    { "record-trace", 0, 0, G_OPTION_ARG_FILENAME, NULL, "Record the mixer events and writes to a trace file", "FILE" },
+    { "replay-trace", 0, 0, G_OPTION_ARG_FILENAME, NULL, "Replay a trace file against the fake card without opening a window", "FILE" },
+    { "replay-fast", 0, 0, G_OPTION_ARG_NONE, NULL, "Replay the trace as fast as possible instead of in real time", NULL },
+    { NULL }
+};
+
+static gboolean
+sm_app_start_trace(const gchar *filename)
+{
+    GError *err = NULL;
+
+    if (!sm_trace_start(filename, &err))
+    {
+        g_printerr("%s\n", err->message);
+        g_error_free(err);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static gint
+sm_app_handle_local_options(GApplication *app,
+        GVariantDict *options)
+{
+    gchar *filename = NULL;
+    gchar *trace = NULL;
+    gint status;
+    GError *err = NULL;
+
+    if (g_variant_dict_contains(options, "timing"))
+    {
+        sm_timing_set_report_enabled(TRUE);
+    }
+    g_variant_dict_lookup(options, "record-trace", "^ay", &trace);
+    if (g_variant_dict_lookup(options, "replay-trace", "^ay", &filename))
+    {
+        status = 1;
+        if (!trace || sm_app_start_trace(trace))
+        {
+            status = sm_app_replay(SM_APP(app), filename,
+                    g_variant_dict_contains(options, "replay-fast"));
+        }
+        g_free(filename);
+        g_free(trace);
+        sm_trace_stop();
+        return status;
+    }
+    if (g_variant_dict_contains(options, "restore")
+            || g_variant_dict_contains(options, "daemon"))
+    {
+        // Headless mode: The GtkApplication is never registered or started up.
+        status = 1;
+        if (!trace || sm_app_start_trace(trace))
+        {
+            g_variant_dict_lookup(options, "config", "^ay", &filename);
+            status = sm_app_restore(SM_APP(app), filename,
+                    g_variant_dict_contains(options, "daemon"));
+        }
+        g_free(filename);
+        g_free(trace);
+        sm_trace_stop();
+        return status;
+    }
+    if (trace)
+    {
+        // Only the primary instance talks to the mixer, a remote one would record nothing.
+        if (!g_application_register(app, NULL, &err))
+        {
+            g_printerr("%s\n", err->message);
+            g_error_free(err);
+            g_free(trace);
+            return 1;
+        }
+        if (g_application_get_is_remote(app))
+        {
+            g_printerr("Cannot record a trace, %s is already running.\n", PACKAGE_NAME);
+            g_free(trace);
+            return 1;
+        }
+        status = sm_app_start_trace(trace) ? -1 : 1;
+        g_free(trace);
+        return status;
+    }
+    // Continue with the default command line processing
+    return -1;
+}
+
 static void
 sm_app_activate(GApplication *app)
 {
@@ -216,11 +468,268 @@ sm_app_activate(GApplication *app)
 }
 
 static void
-sm_app_startup(GApplication *app)
+sm_app_init_settings(SmApp *app)
 {
-    SmApp *sm_app;
     gchar *path;
     GSettingsBackend *gs_backend;
+
+    //Setup keyfile backend for GSettings in XDG_CONFIG_HOME
+    path = g_build_filename(g_get_user_config_dir(), PACKAGE, "config", NULL);
+    gs_backend = g_keyfile_settings_backend_new(path, "/org/alsa/scarlettmixer/", "Preferences");
+    app->settings = g_settings_new_with_backend("org.alsa.scarlettmixer", gs_backend);
+    g_object_unref(gs_backend);
+    g_free(path);
+}
+
+/*
+ * Without a hold the application quits when its last window is closed. With
+ * the hold the window is destroyed, but the mixer objects stay attached and
+ * follow the mixer, so activating the application again only rebuilds the
+ * window.
+ */
+static void
+sm_app_update_hold(SmApp *app)
+{
+    gboolean background;
+
+    background = g_settings_get_boolean(app->settings, "run-in-background");
+    if (background && !app->held)
+    {
+        g_application_hold(G_APPLICATION(app));
+    }
+    else if (!background && app->held)
+    {
+        g_application_release(G_APPLICATION(app));
+    }
+    app->held = background;
+}
+
+static void
+sm_app_background_changed_cb(GSettings *settings, gchar *key, gpointer user_data)
+{
+    sm_app_update_hold(SM_APP(user_data));
+}
+
+static void
+sm_app_update_osc(SmApp *app)
+{
+    gchar *address;
+    guint16 port;
+    GError *err = NULL;
+
+    g_clear_object(&app->osc);
+    if (!g_settings_get_boolean(app->settings, "osc-enabled"))
+    {
+        return;
+    }
+    address = g_settings_get_string(app->settings, "osc-address");
+    g_settings_get(app->settings, "osc-port", "q", &port);
+    app->osc = sm_osc_server_new(app);
+    if (!sm_osc_server_start(app->osc, address, port, &err))
+    {
+        g_warning("Could not start OSC server: %s", err->message);
+        g_error_free(err);
+        g_clear_object(&app->osc);
+    }
+    g_free(address);
+}
+
+static void
+sm_app_osc_changed_cb(GSettings *settings, gchar *key, gpointer user_data)
+{
+    sm_app_update_osc(SM_APP(user_data));
+}
+
+static void
+sm_app_update_http(SmApp *app)
+{
+    guint16 port;
+    GError *err = NULL;
+
+    g_clear_object(&app->http);
+    if (!g_settings_get_boolean(app->settings, "http-enabled"))
+    {
+        return;
+    }
+    g_settings_get(app->settings, "http-port", "q", &port);
+    app->http = sm_http_server_new(app);
+    if (!sm_http_server_start(app->http, port, &err))
+    {
+        g_warning("Could not start HTTP server: %s", err->message);
+        g_error_free(err);
+        g_clear_object(&app->http);
+    }
+}
+
+static void
+sm_app_http_changed_cb(GSettings *settings, gchar *key, gpointer user_data)
+{
+    sm_app_update_http(SM_APP(user_data));
+}
+
+static void
+sm_app_update_midi(SmApp *app)
+{
+    GAction *action;
+    GError *err = NULL;
+
+    g_clear_object(&app->midi);
+    if (g_settings_get_boolean(app->settings, "midi-enabled"))
+    {
+        app->midi = sm_midi_client_new(app);
+        if (!sm_midi_client_open(app->midi, &err))
+        {
+            g_warning("Could not start MIDI client: %s", err->message);
+            g_error_free(err);
+            g_clear_object(&app->midi);
+        }
+    }
+    action = g_action_map_lookup_action(G_ACTION_MAP(app), "midi-learn");
+    g_simple_action_set_enabled(G_SIMPLE_ACTION(action), app->midi != NULL);
+    action = g_action_map_lookup_action(G_ACTION_MAP(app), "midi-forget");
+    g_simple_action_set_enabled(G_SIMPLE_ACTION(action), app->midi != NULL);
+}
+
+static void
+sm_app_midi_changed_cb(GSettings *settings, gchar *key, gpointer user_data)
+{
+    sm_app_update_midi(SM_APP(user_data));
+}
+
+static gboolean
+sm_app_write_metrics_cb(gpointer user_data)
+{
+    SmApp *app = SM_APP(user_data);
+    GError *err = NULL;
+
+    if (!sm_metrics_write_file(app->metrics_filename, &err))
+    {
+        g_warning("Could not write metrics: %s", err->message);
+        g_error_free(err);
+    }
+    return G_SOURCE_CONTINUE;
+}
+
+static void
+sm_app_stop_metrics(SmApp *app)
+{
+    if (app->metrics_id)
+    {
+        g_source_remove(app->metrics_id);
+        app->metrics_id = 0;
+    }
+    g_clear_pointer(&app->metrics_filename, g_free);
+}
+
+static void
+sm_app_update_metrics(SmApp *app)
+{
+    gchar *filename;
+
+    sm_app_stop_metrics(app);
+    filename = g_settings_get_string(app->settings, "metrics-file");
+    if (g_utf8_strlen(filename, -1) == 0)
+    {
+        g_free(filename);
+        return;
+    }
+    app->metrics_filename = filename;
+    sm_app_write_metrics_cb(app);
+    app->metrics_id = g_timeout_add_seconds(SM_APP_METRICS_INTERVAL, sm_app_write_metrics_cb, app);
+}
+
+static void
+sm_app_metrics_changed_cb(GSettings *settings, gchar *key, gpointer user_data)
+{
+    sm_app_update_metrics(SM_APP(user_data));
+}
+
+static void
+sm_app_update_shm(SmApp *app)
+{
+    GError *err = NULL;
+
+    g_clear_object(&app->shm);
+    if (!g_settings_get_boolean(app->settings, "shm-enabled"))
+    {
+        return;
+    }
+    app->shm = sm_shm_export_new(app);
+    if (!sm_shm_export_open(app->shm, &err))
+    {
+        g_warning("Could not publish the state in shared memory: %s", err->message);
+        g_error_free(err);
+        g_clear_object(&app->shm);
+    }
+}
+
+static void
+sm_app_shm_changed_cb(GSettings *settings, gchar *key, gpointer user_data)
+{
+    sm_app_update_shm(SM_APP(user_data));
+}
+
+/*
+ * Follow the clock source and sync status in the metrics, e.g. to notice a
+ * lost sync. There is no item while the mixer is closed.
+ */
+static void
+sm_app_update_switch_metrics(SmApp *app)
+{
+    gchar *item;
+
+    item = app->mixer && app->clock_source ? sm_switch_get_selected_item_name(app->clock_source) : NULL;
+    sm_metrics_set_switch_item(SM_METRICS_SWITCH_CLOCK_SOURCE, item);
+    g_free(item);
+    item = app->mixer && app->sync_status ? sm_switch_get_selected_item_name(app->sync_status) : NULL;
+    sm_metrics_set_switch_item(SM_METRICS_SWITCH_SYNC_STATUS, item);
+    g_free(item);
+}
+
+static void
+sm_app_remove_mixer_watches(SmApp *app)
+{
+    guint idx;
+
+    for (idx = 0; app->mixer_watches && idx < app->mixer_watches->len; idx++)
+    {
+        g_source_remove(g_array_index(app->mixer_watches, guint, idx));
+    }
+    g_clear_pointer(&app->mixer_watches, g_array_unref);
+}
+
+void
+sm_app_close_mixer(SmApp *app)
+{
+    SmAppModel model;
+    int err;
+
+    sm_app_take_model(app, &model);
+    sm_app_model_clear(&model);
+    sm_app_remove_mixer_watches(app);
+    app->mixer_lost = FALSE;
+    if (app->card_info)
+    {
+        snd_ctl_card_info_free(app->card_info);
+        app->card_info = NULL;
+    }
+    if (app->mixer)
+    {
+        err = snd_mixer_close(app->mixer);
+        if (err < 0)
+        {
+            g_debug("sm_app_close_mixer: Failed to close mixer: %s", snd_strerror(err));
+        }
+        app->mixer = NULL;
+    }
+    sm_app_update_switch_metrics(app);
+    g_signal_emit(app, sm_app_signals[SM_APP_SIGNAL_MODEL_CHANGED], 0);
+}
+
+static void
+sm_app_startup(GApplication *app)
+{
+    SmApp *sm_app;
     GtkBuilder *builder;
     GMenuModel *app_menu;
     const gchar *open_accels[2] = { "<Ctrl>O", NULL };
@@ -231,7 +740,9 @@ sm_app_startup(GApplication *app)
     g_debug("sm_app_startup.");
     sm_app = SM_APP(app);
 
+    sm_timing_mark("Application registration");
     G_APPLICATION_CLASS(sm_app_parent_class)->startup(app);
+    sm_timing_mark("GtkApplication startup");
 
     g_action_map_add_action_entries(G_ACTION_MAP(app),
             app_actions,
@@ -250,73 +761,106 @@ sm_app_startup(GApplication *app)
             "app.quit",
             quit_accels);
 
-    //Setup keyfile backend for GSettings in XDG_CONFIG_HOME
-    path = g_build_filename(g_get_user_config_dir(), PACKAGE, "config", NULL);
-    gs_backend = g_keyfile_settings_backend_new(path, "/org/alsa/scarlettmixer/", "Preferences");
-    sm_app->settings = g_settings_new_with_backend("org.alsa.scarlettmixer", gs_backend);
+    sm_app_init_settings(sm_app);
+    g_signal_connect(sm_app->settings, "changed::run-in-background",
+            G_CALLBACK(sm_app_background_changed_cb), sm_app);
+    sm_app_update_hold(sm_app);
+    g_signal_connect(sm_app->settings, "changed::osc-enabled",
+            G_CALLBACK(sm_app_osc_changed_cb), sm_app);
+    g_signal_connect(sm_app->settings, "changed::osc-address",
+            G_CALLBACK(sm_app_osc_changed_cb), sm_app);
+    g_signal_connect(sm_app->settings, "changed::osc-port",
+            G_CALLBACK(sm_app_osc_changed_cb), sm_app);
+    sm_app_update_osc(sm_app);
+    g_signal_connect(sm_app->settings, "changed::http-enabled",
+            G_CALLBACK(sm_app_http_changed_cb), sm_app);
+    g_signal_connect(sm_app->settings, "changed::http-port",
+            G_CALLBACK(sm_app_http_changed_cb), sm_app);
+    sm_app_update_http(sm_app);
+    g_signal_connect(sm_app->settings, "changed::midi-enabled",
+            G_CALLBACK(sm_app_midi_changed_cb), sm_app);
+    sm_app_update_midi(sm_app);
+    g_signal_connect(sm_app->settings, "changed::shm-enabled",
+            G_CALLBACK(sm_app_shm_changed_cb), sm_app);
+    sm_app_update_shm(sm_app);
+    g_signal_connect(sm_app->settings, "changed::metrics-file",
+            G_CALLBACK(sm_app_metrics_changed_cb), sm_app);
+    sm_app_update_metrics(sm_app);
+    sm_timing_mark("GSettings keyfile backend");
 
     builder = gtk_builder_new_from_resource("/org/alsa/scarlettmixer/sm-appmenu.ui");
     app_menu = G_MENU_MODEL(gtk_builder_get_object(builder, "app_menu"));
     gtk_application_set_app_menu(GTK_APPLICATION(app), app_menu);
     g_object_unref(builder);
+    sm_timing_mark("App menu");
 }
 
 static void
 sm_app_shutdown(GApplication *app)
 {
     SmApp *sm_app;
-    GList* item;
-    int err;
+    GError *error = NULL;
 
     g_debug("sm_app_shutdown.");
     sm_app = SM_APP(app);
 
-    for (item = g_list_first(sm_app->channels); item; item = g_list_next(item))
-    {
-        g_object_unref(item->data);
-    }
-    g_list_free(sm_app->channels);
-    sm_app->channels = NULL;
-    for (item = g_list_first(sm_app->input_sources); item; item = g_list_next(item))
-    {
-        g_object_unref(item->data);
-    }
-    g_list_free(sm_app->input_sources);
-    sm_app->input_sources = NULL;
-    for (item = g_list_first(sm_app->input_switches); item; item = g_list_next(item))
-    {
-        g_object_unref(item->data);
-    }
-    g_list_free(sm_app->input_switches);
-    sm_app->input_switches = NULL;
-    if (sm_app->clock_source)
-    {
-        g_object_unref(sm_app->clock_source);
-    }
-    sm_app->clock_source = NULL;
-    if (sm_app->sync_status)
+    if (sm_app->card_name && !sm_app->snapshot && !sm_app->mixer_lost)
     {
-        g_object_unref(sm_app->sync_status);
+        if (!sm_app_write_snapshot(sm_app, &error))
+        {
+            g_warning("Could not write snapshot: %s", error->message);
+            g_error_free(error);
+        }
     }
-    sm_app->sync_status = NULL;
-    if (sm_app->usb_sync)
+    g_clear_object(&sm_app->osc);
+    g_clear_object(&sm_app->http);
+    g_clear_object(&sm_app->midi);
+    g_clear_object(&sm_app->shm);
+    sm_app_stop_metrics(sm_app);
+    sm_app_close_mixer(sm_app);
+    sm_trace_stop();
+    g_clear_pointer(&sm_app->config_filename, g_free);
+    G_APPLICATION_CLASS(sm_app_parent_class)->shutdown(app);
+}
+
+static gboolean
+sm_app_dbus_register(GApplication *app,
+        GDBusConnection *connection,
+        const gchar *object_path,
+        GError **error)
+{
+    SmApp *sm_app;
+
+    g_debug("sm_app_dbus_register: %s", object_path);
+    sm_app = SM_APP(app);
+
+    if (!G_APPLICATION_CLASS(sm_app_parent_class)->dbus_register(app, connection, object_path, error))
     {
-        g_object_unref(sm_app->usb_sync);
+        return FALSE;
     }
-    sm_app->usb_sync = NULL;
-    if (sm_app->card_info)
+    if (!sm_app->dbus)
     {
-        snd_ctl_card_info_free(sm_app->card_info);
+        sm_app->dbus = sm_dbus_service_new(sm_app);
     }
-    if (sm_app->mixer)
+    return sm_dbus_service_register(sm_app->dbus, connection, object_path, error);
+}
+
+static void
+sm_app_dbus_unregister(GApplication *app,
+        GDBusConnection *connection,
+        const gchar *object_path)
+{
+    SmApp *sm_app;
+
+    g_debug("sm_app_dbus_unregister: %s", object_path);
+    sm_app = SM_APP(app);
+
+    if (sm_app->dbus)
     {
-        err = snd_mixer_close(sm_app->mixer);
-        if (err < 0)
-        {
-            g_debug("sm_app_shutdown: Failed to close mixer: %s", snd_strerror(err));
-        }
+        sm_dbus_service_unregister(sm_app->dbus);
+        g_clear_object(&sm_app->dbus);
     }
-    G_APPLICATION_CLASS(sm_app_parent_class)->shutdown(app);
+    G_APPLICATION_CLASS(sm_app_parent_class)->dbus_unregister(app, connection, object_path);
 }
 
 static void
@@ -325,9 +869,36 @@ sm_app_class_init(SmAppClass *class)
     g_debug("sm_app_class_init.");
     g_set_prgname(PACKAGE_NAME);
     g_set_application_name(PACKAGE_NAME);
+    G_APPLICATION_CLASS(class)->handle_local_options = sm_app_handle_local_options;
     G_APPLICATION_CLASS(class)->activate = sm_app_activate;
     G_APPLICATION_CLASS(class)->startup = sm_app_startup;
     G_APPLICATION_CLASS(class)->shutdown = sm_app_shutdown;
+    G_APPLICATION_CLASS(class)->dbus_register = sm_app_dbus_register;
+    G_APPLICATION_CLASS(class)->dbus_unregister = sm_app_dbus_unregister;
+
+    /* init signals */
+    sm_app_signals[SM_APP_SIGNAL_MODEL_CHANGED] =
+        g_signal_newv("model-changed",
+                      G_TYPE_FROM_CLASS(class),
+                      G_SIGNAL_RUN_LAST | G_SIGNAL_NO_RECURSE | G_SIGNAL_NO_HOOKS,
+                      NULL /* closure */,
+                      NULL /* accumulator */,
+                      NULL /* accumulator data */,
+                      NULL /* C marshaller */,
+                      G_TYPE_NONE /* return_type */,
+                      0     /* n_params */,
+                      NULL  /* param_types */);
+    sm_app_signals[SM_APP_SIGNAL_MIXER_LOST] =
+        g_signal_newv("mixer-lost",
+                      G_TYPE_FROM_CLASS(class),
+                      G_SIGNAL_RUN_LAST | G_SIGNAL_NO_RECURSE | G_SIGNAL_NO_HOOKS,
+                      NULL /* closure */,
+                      NULL /* accumulator */,
+                      NULL /* accumulator data */,
+                      NULL /* C marshaller */,
+                      G_TYPE_NONE /* return_type */,
+                      0     /* n_params */,
+                      NULL  /* param_types */);
 }
 
 gint
@@ -337,7 +908,15 @@ sm_app_find_card(const gchar* prefix)
     snd_ctl_t *ctl;
     snd_ctl_card_info_t *cinfo;
     gchar hw_buf[8];
+    SmFakeCard *fake;
 
+    fake = sm_fake_card_get_default();
+    if (fake)
+    {
+        // The fake card replaces all sound cards as card 0. It has no PCM
+        // device, the window does not start the meter for it.
+        return g_str_has_prefix(sm_fake_card_get_name(fake), prefix) ? 0 : -1;
+    }
     snd_ctl_card_info_malloc(&cinfo);
     number = -1;
     while (1)
@@ -398,6 +977,8 @@ sm_app_mixer_elem_callback(snd_mixer_elem_t *elem, unsigned int mask)
     {
         g_debug("sm_app_mixer_elem_callback: %s value changed.",
                         snd_mixer_selem_get_name(elem));
+        sm_metrics_count_event();
+        sm_trace_record_event(elem);
         app = SM_APP(g_application_get_default());
         if (!app)
         {
@@ -447,6 +1028,7 @@ sm_app_mixer_elem_callback(snd_mixer_elem_t *elem, unsigned int mask)
                         sm_switch_get_name(app->clock_source),
                         snd_mixer_selem_get_name(elem));
                 sm_switch_mixer_elem_changed(app->clock_source, elem);
+                sm_app_update_switch_metrics(app);
             }
         }
         if (app->sync_status)
@@ -457,6 +1039,7 @@ sm_app_mixer_elem_callback(snd_mixer_elem_t *elem, unsigned int mask)
                         sm_switch_get_name(app->sync_status),
                         snd_mixer_selem_get_name(elem));
                 sm_switch_mixer_elem_changed(app->sync_status, elem);
+                sm_app_update_switch_metrics(app);
             }
         }
     }
@@ -508,32 +1091,91 @@ sm_app_gioch_mixer_callback(GIOChannel *source,
         gpointer data)
 {
     SmApp *app = SM_APP(data);
+    gint64 start;
+
+    if (condition & (G_IO_ERR | G_IO_HUP))
+    {
+        g_warning("Lost connection to the mixer of %s.", app->card_name);
+        app->mixer_lost = TRUE;
+        // Stop watching the other descriptors as well, the mixer is closed later.
+        sm_app_remove_mixer_watches(app);
+        if (app->loop)
+        {
+            g_main_loop_quit(app->loop);
+        }
+        g_signal_emit(app, sm_app_signals[SM_APP_SIGNAL_MIXER_LOST], 0);
+        return FALSE;
+    }
+    start = g_get_monotonic_time();
     snd_mixer_handle_events(app->mixer);
+    sm_metrics_observe_dispatch(g_get_monotonic_time() - start);
     return TRUE;
 }
 
-const gchar*
-sm_app_open_mixer(SmApp *app, int card_number)
+static gboolean
+sm_app_reconcile_list(GList *snapshot, GList *live, SmAppReconcileFunc func)
 {
-    int err, idx;
+    for (snapshot = g_list_first(snapshot), live = g_list_first(live);
+            snapshot && live;
+            snapshot = g_list_next(snapshot), live = g_list_next(live))
+    {
+        if (!func(snapshot->data, live->data))
+        {
+            return FALSE;
+        }
+    }
+    return snapshot == NULL && live == NULL;
+}
+
+static gboolean
+sm_app_reconcile_switch(SmSwitch *snapshot, SmSwitch *live)
+{
+    if (snapshot == NULL || live == NULL)
+    {
+        return snapshot == live;
+    }
+    return sm_switch_reconcile(snapshot, live);
+}
+
+/*
+ * Attach the mixer elements of the live objects to the snapshot objects.
+ * The objects are compared in the order of the mixer elements, so any
+ * difference in the topology makes the snapshot unusable.
+ */
+static gboolean
+sm_app_reconcile_snapshot(SmApp *app, SmAppModel *snapshot)
+{
+    if (g_strcmp0(snapshot->card_name, app->card_name) != 0
+            || g_list_length(snapshot->channels) != g_list_length(app->channels)
+            || g_list_length(snapshot->input_sources) != g_list_length(app->input_sources)
+            || g_list_length(snapshot->input_switches) != g_list_length(app->input_switches))
+    {
+        return FALSE;
+    }
+    return sm_app_reconcile_list(snapshot->channels, app->channels,
+                (SmAppReconcileFunc)sm_channel_reconcile)
+            && sm_app_reconcile_list(snapshot->input_sources, app->input_sources,
+                (SmAppReconcileFunc)sm_source_reconcile)
+            && sm_app_reconcile_list(snapshot->input_switches, app->input_switches,
+                (SmAppReconcileFunc)sm_switch_reconcile)
+            && sm_app_reconcile_switch(snapshot->clock_source, app->clock_source)
+            && sm_app_reconcile_switch(snapshot->sync_status, app->sync_status)
+            && sm_app_reconcile_switch(snapshot->usb_sync, app->usb_sync);
+}
+
+/*
+ * Register the simple mixer elements of the sound card and load them.
+ * Closes the mixer on error.
+ */
+static gboolean
+sm_app_load_card(SmApp *app, int card_number)
+{
+    int err;
     struct snd_mixer_selem_regopt selem_regopt = {
             .ver = 1,
             .abstract = SND_MIXER_SABSTRACT_NONE,
             .device = g_strdup_printf("hw:%d", card_number)
     };
-    snd_mixer_elem_t *elem;
-    GList *item;
-    int npfds;
-    struct pollfd *pfds;
-    GIOChannel *gioch;
-
-    err = snd_mixer_open(&(app->mixer), 0);
-    if (err < 0)
-    {
-        g_critical("Cannot open mixer: %s", snd_strerror(err));
-        g_free((gpointer)selem_regopt.device);
-        return NULL;
-    }
 
     err = snd_mixer_selem_register(app->mixer, &selem_regopt, NULL);
     if (err < 0)
@@ -541,7 +1183,7 @@ sm_app_open_mixer(SmApp *app, int card_number)
         g_critical("Cannot register simple mixer: %s", snd_strerror(err));
         g_free((gpointer)selem_regopt.device);
         snd_mixer_close(app->mixer);
-        return NULL;
+        return FALSE;
     }
     snd_mixer_set_callback(app->mixer, sm_app_mixer_callback);
 
@@ -551,36 +1193,105 @@ sm_app_open_mixer(SmApp *app, int card_number)
         g_critical("Cannot load mixer controls: %s", snd_strerror(err));
         g_free((gpointer)selem_regopt.device);
         snd_mixer_close(app->mixer);
+        return FALSE;
+    }
+
+    err = snd_mixer_get_hctl(app->mixer, selem_regopt.device, &(app->hctl));
+    g_free((gpointer)selem_regopt.device);
+    if (err < 0)
+    {
+        g_critical("Cannot get HCTL: %s", snd_strerror(err));
+        snd_mixer_close(app->mixer);
+        return FALSE;
+    }
+    snd_ctl_card_info_malloc(&(app->card_info));
+    err = snd_ctl_card_info(snd_hctl_ctl(app->hctl), app->card_info);
+    if (err < 0)
+    {
+        g_critical("Cannot read information from sound card: %s", snd_strerror(err));
+        snd_ctl_card_info_free(app->card_info);
+        app->card_info = NULL;
+        snd_mixer_close(app->mixer);
+        snd_hctl_free(app->hctl);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/*
+ * Register the elements of the fake card instead of the sound card. There is
+ * no card info, so the fake card has no card number and no level meter.
+ * Closes the mixer on error.
+ */
+static gboolean
+sm_app_load_fake_card(SmApp *app, SmFakeCard *fake)
+{
+    int err;
+
+    snd_mixer_set_callback(app->mixer, sm_app_mixer_callback);
+    err = sm_fake_card_attach(fake, app->mixer);
+    if (err < 0)
+    {
+        g_critical("Cannot attach fake card: %s", snd_strerror(err));
+        snd_mixer_close(app->mixer);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+const gchar*
+sm_app_open_mixer(SmApp *app, int card_number)
+{
+    SmAppModel snapshot = { 0 };
+    SmAppModel live;
+    SmFakeCard *fake;
+    int err, idx;
+    snd_mixer_elem_t *elem;
+    GList *item;
+    int npfds;
+    struct pollfd *pfds;
+    GIOChannel *gioch;
+    guint watch;
+
+    if (app->mixer)
+    {
+        // The mixer was lost: Replace it and its objects.
+        sm_app_close_mixer(app);
+    }
+    app->snapshot_adopted = FALSE;
+    app->mixer_lost = FALSE;
+    err = snd_mixer_open(&(app->mixer), 0);
+    if (err < 0)
+    {
+        g_critical("Cannot open mixer: %s", snd_strerror(err));
+        app->mixer = NULL;
         return NULL;
     }
 
-    err = snd_mixer_get_hctl(app->mixer, selem_regopt.device, &(app->hctl));
-    g_free((gpointer)selem_regopt.device);
-    if (err < 0)
+    fake = sm_fake_card_get_default();
+    if (!(fake ? sm_app_load_fake_card(app, fake) : sm_app_load_card(app, card_number)))
     {
-        g_critical("Cannot get HCTL: %s", snd_strerror(err));
-        snd_mixer_close(app->mixer);
+        app->mixer = NULL;
         return NULL;
     }
-    snd_ctl_card_info_malloc(&(app->card_info));
-    err = snd_ctl_card_info(snd_hctl_ctl(app->hctl), app->card_info);
-    if (err < 0)
+    if (app->snapshot)
     {
-        g_critical("Cannot read information from sound card: %s", snd_strerror(err));
-        snd_ctl_card_info_free(app->card_info);
-        snd_mixer_close(app->mixer);
-        snd_hctl_free(app->hctl);
-        return NULL;
+        // Keep the objects displayed so far aside until the live objects are created.
+        sm_app_take_model(app, &snapshot);
     }
-    app->card_name = snd_ctl_card_info_get_name(app->card_info);
+    g_free(app->card_name);
+    app->card_name = g_strdup(fake ? sm_fake_card_get_name(fake) : snd_ctl_card_info_get_name(app->card_info));
 
     npfds = snd_mixer_poll_descriptors_count(app->mixer);
     if (npfds > 0) {
         pfds = malloc(sizeof(*pfds) * npfds);
         npfds = snd_mixer_poll_descriptors(app->mixer, pfds, npfds);
+        app->mixer_watches = g_array_sized_new(FALSE, FALSE, sizeof(guint), npfds);
         for (idx = 0; idx < npfds; idx++) {
             gioch = g_io_channel_unix_new(pfds[idx].fd);
-            g_io_add_watch(gioch, G_IO_IN, sm_app_gioch_mixer_callback, app);
+            watch = g_io_add_watch(gioch, G_IO_IN | G_IO_ERR | G_IO_HUP, sm_app_gioch_mixer_callback, app);
+            g_array_append_val(app->mixer_watches, watch);
+            g_io_channel_unref(gioch);
         }
         g_free(pfds);
     }
@@ -695,6 +1406,28 @@ sm_app_open_mixer(SmApp *app, int card_number)
             }
         }
     }
+    if (app->snapshot)
+    {
+        app->snapshot = FALSE;
+        app->snapshot_adopted = sm_app_reconcile_snapshot(app, &snapshot);
+        if (app->snapshot_adopted)
+        {
+            // Continue with the snapshot objects, which are now attached to the mixer.
+            sm_app_take_model(app, &live);
+            g_free(snapshot.card_name);
+            snapshot.card_name = live.card_name;
+            live.card_name = NULL;
+            sm_app_set_model(app, &snapshot);
+            sm_app_model_clear(&live);
+        }
+        else
+        {
+            g_debug("sm_app_open_mixer: Topology of %s differs from snapshot.", app->card_name);
+            sm_app_model_clear(&snapshot);
+        }
+    }
+    sm_app_update_switch_metrics(app);
+    g_signal_emit(app, sm_app_signals[SM_APP_SIGNAL_MODEL_CHANGED], 0);
     return app->card_name;
 }
 
@@ -702,6 +1435,7 @@ static void
 sm_app_init(SmApp *app)
 {
     g_debug("sm_app_init.");
+    g_application_add_main_option_entries(G_APPLICATION(app), app_options);
 }
 
 SmApp *
@@ -756,13 +1490,280 @@ sm_app_get_sync_status(SmApp *app)
     return app->sync_status;
 }
 
+gint
+sm_app_get_card_number(SmApp *app)
+{
+    if (!app->mixer || app->snapshot || app->mixer_lost)
+    {
+        return -1;
+    }
+    // Only the fake card is opened without card info, see sm_app_find_card().
+    return app->card_info ? snd_ctl_card_info_get_card(app->card_info) : 0;
+}
+
+const gchar*
+sm_app_get_card_name(SmApp *app)
+{
+    return app->card_name;
+}
+
+const gchar*
+sm_app_get_config_filename(SmApp *app)
+{
+    return app->config_filename;
+}
+
+gint
+sm_app_handle_mixer_events(SmApp *app)
+{
+    if (!app->mixer || app->mixer_lost)
+    {
+        return 0;
+    }
+    return snd_mixer_handle_events(app->mixer);
+}
+
 gboolean
-sm_app_write_config_file(SmApp *app, const char *filename, GError **err)
+sm_app_is_snapshot(SmApp *app)
+{
+    return app->snapshot;
+}
+
+gboolean
+sm_app_get_snapshot_adopted(SmApp *app)
+{
+    return app->snapshot_adopted;
+}
+
+gboolean
+sm_app_write_snapshot(SmApp *app, GError **err)
 {
     JsonBuilder *jb;
     JsonNode *jn;
     JsonGenerator *jg;
     GList *item;
+    gchar *filename;
+    gchar *dirname;
+    gboolean ret;
+
+    jb = json_builder_new();
+    jb = json_builder_begin_object(jb);
+
+    jb = json_builder_set_member_name(jb, "version");
+    jb = json_builder_add_int_value(jb, SM_APP_SNAPSHOT_VERSION);
+
+    jb = json_builder_set_member_name(jb, "card_name");
+    jb = json_builder_add_string_value(jb, app->card_name);
+
+    jb = json_builder_set_member_name(jb, "channels");
+    jb = json_builder_begin_array(jb);
+    for (item = g_list_first(app->channels); item; item = g_list_next(item))
+    {
+        jb = json_builder_add_value(jb, sm_channel_to_snapshot_node(SM_CHANNEL(item->data)));
+    }
+    jb = json_builder_end_array(jb);
+
+    jb = json_builder_set_member_name(jb, "input_sources");
+    jb = json_builder_begin_array(jb);
+    for (item = g_list_first(app->input_sources); item; item = g_list_next(item))
+    {
+        jb = json_builder_add_value(jb, sm_source_to_snapshot_node(SM_SOURCE(item->data)));
+    }
+    jb = json_builder_end_array(jb);
+
+    jb = json_builder_set_member_name(jb, "input_switches");
+    jb = json_builder_begin_array(jb);
+    for (item = g_list_first(app->input_switches); item; item = g_list_next(item))
+    {
+        jb = json_builder_add_value(jb, sm_switch_to_snapshot_node(SM_SWITCH(item->data)));
+    }
+    jb = json_builder_end_array(jb);
+
+    jb = json_builder_set_member_name(jb, "clock_source");
+    if (app->clock_source)
+        jb = json_builder_add_value(jb, sm_switch_to_snapshot_node(app->clock_source));
+    else
+        jb = json_builder_add_null_value(jb);
+
+    jb = json_builder_set_member_name(jb, "sync_status");
+    if (app->sync_status)
+        jb = json_builder_add_value(jb, sm_switch_to_snapshot_node(app->sync_status));
+    else
+        jb = json_builder_add_null_value(jb);
+
+    jb = json_builder_set_member_name(jb, "usb_sync");
+    if (app->usb_sync)
+        jb = json_builder_add_value(jb, sm_switch_to_snapshot_node(app->usb_sync));
+    else
+        jb = json_builder_add_null_value(jb);
+
+    jb = json_builder_end_object(jb);
+    jn = json_builder_get_root(jb);
+    g_object_unref(jb);
+
+    filename = sm_app_get_snapshot_filename();
+    dirname = g_path_get_dirname(filename);
+    g_mkdir_with_parents(dirname, 0700);
+    g_free(dirname);
+    jg = json_generator_new();
+    json_generator_set_root(jg, jn);
+    ret = json_generator_to_file(jg, filename, err);
+    g_debug("sm_app_write_snapshot: %s", filename);
+    g_free(filename);
+    g_object_unref(jg);
+    json_node_free(jn);
+    return ret;
+}
+
+gboolean
+sm_app_write_topology(SmApp *app, const gchar *filename, GError **err)
+{
+    if (!app->mixer || app->snapshot || app->mixer_lost)
+    {
+        g_set_error(err, G_IO_ERROR, G_IO_ERROR_NOT_CONNECTED, "No mixer is open.");
+        return FALSE;
+    }
+    return sm_fake_card_write_topology(app->mixer, app->card_name, filename, err);
+}
+
+static SmSwitch*
+sm_app_read_snapshot_switch(JsonObject *jo, const gchar *member)
+{
+    JsonNode *jn;
+
+    if (!json_object_has_member(jo, member))
+    {
+        return NULL;
+    }
+    jn = json_object_get_member(jo, member);
+    if (JSON_NODE_HOLDS_NULL(jn))
+    {
+        return NULL;
+    }
+    return sm_switch_new_from_snapshot_node(jn);
+}
+
+/*
+ * Check the version of a snapshot and the types of its top level members.
+ */
+static gboolean
+sm_app_snapshot_is_valid(JsonObject *jo)
+{
+    static const gchar *arrays[] = { "channels", "input_sources", "input_switches" };
+    JsonNode *jn;
+    guint i;
+
+    jn = json_object_get_member(jo, "version");
+    if (!jn || !JSON_NODE_HOLDS_VALUE(jn)
+            || json_node_get_value_type(jn) != G_TYPE_INT64
+            || json_node_get_int(jn) != SM_APP_SNAPSHOT_VERSION)
+    {
+        return FALSE;
+    }
+    jn = json_object_get_member(jo, "card_name");
+    if (!jn || !JSON_NODE_HOLDS_VALUE(jn) || json_node_get_value_type(jn) != G_TYPE_STRING)
+    {
+        return FALSE;
+    }
+    for (i = 0; i < G_N_ELEMENTS(arrays); i++)
+    {
+        jn = json_object_get_member(jo, arrays[i]);
+        if (!jn || !JSON_NODE_HOLDS_ARRAY(jn))
+        {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+const gchar*
+sm_app_read_snapshot(SmApp *app)
+{
+    JsonParser *jp;
+    JsonObject *jo;
+    JsonArray *ja;
+    gchar *filename;
+    GError *err = NULL;
+    SmChannel *ch;
+    SmSource *src;
+    SmSwitch *sw;
+    guint i;
+
+    if (app->card_name)
+    {
+        // The mixer is already open.
+        return NULL;
+    }
+    filename = sm_app_get_snapshot_filename();
+    jp = json_parser_new();
+    if (!json_parser_load_from_file(jp, filename, &err))
+    {
+        g_debug("sm_app_read_snapshot: Could not read %s: %s", filename, err->message);
+        g_error_free(err);
+        g_free(filename);
+        g_object_unref(jp);
+        return NULL;
+    }
+    g_free(filename);
+    if (!JSON_NODE_HOLDS_OBJECT(json_parser_get_root(jp)))
+    {
+        g_object_unref(jp);
+        return NULL;
+    }
+    jo = json_node_get_object(json_parser_get_root(jp));
+    if (!sm_app_snapshot_is_valid(jo))
+    {
+        g_warning("Ignoring snapshot with invalid format.");
+        g_object_unref(jp);
+        return NULL;
+    }
+
+    ja = json_object_get_array_member(jo, "channels");
+    for (i = 0; i < json_array_get_length(ja); i++)
+    {
+        ch = sm_channel_new_from_snapshot_node(json_array_get_element(ja, i));
+        if (ch)
+        {
+            app->channels = g_list_prepend(app->channels, ch);
+        }
+    }
+    app->channels = g_list_reverse(app->channels);
+    ja = json_object_get_array_member(jo, "input_sources");
+    for (i = 0; i < json_array_get_length(ja); i++)
+    {
+        src = sm_source_new_from_snapshot_node(json_array_get_element(ja, i));
+        if (src)
+        {
+            app->input_sources = g_list_prepend(app->input_sources, src);
+        }
+    }
+    app->input_sources = g_list_reverse(app->input_sources);
+    ja = json_object_get_array_member(jo, "input_switches");
+    for (i = 0; i < json_array_get_length(ja); i++)
+    {
+        sw = sm_switch_new_from_snapshot_node(json_array_get_element(ja, i));
+        if (sw)
+        {
+            app->input_switches = g_list_prepend(app->input_switches, sw);
+        }
+    }
+    app->input_switches = g_list_reverse(app->input_switches);
+    app->clock_source = sm_app_read_snapshot_switch(jo, "clock_source");
+    app->sync_status = sm_app_read_snapshot_switch(jo, "sync_status");
+    app->usb_sync = sm_app_read_snapshot_switch(jo, "usb_sync");
+    app->card_name = g_strdup(json_object_get_string_member(jo, "card_name"));
+    app->snapshot = TRUE;
+    g_object_unref(jp);
+    g_signal_emit(app, sm_app_signals[SM_APP_SIGNAL_MODEL_CHANGED], 0);
+    return app->card_name;
+}
+
+JsonNode*
+sm_app_config_to_json_node(SmApp *app)
+{
+    JsonBuilder *jb;
+    JsonNode *jn;
+    GList *item;
 
     jb = json_builder_new();
     jb = json_builder_begin_object(jb);
@@ -806,19 +1807,36 @@ sm_app_write_config_file(SmApp *app, const char *filename, GError **err)
 
     jb = json_builder_end_object(jb);
     jn = json_builder_get_root(jb);
+    g_object_unref(jb);
+    return jn;
+}
+
+gboolean
+sm_app_write_config_file(SmApp *app, const char *filename, GError **err)
+{
+    JsonNode *jn;
+    JsonGenerator *jg;
+    gboolean ret;
+
+    jn = sm_app_config_to_json_node(app);
     jg = json_generator_new();
     json_generator_set_root(jg, jn);
     json_generator_set_pretty(jg, TRUE);
-    if(!json_generator_to_file(jg, filename, err))
+    ret = json_generator_to_file(jg, filename, err);
+    g_object_unref(jg);
+    json_node_free(jn);
+    if (!ret)
     {
         g_print("Failed to write %s\n", filename);
         return FALSE;
     }
+    g_free(app->config_filename);
+    app->config_filename = g_strdup(filename);
     return TRUE;
 }
 
-gboolean
-sm_app_read_config_file(SmApp *app, const char *filename, GError **err)
+static gboolean
+sm_app_load_config_file(SmApp *app, const char *filename, GError **err)
 {
     JsonParser *jp;
     JsonNode *jn;
@@ -946,9 +1964,23 @@ sm_app_read_config_file(SmApp *app, const char *filename, GError **err)
         }
     }
     g_object_unref(jp);
+    g_free(app->config_filename);
+    app->config_filename = g_strdup(filename);
     return TRUE;
 }
 
+gboolean
+sm_app_read_config_file(SmApp *app, const char *filename, GError **err)
+{
+    gint64 start;
+    gboolean ret;
+
+    start = g_get_monotonic_time();
+    ret = sm_app_load_config_file(app, filename, err);
+    sm_metrics_observe_apply(g_get_monotonic_time() - start, ret);
+    return ret;
+}
+
 gchar*
 sm_app_read_card_name_from_config_file(const gchar *filename, GError **err)
 {
@@ -990,3 +2022,171 @@ sm_app_read_card_name_from_config_file(const gchar *filename, GError **err)
     g_object_unref(jp);
     return card_name;
 }
+
+static gboolean
+sm_app_restore_apply(SmApp *app, const gchar *filename)
+{
+    GError *err = NULL;
+
+    if (!sm_app_read_config_file(app, filename, &err))
+    {
+        g_printerr("Could not apply configuration %s: %s\n", filename, err->message);
+        g_error_free(err);
+        return FALSE;
+    }
+    g_debug("Applied configuration %s to %s.", filename, app->card_name);
+    return TRUE;
+}
+
+static gboolean
+sm_app_restore_quit_cb(gpointer user_data)
+{
+    SmApp *app = SM_APP(user_data);
+
+    g_debug("sm_app_restore_quit_cb.");
+    g_main_loop_quit(app->loop);
+    return G_SOURCE_CONTINUE;
+}
+
+static gboolean
+sm_app_restore_reload_cb(gpointer user_data)
+{
+    SmApp *app = SM_APP(user_data);
+
+    g_debug("sm_app_restore_reload_cb.");
+    sm_app_restore_apply(app, app->restore_filename);
+    return G_SOURCE_CONTINUE;
+}
+
+gint
+sm_app_restore(SmApp *app, const gchar *filename, gboolean daemon)
+{
+    gchar *configfile;
+    GError *err = NULL;
+    gint card_number;
+    gint status = 1;
+    guint sources[3];
+    guint idx;
+
+    if (filename)
+    {
+        configfile = g_strdup(filename);
+    }
+    else
+    {
+        sm_app_init_settings(app);
+        configfile = g_settings_get_string(app->settings, "configfile");
+        g_clear_object(&app->settings);
+        if (g_utf8_strlen(configfile, -1) == 0)
+        {
+            g_printerr("No configuration file set in the preferences.\n");
+            g_free(configfile);
+            return status;
+        }
+    }
+    sm_timing_mark("Configuration file name");
+
+    card_number = sm_app_find_card(prefix);
+    sm_timing_mark("Find card");
+    if (card_number < 0)
+    {
+        g_printerr("No %s audio interface found.\n", prefix);
+        g_free(configfile);
+        return status;
+    }
+    if (!sm_app_open_mixer(app, card_number))
+    {
+        g_free(configfile);
+        return status;
+    }
+    sm_timing_mark("Open mixer of %s", app->card_name);
+
+    if (sm_app_restore_apply(app, configfile))
+    {
+        status = 0;
+    }
+    sm_timing_mark("Apply configuration");
+
+    if (daemon && status == 0)
+    {
+        // Stay resident and follow the mixer events until we are told to quit.
+        app->restore_filename = configfile;
+        sm_app_init_settings(app);
+        sm_app_update_metrics(app);
+        app->loop = g_main_loop_new(NULL, FALSE);
+        sources[0] = g_unix_signal_add(SIGINT, sm_app_restore_quit_cb, app);
+        sources[1] = g_unix_signal_add(SIGTERM, sm_app_restore_quit_cb, app);
+        sources[2] = g_unix_signal_add(SIGHUP, sm_app_restore_reload_cb, app);
+        sm_timing_report("Restore");
+        g_main_loop_run(app->loop);
+        for (idx = 0; idx < G_N_ELEMENTS(sources); idx++)
+        {
+            g_source_remove(sources[idx]);
+        }
+        g_clear_pointer(&app->loop, g_main_loop_unref);
+        sm_app_stop_metrics(app);
+        g_clear_object(&app->settings);
+        app->restore_filename = NULL;
+        if (app->mixer_lost)
+        {
+            // Let the service manager restart us once the interface is back.
+            status = 1;
+        }
+    }
+    if (!app->mixer_lost)
+    {
+        // Keep the snapshot current, so the next window starts with the restored values.
+        if (!sm_app_write_snapshot(app, &err))
+        {
+            g_warning("Could not write snapshot: %s", err->message);
+            g_error_free(err);
+        }
+    }
+    sm_app_close_mixer(app);
+    g_clear_pointer(&app->config_filename, g_free);
+    g_free(configfile);
+    if (!daemon)
+    {
+        sm_timing_mark("Write snapshot");
+        sm_timing_report("Restore");
+    }
+    return status;
+}
+
+gint
+sm_app_replay(SmApp *app, const gchar *filename, gboolean fast)
+{
+    SmTraceReplay *replay;
+    SmFakeCard *fake;
+    GError *err = NULL;
+
+    fake = sm_fake_card_get_default();
+    if (!fake)
+    {
+        g_printerr("Replaying a trace needs a fake card, set SCARLETTMIXER_FAKE_CARD.\n");
+        return 1;
+    }
+    replay = sm_trace_replay_new_from_file(filename, &err);
+    if (!replay)
+    {
+        g_printerr("%s\n", err->message);
+        g_error_free(err);
+        return 1;
+    }
+    if (!sm_app_open_mixer(app, 0))
+    {
+        g_object_unref(replay);
+        return 1;
+    }
+    app->loop = g_main_loop_new(NULL, FALSE);
+    g_signal_connect_swapped(replay, "finished", G_CALLBACK(g_main_loop_quit), app->loop);
+    sm_trace_replay_start(replay, app->mixer, fake, fast);
+    g_main_loop_run(app->loop);
+    g_clear_pointer(&app->loop, g_main_loop_unref);
+    // Dispatch the events of the last records before the mixer is closed.
+    while (g_main_context_iteration(NULL, FALSE));
+    sm_trace_replay_report(replay);
+    g_object_unref(replay);
+    sm_app_close_mixer(app);
+    return 0;
+}
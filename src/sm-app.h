@@ -3,11 +3,22 @@
 /**
  * @file
  * @brief Header file for the scarlett mixer application object.
+ *
+ * The application emits the "model-changed" signal when the mixer objects
+ * returned by the getters are replaced, i.e. after @ref sm_app_open_mixer(),
+ * @ref sm_app_read_snapshot() and when the mixer is closed. It emits the
+ * "mixer-lost" signal when the connection to the mixer is lost; the lost
+ * mixer is replaced by the next @ref sm_app_open_mixer().
  */
 #include <gtk/gtk.h>
 #include <gio/gio.h>
 #include "sm-switch.h"
 
+/**
+ * @brief Prefix of the names of the supported sound cards.
+ */
+#define SM_APP_CARD_PREFIX "Scarlett"
+
 /**
  * @brief Macro to get the type information of the application.
  */
@@ -41,6 +52,7 @@ SmApp*       sm_app_new();
 
 /**
  * @brief Find sound card with name prefix.
+ * If a fake card is selected (see sm-fake-card.h), only the fake card is considered.
  *
  * @param prefix ALSA sound card name prefix to find (e.g. "Scarlett").
  * @return The ALSA sound card number, if sound card was found; -1 else;
@@ -54,12 +66,47 @@ gint         sm_app_find_card(const gchar* prefix);
  * * Input sources: Input channels.
  * * Switches: Switches like Input Impedance switch and Sample clock source.
  *
+ * If a fake card is selected (see sm-fake-card.h), its elements are used
+ * instead of the sound card and the card number is ignored.
+ *
+ * A lost mixer is closed first, together with its objects.
+ *
  * @param app The application object.
  * @param card_number ALSA card number. @see sm_app_find_card
  * @return The card name if successful, NULL otherwise.
  */
 const gchar* sm_app_open_mixer(SmApp *app, int card_number);
 
+/**
+ * @brief Close the ALSA mixer and release the mixer objects.
+ * @param app The application object.
+ */
+void         sm_app_close_mixer(SmApp *app);
+
+/**
+ * @brief Get the card number of the opened mixer.
+ * The mixer stays open while the application runs in the background without
+ * a window, so a new window can be built from the mixer objects right away.
+ * @param app The application object.
+ * @return The ALSA card number (0 for the fake card), or -1 if the mixer is not
+ * open, was lost or the mixer objects are not yet attached to it.
+ */
+gint         sm_app_get_card_number(SmApp *app);
+
+/**
+ * @brief Get the name of the sound card.
+ * @param app The application object.
+ * @return The card name, or NULL if no mixer was opened or snapshot read.
+ */
+const gchar* sm_app_get_card_name(SmApp *app);
+
+/**
+ * @brief Get the configuration file last read or written.
+ * @param app The application object.
+ * @return The path of the configuration file, or NULL.
+ */
+const gchar* sm_app_get_config_filename(SmApp *app);
+
 /**
  * @brief Get the GSettings object of the application.
  * @param app The application object.
@@ -107,6 +154,60 @@ SmSwitch*    sm_app_get_clock_source(SmApp *app);
  */
 SmSwitch*    sm_app_get_sync_status(SmApp *app);
 
+/**
+ * @brief Read the mixer objects from the last-known state snapshot.
+ * The snapshot is written on shutdown to the user cache directory. The mixer
+ * objects read from it can be displayed immediately, but are not attached to
+ * the mixer until @ref sm_app_open_mixer reconciles them with the hardware.
+ * @param app The application object.
+ * @return The card name of the snapshot, or NULL if there is no valid snapshot.
+ */
+const gchar* sm_app_read_snapshot(SmApp *app);
+
+/**
+ * @brief Write the last-known state snapshot of the mixer objects.
+ * @param app The application object.
+ * @param err The GError that will be initialized in case of an error.
+ * @return TRUE on success, FALSE otherwise.
+ */
+gboolean     sm_app_write_snapshot(SmApp *app, GError **err);
+
+/**
+ * @brief Capture the topology and the current values of the open mixer.
+ * The topology file can replace the sound card, see sm-fake-card.h.
+ * @param app The application object.
+ * @param filename Path of the topology file.
+ * @param err The GError that will be initialized in case of an error.
+ * @return TRUE on success, FALSE otherwise.
+ */
+gboolean     sm_app_write_topology(SmApp *app, const gchar *filename, GError **err);
+
+/**
+ * @brief Process the pending events of the open mixer.
+ * Without a running main loop, e.g. in the command line client, the mixer
+ * objects follow changes made by others only through this function.
+ * @param app The application object.
+ * @return Number of processed events, or a negative error code.
+ */
+gint         sm_app_handle_mixer_events(SmApp *app);
+
+/**
+ * @brief Check whether the mixer objects are read from the snapshot and not yet attached to the mixer.
+ * @param app The application object.
+ * @return TRUE if the mixer objects are not attached to the mixer, FALSE otherwise.
+ */
+gboolean     sm_app_is_snapshot(SmApp *app);
+
+/**
+ * @brief Check whether @ref sm_app_open_mixer reconciled the snapshot objects with the mixer.
+ * If the topology of the mixer differs from the snapshot, the snapshot objects
+ * are replaced by new objects and any user interface built for them must be
+ * rebuilt.
+ * @param app The application object.
+ * @return TRUE if the snapshot objects are kept, FALSE otherwise.
+ */
+gboolean     sm_app_get_snapshot_adopted(SmApp *app);
+
 /**
  * @brief Read the card name from a given config file.
  * @param filename The config file to parse.
@@ -115,6 +216,13 @@ SmSwitch*    sm_app_get_sync_status(SmApp *app);
  */
 gchar*       sm_app_read_card_name_from_config_file(const gchar *filename, GError **err);
 
+/**
+ * @brief Build the current configuration in the format of the configuration files.
+ * @param app The application object.
+ * @return The configuration, free with json_node_free().
+ */
+JsonNode*    sm_app_config_to_json_node(SmApp *app);
+
 /**
  * @brief Write the current configuration to a given file.
  * @param app The application object.
@@ -132,4 +240,31 @@ gboolean     sm_app_write_config_file(SmApp *app, const char *filename, GError *
  * @return TRUE on success, FALSE otherwise.
  */
 gboolean     sm_app_read_config_file(SmApp *app, const char *filename, GError **err);
+
+/**
+ * @brief Apply a configuration file to the audio interface without a window.
+ * Opens the mixer and applies the configuration without initializing GTK, so
+ * no display server is required. Only values that differ from the current
+ * state of the mixer are written.
+ * In daemon mode the function keeps running until SIGINT or SIGTERM is
+ * received, SIGHUP applies the configuration again. The snapshot is written
+ * before the mixer is closed.
+ * @param app The application object.
+ * @param filename Path of the configuration file, or NULL to use the file set in the preferences.
+ * @param daemon TRUE to keep running after the configuration was applied.
+ * @return The exit status: 0 on success, 1 if the configuration could not be applied or the mixer was lost.
+ */
+gint         sm_app_restore(SmApp *app, const gchar *filename, gboolean daemon);
+
+/**
+ * @brief Replay a control event trace against the fake card without a window.
+ * Opens the mixer of the fake card (see sm-fake-card.h), replays the trace
+ * (see sm-trace.h) and prints the replay timing to stderr. The snapshot is
+ * not written.
+ * @param app The application object.
+ * @param filename Path of the trace file.
+ * @param fast TRUE to replay as fast as possible, FALSE to keep the recorded times.
+ * @return The exit status: 0 on success, 1 otherwise.
+ */
+gint         sm_app_replay(SmApp *app, const gchar *filename, gboolean fast);
 #endif /* __SM_APP_H */
@@ -23,10 +23,18 @@
 #include "sm-strip.h"
 #include "sm-mix-strip.h"
 #include "sm-channel.h"
+#include "sm-meter.h"
+#include "sm-fake-card.h"
+#include "sm-matrix-grid.h"
+#include "sm-enum-model.h"
+#include "sm-source-selector.h"
+#include "sm-taper.h"
 #include "sm-source.h"
 #include "sm-switch.h"
+#include "sm-timing.h"
 
 #define SM_APPWIN_INIT_TIMEOUT (100)
+#define SM_APPWIN_INIT_BUDGET (8000) ///< Time budget in us per idle callback populating the window.
 #define SM_APPWIN_BOX_MARGIN (6)
 #define SM_APPWIN_BOX_PADDING (3)
 
@@ -67,13 +75,45 @@ struct _SmAppWinPrivate
     GtkMenuButton *config_menubutton; ///< GtkMenuButton to display the menu.
     GtkStack *main_stack; ///< GtkStack as container for the main views (Mix, Searching, Error).
     GtkNotebook *output_mix_notebook; ///< GtkNotebook as container widget for the different mixes.
-    GList *mix_pages; ///< GList to display the pages for the different mixes.
+    GList *mix_pages; ///< GList of @ref SmAppWinMixPage for the different mixes.
+    gboolean mix_pages_ready; ///< Indicates if all channels are assigned to the mix pages.
+    gboolean matrix_view; ///< Indicates if all Matrix Mix channels are shown in a single matrix grid page.
     GtkBox *output_channel_main_box; ///< GtkBox to display the Master channel faders.
     GtkBox *output_channel_box; ///< GtkBox to display the output channel faders.
     GtkBox *input_sources_box; ///< GtkBox to display the input sources.
     GtkBox *input_switches_box;///< GtkBox to display the input switches.
     GtkComboBoxText *sync_source_comboboxtext; ///< GtkComboBoxText to display the clock synchronization sources.
     GtkEntry *sync_status_entry; ///< GtkEntry to display the clock synchronization status.
+    guint check_source_id; ///< Timeout source ID of the search for the audio interface, or 0.
+    GQueue *init_queue; ///< Queue of @ref SmAppWinInitArg builders still populating the window.
+    guint init_source_id; ///< Idle source ID of the builder populating the window.
+    guint init_batch; ///< Number of idle callback invocations populating the window.
+    gboolean populated; ///< Indicates if the initial population of the window is finished.
+    gboolean snapshot; ///< Indicates if the window displays the mixer objects read from the snapshot.
+    SmMeter *meter; ///< SmMeter providing the signal levels for the strips.
+    guint meter_tick_id; ///< Tick callback ID updating the meter at display rate, or 0 while the levels are idle.
+    gboolean iconified; ///< Indicates if the window is iconified.
+    gboolean suspended; ///< Indicates if the window is hidden and the meter and widget updates are suspended.
+};
+
+/**
+ * @brief Type definition for a Matrix Mix notebook page.
+ */
+typedef struct _SmAppWinMixPage SmAppWinMixPage;
+
+/**
+ * @brief Structure holding a Matrix Mix notebook page.
+ * The mix strips of a page are created when the page is revealed the first time.
+ */
+struct _SmAppWinMixPage
+{
+    gchar mix_ids[3]; ///< The Matrix Mix ids of the page.
+    gchar *name; ///< The page label.
+    GtkWidget *page; ///< The notebook page widget.
+    GtkBox *box; ///< GtkBox to display the mix strips, or NULL for the matrix grid page.
+    SmMatrixGrid *grid; ///< Matrix grid of the matrix grid page, or NULL.
+    GList *channels; ///< List of the @ref _SmChannel Matrix Mix channels of the page.
+    gboolean built; ///< Indicates if the mix strips of the page are created.
 };
 
 /**
@@ -81,13 +121,25 @@ struct _SmAppWinPrivate
  */
 typedef struct _SmAppWinInitArg SmAppWinInitArg;
 
+/**
+ * @brief Function to create the GUI elements for one list item.
+ */
+typedef void (*SmAppWinInitFunc)(SmAppWinPrivate *priv, gpointer data);
+
+/**
+ * @brief Function called after the GUI elements for all list items are created.
+ */
+typedef void (*SmAppWinDoneFunc)(SmAppWinPrivate *priv);
+
 /**
  * @brief Structure used to pass initialization data for GUI elements.
  */
 struct _SmAppWinInitArg
 {
-    SmAppWinPrivate *priv; ///< Pointer to private attributes object.
+    const gchar *name; ///< Name of the GUI elements for the timing report.
     GList *list; ///< List containing the initialization data.
+    SmAppWinInitFunc init_item; ///< Function to create the GUI elements for one list item.
+    SmAppWinDoneFunc done; ///< Function called after the last list item, or NULL.
 };
 
 G_DEFINE_TYPE_WITH_PRIVATE(SmAppWin, sm_appwin,
@@ -96,6 +148,58 @@ G_DEFINE_TYPE_WITH_PRIVATE(SmAppWin, sm_appwin,
 // Forward declarations
 static void
 sm_appwin_init_channels(SmAppWin *win, const gchar *card_name);
+static void
+sm_appwin_init_queue_start(SmAppWin *win);
+static void
+sm_appwin_mix_page_free(gpointer data);
+static void
+sm_appwin_clear_channels(SmAppWin *win);
+static void
+sm_appwin_set_attached(SmAppWinPrivate *priv, gboolean attached);
+static void
+sm_appwin_meter_schedule(SmAppWin *win);
+static void
+output_mix_notebook_switch_page_cb(GtkNotebook *notebook,
+        GtkWidget *page,
+        guint page_num,
+        gpointer user_data);
+
+/*
+ * Start the meter and display the mixer objects of the opened mixer.
+ */
+static void
+sm_appwin_attach(SmAppWin *win, gint card_number, const gchar *card_name)
+{
+    SmAppWinPrivate *priv;
+
+    priv = sm_appwin_get_instance_private(win);
+    sm_meter_set_input_sources(priv->meter, sm_app_get_input_sources(priv->app));
+    // The fake card has no PCM device, its card number belongs to another card.
+    if (!sm_fake_card_get_default() && sm_meter_start(priv->meter, card_number))
+    {
+        if (priv->suspended)
+        {
+            sm_meter_suspend(priv->meter);
+        }
+        sm_appwin_meter_schedule(win);
+    }
+    sm_appwin_set_attached(priv, TRUE);
+    if (priv->snapshot)
+    {
+        // The window already displays the reconciled snapshot objects.
+        priv->snapshot = FALSE;
+        if (priv->mix_pages_ready)
+        {
+            gtk_stack_set_visible_child_name(priv->main_stack, "output");
+        }
+        sm_timing_mark("Reconcile snapshot");
+    }
+    else
+    {
+        sm_appwin_init_channels(win, card_name);
+        sm_timing_mark("Init channels");
+    }
+}
 
 static gboolean
 sm_appwin_check_for_interface(gpointer win)
@@ -107,12 +211,29 @@ sm_appwin_check_for_interface(gpointer win)
     GError *err = NULL;
 
     priv = sm_appwin_get_instance_private(win);
+    priv->check_source_id = 0;
+    sm_timing_mark("Window creation");
     card_number = sm_app_find_card(priv->prefix);
+    sm_timing_mark("Find card");
     if (card_number >= 0)
     {
         GSettings *settings;
         gchar *configfile;
         card_name = sm_app_open_mixer(priv->app, card_number);
+        sm_timing_mark("Open mixer");
+        if (card_name == NULL)
+        {
+            gtk_stack_set_visible_child_name(priv->main_stack, "error");
+            g_application_unmark_busy(G_APPLICATION(priv->app));
+            return FALSE;
+        }
+        if (priv->snapshot && !sm_app_get_snapshot_adopted(priv->app))
+        {
+            // The topology differs from the snapshot: Rebuild the window.
+            g_debug("Snapshot does not match %s.", card_name);
+            sm_appwin_clear_channels(win);
+            priv->snapshot = FALSE;
+        }
         //Load configuration from file set in settings
         settings = sm_app_get_settings(priv->app);
         configfile = g_settings_get_string(settings, "configfile");
@@ -149,17 +270,38 @@ sm_appwin_check_for_interface(gpointer win)
             gtk_widget_destroy(msg_dialog);
         }
         g_free(configfile);
-        sm_appwin_init_channels(win, card_name);
+        sm_timing_mark("Apply configuration");
+        sm_appwin_attach(SM_APPWIN(win), card_number, card_name);
     }
     else
     {
         g_debug("No interface with prefix %s found.", priv->prefix);
         gtk_stack_set_visible_child_name(priv->main_stack, "error");
+        sm_timing_report("Startup");
     }
     g_application_unmark_busy(G_APPLICATION(priv->app));
     return FALSE;
 }
 
+/*
+ * Drop the strips of the lost mixer and offer to search the interface again.
+ * The next sm_app_open_mixer() replaces the lost mixer.
+ */
+static void
+sm_appwin_mixer_lost_cb(SmApp *app, gpointer user_data)
+{
+    SmAppWin *win;
+    SmAppWinPrivate *priv;
+
+    win = SM_APPWIN(user_data);
+    priv = sm_appwin_get_instance_private(win);
+    sm_meter_stop(priv->meter);
+    sm_appwin_clear_channels(win);
+    priv->snapshot = FALSE;
+    sm_appwin_set_attached(priv, FALSE);
+    gtk_stack_set_visible_child_name(priv->main_stack, "error");
+}
+
 static void
 refresh_button_clicked_cb(GtkButton *button, gpointer data)
 {
@@ -171,7 +313,11 @@ refresh_button_clicked_cb(GtkButton *button, gpointer data)
     priv = sm_appwin_get_instance_private(win);
     g_application_mark_busy(G_APPLICATION(priv->app));
     gtk_stack_set_visible_child_name(priv->main_stack, "init");
-    g_timeout_add(SM_APPWIN_INIT_TIMEOUT, sm_appwin_check_for_interface, (gpointer)win);
+    if (!priv->check_source_id)
+    {
+        priv->check_source_id = g_timeout_add(SM_APPWIN_INIT_TIMEOUT,
+                sm_appwin_check_for_interface, (gpointer)win);
+    }
 }
 
 static void
@@ -193,9 +339,25 @@ sm_appwin_dispose(GObject *object)
     win = SM_APPWIN(object);
     priv = sm_appwin_get_instance_private(win);
     g_debug("sm_appwin_dispose.");
+    if (priv->check_source_id)
+    {
+        g_source_remove(priv->check_source_id);
+        priv->check_source_id = 0;
+    }
+    if (priv->init_source_id)
+    {
+        g_source_remove(priv->init_source_id);
+        priv->init_source_id = 0;
+    }
+    if (priv->init_queue)
+    {
+        g_queue_free_full(priv->init_queue, g_free);
+        priv->init_queue = NULL;
+    }
     if (priv->mix_pages)
     {
-        g_list_free(priv->mix_pages);
+        // Pages removed during destruction find no mix page to build.
+        g_list_free_full(priv->mix_pages, sm_appwin_mix_page_free);
         priv->mix_pages = NULL;
     }
     if (priv->file_filter)
@@ -203,6 +365,21 @@ sm_appwin_dispose(GObject *object)
         g_object_unref(priv->file_filter);
         priv->file_filter = NULL;
     }
+    if (priv->meter_tick_id)
+    {
+        gtk_widget_remove_tick_callback(GTK_WIDGET(win), priv->meter_tick_id);
+        priv->meter_tick_id = 0;
+    }
+    if (priv->app)
+    {
+        g_signal_handlers_disconnect_by_data(priv->app, win);
+    }
+    if (priv->meter)
+    {
+        g_signal_handlers_disconnect_by_data(priv->meter, win);
+        sm_meter_stop(priv->meter);
+        g_clear_object(&priv->meter);
+    }
     G_OBJECT_CLASS(sm_appwin_parent_class)->dispose(object);
 }
 
@@ -262,31 +439,197 @@ sm_appwin_class_init(SmAppWinClass *class)
             refresh_button_clicked_cb);
 }
 
+static gboolean
+sm_appwin_meter_tick_cb(GtkWidget *widget, GdkFrameClock *frame_clock, gpointer user_data)
+{
+    SmAppWinPrivate *priv;
+
+    priv = sm_appwin_get_instance_private(SM_APPWIN(widget));
+    if (!sm_meter_is_running(priv->meter)
+            || !sm_meter_update(priv->meter, gdk_frame_clock_get_frame_time(frame_clock)))
+    {
+        // Levels are silent, the "active" signal of the meter restarts the ticks.
+        priv->meter_tick_id = 0;
+        return G_SOURCE_REMOVE;
+    }
+    return G_SOURCE_CONTINUE;
+}
+
+static void
+sm_appwin_meter_schedule(SmAppWin *win)
+{
+    SmAppWinPrivate *priv;
+
+    priv = sm_appwin_get_instance_private(win);
+    if (priv->meter_tick_id || priv->suspended
+            || !sm_meter_is_running(priv->meter))
+    {
+        return;
+    }
+    priv->meter_tick_id = gtk_widget_add_tick_callback(GTK_WIDGET(win),
+            sm_appwin_meter_tick_cb, NULL, NULL);
+}
+
+static void
+sm_appwin_meter_unschedule(SmAppWin *win)
+{
+    SmAppWinPrivate *priv;
+
+    priv = sm_appwin_get_instance_private(win);
+    if (priv->meter_tick_id)
+    {
+        gtk_widget_remove_tick_callback(GTK_WIDGET(win), priv->meter_tick_id);
+        priv->meter_tick_id = 0;
+    }
+}
+
+static void
+sm_appwin_meter_active_cb(SmMeter *meter, gpointer user_data)
+{
+    sm_appwin_meter_schedule(SM_APPWIN(user_data));
+}
+
+static void
+sm_appwin_set_children_suspended(GtkContainer *container, GType type, gboolean suspended)
+{
+    GList *children, *item;
+
+    children = gtk_container_get_children(container);
+    for (item = g_list_first(children); item; item = g_list_next(item))
+    {
+        if (!G_TYPE_CHECK_INSTANCE_TYPE(item->data, type))
+        {
+            continue;
+        }
+        if (type == SM_STRIP_TYPE)
+        {
+            sm_strip_set_suspended(SM_STRIP(item->data), suspended);
+        }
+        else
+        {
+            sm_mix_strip_set_suspended(SM_MIX_STRIP(item->data), suspended);
+        }
+    }
+    g_list_free(children);
+}
+
+/*
+ * While the window is unmapped or iconified nothing is displayed, so the
+ * capture thread, the meter ticks and the strip updates are stopped. The
+ * channels keep following the mixer, the strips compare their widgets once
+ * when the window is shown again.
+ */
+static void
+sm_appwin_update_suspended(SmAppWin *win)
+{
+    SmAppWinPrivate *priv;
+    SmAppWinMixPage *mp;
+    GList *item;
+    gboolean suspended;
+
+    priv = sm_appwin_get_instance_private(win);
+    suspended = priv->iconified || !gtk_widget_get_mapped(GTK_WIDGET(win));
+    if (priv->suspended == suspended)
+    {
+        return;
+    }
+    g_debug("sm_appwin_update_suspended: %d", suspended);
+    priv->suspended = suspended;
+    if (suspended)
+    {
+        sm_appwin_meter_unschedule(win);
+        sm_meter_suspend(priv->meter);
+    }
+    sm_appwin_set_children_suspended(GTK_CONTAINER(priv->output_channel_main_box),
+            SM_STRIP_TYPE, suspended);
+    sm_appwin_set_children_suspended(GTK_CONTAINER(priv->output_channel_box),
+            SM_STRIP_TYPE, suspended);
+    for (item = g_list_first(priv->mix_pages); item; item = g_list_next(item))
+    {
+        mp = (SmAppWinMixPage*)item->data;
+        if (mp->grid)
+        {
+            sm_matrix_grid_set_suspended(mp->grid, suspended);
+        }
+        else
+        {
+            sm_appwin_set_children_suspended(GTK_CONTAINER(mp->box),
+                    SM_MIX_STRIP_TYPE, suspended);
+        }
+    }
+    if (!suspended)
+    {
+        sm_meter_resume(priv->meter);
+        sm_appwin_meter_schedule(win);
+    }
+}
+
+static void
+sm_appwin_map_cb(GtkWidget *widget, gpointer user_data)
+{
+    sm_appwin_update_suspended(SM_APPWIN(widget));
+}
+
+static void
+sm_appwin_unmap_cb(GtkWidget *widget, gpointer user_data)
+{
+    sm_appwin_update_suspended(SM_APPWIN(widget));
+}
+
+static gboolean
+sm_appwin_window_state_event_cb(GtkWidget *widget, GdkEventWindowState *event, gpointer user_data)
+{
+    SmAppWinPrivate *priv;
+
+    priv = sm_appwin_get_instance_private(SM_APPWIN(widget));
+    priv->iconified = (event->new_window_state & GDK_WINDOW_STATE_ICONIFIED) != 0;
+    sm_appwin_update_suspended(SM_APPWIN(widget));
+    return FALSE;
+}
+
 static void
 sm_appwin_init(SmAppWin *win)
 {
+    SmAppWinPrivate *priv;
+
     g_debug("sm_appwin_init.");
+    priv = sm_appwin_get_instance_private(win);
     gtk_widget_init_template(GTK_WIDGET(win));
+    priv->init_queue = g_queue_new();
+    // Nothing is displayed before the window is mapped.
+    priv->suspended = TRUE;
+    priv->meter = sm_meter_new();
+    g_signal_connect(priv->meter, "active",
+            G_CALLBACK(sm_appwin_meter_active_cb), win);
+    g_signal_connect(win, "map", G_CALLBACK(sm_appwin_map_cb), NULL);
+    g_signal_connect(win, "unmap", G_CALLBACK(sm_appwin_unmap_cb), NULL);
+    g_signal_connect(win, "window-state-event",
+            G_CALLBACK(sm_appwin_window_state_event_cb), NULL);
+    g_signal_connect(priv->output_mix_notebook, "switch-page",
+            G_CALLBACK(output_mix_notebook_switch_page_cb), win);
 }
 
 static void
-sm_appwin_source_comboboxtext_changed_cb(GtkComboBox *combo, gpointer user_data)
+sm_appwin_source_selector_changed_cb(SmSourceSelector *selector, gpointer user_data)
 {
     SmSource *src = SM_SOURCE(user_data);
     int active_idx;
 
-    active_idx = gtk_combo_box_get_active(combo);
-    sm_source_set_selected_item_index(src, active_idx);
+    active_idx = sm_source_selector_get_active(selector);
+    if (active_idx >= 0)
+    {
+        sm_source_set_selected_item_index(src, active_idx);
+    }
 }
 
 static void
 sm_appwin_source_changed_cb(SmSource *src, gpointer user_data)
 {
-    GtkComboBoxText *comboboxtext = GTK_COMBO_BOX_TEXT(user_data);
+    SmSourceSelector *selector = SM_SOURCE_SELECTOR(user_data);
     int active_idx;
 
     active_idx = sm_source_get_selected_item_index(src);
-    gtk_combo_box_set_active(GTK_COMBO_BOX(comboboxtext), active_idx);
+    sm_source_selector_set_active(selector, active_idx);
 }
 
 static void
@@ -315,172 +658,316 @@ sm_appwin_sync_changed_cb(SmSwitch *sw, gpointer user_data)
     gtk_entry_set_text(GTK_ENTRY(user_data), sm_switch_get_selected_item_name(sw));
 }
 
-static gboolean
-sm_appwin_init_strips(gpointer data)
+static SmAppWinMixPage*
+sm_appwin_find_mix_page(SmAppWinPrivate *priv, gchar mix_id)
 {
-    SmAppWinInitArg *arg;
-    SmChannel *ch;
-    SmStrip *strip;
-    SmMixStrip *mixstrip;
-    GList *page, *item;
+    SmAppWinMixPage *mp;
+    GList *item;
+
+    if (priv->matrix_view)
+    {
+        // The matrix grid page displays all mixes.
+        return priv->mix_pages ? priv->mix_pages->data : NULL;
+    }
+    for (item = g_list_first(priv->mix_pages); item; item = g_list_next(item))
+    {
+        mp = (SmAppWinMixPage*)item->data;
+        if (mp->mix_ids[0] == mix_id || mp->mix_ids[1] == mix_id)
+        {
+            return mp;
+        }
+    }
+    return NULL;
+}
+
+static SmAppWinMixPage*
+sm_appwin_find_mix_page_by_widget(SmAppWinPrivate *priv, GtkWidget *page)
+{
+    SmAppWinMixPage *mp;
+    GList *item;
+
+    for (item = g_list_first(priv->mix_pages); item; item = g_list_next(item))
+    {
+        mp = (SmAppWinMixPage*)item->data;
+        if (mp->page == page)
+        {
+            return mp;
+        }
+    }
+    return NULL;
+}
+
+static SmAppWinMixPage*
+sm_appwin_add_mix_page(SmAppWinPrivate *priv, gchar mix_id)
+{
+    SmAppWinMixPage *mp;
     GtkScrolledWindow *scrolled_win;
     GtkViewport *viewport;
-    GtkBox *box;
     GtkLabel *label;
-    const gchar *mix_ids;
-    gboolean pack_strip;
+    int mix_idx;
+
+    mp = g_malloc0(sizeof(SmAppWinMixPage));
+    mix_idx = (mix_id - 'A') % 2;
+    mp->mix_ids[mix_idx] = mix_id;
+    if (mix_idx == 0)
+        mp->mix_ids[1] = mix_id + 1;
+    else
+        mp->mix_ids[0] = mix_id - 1;
+    mp->mix_ids[2] = '\0';
+    mp->name = g_strdup_printf("Mix %c & %c", mp->mix_ids[0], mp->mix_ids[1]);
+
+    /* Create the page widget, the mix strips are created on first reveal */
+    mp->box = GTK_BOX(gtk_box_new(GTK_ORIENTATION_HORIZONTAL, SM_APPWIN_BOX_PADDING));
+    gtk_widget_set_margin_start(GTK_WIDGET(mp->box), SM_APPWIN_BOX_MARGIN);
+    gtk_widget_set_margin_end(GTK_WIDGET(mp->box), SM_APPWIN_BOX_MARGIN);
+    gtk_widget_set_margin_top(GTK_WIDGET(mp->box), SM_APPWIN_BOX_MARGIN);
+    gtk_widget_set_margin_bottom(GTK_WIDGET(mp->box), SM_APPWIN_BOX_MARGIN);
+    gtk_widget_set_name(GTK_WIDGET(mp->box), mp->mix_ids);
+    viewport = GTK_VIEWPORT(gtk_viewport_new(NULL, NULL));
+    gtk_container_add(GTK_CONTAINER(viewport), GTK_WIDGET(mp->box));
+    scrolled_win = GTK_SCROLLED_WINDOW(gtk_scrolled_window_new(NULL, NULL));
+    gtk_scrolled_window_set_policy(scrolled_win, GTK_POLICY_AUTOMATIC, GTK_POLICY_NEVER);
+    gtk_container_add(GTK_CONTAINER(scrolled_win), GTK_WIDGET(viewport));
+    gtk_widget_show_all(GTK_WIDGET(scrolled_win));
+    mp->page = GTK_WIDGET(scrolled_win);
+    priv->mix_pages = g_list_append(priv->mix_pages, mp);
+    label = GTK_LABEL(gtk_label_new(mp->name));
+    gtk_notebook_append_page(priv->output_mix_notebook, mp->page, GTK_WIDGET(label));
+    return mp;
+}
+
+static SmAppWinMixPage*
+sm_appwin_add_matrix_page(SmAppWinPrivate *priv)
+{
+    SmAppWinMixPage *mp;
+    GtkScrolledWindow *scrolled_win;
+    GtkLabel *label;
+
+    mp = g_malloc0(sizeof(SmAppWinMixPage));
+    mp->name = g_strdup("Matrix");
+
+    /* Create the page widget, the grid is filled on first reveal */
+    mp->grid = SM_MATRIX_GRID(sm_matrix_grid_new());
+    sm_matrix_grid_set_suspended(mp->grid, priv->suspended);
+    gtk_widget_set_margin_start(GTK_WIDGET(mp->grid), SM_APPWIN_BOX_MARGIN);
+    gtk_widget_set_margin_end(GTK_WIDGET(mp->grid), SM_APPWIN_BOX_MARGIN);
+    gtk_widget_set_margin_top(GTK_WIDGET(mp->grid), SM_APPWIN_BOX_MARGIN);
+    gtk_widget_set_margin_bottom(GTK_WIDGET(mp->grid), SM_APPWIN_BOX_MARGIN);
+    gtk_widget_set_halign(GTK_WIDGET(mp->grid), GTK_ALIGN_START);
+    gtk_widget_set_valign(GTK_WIDGET(mp->grid), GTK_ALIGN_START);
+    scrolled_win = GTK_SCROLLED_WINDOW(gtk_scrolled_window_new(NULL, NULL));
+    gtk_scrolled_window_set_policy(scrolled_win, GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
+    gtk_container_add(GTK_CONTAINER(scrolled_win), GTK_WIDGET(mp->grid));
+    gtk_widget_show_all(GTK_WIDGET(scrolled_win));
+    mp->page = GTK_WIDGET(scrolled_win);
+    priv->mix_pages = g_list_append(priv->mix_pages, mp);
+    label = GTK_LABEL(gtk_label_new(mp->name));
+    gtk_notebook_append_page(priv->output_mix_notebook, mp->page, GTK_WIDGET(label));
+    return mp;
+}
+
+static void
+sm_appwin_mix_page_free(gpointer data)
+{
+    SmAppWinMixPage *mp = (SmAppWinMixPage*)data;
 
-    arg = (SmAppWinInitArg*)data;
-    ch = SM_CHANNEL(arg->list->data);
+    g_list_free(mp->channels);
+    g_free(mp->name);
+    g_free(mp);
+}
+
+static void
+sm_appwin_init_mix_strip(SmAppWinPrivate *priv, gpointer data)
+{
+    SmChannel *ch;
+    SmAppWinMixPage *mp;
+    SmMixStrip *mixstrip;
+    GList *children, *item;
+
+    ch = SM_CHANNEL(data);
+    mp = sm_appwin_find_mix_page(priv, sm_channel_get_mix_id(ch));
+    if (!mp)
+    {
+        return;
+    }
+    children = gtk_container_get_children(GTK_CONTAINER(mp->box));
+    for (item = g_list_first(children); item; item = g_list_next(item))
+    {
+        if (sm_mix_strip_add_channel(SM_MIX_STRIP(item->data), ch))
+        {
+            g_list_free(children);
+            return;
+        }
+    }
+    g_list_free(children);
+    mixstrip = sm_mix_strip_new(ch);
+    sm_mix_strip_set_meter(mixstrip, priv->meter);
+    sm_mix_strip_set_suspended(mixstrip, priv->suspended);
+    gtk_box_pack_start(mp->box, GTK_WIDGET(mixstrip), FALSE, FALSE, 0);
+}
+
+static void
+sm_appwin_build_mix_page(SmAppWinPrivate *priv, SmAppWinMixPage *mp)
+{
+    SmAppWinInitArg *arg;
+
+    if (mp->built)
+    {
+        return;
+    }
+    g_debug("sm_appwin_build_mix_page: %s", mp->name);
+    mp->built = TRUE;
+    if (mp->grid)
+    {
+        // The matrix grid is a single widget, no need to build it in batches.
+        sm_matrix_grid_set_channels(mp->grid, mp->channels);
+        return;
+    }
+    /* The revealed page is built before any pending builder */
+    arg = g_malloc0(sizeof(SmAppWinInitArg));
+    arg->name = mp->name;
+    arg->list = g_list_first(mp->channels);
+    arg->init_item = sm_appwin_init_mix_strip;
+    g_queue_push_head(priv->init_queue, arg);
+}
+
+static void
+sm_appwin_init_strip(SmAppWinPrivate *priv, gpointer data)
+{
+    SmChannel *ch;
+    SmStrip *strip;
+    SmAppWinMixPage *mp;
+
+    ch = SM_CHANNEL(data);
     switch (sm_channel_get_channel_type(ch))
     {
         case SM_CHANNEL_MASTER:
         {
             strip = sm_strip_new(ch);
-            gtk_box_pack_end(arg->priv->output_channel_main_box, GTK_WIDGET(strip), FALSE, FALSE, 0);
+            sm_strip_set_meter(strip, priv->meter);
+            sm_strip_set_suspended(strip, priv->suspended);
+            gtk_box_pack_end(priv->output_channel_main_box, GTK_WIDGET(strip), FALSE, FALSE, 0);
             break;
         }
         case SM_CHANNEL_OUTPUT:
         {
             strip = sm_strip_new(ch);
-            gtk_box_pack_start(arg->priv->output_channel_box, GTK_WIDGET(strip), FALSE, FALSE, 0);
+            sm_strip_set_meter(strip, priv->meter);
+            sm_strip_set_suspended(strip, priv->suspended);
+            gtk_box_pack_start(priv->output_channel_box, GTK_WIDGET(strip), FALSE, FALSE, 0);
             break;
         }
         case SM_CHANNEL_MIX:
         {
-            pack_strip = TRUE;
-            mixstrip = NULL;
-            page = NULL;
-            item = NULL;
-            box = NULL;
-            for (page = g_list_first(arg->priv->mix_pages); page; page = g_list_next(page))
-            {
-                mix_ids = gtk_widget_get_name(GTK_WIDGET(page->data));
-                if (mix_ids[0] != sm_channel_get_mix_id(ch) && mix_ids[1] != sm_channel_get_mix_id(ch))
-                {
-                    continue;
-                }
-                for (item = g_list_first(gtk_container_get_children(GTK_CONTAINER(page->data))); item; item = g_list_next(item))
-                {
-                    if (sm_mix_strip_add_channel(SM_MIX_STRIP(item->data), ch))
-                    {
-                        mixstrip = SM_MIX_STRIP(item->data);
-                        pack_strip = FALSE;
-                        break;
-                    }
-                }
-                box = GTK_BOX(page->data);
-                break;
-            }
-            if (!mixstrip)
-            {
-                mixstrip = sm_mix_strip_new(ch);
-            }
-            if (!page)
+            mp = sm_appwin_find_mix_page(priv, sm_channel_get_mix_id(ch));
+            if (!mp)
             {
-                /* Create a new page widget */
-                mix_ids = sm_mix_strip_get_mix_ids(mixstrip);
-                box = GTK_BOX(gtk_box_new(GTK_ORIENTATION_HORIZONTAL, SM_APPWIN_BOX_PADDING));
-                gtk_widget_set_margin_start(GTK_WIDGET(box), SM_APPWIN_BOX_MARGIN);
-                gtk_widget_set_margin_end(GTK_WIDGET(box), SM_APPWIN_BOX_MARGIN);
-                gtk_widget_set_margin_top(GTK_WIDGET(box), SM_APPWIN_BOX_MARGIN);
-                gtk_widget_set_margin_bottom(GTK_WIDGET(box), SM_APPWIN_BOX_MARGIN);
-                gtk_widget_set_name(GTK_WIDGET(box), mix_ids);
-                viewport = GTK_VIEWPORT(gtk_viewport_new(NULL, NULL));
-                gtk_container_add(GTK_CONTAINER(viewport), GTK_WIDGET(box));
-                scrolled_win = GTK_SCROLLED_WINDOW(gtk_scrolled_window_new(NULL, NULL));
-                gtk_scrolled_window_set_policy(scrolled_win, GTK_POLICY_AUTOMATIC, GTK_POLICY_NEVER);
-                gtk_container_add(GTK_CONTAINER(scrolled_win), GTK_WIDGET(viewport));
-                gtk_widget_show_all(GTK_WIDGET(scrolled_win));
-                arg->priv->mix_pages = g_list_prepend(arg->priv->mix_pages, box);
-                label = GTK_LABEL(gtk_label_new(g_strdup_printf("Mix %c & %c",mix_ids[0], mix_ids[1])));
-                gtk_notebook_append_page(arg->priv->output_mix_notebook, GTK_WIDGET(scrolled_win), GTK_WIDGET(label));
-            }
-            if (pack_strip)
-            {
-                gtk_box_pack_start(box, GTK_WIDGET(mixstrip), FALSE, FALSE, 0);
-                gtk_widget_show(GTK_WIDGET(box));
+                mp = priv->matrix_view ? sm_appwin_add_matrix_page(priv)
+                    : sm_appwin_add_mix_page(priv, sm_channel_get_mix_id(ch));
             }
+            mp->channels = g_list_append(mp->channels, ch);
             break;
         }
         default:
             g_warning("Unknown channel type: %ud", sm_channel_get_channel_type(ch));
     }
-    arg->list = g_list_next(arg->list);
-    if (arg->list)
+}
+
+static void
+sm_appwin_init_strips_done(SmAppWinPrivate *priv)
+{
+    GtkWidget *page;
+    SmAppWinMixPage *mp;
+    gint page_num;
+
+    priv->mix_pages_ready = TRUE;
+    page_num = gtk_notebook_get_current_page(priv->output_mix_notebook);
+    if (page_num >= 0)
     {
-        return TRUE;
+        page = gtk_notebook_get_nth_page(priv->output_mix_notebook, page_num);
+        mp = sm_appwin_find_mix_page_by_widget(priv, page);
+        if (mp)
+        {
+            sm_appwin_build_mix_page(priv, mp);
+        }
     }
-    else
+    // Do not hide the error page shown while the snapshot is displayed.
+    if (g_strcmp0(gtk_stack_get_visible_child_name(priv->main_stack), "init") == 0)
     {
-        arg->priv->mix_pages = g_list_reverse(arg->priv->mix_pages);
-        gtk_stack_set_visible_child_name(arg->priv->main_stack, "output");
-        g_free(arg);
-        return FALSE;
+        gtk_stack_set_visible_child_name(priv->main_stack, "output");
     }
 }
 
-static gboolean
-sm_appwin_init_input_sources(gpointer data)
+static void
+output_mix_notebook_switch_page_cb(GtkNotebook *notebook,
+        GtkWidget *page,
+        guint page_num,
+        gpointer user_data)
+{
+    SmAppWin *win;
+    SmAppWinPrivate *priv;
+    SmAppWinMixPage *mp;
+
+    win = SM_APPWIN(user_data);
+    priv = sm_appwin_get_instance_private(win);
+    if (!priv->mix_pages_ready)
+    {
+        // The channels of the pages are not yet known.
+        return;
+    }
+    mp = sm_appwin_find_mix_page_by_widget(priv, page);
+    if (mp && !mp->built)
+    {
+        sm_appwin_build_mix_page(priv, mp);
+        sm_appwin_init_queue_start(win);
+    }
+}
+
+static void
+sm_appwin_init_input_source(SmAppWinPrivate *priv, gpointer data)
 {
-    SmAppWinInitArg *arg;
     SmSource *src;
-    GList *item;
     GtkBox *box;
     GtkLabel *label;
-    GtkComboBoxText *comboboxtext;
+    GtkWidget *selector;
     GtkStyleContext *style_ctx;
     gint idx;
     gchar *name;
 
-    arg = (SmAppWinInitArg*)data;
-    src = SM_SOURCE(arg->list->data);
+    src = SM_SOURCE(data);
     box = GTK_BOX(gtk_box_new(GTK_ORIENTATION_VERTICAL, SM_APPWIN_BOX_PADDING));
     sscanf(sm_source_get_name(src), "Input Source %02u", &idx);
     name = g_strdup_printf("Input %d", idx);
     label = GTK_LABEL(gtk_label_new(name));
     g_free(name);
     gtk_box_pack_start(box, GTK_WIDGET(label), FALSE, FALSE, 0);
-    comboboxtext = GTK_COMBO_BOX_TEXT(gtk_combo_box_text_new());
-    style_ctx = gtk_widget_get_style_context(GTK_WIDGET(comboboxtext));
+    selector = sm_source_selector_new();
+    style_ctx = gtk_widget_get_style_context(selector);
     gtk_style_context_add_class(style_ctx, "small-text");
-    for (item = g_list_first(sm_source_get_item_names(src)); item; item = g_list_next(item))
-    {
-        gtk_combo_box_text_append_text(comboboxtext, item->data);
-        g_free(item->data);
-    }
     idx = sm_source_get_selected_item_index(src);
     if (idx < 0) {
         g_warning("Could not get active enum item!");
     }
-    else {
-        gtk_combo_box_set_active(GTK_COMBO_BOX(comboboxtext), idx);
-    }
-    g_signal_connect(GTK_WIDGET(comboboxtext), "changed", G_CALLBACK(sm_appwin_source_comboboxtext_changed_cb), src);
-    g_signal_connect(src, "changed", G_CALLBACK(sm_appwin_source_changed_cb), comboboxtext);
-    gtk_box_pack_start(box, GTK_WIDGET(comboboxtext), FALSE, FALSE, 0);
-    gtk_box_pack_start(arg->priv->input_sources_box, GTK_WIDGET(box), FALSE, FALSE, 0);
-    arg->list = g_list_next(arg->list);
-    if (arg->list)
-    {
-        return TRUE;
-    }
-    else
-    {
-        gtk_widget_show(GTK_WIDGET(arg->priv->open_config_button));
-        gtk_widget_show(GTK_WIDGET(arg->priv->reveal_input_config_togglebutton));
-        gtk_widget_show(GTK_WIDGET(arg->priv->save_config_button));
-        gtk_widget_show(GTK_WIDGET(arg->priv->config_menubutton));
-        gtk_widget_show_all(GTK_WIDGET(arg->priv->input_sources_box));
-        g_free(arg);
-        return FALSE;
-    }
+    sm_source_selector_set_items(SM_SOURCE_SELECTOR(selector), sm_source_get_items(src), idx);
+    g_signal_connect(selector, "changed", G_CALLBACK(sm_appwin_source_selector_changed_cb), src);
+    g_signal_connect_object(src, "changed", G_CALLBACK(sm_appwin_source_changed_cb), selector, 0);
+    gtk_box_pack_start(box, selector, FALSE, FALSE, 0);
+    gtk_box_pack_start(priv->input_sources_box, GTK_WIDGET(box), FALSE, FALSE, 0);
 }
 
-static gboolean
-sm_appwin_init_input_switches(gpointer data)
+static void
+sm_appwin_init_input_sources_done(SmAppWinPrivate *priv)
+{
+    gtk_widget_show(GTK_WIDGET(priv->open_config_button));
+    gtk_widget_show(GTK_WIDGET(priv->reveal_input_config_togglebutton));
+    gtk_widget_show(GTK_WIDGET(priv->save_config_button));
+    gtk_widget_show(GTK_WIDGET(priv->config_menubutton));
+    gtk_widget_show_all(GTK_WIDGET(priv->input_sources_box));
+}
+
+static void
+sm_appwin_init_input_switch(SmAppWinPrivate *priv, gpointer data)
 {
-    SmAppWinInitArg *arg;
     SmSwitch *sw;
     GList *item;
     GtkBox *box;
@@ -490,10 +977,9 @@ sm_appwin_init_input_switches(gpointer data)
     gint idx, *switch_id;
     gboolean new_box;
 
-    arg = (SmAppWinInitArg*)data;
-    sw = SM_SWITCH(arg->list->data);
+    sw = SM_SWITCH(data);
     idx = sm_switch_get_id(sw);
-    item = gtk_container_get_children(GTK_CONTAINER(arg->priv->input_switches_box));
+    item = gtk_container_get_children(GTK_CONTAINER(priv->input_switches_box));
     new_box = TRUE;
     for (item = g_list_first(item); item; item = g_list_next(item))
     {
@@ -509,54 +995,132 @@ sm_appwin_init_input_switches(gpointer data)
         box = GTK_BOX(gtk_box_new(GTK_ORIENTATION_VERTICAL, SM_APPWIN_BOX_PADDING));
         switch_id = g_malloc0(sizeof(gint));
         *switch_id = idx;
-        g_object_set_data(G_OBJECT(box), "switch_id", (gpointer)switch_id);
-        new_box = TRUE;
+        g_object_set_data_full(G_OBJECT(box), "switch_id", (gpointer)switch_id, g_free);
     }
     label = GTK_LABEL(gtk_label_new(sm_switch_get_name(sw)));
     gtk_box_pack_start(box, GTK_WIDGET(label), FALSE, FALSE, 0);
     comboboxtext = GTK_COMBO_BOX_TEXT(gtk_combo_box_text_new());
     style_ctx = gtk_widget_get_style_context(GTK_WIDGET(comboboxtext));
     gtk_style_context_add_class(style_ctx, "small-text");
-    for (item = g_list_first(sm_switch_get_item_names(sw)); item; item = g_list_next(item))
-    {
-        gtk_combo_box_text_append_text(comboboxtext, item->data);
-        g_free(item->data);
-    }
     idx = sm_switch_get_selected_item_index(sw);
     if (idx < 0) {
         g_warning("Could not get active enum item!");
     }
-    else {
-        gtk_combo_box_set_active(GTK_COMBO_BOX(comboboxtext), idx);
-    }
+    sm_enum_model_set_combo_box(GTK_COMBO_BOX(comboboxtext), sm_switch_get_items(sw), idx);
     g_signal_connect(GTK_WIDGET(comboboxtext), "changed", G_CALLBACK(sm_appwin_switch_comboboxtext_changed_cb), sw);
-    g_signal_connect(sw, "changed", G_CALLBACK(sm_appwin_switch_changed_cb), comboboxtext);
+    g_signal_connect_object(sw, "changed", G_CALLBACK(sm_appwin_switch_changed_cb), comboboxtext, 0);
     gtk_box_pack_start(box, GTK_WIDGET(comboboxtext), FALSE, FALSE, 0);
     if (new_box)
     {
-        gtk_box_pack_start(arg->priv->input_switches_box, GTK_WIDGET(box), FALSE, FALSE, 0);
+        gtk_box_pack_start(priv->input_switches_box, GTK_WIDGET(box), FALSE, FALSE, 0);
     }
-    arg->list = g_list_next(arg->list);
-    if (arg->list)
+}
+
+static void
+sm_appwin_init_input_switches_done(SmAppWinPrivate *priv)
+{
+    gtk_widget_show(GTK_WIDGET(priv->reveal_input_config_togglebutton));
+    gtk_widget_show_all(GTK_WIDGET(priv->input_switches_box));
+}
+
+static gboolean
+sm_appwin_init_idle(gpointer data)
+{
+    SmAppWin *win;
+    SmAppWinPrivate *priv;
+    SmAppWinInitArg *arg;
+    gint64 start;
+    guint count;
+    gchar *tooltip;
+
+    win = SM_APPWIN(data);
+    priv = sm_appwin_get_instance_private(win);
+    priv->init_batch++;
+    start = g_get_monotonic_time();
+    count = 0;
+    /* Build as many widgets as fit into the frame budget,
+     * but at least one to guarantee progress. */
+    while (!g_queue_is_empty(priv->init_queue))
+    {
+        arg = g_queue_peek_head(priv->init_queue);
+        if (arg->list)
+        {
+            arg->init_item(priv, arg->list->data);
+            arg->list = g_list_next(arg->list);
+            count++;
+        }
+        if (!arg->list)
+        {
+            g_queue_pop_head(priv->init_queue);
+            if (arg->done)
+            {
+                arg->done(priv);
+            }
+            sm_timing_mark("%s built", arg->name);
+            g_free(arg);
+        }
+        if (g_get_monotonic_time() - start >= SM_APPWIN_INIT_BUDGET)
+        {
+            break;
+        }
+    }
+    sm_timing_mark("Init batch %u: %u widgets", priv->init_batch, count);
+    if (!g_queue_is_empty(priv->init_queue))
     {
         return TRUE;
     }
-    else
+    priv->init_source_id = 0;
+    if (priv->populated)
     {
-        gtk_widget_show(GTK_WIDGET(arg->priv->reveal_input_config_togglebutton));
-        gtk_widget_show_all(GTK_WIDGET(arg->priv->input_switches_box));
-        g_free(arg);
         return FALSE;
     }
+    priv->populated = TRUE;
+    sm_timing_mark("Window populated");
+    tooltip = g_strdup_printf("Ready after %.1f ms (%u channels, %u batches).",
+            sm_timing_get_elapsed() / 1000.0,
+            g_list_length(sm_app_get_channels(priv->app)),
+            priv->init_batch);
+    g_debug("sm_appwin_init_idle: %s", tooltip);
+    gtk_widget_set_tooltip_text(GTK_WIDGET(priv->card_name_label), tooltip);
+    g_free(tooltip);
+    sm_timing_report("Startup");
+    return FALSE;
+}
+
+static void
+sm_appwin_init_queue_push(SmAppWinPrivate *priv,
+        const gchar *name,
+        GList *list,
+        SmAppWinInitFunc init_item,
+        SmAppWinDoneFunc done)
+{
+    SmAppWinInitArg *arg;
+
+    arg = g_malloc0(sizeof(SmAppWinInitArg));
+    arg->name = name;
+    arg->list = g_list_first(list);
+    arg->init_item = init_item;
+    arg->done = done;
+    g_queue_push_tail(priv->init_queue, arg);
+}
+
+static void
+sm_appwin_init_queue_start(SmAppWin *win)
+{
+    SmAppWinPrivate *priv;
+
+    priv = sm_appwin_get_instance_private(win);
+    if (priv->init_source_id == 0 && !g_queue_is_empty(priv->init_queue))
+    {
+        priv->init_source_id = g_idle_add(sm_appwin_init_idle, win);
+    }
 }
 
 static void
 sm_appwin_init_channels(SmAppWin *win, const gchar *card_name)
 {
     SmAppWinPrivate *priv;
-    SmAppWinInitArg *arg;
     SmSwitch *sw;
-    GList *item;
     gint idx;
 
     g_debug("sm_appwin_init_channels.");
@@ -566,40 +1130,97 @@ sm_appwin_init_channels(SmAppWin *win, const gchar *card_name)
     {
         gtk_label_set_label(priv->card_name_label, card_name);
     }
-    arg = g_malloc0(sizeof(SmAppWinInitArg));
-    arg->priv = priv;
-    arg->list = g_list_first(sm_app_get_channels(priv->app));
-    g_idle_add(sm_appwin_init_strips, arg);
-
-    arg = g_malloc0(sizeof(SmAppWinInitArg));
-    arg->priv = priv;
-    arg->list = g_list_first(sm_app_get_input_sources(priv->app));
-    g_idle_add(sm_appwin_init_input_sources, arg);
-
-    arg = g_malloc0(sizeof(SmAppWinInitArg));
-    arg->priv = priv;
-    arg->list = g_list_first(sm_app_get_input_switches(priv->app));
-    g_idle_add(sm_appwin_init_input_switches, arg);
+    priv->matrix_view = g_settings_get_boolean(sm_app_get_settings(priv->app), "matrix-view");
+    sm_taper_set_default_law(g_settings_get_enum(sm_app_get_settings(priv->app), "fader-law"));
+    sm_appwin_init_queue_push(priv, "Strips",
+            sm_app_get_channels(priv->app),
+            sm_appwin_init_strip, sm_appwin_init_strips_done);
+    sm_appwin_init_queue_push(priv, "Input sources",
+            sm_app_get_input_sources(priv->app),
+            sm_appwin_init_input_source, sm_appwin_init_input_sources_done);
+    sm_appwin_init_queue_push(priv, "Input switches",
+            sm_app_get_input_switches(priv->app),
+            sm_appwin_init_input_switch, sm_appwin_init_input_switches_done);
+    priv->init_batch = 0;
+    priv->populated = FALSE;
+    sm_appwin_init_queue_start(win);
 
     sw = sm_app_get_clock_source(priv->app);
-    for (item = g_list_first(sm_switch_get_item_names(sw)); item; item = g_list_next(item))
-    {
-        gtk_combo_box_text_append_text(priv->sync_source_comboboxtext, item->data);
-        g_free(item->data);
-    }
     idx = sm_switch_get_selected_item_index(sw);
     if (idx < 0) {
         g_warning("Could not get active enum item!");
     }
-    else {
-        gtk_combo_box_set_active(GTK_COMBO_BOX(priv->sync_source_comboboxtext), idx);
-    }
+    sm_enum_model_set_combo_box(GTK_COMBO_BOX(priv->sync_source_comboboxtext),
+            sm_switch_get_items(sw), idx);
     g_signal_connect(GTK_WIDGET(priv->sync_source_comboboxtext), "changed", G_CALLBACK(sm_appwin_switch_comboboxtext_changed_cb), sw);
-    g_signal_connect(sw, "changed", G_CALLBACK(sm_appwin_switch_changed_cb), priv->sync_source_comboboxtext);
+    g_signal_connect_object(sw, "changed", G_CALLBACK(sm_appwin_switch_changed_cb), priv->sync_source_comboboxtext, 0);
 
     sw = sm_app_get_sync_status(priv->app);
     gtk_entry_set_text(GTK_ENTRY(priv->sync_status_entry), sm_switch_get_selected_item_name(sw));
-    g_signal_connect(sw, "changed", G_CALLBACK(sm_appwin_sync_changed_cb), priv->sync_status_entry);
+    g_signal_connect_object(sw, "changed", G_CALLBACK(sm_appwin_sync_changed_cb), priv->sync_status_entry, 0);
+}
+
+static void
+sm_appwin_destroy_children(GtkContainer *container, GType type)
+{
+    GList *children, *item;
+
+    children = gtk_container_get_children(container);
+    for (item = g_list_first(children); item; item = g_list_next(item))
+    {
+        if (G_TYPE_CHECK_INSTANCE_TYPE(item->data, type))
+        {
+            gtk_widget_destroy(GTK_WIDGET(item->data));
+        }
+    }
+    g_list_free(children);
+}
+
+static void
+sm_appwin_clear_channels(SmAppWin *win)
+{
+    SmAppWinPrivate *priv;
+    GList *mix_pages, *item;
+
+    g_debug("sm_appwin_clear_channels.");
+    priv = sm_appwin_get_instance_private(win);
+    if (priv->init_source_id)
+    {
+        g_source_remove(priv->init_source_id);
+        priv->init_source_id = 0;
+    }
+    g_queue_foreach(priv->init_queue, (GFunc)g_free, NULL);
+    g_queue_clear(priv->init_queue);
+
+    // Pages removed from the notebook find no mix page to build.
+    priv->mix_pages_ready = FALSE;
+    mix_pages = priv->mix_pages;
+    priv->mix_pages = NULL;
+    for (item = g_list_first(mix_pages); item; item = g_list_next(item))
+    {
+        gtk_widget_destroy(((SmAppWinMixPage*)item->data)->page);
+    }
+    g_list_free_full(mix_pages, sm_appwin_mix_page_free);
+
+    sm_appwin_destroy_children(GTK_CONTAINER(priv->output_channel_main_box), SM_STRIP_TYPE);
+    sm_appwin_destroy_children(GTK_CONTAINER(priv->output_channel_box), GTK_TYPE_WIDGET);
+    sm_appwin_destroy_children(GTK_CONTAINER(priv->input_sources_box), GTK_TYPE_WIDGET);
+    sm_appwin_destroy_children(GTK_CONTAINER(priv->input_switches_box), GTK_TYPE_WIDGET);
+    g_signal_handlers_disconnect_matched(priv->sync_source_comboboxtext,
+            G_SIGNAL_MATCH_FUNC, 0, 0, NULL,
+            sm_appwin_switch_comboboxtext_changed_cb, NULL);
+    // The model is shared, do not remove its items.
+    sm_enum_model_set_combo_box(GTK_COMBO_BOX(priv->sync_source_comboboxtext), NULL, -1);
+}
+
+static void
+sm_appwin_set_attached(SmAppWinPrivate *priv, gboolean attached)
+{
+    gtk_widget_set_sensitive(gtk_stack_get_child_by_name(priv->main_stack, "output"), attached);
+    gtk_widget_set_sensitive(GTK_WIDGET(priv->input_sources_box), attached);
+    gtk_widget_set_sensitive(GTK_WIDGET(priv->input_switches_box), attached);
+    gtk_widget_set_sensitive(GTK_WIDGET(priv->open_config_button), attached);
+    gtk_widget_set_sensitive(GTK_WIDGET(priv->save_config_button), attached);
 }
 
 SmAppWin *
@@ -608,6 +1229,8 @@ sm_appwin_new(SmApp *app, const gchar* prefix)
     SmAppWin *win;
     SmAppWinPrivate *priv;
     GtkFileFilter *file_filter;
+    const gchar *card_name;
+    gint card_number;
 
     g_debug("sm_appwin_new.");
     win = g_object_new(SM_APPWIN_TYPE, "application", app, NULL);
@@ -618,7 +1241,30 @@ sm_appwin_new(SmApp *app, const gchar* prefix)
     gtk_file_filter_add_mime_type(file_filter, "application/json");
     gtk_file_filter_set_name(file_filter, "All JSON Files");
     priv->file_filter = g_object_ref_sink(file_filter);
-    g_timeout_add(SM_APPWIN_INIT_TIMEOUT, sm_appwin_check_for_interface, (gpointer)win);
+    g_signal_connect(app, "mixer-lost", G_CALLBACK(sm_appwin_mixer_lost_cb), win);
+    card_number = sm_app_get_card_number(app);
+    if (card_number >= 0)
+    {
+        // The mixer stayed open in the background: Display its objects right away.
+        if (sm_app_get_config_filename(app))
+        {
+            gtk_label_set_text(priv->config_filename_label, sm_app_get_config_filename(app));
+        }
+        sm_appwin_attach(win, card_number, sm_app_get_card_name(app));
+        g_application_unmark_busy(G_APPLICATION(app));
+        return win;
+    }
+    // Display the last-known state until the mixer is reconciled.
+    card_name = sm_app_read_snapshot(app);
+    if (card_name)
+    {
+        sm_timing_mark("Read snapshot");
+        priv->snapshot = TRUE;
+        sm_appwin_set_attached(priv, FALSE);
+        sm_appwin_init_channels(win, card_name);
+    }
+    priv->check_source_id = g_timeout_add(SM_APPWIN_INIT_TIMEOUT,
+            sm_appwin_check_for_interface, (gpointer)win);
     return win;
 }
 
@@ -19,6 +19,31 @@
 #include <math.h>
 
 #include "sm-channel.h"
+#include "sm-enum.h"
+#include "sm-metrics.h"
+#include "sm-trace.h"
+
+/**
+ * @brief Type definition for the last-known state of a channel.
+ */
+typedef struct _SmChannelState SmChannelState;
+
+/**
+ * @brief Structure holding the last-known state of a channel.
+ * Index 0 holds the left (or mono) channel, index 1 the right channel.
+ */
+struct _SmChannelState
+{
+    gboolean has_volume[2]; ///< Indicates if the channel has a volume.
+    gboolean has_mute; ///< Indicates if the volume has a mute switch.
+    gdouble min_db; ///< Minimal volume in dB.
+    gdouble max_db; ///< Maximal volume in dB.
+    gdouble step_db; ///< Volume step in dB, 0 if unknown.
+    gdouble vol_db[2]; ///< Volume in dB.
+    int mute[2]; ///< Mute state: 0 = Muted, 1 = Unmuted.
+    const gchar * const *source_items[2]; ///< Interned source names, NULL if there is no source.
+    int source_index[2]; ///< Index of the selected source.
+};
 
 /**
  * @brief Structure holding the ALSA mixer elements belonging to an output channel.
@@ -38,6 +63,8 @@ struct _SmChannel
     gchar *display_name; ///< Name to display in UI.
     unsigned int id; ///< ID parsed from @ref _SmChannel::name.
     gchar mix_id; ///< Mix ID parsed from @ref _SmChannel::name. Only valid for @ref SM_CHANNEL_MIX channel types.
+    SmChannelState *state; ///< Last-known state, only set while no ALSA mixer elements are attached.
+    const gchar * const *source_names[2]; ///< Interned source names of the left and right source element, read on first use.
 };
 
 G_DEFINE_TYPE(SmChannel, sm_channel, G_TYPE_OBJECT);
@@ -50,6 +77,113 @@ enum
 
 static int sm_channel_signals[N_SIGNALS] = {0};
 
+static int
+sm_channel_state_index(snd_mixer_selem_channel_id_t ch)
+{
+    switch (ch)
+    {
+        case SND_MIXER_SCHN_FRONT_LEFT:
+            return 0;
+        case SND_MIXER_SCHN_FRONT_RIGHT:
+            return 1;
+        default:
+            return -1;
+    }
+}
+
+static void
+sm_channel_state_free(SmChannelState *state)
+{
+    if (!state)
+    {
+        return;
+    }
+    g_free(state);
+}
+
+/*
+ * Read the current state of the channel, either from the ALSA mixer elements
+ * or from the last-known state.
+ */
+static SmChannelState*
+sm_channel_state_capture(SmChannel *self)
+{
+    SmChannelState *state;
+    int idx;
+
+    state = g_malloc0(sizeof(SmChannelState));
+    for (idx = 0; idx < 2; idx++)
+    {
+        state->has_volume[idx] = sm_channel_has_volume(self, idx);
+        if (state->has_volume[idx])
+        {
+            state->has_mute = sm_channel_has_volume_mute(self, idx);
+            sm_channel_volume_get_db(self, idx, &state->vol_db[idx]);
+            state->mute[idx] = 1;
+            if (state->has_mute)
+            {
+                sm_channel_volume_get_mute(self, idx, &state->mute[idx]);
+            }
+        }
+        state->source_index[idx] = -1;
+        if (sm_channel_has_source(self, idx))
+        {
+            state->source_items[idx] = sm_channel_source_get_items(self, idx);
+            state->source_index[idx] = sm_channel_source_get_selected_item_index(self, idx);
+        }
+    }
+    if (state->has_volume[0])
+    {
+        sm_channel_volume_get_range_db(self, &state->min_db, &state->max_db);
+        sm_channel_volume_get_step_db(self, &state->step_db);
+    }
+    return state;
+}
+
+static gboolean
+sm_channel_state_equal_topology(SmChannelState *a, SmChannelState *b)
+{
+    int idx;
+
+    if (a->has_mute != b->has_mute
+            || a->min_db != b->min_db
+            || a->max_db != b->max_db
+            || a->step_db != b->step_db)
+    {
+        return FALSE;
+    }
+    for (idx = 0; idx < 2; idx++)
+    {
+        if (a->has_volume[idx] != b->has_volume[idx])
+        {
+            return FALSE;
+        }
+        // Interned sets are equal if their addresses are equal.
+        if (a->source_items[idx] != b->source_items[idx])
+        {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+static gboolean
+sm_channel_state_equal_values(SmChannelState *a, SmChannelState *b)
+{
+    int idx;
+
+    for (idx = 0; idx < 2; idx++)
+    {
+        if (a->vol_db[idx] != b->vol_db[idx]
+                || a->mute[idx] != b->mute[idx]
+                || a->source_index[idx] != b->source_index[idx])
+        {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
 static void
 sm_channel_dispose(GObject *gobject)
 {
@@ -79,6 +213,7 @@ sm_channel_finalize(GObject *gobject)
     g_debug("sm_channel_finalize: %s", self->name);
     g_free(self->name);
     g_free(self->display_name);
+    sm_channel_state_free(self->state);
     /* Always chain up to the parent class; as with dispose(), finalize()
      * is guaranteed to exist on the parent's class virtual function table
      */
@@ -328,6 +463,11 @@ sm_channel_mixer_elem_changed(SmChannel *self, snd_mixer_elem_t *elem)
 gboolean
 sm_channel_has_source(SmChannel *self, snd_mixer_selem_channel_id_t ch)
 {
+    if (self->state)
+    {
+        return sm_channel_state_index(ch) >= 0
+            && self->state->source_items[sm_channel_state_index(ch)] != NULL;
+    }
     switch (ch)
     {
         case SND_MIXER_SCHN_FRONT_LEFT:
@@ -341,35 +481,33 @@ sm_channel_has_source(SmChannel *self, snd_mixer_selem_channel_id_t ch)
     }
 }
 
-GList*
-sm_channel_source_get_item_names(SmChannel *self, snd_mixer_selem_channel_id_t ch)
+const gchar * const *
+sm_channel_source_get_items(SmChannel *self, snd_mixer_selem_channel_id_t ch)
 {
     snd_mixer_elem_t *elem;
     int idx;
-    gchar buf[16];
-    GList *ret = NULL;
 
     if (!sm_channel_has_source(self, ch))
     {
         return NULL;
     }
-    switch (ch)
+    idx = sm_channel_state_index(ch);
+    if (self->state)
     {
-        case SND_MIXER_SCHN_FRONT_LEFT:
-            elem = self->source_left;
-            break;
-        case SND_MIXER_SCHN_FRONT_RIGHT:
-            elem = self->source_right;
-            break;
-        default:
-            return NULL;
+        return self->state->source_items[idx];
     }
-    for(idx = 0; idx < snd_mixer_selem_get_enum_items(elem); idx++) {
-        if(snd_mixer_selem_get_enum_item_name(elem, idx, 16, buf) == 0) {
-            ret = g_list_prepend(ret, g_strdup(buf));
-        }
+    if (!self->source_names[idx])
+    {
+        elem = idx == 0 ? self->source_left : self->source_right;
+        self->source_names[idx] = sm_enum_intern_elem(elem);
     }
-    return g_list_reverse(ret);
+    return self->source_names[idx];
+}
+
+GList*
+sm_channel_source_get_item_names(SmChannel *self, snd_mixer_selem_channel_id_t ch)
+{
+    return sm_enum_to_list(sm_channel_source_get_items(self, ch));
 }
 
 int
@@ -383,6 +521,10 @@ sm_channel_source_get_selected_item_index(SmChannel *self, snd_mixer_selem_chann
     {
         return -1;
     }
+    if (self->state)
+    {
+        return self->state->source_index[sm_channel_state_index(ch)];
+    }
     switch (ch)
     {
         case SND_MIXER_SCHN_FRONT_LEFT:
@@ -407,12 +549,18 @@ gboolean
 sm_channel_source_set_selected_item_index(SmChannel *self, snd_mixer_selem_channel_id_t ch, unsigned int idx)
 {
     snd_mixer_elem_t *elem;
+    unsigned int current;
     int err;
 
     if (!sm_channel_has_source(self, ch))
     {
         return FALSE;
     }
+    if (self->state)
+    {
+        self->state->source_index[sm_channel_state_index(ch)] = idx;
+        return TRUE;
+    }
     switch (ch)
     {
         case SND_MIXER_SCHN_FRONT_LEFT:
@@ -424,18 +572,33 @@ sm_channel_source_set_selected_item_index(SmChannel *self, snd_mixer_selem_chann
         default:
             return FALSE;
     }
+    if (snd_mixer_selem_get_enum_item(elem, SND_MIXER_SCHN_FRONT_LEFT, &current) >= 0
+            && current == idx)
+    {
+        // Skip the write, the item is already selected.
+        sm_metrics_count_write(SM_METRICS_CONTROL_SOURCE, SM_METRICS_WRITE_SKIPPED);
+        return TRUE;
+    }
     err = snd_mixer_selem_set_enum_item(elem, SND_MIXER_SCHN_FRONT_LEFT, idx);
     if (err < 0)
     {
+        sm_metrics_count_write(SM_METRICS_CONTROL_SOURCE, SM_METRICS_WRITE_FAILED);
         g_warning("sm_channel_source_get_selected_item_index: Cannot get selected item index!");
         return FALSE;
     }
+    sm_metrics_count_write(SM_METRICS_CONTROL_SOURCE, SM_METRICS_WRITE_DONE);
+    sm_trace_record_write(SM_TRACE_WRITE_ENUM, elem, SND_MIXER_SCHN_FRONT_LEFT, idx);
     return TRUE;
 }
 
 gboolean
 sm_channel_has_volume(SmChannel *self, snd_mixer_selem_channel_id_t ch)
 {
+    if (self->state)
+    {
+        return sm_channel_state_index(ch) >= 0
+            && self->state->has_volume[sm_channel_state_index(ch)];
+    }
     if (self->volume == NULL)
     {
         return FALSE;
@@ -450,6 +613,10 @@ sm_channel_has_volume_mute(SmChannel *self, snd_mixer_selem_channel_id_t ch)
     {
         return FALSE;
     }
+    if (self->state)
+    {
+        return self->state->has_mute;
+    }
     return snd_mixer_selem_has_playback_switch(self->volume) == 1;
 }
 
@@ -460,8 +627,14 @@ sm_channel_volume_get_range_db(SmChannel *self, gdouble *min_db, gdouble *max_db
     long min_value;
     long max_value;
 
+    if (self->state && self->state->has_volume[0])
+    {
+        *min_db = self->state->min_db;
+        *max_db = self->state->max_db;
+        return TRUE;
+    }
     if (self->volume == NULL)
-        {
+    {
         g_warning("sm_channel_volume_get_range_db: Cannot get volume range in dB!");
         return FALSE;
     }
@@ -476,6 +649,30 @@ sm_channel_volume_get_range_db(SmChannel *self, gdouble *min_db, gdouble *max_db
     return TRUE;
 }
 
+gboolean
+sm_channel_volume_get_step_db(SmChannel *self, gdouble *step_db)
+{
+    long min_value, max_value;
+    gdouble min_db, max_db;
+
+    if (self->state && self->state->has_volume[0])
+    {
+        *step_db = self->state->step_db;
+        return TRUE;
+    }
+    if (!sm_channel_volume_get_range_db(self, &min_db, &max_db))
+    {
+        return FALSE;
+    }
+    if (snd_mixer_selem_get_playback_volume_range(self->volume, &min_value, &max_value) < 0)
+    {
+        g_warning("sm_channel_volume_get_step_db: Cannot get volume range!");
+        return FALSE;
+    }
+    *step_db = max_value > min_value ? (max_db - min_db) / (max_value - min_value) : 0.0;
+    return TRUE;
+}
+
 gboolean
 sm_channel_volume_get_db(SmChannel *self, snd_mixer_selem_channel_id_t ch, gdouble *vol_db)
 {
@@ -487,6 +684,11 @@ sm_channel_volume_get_db(SmChannel *self, snd_mixer_selem_channel_id_t ch, gdoub
         g_warning("sm_channel_volume_get_db: Cannot get volume in dB!");
         return FALSE;
     }
+    if (self->state)
+    {
+        *vol_db = self->state->vol_db[sm_channel_state_index(ch)];
+        return TRUE;
+    }
     err = snd_mixer_selem_get_playback_dB(self->volume, ch, &value);
     if (err < 0)
     {
@@ -501,7 +703,7 @@ gboolean
 sm_channel_volume_set_db(SmChannel *self, snd_mixer_selem_channel_id_t ch, gdouble vol_db)
 {
     int err;
-    long value;
+    long value, raw, current;
 
     if (!sm_channel_has_volume(self, ch))
     {
@@ -509,12 +711,28 @@ sm_channel_volume_set_db(SmChannel *self, snd_mixer_selem_channel_id_t ch, gdoub
         return FALSE;
     }
     value = (long)round(vol_db * 100.0);
+    if (self->state)
+    {
+        self->state->vol_db[sm_channel_state_index(ch)] = (gdouble)value / 100.0;
+        return TRUE;
+    }
+    if (snd_mixer_selem_ask_playback_dB_vol(self->volume, value, -1, &raw) >= 0
+            && snd_mixer_selem_get_playback_volume(self->volume, ch, &current) >= 0
+            && current == raw)
+    {
+        // Skip the write, the volume is already set.
+        sm_metrics_count_write(SM_METRICS_CONTROL_VOLUME, SM_METRICS_WRITE_SKIPPED);
+        return TRUE;
+    }
     err = snd_mixer_selem_set_playback_dB(self->volume, ch, value, -1);
     if (err < 0)
     {
+        sm_metrics_count_write(SM_METRICS_CONTROL_VOLUME, SM_METRICS_WRITE_FAILED);
         g_warning("sm_channel_volume_set_range_db: Cannot set volume in dB!");
         return FALSE;
     }
+    sm_metrics_count_write(SM_METRICS_CONTROL_VOLUME, SM_METRICS_WRITE_DONE);
+    sm_trace_record_write(SM_TRACE_WRITE_DB, self->volume, ch, value);
     return TRUE;
 }
 
@@ -528,6 +746,11 @@ sm_channel_volume_get_mute(SmChannel *self, snd_mixer_selem_channel_id_t ch, int
         g_warning("sm_channel_volume_get_mute: Cannot get volume mute!");
         return FALSE;
     }
+    if (self->state)
+    {
+        *mute = self->state->mute[sm_channel_state_index(ch)];
+        return TRUE;
+    }
     err = snd_mixer_selem_get_playback_switch(self->volume, ch, mute);
     if (err < 0)
     {
@@ -540,19 +763,34 @@ sm_channel_volume_get_mute(SmChannel *self, snd_mixer_selem_channel_id_t ch, int
 gboolean
 sm_channel_volume_set_mute(SmChannel *self, snd_mixer_selem_channel_id_t ch, int mute)
 {
-    int err;
+    int err, current;
 
     if (!sm_channel_has_volume(self, ch))
     {
         g_warning("sm_channel_volume_set_mute: Cannot set volume mute!");
         return FALSE;
     }
+    if (self->state)
+    {
+        self->state->mute[sm_channel_state_index(ch)] = mute;
+        return TRUE;
+    }
+    if (snd_mixer_selem_get_playback_switch(self->volume, ch, &current) >= 0
+            && current == mute)
+    {
+        // Skip the write, the switch is already set.
+        sm_metrics_count_write(SM_METRICS_CONTROL_MUTE, SM_METRICS_WRITE_SKIPPED);
+        return TRUE;
+    }
     err = snd_mixer_selem_set_playback_switch(self->volume, ch, mute);
     if (err < 0)
     {
+        sm_metrics_count_write(SM_METRICS_CONTROL_MUTE, SM_METRICS_WRITE_FAILED);
         g_warning("sm_channel_volume_set_mute: Cannot set volume mute!");
         return FALSE;
     }
+    sm_metrics_count_write(SM_METRICS_CONTROL_MUTE, SM_METRICS_WRITE_DONE);
+    sm_trace_record_write(SM_TRACE_WRITE_SWITCH, self->volume, ch, mute);
     return TRUE;
 }
 
@@ -734,3 +972,327 @@ sm_channel_load_from_json_node(SmChannel *self, JsonNode *node)
     g_signal_emit(self, sm_channel_signals[SM_CHANNEL_SIGNAL_CHANGED], 0);
     return TRUE;
 }
+
+JsonNode*
+sm_channel_to_snapshot_node(SmChannel *self)
+{
+    JsonBuilder *jb;
+    JsonNode *jn;
+    SmChannelState *state;
+    gchar mix_id[2] = { self->mix_id, '\0' };
+    const gchar * const *items;
+    int idx;
+
+    state = sm_channel_state_capture(self);
+    jb = json_builder_new();
+    jb = json_builder_begin_object(jb);
+
+    jb = json_builder_set_member_name(jb, "channel_type");
+    jb = json_builder_add_int_value(jb, self->channel_type);
+
+    jb = json_builder_set_member_name(jb, "name");
+    jb = json_builder_add_string_value(jb, self->name);
+
+    jb = json_builder_set_member_name(jb, "display_name");
+    jb = json_builder_add_string_value(jb, self->display_name);
+
+    jb = json_builder_set_member_name(jb, "id");
+    jb = json_builder_add_int_value(jb, self->id);
+
+    jb = json_builder_set_member_name(jb, "mix_id");
+    jb = json_builder_add_string_value(jb, mix_id);
+
+    jb = json_builder_set_member_name(jb, "joint_vol");
+    jb = json_builder_add_boolean_value(jb, self->joint_volume);
+
+    jb = json_builder_set_member_name(jb, "has_mute");
+    jb = json_builder_add_boolean_value(jb, state->has_mute);
+
+    jb = json_builder_set_member_name(jb, "range_db");
+    jb = json_builder_begin_array(jb);
+    jb = json_builder_add_double_value(jb, state->min_db);
+    jb = json_builder_add_double_value(jb, state->max_db);
+    jb = json_builder_add_double_value(jb, state->step_db);
+    jb = json_builder_end_array(jb);
+
+    /* One entry per side, null if the side has no volume or no source. */
+    jb = json_builder_set_member_name(jb, "vol_db");
+    jb = json_builder_begin_array(jb);
+    for (idx = 0; idx < 2; idx++)
+    {
+        if (state->has_volume[idx])
+            jb = json_builder_add_double_value(jb, state->vol_db[idx]);
+        else
+            jb = json_builder_add_null_value(jb);
+    }
+    jb = json_builder_end_array(jb);
+
+    jb = json_builder_set_member_name(jb, "mute");
+    jb = json_builder_begin_array(jb);
+    for (idx = 0; idx < 2; idx++)
+    {
+        jb = json_builder_add_int_value(jb, state->mute[idx]);
+    }
+    jb = json_builder_end_array(jb);
+
+    jb = json_builder_set_member_name(jb, "source_items");
+    jb = json_builder_begin_array(jb);
+    for (idx = 0; idx < 2; idx++)
+    {
+        if (!state->source_items[idx])
+        {
+            jb = json_builder_add_null_value(jb);
+            continue;
+        }
+        jb = json_builder_begin_array(jb);
+        for (items = state->source_items[idx]; *items; items++)
+        {
+            jb = json_builder_add_string_value(jb, *items);
+        }
+        jb = json_builder_end_array(jb);
+    }
+    jb = json_builder_end_array(jb);
+
+    jb = json_builder_set_member_name(jb, "source_index");
+    jb = json_builder_begin_array(jb);
+    for (idx = 0; idx < 2; idx++)
+    {
+        jb = json_builder_add_int_value(jb, state->source_index[idx]);
+    }
+    jb = json_builder_end_array(jb);
+
+    jb = json_builder_end_object(jb);
+    jn = json_builder_get_root(jb);
+    g_object_unref(jb);
+    sm_channel_state_free(state);
+    return jn;
+}
+
+/*
+ * Check if a snapshot node is a value of the given type.
+ */
+static gboolean
+sm_channel_snapshot_holds(JsonNode *jn, GType type)
+{
+    if (!jn || !JSON_NODE_HOLDS_VALUE(jn))
+    {
+        return FALSE;
+    }
+    // A double without fraction is read back as an integer.
+    if (type == G_TYPE_DOUBLE && json_node_get_value_type(jn) == G_TYPE_INT64)
+    {
+        return TRUE;
+    }
+    return json_node_get_value_type(jn) == type;
+}
+
+/*
+ * Check if a snapshot node is an array of at least length values of the
+ * given type, optionally null.
+ */
+static gboolean
+sm_channel_snapshot_holds_array(JsonNode *jn, guint length, GType type, gboolean nullable)
+{
+    JsonArray *ja;
+    JsonNode *element;
+    guint i;
+
+    if (!jn || !JSON_NODE_HOLDS_ARRAY(jn))
+    {
+        return FALSE;
+    }
+    ja = json_node_get_array(jn);
+    if (json_array_get_length(ja) < length)
+    {
+        return FALSE;
+    }
+    for (i = 0; i < json_array_get_length(ja); i++)
+    {
+        element = json_array_get_element(ja, i);
+        if (!(nullable && JSON_NODE_HOLDS_NULL(element))
+                && !sm_channel_snapshot_holds(element, type))
+        {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+/*
+ * Check the members of a snapshot channel before they are read.
+ */
+static gboolean
+sm_channel_snapshot_is_valid(JsonObject *jo)
+{
+    JsonArray *ja;
+    JsonNode *jn;
+    int idx;
+
+    jn = json_object_get_member(jo, "display_name");
+    if (jn && !JSON_NODE_HOLDS_NULL(jn) && !sm_channel_snapshot_holds(jn, G_TYPE_STRING))
+    {
+        return FALSE;
+    }
+    if (json_object_has_member(jo, "mix_id")
+            && !sm_channel_snapshot_holds(json_object_get_member(jo, "mix_id"), G_TYPE_STRING))
+    {
+        return FALSE;
+    }
+    if (!sm_channel_snapshot_holds(json_object_get_member(jo, "name"), G_TYPE_STRING)
+            || !sm_channel_snapshot_holds(json_object_get_member(jo, "channel_type"), G_TYPE_INT64)
+            || !sm_channel_snapshot_holds(json_object_get_member(jo, "id"), G_TYPE_INT64)
+            || !sm_channel_snapshot_holds(json_object_get_member(jo, "joint_vol"), G_TYPE_BOOLEAN)
+            || !sm_channel_snapshot_holds(json_object_get_member(jo, "has_mute"), G_TYPE_BOOLEAN)
+            || !sm_channel_snapshot_holds_array(json_object_get_member(jo, "range_db"), 2, G_TYPE_DOUBLE, FALSE)
+            || !sm_channel_snapshot_holds_array(json_object_get_member(jo, "vol_db"), 2, G_TYPE_DOUBLE, TRUE)
+            || !sm_channel_snapshot_holds_array(json_object_get_member(jo, "mute"), 2, G_TYPE_INT64, FALSE)
+            || !sm_channel_snapshot_holds_array(json_object_get_member(jo, "source_index"), 2, G_TYPE_INT64, FALSE))
+    {
+        return FALSE;
+    }
+    // One list of source items per side, or null.
+    jn = json_object_get_member(jo, "source_items");
+    if (!jn || !JSON_NODE_HOLDS_ARRAY(jn))
+    {
+        return FALSE;
+    }
+    ja = json_node_get_array(jn);
+    if (json_array_get_length(ja) < 2)
+    {
+        return FALSE;
+    }
+    for (idx = 0; idx < 2; idx++)
+    {
+        jn = json_array_get_element(ja, idx);
+        if (!JSON_NODE_HOLDS_NULL(jn)
+                && !sm_channel_snapshot_holds_array(jn, 0, G_TYPE_STRING, FALSE))
+        {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+SmChannel*
+sm_channel_new_from_snapshot_node(JsonNode *node)
+{
+    SmChannel *self;
+    SmChannelState *state;
+    JsonObject *jo;
+    JsonArray *ja;
+    JsonArray *items;
+    JsonNode *jn;
+    const gchar **names;
+    guint i;
+    int idx;
+
+    if (!JSON_NODE_HOLDS_OBJECT(node))
+    {
+        return NULL;
+    }
+    jo = json_node_get_object(node);
+    if (!sm_channel_snapshot_is_valid(jo))
+    {
+        g_warning("Invalid snapshot format: Incomplete channel!");
+        return NULL;
+    }
+    self = sm_channel_new();
+    state = g_malloc0(sizeof(SmChannelState));
+    self->state = state;
+    self->channel_type = json_object_get_int_member(jo, "channel_type");
+    self->name = g_strdup(json_object_get_string_member(jo, "name"));
+    jn = json_object_get_member(jo, "display_name");
+    if (jn && !JSON_NODE_HOLDS_NULL(jn))
+    {
+        self->display_name = g_strdup(json_node_get_string(jn));
+    }
+    self->id = json_object_get_int_member(jo, "id");
+    if (json_object_has_member(jo, "mix_id"))
+    {
+        self->mix_id = json_object_get_string_member(jo, "mix_id")[0];
+    }
+    self->joint_volume = json_object_get_boolean_member(jo, "joint_vol");
+    state->has_mute = json_object_get_boolean_member(jo, "has_mute");
+    ja = json_object_get_array_member(jo, "range_db");
+    if (json_array_get_length(ja) >= 2)
+    {
+        state->min_db = json_array_get_double_element(ja, 0);
+        state->max_db = json_array_get_double_element(ja, 1);
+    }
+    if (json_array_get_length(ja) >= 3)
+    {
+        state->step_db = json_array_get_double_element(ja, 2);
+    }
+    for (idx = 0; idx < 2; idx++)
+    {
+        ja = json_object_get_array_member(jo, "vol_db");
+        jn = json_array_get_element(ja, idx);
+        if (jn && !JSON_NODE_HOLDS_NULL(jn))
+        {
+            state->has_volume[idx] = TRUE;
+            state->vol_db[idx] = json_node_get_double(jn);
+        }
+        ja = json_object_get_array_member(jo, "mute");
+        state->mute[idx] = json_array_get_int_element(ja, idx);
+        ja = json_object_get_array_member(jo, "source_index");
+        state->source_index[idx] = json_array_get_int_element(ja, idx);
+        ja = json_object_get_array_member(jo, "source_items");
+        jn = json_array_get_element(ja, idx);
+        if (jn && JSON_NODE_HOLDS_ARRAY(jn))
+        {
+            items = json_node_get_array(jn);
+            names = g_new0(const gchar*, json_array_get_length(items) + 1);
+            for (i = 0; i < json_array_get_length(items); i++)
+            {
+                names[i] = json_array_get_string_element(items, i);
+            }
+            state->source_items[idx] = sm_enum_intern(names);
+            g_free(names);
+        }
+    }
+    return self;
+}
+
+gboolean
+sm_channel_is_attached(SmChannel *self)
+{
+    return self->state == NULL;
+}
+
+gboolean
+sm_channel_reconcile(SmChannel *self, SmChannel *live)
+{
+    SmChannelState *state;
+    gboolean changed;
+
+    if (!self->state
+            || live->state
+            || self->channel_type != live->channel_type
+            || g_strcmp0(self->name, live->name) != 0)
+    {
+        return FALSE;
+    }
+    state = sm_channel_state_capture(live);
+    if (!sm_channel_state_equal_topology(self->state, state))
+    {
+        sm_channel_state_free(state);
+        return FALSE;
+    }
+    changed = !sm_channel_state_equal_values(self->state, state);
+    sm_channel_state_free(state);
+
+    self->volume = live->volume;
+    self->source_left = live->source_left;
+    self->source_right = live->source_right;
+    self->source_mix = live->source_mix;
+    self->source_names[0] = live->source_names[0];
+    self->source_names[1] = live->source_names[1];
+    sm_channel_state_free(self->state);
+    self->state = NULL;
+    if (changed)
+    {
+        g_debug("sm_channel_reconcile: %s differs from snapshot.", self->name);
+        g_signal_emit(self, sm_channel_signals[SM_CHANNEL_SIGNAL_CHANGED], 0);
+    }
+    return TRUE;
+}
@@ -118,6 +118,18 @@ void              sm_channel_mixer_elem_changed(SmChannel *self, snd_mixer_elem_
  */
 gboolean          sm_channel_has_source(SmChannel *self, snd_mixer_selem_channel_id_t ch);
 
+/**
+ * @brief Get the interned source names for a given ALSA channel ID.
+ * The names are read from ALSA on first use, see @ref sm-enum.h.
+ * Accepted ALSA channel IDs:
+ * - SND_MIXER_SCHN_FRONT_LEFT
+ * - SND_MIXER_SCHN_FRONT_RIGHT
+ * @param self The channel object.
+ * @param ch The ALSA channel ID.
+ * @return The interned set of source names or NULL.
+ */
+const gchar * const *sm_channel_source_get_items(SmChannel *self, snd_mixer_selem_channel_id_t ch);
+
 /**
  * @brief Get the list of source names for a given ALSA channel ID.
  * Accepted ALSA channel IDs:
@@ -125,7 +137,7 @@ gboolean          sm_channel_has_source(SmChannel *self, snd_mixer_selem_channel
  * - SND_MIXER_SCHN_FRONT_RIGHT
  * @param self The channel object.
  * @param ch The ALSA channel ID.
- * @return The list of source names or NULL.
+ * @return The list of newly allocated source names or NULL.
  */
 GList*            sm_channel_source_get_item_names(SmChannel *self, snd_mixer_selem_channel_id_t ch);
 
@@ -183,6 +195,14 @@ gboolean          sm_channel_has_volume_mute(SmChannel *self, snd_mixer_selem_ch
  */
 gboolean          sm_channel_volume_get_range_db(SmChannel *self, gdouble *min_db, gdouble *max_db);
 
+/**
+ * @brief Get the volume step of the hardware in dB.
+ * @param self The channel object.
+ * @param[out] step_db Pointer to write the volume step in dB to, 0 if unknown.
+ * @return TRUE on success, FALSE otherwise.
+ */
+gboolean          sm_channel_volume_get_step_db(SmChannel *self, gdouble *step_db);
+
 /**
  * @brief Get the current volume in dB for a given ALSA channel ID.
  * Accepted ALSA channel IDs:
@@ -259,6 +279,44 @@ JsonNode*         sm_channel_to_json_node(SmChannel *self);
  * @return TRUE on success, FALSE otherwise.
  */
 gboolean          sm_channel_load_from_json_node(SmChannel *self, JsonNode *node);
+
+/**
+ * @brief Get a JSON object representation of the channel topology and values.
+ * In contrast to @ref sm_channel_to_json_node, the snapshot contains
+ * everything needed to display the channel without ALSA mixer elements.
+ * @param self The channel object.
+ * @return The JSON object.
+ */
+JsonNode*         sm_channel_to_snapshot_node(SmChannel *self);
+
+/**
+ * @brief Create a channel from a snapshot JSON object.
+ * The channel has no ALSA mixer elements attached: All getters return the
+ * last-known state and all setters only modify the last-known state,
+ * until the mixer elements are attached by @ref sm_channel_reconcile.
+ * @param node The JSON object created by @ref sm_channel_to_snapshot_node.
+ * @return Pointer to new channel instance or NULL in case of an error.
+ */
+SmChannel*        sm_channel_new_from_snapshot_node(JsonNode *node);
+
+/**
+ * @brief Check whether the ALSA mixer elements are attached to the channel.
+ * @param self The channel object.
+ * @return FALSE if the channel was created from a snapshot and
+ * is not yet reconciled, TRUE otherwise.
+ */
+gboolean          sm_channel_is_attached(SmChannel *self);
+
+/**
+ * @brief Reconcile a channel created from a snapshot with a live channel.
+ * If the topology of both channels matches, the ALSA mixer elements of the
+ * live channel are attached to the channel. The SM_CHANNEL_SIGNAL_CHANGED
+ * signal is only emitted if a value differs from the last-known state.
+ * @param self The channel created by @ref sm_channel_new_from_snapshot_node.
+ * @param live The channel created from the ALSA mixer elements.
+ * @return TRUE if the channel was reconciled, FALSE if the topology differs.
+ */
+gboolean          sm_channel_reconcile(SmChannel *self, SmChannel *live);
 G_END_DECLS
 
 #endif /* __SM_CHANNEL_H__ */
@@ -0,0 +1,283 @@
+/*
+ * sm-controls-monitor.c - Monitor of the named controls.
+ * Copyright (c) 2016 Martin Roesch <martin.roesch79@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "sm-controls-monitor.h"
+#include "sm-controls.h"
+
+/**
+ * @brief Structure holding the state of the controls monitor.
+ */
+struct _SmControlsMonitor
+{
+    GObject parent_instance; ///< Parent object.
+
+    /* Other members, including private data. */
+    SmApp *app; ///< The application object (not referenced, it outlives the monitor).
+    guint interval; ///< Minimal time between two announcements in milliseconds.
+    gint64 last_flush; ///< Monotonic time of the last announcement in microseconds.
+    GList *objects; ///< List of the mixer objects whose "changed" signal is connected.
+    GHashTable *values; ///< Last announced value of every control.
+    GHashTable *dirty; ///< Set of the mixer objects changed since the last announcement.
+    guint flush_id; ///< Source ID announcing the changes, or 0.
+};
+
+/**
+ * @brief Enumeration of the controls monitor signals.
+ */
+enum
+{
+    SM_CONTROLS_MONITOR_SIGNAL_CHANGED, ///< Controls changed signal.
+    N_SIGNALS ///< Number of signals.
+};
+
+static int sm_controls_monitor_signals[N_SIGNALS] = {0};
+
+G_DEFINE_TYPE(SmControlsMonitor, sm_controls_monitor, G_TYPE_OBJECT);
+
+static void
+sm_controls_monitor_emit(SmControlsMonitor *self, GVariant *controls)
+{
+    g_variant_ref_sink(controls);
+    self->last_flush = g_get_monotonic_time();
+    if (g_variant_n_children(controls) > 0)
+    {
+        g_signal_emit(self, sm_controls_monitor_signals[SM_CONTROLS_MONITOR_SIGNAL_CHANGED], 0, controls);
+    }
+    g_variant_unref(controls);
+}
+
+/*
+ * Announce the controls of the changed objects which differ from the last
+ * announced values.
+ */
+static gboolean
+sm_controls_monitor_flush_cb(gpointer user_data)
+{
+    SmControlsMonitor *self = SM_CONTROLS_MONITOR(user_data);
+    GVariantBuilder objects, changed;
+    GHashTableIter iter;
+    GVariantIter controls;
+    GVariant *state, *value, *last;
+    gpointer object;
+    gchar *name;
+
+    self->flush_id = 0;
+    g_variant_builder_init(&objects, G_VARIANT_TYPE_VARDICT);
+    g_hash_table_iter_init(&iter, self->dirty);
+    while (g_hash_table_iter_next(&iter, &object, NULL))
+    {
+        sm_controls_add_object(&objects, G_OBJECT(object));
+    }
+    g_hash_table_remove_all(self->dirty);
+    state = g_variant_ref_sink(g_variant_builder_end(&objects));
+
+    g_variant_builder_init(&changed, G_VARIANT_TYPE_VARDICT);
+    g_variant_iter_init(&controls, state);
+    while (g_variant_iter_next(&controls, "{sv}", &name, &value))
+    {
+        last = g_hash_table_lookup(self->values, name);
+        if (last && g_variant_equal(last, value))
+        {
+            g_free(name);
+            g_variant_unref(value);
+            continue;
+        }
+        g_variant_builder_add(&changed, "{sv}", name, value);
+        g_hash_table_replace(self->values, name, value);
+    }
+    g_variant_unref(state);
+    sm_controls_monitor_emit(self, g_variant_builder_end(&changed));
+    return G_SOURCE_REMOVE;
+}
+
+static void
+sm_controls_monitor_object_changed_cb(GObject *object, gpointer user_data)
+{
+    SmControlsMonitor *self = SM_CONTROLS_MONITOR(user_data);
+    gint64 delay;
+
+    g_hash_table_add(self->dirty, object);
+    if (self->flush_id)
+    {
+        return;
+    }
+    // The first change after a quiet period is announced right away.
+    delay = self->last_flush + (gint64)self->interval * 1000 - g_get_monotonic_time();
+    if (delay <= 0)
+    {
+        self->flush_id = g_idle_add(sm_controls_monitor_flush_cb, self);
+    }
+    else
+    {
+        self->flush_id = g_timeout_add((guint)(delay / 1000) + 1, sm_controls_monitor_flush_cb, self);
+    }
+}
+
+static void
+sm_controls_monitor_disconnect_objects(SmControlsMonitor *self)
+{
+    GList *item;
+
+    for (item = g_list_first(self->objects); item; item = g_list_next(item))
+    {
+        g_signal_handlers_disconnect_by_data(item->data, self);
+    }
+    g_list_free_full(self->objects, g_object_unref);
+    self->objects = NULL;
+    g_hash_table_remove_all(self->dirty);
+    if (self->flush_id)
+    {
+        g_source_remove(self->flush_id);
+        self->flush_id = 0;
+    }
+}
+
+static void
+sm_controls_monitor_connect_object(SmControlsMonitor *self, gpointer object)
+{
+    if (!object)
+    {
+        return;
+    }
+    self->objects = g_list_prepend(self->objects, g_object_ref(object));
+    g_signal_connect(object, "changed", G_CALLBACK(sm_controls_monitor_object_changed_cb), self);
+}
+
+/*
+ * Follow the current mixer objects of the application and take their
+ * controls as announced values.
+ */
+static GVariant*
+sm_controls_monitor_reset(SmControlsMonitor *self)
+{
+    GList *item;
+    GVariantIter iter;
+    GVariant *state, *value;
+    gchar *name;
+
+    sm_controls_monitor_disconnect_objects(self);
+    for (item = g_list_first(sm_app_get_channels(self->app)); item; item = g_list_next(item))
+    {
+        sm_controls_monitor_connect_object(self, item->data);
+    }
+    for (item = g_list_first(sm_app_get_input_sources(self->app)); item; item = g_list_next(item))
+    {
+        sm_controls_monitor_connect_object(self, item->data);
+    }
+    for (item = g_list_first(sm_app_get_input_switches(self->app)); item; item = g_list_next(item))
+    {
+        sm_controls_monitor_connect_object(self, item->data);
+    }
+    sm_controls_monitor_connect_object(self, sm_app_get_clock_source(self->app));
+    sm_controls_monitor_connect_object(self, sm_app_get_sync_status(self->app));
+
+    g_hash_table_remove_all(self->values);
+    state = g_variant_ref_sink(sm_controls_get_state(self->app));
+    g_variant_iter_init(&iter, state);
+    while (g_variant_iter_next(&iter, "{sv}", &name, &value))
+    {
+        g_hash_table_replace(self->values, name, value);
+    }
+    return state;
+}
+
+/*
+ * The mixer objects were replaced: Follow the new objects and announce all
+ * controls, so clients do not need to ask for the state again.
+ */
+static void
+sm_controls_monitor_model_changed_cb(SmApp *app, gpointer user_data)
+{
+    SmControlsMonitor *self = SM_CONTROLS_MONITOR(user_data);
+
+    sm_controls_monitor_emit(self, sm_controls_monitor_reset(self));
+}
+
+static void
+sm_controls_monitor_dispose(GObject *object)
+{
+    SmControlsMonitor *self = SM_CONTROLS_MONITOR(object);
+
+    sm_controls_monitor_disconnect_objects(self);
+    if (self->app)
+    {
+        g_signal_handlers_disconnect_by_data(self->app, self);
+        self->app = NULL;
+    }
+    G_OBJECT_CLASS(sm_controls_monitor_parent_class)->dispose(object);
+}
+
+static void
+sm_controls_monitor_finalize(GObject *object)
+{
+    SmControlsMonitor *self = SM_CONTROLS_MONITOR(object);
+
+    g_hash_table_unref(self->values);
+    g_hash_table_unref(self->dirty);
+    G_OBJECT_CLASS(sm_controls_monitor_parent_class)->finalize(object);
+}
+
+static void
+sm_controls_monitor_class_init(SmControlsMonitorClass *klass)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS(klass);
+    GType param_types[1] = { G_TYPE_VARIANT };
+
+    object_class->dispose = sm_controls_monitor_dispose;
+    object_class->finalize = sm_controls_monitor_finalize;
+
+    /* init signals */
+    sm_controls_monitor_signals[SM_CONTROLS_MONITOR_SIGNAL_CHANGED] =
+        g_signal_newv("changed",
+                      G_TYPE_FROM_CLASS(object_class),
+                      G_SIGNAL_RUN_LAST | G_SIGNAL_NO_RECURSE | G_SIGNAL_NO_HOOKS,
+                      NULL /* closure */,
+                      NULL /* accumulator */,
+                      NULL /* accumulator data */,
+                      NULL /* C marshaller */,
+                      G_TYPE_NONE /* return_type */,
+                      1     /* n_params */,
+                      param_types  /* param_types */);
+}
+
+static void
+sm_controls_monitor_init(SmControlsMonitor *self)
+{
+    self->values = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+            (GDestroyNotify)g_variant_unref);
+    self->dirty = g_hash_table_new(g_direct_hash, g_direct_equal);
+}
+
+SmControlsMonitor*
+sm_controls_monitor_new(SmApp *app, guint interval)
+{
+    SmControlsMonitor *self;
+
+    self = g_object_new(SM_TYPE_CONTROLS_MONITOR, NULL);
+    self->app = app;
+    self->interval = interval;
+    g_variant_unref(sm_controls_monitor_reset(self));
+    g_signal_connect(app, "model-changed", G_CALLBACK(sm_controls_monitor_model_changed_cb), self);
+    return self;
+}
+
+GVariant*
+sm_controls_monitor_lookup(SmControlsMonitor *self, const gchar *name)
+{
+    return g_hash_table_lookup(self->values, name);
+}
@@ -0,0 +1,51 @@
+#ifndef __SM_CONTROLS_MONITOR_H__
+#define __SM_CONTROLS_MONITOR_H__
+/**
+ * @file
+ * @brief Header file for the monitor of the named controls.
+ *
+ * The monitor follows the "changed" signals of all mixer objects of the
+ * application and announces the controls (see sm-controls.h) whose values
+ * differ from the last announcement by its "changed" signal:
+ * @code
+ * void handler(SmControlsMonitor *monitor, GVariant *controls, gpointer user_data);
+ * @endcode
+ * `controls` is of type a{sv}. Changes are collected until the main loop is
+ * idle, and announced at most once per interval. When the mixer objects of
+ * the application are replaced, all controls are announced.
+ */
+#include <glib-object.h>
+
+#include "sm-app.h"
+
+G_BEGIN_DECLS
+
+/**
+ * @brief Macro to get the type information of the controls monitor.
+ */
+#define SM_TYPE_CONTROLS_MONITOR sm_controls_monitor_get_type()
+/**
+ * @brief Macro declaring the final controls monitor type.
+ */
+G_DECLARE_FINAL_TYPE(SmControlsMonitor, sm_controls_monitor, SM, CONTROLS_MONITOR, GObject);
+
+/**
+ * @brief Create a new controls monitor.
+ * @param app The application object.
+ * @param interval Minimal time between two announcements in milliseconds, or
+ * 0 to announce as soon as the main loop is idle.
+ * @return Pointer to new controls monitor instance.
+ */
+SmControlsMonitor *sm_controls_monitor_new(SmApp *app, guint interval);
+
+/**
+ * @brief Get the last announced value of a control.
+ * @param self The controls monitor.
+ * @param name The control name.
+ * @return The value owned by the monitor, or NULL if there is no such control.
+ */
+GVariant          *sm_controls_monitor_lookup(SmControlsMonitor *self, const gchar *name);
+
+G_END_DECLS
+
+#endif /* __SM_CONTROLS_MONITOR_H__ */
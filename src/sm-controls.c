@@ -0,0 +1,723 @@
+/*
+ * sm-controls.c - Named controls of the mixer objects.
+ * Copyright (c) 2016 Martin Roesch <martin.roesch79@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include <gio/gio.h>
+
+#include "config.h"
+#include "sm-controls.h"
+#include "sm-channel.h"
+#include "sm-enum.h"
+#include "sm-source.h"
+#include "sm-switch.h"
+#include "sm-taper.h"
+
+#define SM_CONTROLS_SCENE_SUFFIX ".json" ///< File name suffix of the scene files.
+
+/**
+ * @brief Properties of a control.
+ */
+typedef enum
+{
+    SM_CONTROLS_PROP_VOLUME, ///< Channel volume in dB.
+    SM_CONTROLS_PROP_MUTE, ///< Channel mute.
+    SM_CONTROLS_PROP_SOURCE, ///< Channel source item.
+    SM_CONTROLS_PROP_ITEM ///< Source or switch item.
+} SmControlsProp;
+
+/**
+ * @brief Structure holding a checked control change.
+ */
+typedef struct
+{
+    GObject *object; ///< The mixer object.
+    snd_mixer_selem_channel_id_t side; ///< Channel side of channel controls.
+    SmControlsProp prop; ///< The changed property.
+    gdouble vol_db; ///< Volume in dB of @ref SM_CONTROLS_PROP_VOLUME.
+    gint value; ///< Mute state or item index of the other properties.
+} SmControlsChange;
+
+static const GDBusErrorEntry sm_controls_error_entries[] =
+{
+    { SM_CONTROLS_ERROR_NOT_FOUND, "org.alsa.scarlettmixer.Error.NotFound" },
+    { SM_CONTROLS_ERROR_INVALID_VALUE, "org.alsa.scarlettmixer.Error.InvalidValue" },
+    { SM_CONTROLS_ERROR_READ_ONLY, "org.alsa.scarlettmixer.Error.ReadOnly" },
+    { SM_CONTROLS_ERROR_DETACHED, "org.alsa.scarlettmixer.Error.Detached" },
+    { SM_CONTROLS_ERROR_FAILED, "org.alsa.scarlettmixer.Error.Failed" }
+};
+
+G_STATIC_ASSERT(G_N_ELEMENTS(sm_controls_error_entries) == SM_CONTROLS_N_ERRORS);
+
+GQuark
+sm_controls_error_quark()
+{
+    static volatile gsize quark = 0;
+
+    g_dbus_error_register_error_domain("sm-controls-error-quark", &quark,
+            sm_controls_error_entries, G_N_ELEMENTS(sm_controls_error_entries));
+    return (GQuark)quark;
+}
+
+static gboolean
+sm_controls_is_stereo(SmChannel *ch)
+{
+    return sm_channel_has_volume(ch, SND_MIXER_SCHN_FRONT_RIGHT)
+        || sm_channel_has_source(ch, SND_MIXER_SCHN_FRONT_RIGHT);
+}
+
+static void
+sm_controls_add_channel_side(GVariantBuilder *builder, SmChannel *ch,
+        snd_mixer_selem_channel_id_t side, const gchar *prefix)
+{
+    gchar *name;
+    const gchar *item;
+    gdouble vol_db;
+    int mute;
+
+    if (sm_channel_has_volume(ch, side))
+    {
+        if (sm_channel_volume_get_db(ch, side, &vol_db))
+        {
+            name = g_strconcat(prefix, "/volume", NULL);
+            g_variant_builder_add(builder, "{sv}", name, g_variant_new_double(vol_db));
+            g_free(name);
+        }
+        // Get mute state: 0 = Muted, 1 = Unmuted
+        if (sm_channel_has_volume_mute(ch, side) && sm_channel_volume_get_mute(ch, side, &mute))
+        {
+            name = g_strconcat(prefix, "/mute", NULL);
+            g_variant_builder_add(builder, "{sv}", name, g_variant_new_boolean(mute == 0));
+            g_free(name);
+        }
+    }
+    if (sm_channel_has_source(ch, side))
+    {
+        item = sm_enum_get_name(sm_channel_source_get_items(ch, side),
+                sm_channel_source_get_selected_item_index(ch, side));
+        if (item)
+        {
+            name = g_strconcat(prefix, "/source", NULL);
+            g_variant_builder_add(builder, "{sv}", name, g_variant_new_string(item));
+            g_free(name);
+        }
+    }
+}
+
+static void
+sm_controls_add_item(GVariantBuilder *builder, const gchar *object_name,
+        const gchar * const *items, gint idx)
+{
+    gchar *name;
+    const gchar *item;
+
+    item = sm_enum_get_name(items, idx);
+    if (!object_name || !item)
+    {
+        return;
+    }
+    name = g_strconcat(object_name, "/item", NULL);
+    g_variant_builder_add(builder, "{sv}", name, g_variant_new_string(item));
+    g_free(name);
+}
+
+void
+sm_controls_add_object(GVariantBuilder *builder, GObject *object)
+{
+    SmChannel *ch;
+    gchar *prefix;
+
+    if (SM_IS_CHANNEL(object))
+    {
+        ch = SM_CHANNEL(object);
+        if (!sm_controls_is_stereo(ch))
+        {
+            sm_controls_add_channel_side(builder, ch, SND_MIXER_SCHN_MONO, sm_channel_get_name(ch));
+            return;
+        }
+        prefix = g_strconcat(sm_channel_get_name(ch), "/left", NULL);
+        sm_controls_add_channel_side(builder, ch, SND_MIXER_SCHN_FRONT_LEFT, prefix);
+        g_free(prefix);
+        prefix = g_strconcat(sm_channel_get_name(ch), "/right", NULL);
+        sm_controls_add_channel_side(builder, ch, SND_MIXER_SCHN_FRONT_RIGHT, prefix);
+        g_free(prefix);
+    }
+    else if (SM_IS_SOURCE(object))
+    {
+        sm_controls_add_item(builder, sm_source_get_name(SM_SOURCE(object)),
+                sm_source_get_items(SM_SOURCE(object)),
+                sm_source_get_selected_item_index(SM_SOURCE(object)));
+    }
+    else if (SM_IS_SWITCH(object))
+    {
+        sm_controls_add_item(builder, sm_switch_get_name(SM_SWITCH(object)),
+                sm_switch_get_items(SM_SWITCH(object)),
+                sm_switch_get_selected_item_index(SM_SWITCH(object)));
+    }
+}
+
+GVariant*
+sm_controls_get_state(SmApp *app)
+{
+    GVariantBuilder builder;
+    GList *item;
+
+    g_variant_builder_init(&builder, G_VARIANT_TYPE_VARDICT);
+    for (item = g_list_first(sm_app_get_channels(app)); item; item = g_list_next(item))
+    {
+        sm_controls_add_object(&builder, G_OBJECT(item->data));
+    }
+    for (item = g_list_first(sm_app_get_input_sources(app)); item; item = g_list_next(item))
+    {
+        sm_controls_add_object(&builder, G_OBJECT(item->data));
+    }
+    for (item = g_list_first(sm_app_get_input_switches(app)); item; item = g_list_next(item))
+    {
+        sm_controls_add_object(&builder, G_OBJECT(item->data));
+    }
+    if (sm_app_get_clock_source(app))
+    {
+        sm_controls_add_object(&builder, G_OBJECT(sm_app_get_clock_source(app)));
+    }
+    if (sm_app_get_sync_status(app))
+    {
+        sm_controls_add_object(&builder, G_OBJECT(sm_app_get_sync_status(app)));
+    }
+    return g_variant_builder_end(&builder);
+}
+
+static SmChannel*
+sm_controls_find_channel(SmApp *app, const gchar *name, snd_mixer_selem_channel_id_t *side)
+{
+    GList *item;
+    SmChannel *ch;
+    gsize len;
+    const gchar *suffix;
+
+    for (item = g_list_first(sm_app_get_channels(app)); item; item = g_list_next(item))
+    {
+        ch = SM_CHANNEL(item->data);
+        len = strlen(sm_channel_get_name(ch));
+        if (strncmp(name, sm_channel_get_name(ch), len) != 0)
+        {
+            continue;
+        }
+        suffix = name + len;
+        if (!sm_controls_is_stereo(ch))
+        {
+            if (*suffix == '\0')
+            {
+                *side = SND_MIXER_SCHN_MONO;
+                return ch;
+            }
+        }
+        else if (g_strcmp0(suffix, "/left") == 0)
+        {
+            *side = SND_MIXER_SCHN_FRONT_LEFT;
+            return ch;
+        }
+        else if (g_strcmp0(suffix, "/right") == 0)
+        {
+            *side = SND_MIXER_SCHN_FRONT_RIGHT;
+            return ch;
+        }
+    }
+    return NULL;
+}
+
+static GObject*
+sm_controls_find_item_object(SmApp *app, const gchar *name)
+{
+    GList *item;
+    SmSwitch *sw;
+
+    for (item = g_list_first(sm_app_get_input_sources(app)); item; item = g_list_next(item))
+    {
+        if (g_strcmp0(sm_source_get_name(SM_SOURCE(item->data)), name) == 0)
+        {
+            return G_OBJECT(item->data);
+        }
+    }
+    for (item = g_list_first(sm_app_get_input_switches(app)); item; item = g_list_next(item))
+    {
+        if (g_strcmp0(sm_switch_get_name(SM_SWITCH(item->data)), name) == 0)
+        {
+            return G_OBJECT(item->data);
+        }
+    }
+    sw = sm_app_get_clock_source(app);
+    if (sw && g_strcmp0(sm_switch_get_name(sw), name) == 0)
+    {
+        return G_OBJECT(sw);
+    }
+    sw = sm_app_get_sync_status(app);
+    if (sw && g_strcmp0(sm_switch_get_name(sw), name) == 0)
+    {
+        return G_OBJECT(sw);
+    }
+    return NULL;
+}
+
+static gboolean
+sm_controls_check_type(const gchar *name, GVariant *value, const GVariantType *type, GError **err)
+{
+    if (!g_variant_is_of_type(value, type))
+    {
+        g_set_error(err, SM_CONTROLS_ERROR, SM_CONTROLS_ERROR_INVALID_VALUE,
+                "Control %s expects a value of type %.*s, not %s.", name,
+                (int)g_variant_type_get_string_length(type), g_variant_type_peek_string(type),
+                g_variant_get_type_string(value));
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static gboolean
+sm_controls_check_item(const gchar *name, const gchar * const *items, GVariant *value,
+        gint *idx, GError **err)
+{
+    if (!sm_controls_check_type(name, value, G_VARIANT_TYPE_STRING, err))
+    {
+        return FALSE;
+    }
+    *idx = sm_enum_find(items, g_variant_get_string(value, NULL));
+    if (*idx < 0)
+    {
+        g_set_error(err, SM_CONTROLS_ERROR, SM_CONTROLS_ERROR_INVALID_VALUE,
+                "Control %s has no item %s.", name, g_variant_get_string(value, NULL));
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/*
+ * Find the mixer object and property of a control name.
+ */
+static gboolean
+sm_controls_resolve(SmApp *app, const gchar *name, SmControlsChange *change)
+{
+    const gchar *prop;
+    gchar *object_name;
+    SmChannel *ch;
+
+    memset(change, 0, sizeof(SmControlsChange));
+    prop = name ? strrchr(name, '/') : NULL;
+    if (!prop)
+    {
+        return FALSE;
+    }
+    object_name = g_strndup(name, prop - name);
+    prop++;
+    if (g_strcmp0(prop, "item") == 0)
+    {
+        change->object = sm_controls_find_item_object(app, object_name);
+        change->prop = SM_CONTROLS_PROP_ITEM;
+        g_free(object_name);
+        return change->object != NULL;
+    }
+    ch = sm_controls_find_channel(app, object_name, &change->side);
+    g_free(object_name);
+    if (!ch)
+    {
+        return FALSE;
+    }
+    change->object = G_OBJECT(ch);
+    if (g_strcmp0(prop, "volume") == 0 && sm_channel_has_volume(ch, change->side))
+    {
+        change->prop = SM_CONTROLS_PROP_VOLUME;
+        return TRUE;
+    }
+    if (g_strcmp0(prop, "mute") == 0 && sm_channel_has_volume_mute(ch, change->side))
+    {
+        change->prop = SM_CONTROLS_PROP_MUTE;
+        return TRUE;
+    }
+    if (g_strcmp0(prop, "source") == 0 && sm_channel_has_source(ch, change->side))
+    {
+        change->prop = SM_CONTROLS_PROP_SOURCE;
+        return TRUE;
+    }
+    return FALSE;
+}
+
+static const gchar * const *
+sm_controls_get_items(SmControlsChange *change)
+{
+    if (change->prop == SM_CONTROLS_PROP_SOURCE)
+    {
+        return sm_channel_source_get_items(SM_CHANNEL(change->object), change->side);
+    }
+    if (SM_IS_SOURCE(change->object))
+    {
+        return sm_source_get_items(SM_SOURCE(change->object));
+    }
+    return sm_switch_get_items(SM_SWITCH(change->object));
+}
+
+/*
+ * Get the volume taper the faders of a channel use.
+ */
+static const SmTaper*
+sm_controls_get_taper(SmChannel *ch)
+{
+    gdouble min_db, max_db, step_db;
+
+    min_db = max_db = step_db = 0.0;
+    if (sm_channel_volume_get_range_db(ch, &min_db, &max_db))
+    {
+        sm_channel_volume_get_step_db(ch, &step_db);
+    }
+    return sm_taper_get_default(min_db, max_db, step_db);
+}
+
+static gboolean
+sm_controls_check(SmApp *app, const gchar *name, GVariant *value,
+        SmControlsChange *change, GError **err)
+{
+    gdouble min_db, max_db;
+
+    if (!sm_controls_resolve(app, name, change))
+    {
+        g_set_error(err, SM_CONTROLS_ERROR, SM_CONTROLS_ERROR_NOT_FOUND,
+                "No control %s.", name);
+        return FALSE;
+    }
+    switch (change->prop)
+    {
+        case SM_CONTROLS_PROP_VOLUME:
+            if (!sm_controls_check_type(name, value, G_VARIANT_TYPE_DOUBLE, err))
+            {
+                return FALSE;
+            }
+            change->vol_db = g_variant_get_double(value);
+            if (sm_channel_volume_get_range_db(SM_CHANNEL(change->object), &min_db, &max_db)
+                    && (change->vol_db < min_db || change->vol_db > max_db))
+            {
+                g_set_error(err, SM_CONTROLS_ERROR, SM_CONTROLS_ERROR_INVALID_VALUE,
+                        "Volume %.2f dB of %s is out of range %.2f dB .. %.2f dB.",
+                        change->vol_db, name, min_db, max_db);
+                return FALSE;
+            }
+            return TRUE;
+        case SM_CONTROLS_PROP_MUTE:
+            if (!sm_controls_check_type(name, value, G_VARIANT_TYPE_BOOLEAN, err))
+            {
+                return FALSE;
+            }
+            change->value = g_variant_get_boolean(value);
+            return TRUE;
+        case SM_CONTROLS_PROP_ITEM:
+            if (SM_IS_SWITCH(change->object)
+                    && sm_switch_get_switch_type(SM_SWITCH(change->object)) == SM_SWITCH_SYNC_STATUS)
+            {
+                g_set_error(err, SM_CONTROLS_ERROR, SM_CONTROLS_ERROR_READ_ONLY,
+                        "Control %s is read-only.", name);
+                return FALSE;
+            }
+            /* fall through */
+        case SM_CONTROLS_PROP_SOURCE:
+        default:
+            return sm_controls_check_item(name, sm_controls_get_items(change),
+                    value, &change->value, err);
+    }
+}
+
+static gboolean
+sm_controls_apply(SmControlsChange *change)
+{
+    switch (change->prop)
+    {
+        case SM_CONTROLS_PROP_VOLUME:
+            return sm_channel_volume_set_db(SM_CHANNEL(change->object), change->side, change->vol_db);
+        case SM_CONTROLS_PROP_MUTE:
+            // Set mute state: 0 = Muted, 1 = Unmuted
+            return sm_channel_volume_set_mute(SM_CHANNEL(change->object), change->side,
+                    change->value ? 0 : 1);
+        case SM_CONTROLS_PROP_SOURCE:
+            return sm_channel_source_set_selected_item_index(SM_CHANNEL(change->object),
+                    change->side, change->value);
+        case SM_CONTROLS_PROP_ITEM:
+            if (SM_IS_SOURCE(change->object))
+            {
+                return sm_source_set_selected_item_index(SM_SOURCE(change->object), change->value);
+            }
+            return sm_switch_set_selected_item_index(SM_SWITCH(change->object), change->value);
+        default:
+            return FALSE;
+    }
+}
+
+static gboolean
+sm_controls_check_all(SmApp *app, GVariant *controls, GArray *changes, GError **err)
+{
+    GVariantIter iter;
+    GVariant *value;
+    SmControlsChange change;
+    const gchar *name;
+
+    if (sm_app_get_card_number(app) < 0)
+    {
+        g_set_error(err, SM_CONTROLS_ERROR, SM_CONTROLS_ERROR_DETACHED,
+                "The mixer is not open.");
+        return FALSE;
+    }
+    g_variant_iter_init(&iter, controls);
+    while (g_variant_iter_next(&iter, "{&sv}", &name, &value))
+    {
+        if (!sm_controls_check(app, name, value, &change, err))
+        {
+            g_variant_unref(value);
+            return FALSE;
+        }
+        g_variant_unref(value);
+        if (changes)
+        {
+            g_array_append_val(changes, change);
+        }
+    }
+    return TRUE;
+}
+
+gboolean
+sm_controls_validate(SmApp *app, GVariant *controls, GError **err)
+{
+    return sm_controls_check_all(app, controls, NULL, err);
+}
+
+gboolean
+sm_controls_set(SmApp *app, GVariant *controls, GError **err)
+{
+    GArray *changes;
+    const gchar *failed;
+    guint idx;
+
+    // Check all controls before the first one is written.
+    changes = g_array_sized_new(FALSE, FALSE, sizeof(SmControlsChange), g_variant_n_children(controls));
+    if (!sm_controls_check_all(app, controls, changes, err))
+    {
+        g_array_free(changes, TRUE);
+        return FALSE;
+    }
+    failed = NULL;
+    for (idx = 0; idx < changes->len; idx++)
+    {
+        if (!sm_controls_apply(&g_array_index(changes, SmControlsChange, idx)) && !failed)
+        {
+            failed = "Could not write all controls to the mixer.";
+        }
+    }
+    g_array_free(changes, TRUE);
+    if (failed)
+    {
+        g_set_error_literal(err, SM_CONTROLS_ERROR, SM_CONTROLS_ERROR_FAILED, failed);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+gchar*
+sm_controls_get_channel_control_name(SmChannel *ch, snd_mixer_selem_channel_id_t side, const gchar *prop)
+{
+    if (!sm_controls_is_stereo(ch))
+    {
+        return g_strconcat(sm_channel_get_name(ch), "/", prop, NULL);
+    }
+    return g_strconcat(sm_channel_get_name(ch),
+            side == SND_MIXER_SCHN_FRONT_RIGHT ? "/right/" : "/left/", prop, NULL);
+}
+
+GVariant*
+sm_controls_value_from_fraction(SmApp *app, const gchar *name, gdouble fraction)
+{
+    SmControlsChange change;
+    const SmTaper *taper;
+    const gchar * const *items;
+    gdouble lower, upper;
+    guint n_items;
+
+    if (!sm_controls_resolve(app, name, &change))
+    {
+        return NULL;
+    }
+    fraction = CLAMP(fraction, 0.0, 1.0);
+    switch (change.prop)
+    {
+        case SM_CONTROLS_PROP_VOLUME:
+            taper = sm_controls_get_taper(SM_CHANNEL(change.object));
+            lower = sm_taper_get_lower(taper);
+            upper = sm_taper_get_upper(taper);
+            return g_variant_new_double(sm_taper_value_to_db(taper, lower + fraction * (upper - lower)));
+        case SM_CONTROLS_PROP_MUTE:
+            return g_variant_new_boolean(fraction >= 0.5);
+        default:
+            items = sm_controls_get_items(&change);
+            n_items = items ? g_strv_length((gchar**)items) : 0;
+            if (n_items == 0)
+            {
+                return NULL;
+            }
+            return g_variant_new_string(items[MIN((guint)(fraction * n_items), n_items - 1)]);
+    }
+}
+
+gboolean
+sm_controls_value_to_fraction(SmApp *app, const gchar *name, GVariant *value, gdouble *fraction)
+{
+    SmControlsChange change;
+    const SmTaper *taper;
+    const gchar * const *items;
+    gdouble lower, upper;
+    guint n_items;
+    gint idx;
+
+    if (!sm_controls_check(app, name, value, &change, NULL))
+    {
+        return FALSE;
+    }
+    switch (change.prop)
+    {
+        case SM_CONTROLS_PROP_VOLUME:
+            taper = sm_controls_get_taper(SM_CHANNEL(change.object));
+            lower = sm_taper_get_lower(taper);
+            upper = sm_taper_get_upper(taper);
+            *fraction = upper > lower ? (sm_taper_db_to_value(taper, change.vol_db) - lower) / (upper - lower) : 0.0;
+            return TRUE;
+        case SM_CONTROLS_PROP_MUTE:
+            *fraction = change.value ? 1.0 : 0.0;
+            return TRUE;
+        default:
+            items = sm_controls_get_items(&change);
+            n_items = g_strv_length((gchar**)items);
+            idx = change.value;
+            *fraction = n_items > 1 ? (gdouble)idx / (n_items - 1) : 0.0;
+            return TRUE;
+    }
+}
+
+static gchar*
+sm_controls_get_scene_dirname()
+{
+    return g_build_filename(g_get_user_config_dir(), PACKAGE, "scenes", NULL);
+}
+
+static gchar*
+sm_controls_get_scene_filename(const gchar *name, GError **err)
+{
+    gchar *dirname, *basename, *filename;
+
+    if (!name || !*name || name[0] == '.' || strchr(name, G_DIR_SEPARATOR))
+    {
+        g_set_error(err, SM_CONTROLS_ERROR, SM_CONTROLS_ERROR_INVALID_VALUE,
+                "Invalid scene name \"%s\".", name ? name : "");
+        return NULL;
+    }
+    dirname = sm_controls_get_scene_dirname();
+    basename = g_strconcat(name, SM_CONTROLS_SCENE_SUFFIX, NULL);
+    filename = g_build_filename(dirname, basename, NULL);
+    g_free(basename);
+    g_free(dirname);
+    return filename;
+}
+
+static gint
+sm_controls_compare_names(gconstpointer a, gconstpointer b)
+{
+    return g_strcmp0(*(const gchar * const *)a, *(const gchar * const *)b);
+}
+
+gchar**
+sm_controls_list_scenes()
+{
+    GPtrArray *names;
+    GDir *dir;
+    gchar *dirname;
+    const gchar *basename;
+
+    names = g_ptr_array_new();
+    dirname = sm_controls_get_scene_dirname();
+    dir = g_dir_open(dirname, 0, NULL);
+    g_free(dirname);
+    if (dir)
+    {
+        while ((basename = g_dir_read_name(dir)))
+        {
+            if (basename[0] != '.' && g_str_has_suffix(basename, SM_CONTROLS_SCENE_SUFFIX))
+            {
+                g_ptr_array_add(names, g_strndup(basename,
+                        strlen(basename) - strlen(SM_CONTROLS_SCENE_SUFFIX)));
+            }
+        }
+        g_dir_close(dir);
+    }
+    g_ptr_array_sort(names, sm_controls_compare_names);
+    g_ptr_array_add(names, NULL);
+    return (gchar**)g_ptr_array_free(names, FALSE);
+}
+
+gboolean
+sm_controls_save_scene(SmApp *app, const gchar *name, GError **err)
+{
+    gchar *filename, *dirname;
+    gboolean ret;
+
+    if (sm_app_get_card_number(app) < 0)
+    {
+        g_set_error(err, SM_CONTROLS_ERROR, SM_CONTROLS_ERROR_DETACHED,
+                "The mixer is not open.");
+        return FALSE;
+    }
+    filename = sm_controls_get_scene_filename(name, err);
+    if (!filename)
+    {
+        return FALSE;
+    }
+    dirname = g_path_get_dirname(filename);
+    g_mkdir_with_parents(dirname, 0700);
+    g_free(dirname);
+    ret = sm_app_write_config_file(app, filename, err);
+    g_free(filename);
+    return ret;
+}
+
+gboolean
+sm_controls_recall_scene(SmApp *app, const gchar *name, GError **err)
+{
+    gchar *filename;
+    gboolean ret;
+
+    if (sm_app_get_card_number(app) < 0)
+    {
+        g_set_error(err, SM_CONTROLS_ERROR, SM_CONTROLS_ERROR_DETACHED,
+                "The mixer is not open.");
+        return FALSE;
+    }
+    filename = sm_controls_get_scene_filename(name, err);
+    if (!filename)
+    {
+        return FALSE;
+    }
+    if (!g_file_test(filename, G_FILE_TEST_IS_REGULAR))
+    {
+        g_set_error(err, SM_CONTROLS_ERROR, SM_CONTROLS_ERROR_NOT_FOUND,
+                "No scene %s.", name);
+        g_free(filename);
+        return FALSE;
+    }
+    ret = sm_app_read_config_file(app, filename, err);
+    g_free(filename);
+    return ret;
+}
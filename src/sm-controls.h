@@ -0,0 +1,147 @@
+#ifndef __SM_CONTROLS_H__
+#define __SM_CONTROLS_H__
+/**
+ * @file
+ * @brief Header file for the named controls of the mixer objects.
+ *
+ * Remote control interfaces address the mixer objects of the application by
+ * control name instead of walking the object lists:
+ * * `<channel>[/left|/right]/volume`: Volume in dB (double).
+ * * `<channel>[/left|/right]/mute`: TRUE if muted (boolean).
+ * * `<channel>[/left|/right]/source`: Name of the selected source item (string).
+ * * `<source or switch>/item`: Name of the selected item (string).
+ *
+ * Object names are the ALSA mixer element names. The `/left` and `/right`
+ * parts are only present for stereo channels.
+ *
+ * Scenes are configuration files (see @ref sm_app_write_config_file) stored
+ * by name in the `scenes` directory of the user configuration directory.
+ */
+#include <glib.h>
+#include <glib-object.h>
+
+#include "sm-app.h"
+#include "sm-channel.h"
+
+G_BEGIN_DECLS
+
+/**
+ * @brief Error domain of the control functions.
+ */
+#define SM_CONTROLS_ERROR sm_controls_error_quark()
+
+/**
+ * @brief Error codes of @ref SM_CONTROLS_ERROR.
+ */
+typedef enum
+{
+    SM_CONTROLS_ERROR_NOT_FOUND, ///< There is no control or scene with this name.
+    SM_CONTROLS_ERROR_INVALID_VALUE, ///< The value has the wrong type or is out of range.
+    SM_CONTROLS_ERROR_READ_ONLY, ///< The control cannot be set.
+    SM_CONTROLS_ERROR_DETACHED, ///< The mixer objects are not attached to the mixer.
+    SM_CONTROLS_ERROR_FAILED, ///< Writing to the mixer failed.
+    SM_CONTROLS_N_ERRORS ///< Number of error codes.
+} SmControlsError;
+
+/**
+ * @brief Get the error domain of the control functions.
+ * The error codes are registered as D-Bus errors named
+ * `org.alsa.scarlettmixer.Error.<Code>`.
+ * @return The error quark.
+ */
+GQuark       sm_controls_error_quark();
+
+/**
+ * @brief Get the values of all controls.
+ * @param app The application object.
+ * @return Floating GVariant of type a{sv} mapping control names to values.
+ */
+GVariant    *sm_controls_get_state(SmApp *app);
+
+/**
+ * @brief Add the controls of a single mixer object to a dictionary.
+ * @param builder GVariantBuilder of type a{sv}.
+ * @param object The @ref _SmChannel, @ref _SmSource or @ref _SmSwitch.
+ */
+void         sm_controls_add_object(GVariantBuilder *builder, GObject *object);
+
+/**
+ * @brief Check names and values of several controls without writing them.
+ * @param app The application object.
+ * @param controls GVariant of type a{sv} mapping control names to values.
+ * @param err The GError that will be initialized in case of an error.
+ * @return TRUE if @ref sm_controls_set() would accept the controls, FALSE otherwise.
+ */
+gboolean     sm_controls_validate(SmApp *app, GVariant *controls, GError **err);
+
+/**
+ * @brief Set several controls as one transaction.
+ * All names and values are checked before the first control is written, so
+ * an invalid entry leaves the mixer unchanged. A failing write of the mixer
+ * does not undo the controls written before.
+ * @param app The application object.
+ * @param controls GVariant of type a{sv} mapping control names to values.
+ * @param err The GError that will be initialized in case of an error.
+ * @return TRUE on success, FALSE otherwise.
+ */
+gboolean     sm_controls_set(SmApp *app, GVariant *controls, GError **err);
+
+/**
+ * @brief Get the name of a channel control.
+ * @param ch The @ref _SmChannel.
+ * @param side The channel side, ignored for mono channels.
+ * @param prop The property: `volume`, `mute` or `source`.
+ * @return The control name, free with g_free().
+ */
+gchar       *sm_controls_get_channel_control_name(SmChannel *ch, snd_mixer_selem_channel_id_t side,
+                                                  const gchar *prop);
+
+/**
+ * @brief Map a fraction of the travel of a control surface to a control value.
+ * Volumes follow the fader law of the volume faders, items are spread evenly.
+ * @param app The application object.
+ * @param name The control name.
+ * @param fraction Position of the control surface from 0.0 to 1.0.
+ * @return Floating GVariant holding the value, or NULL if there is no such control.
+ */
+GVariant    *sm_controls_value_from_fraction(SmApp *app, const gchar *name, gdouble fraction);
+
+/**
+ * @brief Map a control value to a fraction of the travel of a control surface.
+ * This is the inverse of @ref sm_controls_value_from_fraction().
+ * @param app The application object.
+ * @param name The control name.
+ * @param value The control value.
+ * @param fraction Return location of the position from 0.0 to 1.0.
+ * @return TRUE on success, FALSE if the control or value is invalid.
+ */
+gboolean     sm_controls_value_to_fraction(SmApp *app, const gchar *name, GVariant *value,
+                                           gdouble *fraction);
+
+/**
+ * @brief Get the names of the stored scenes.
+ * @return Sorted NULL terminated array of scene names, free with g_strfreev().
+ */
+gchar      **sm_controls_list_scenes();
+
+/**
+ * @brief Store the current configuration as scene.
+ * @param app The application object.
+ * @param name The scene name, must not contain a path separator.
+ * @param err The GError that will be initialized in case of an error.
+ * @return TRUE on success, FALSE otherwise.
+ */
+gboolean     sm_controls_save_scene(SmApp *app, const gchar *name, GError **err);
+
+/**
+ * @brief Apply a stored scene.
+ * @param app The application object.
+ * @param name The scene name.
+ * @param err The GError that will be initialized in case of an error.
+ * @return TRUE on success, FALSE otherwise.
+ */
+gboolean     sm_controls_recall_scene(SmApp *app, const gchar *name, GError **err);
+
+G_END_DECLS
+
+#endif /* __SM_CONTROLS_H__ */
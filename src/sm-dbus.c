@@ -0,0 +1,251 @@
+/*
+ * sm-dbus.c - D-Bus control interface.
+ * Copyright (c) 2016 Martin Roesch <martin.roesch79@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "sm-dbus.h"
+#include "sm-controls.h"
+#include "sm-controls-monitor.h"
+
+#define SM_DBUS_INTERFACE "org.alsa.scarlettmixer.Mixer" ///< Name of the exported interface.
+
+static const gchar sm_dbus_introspection_xml[] =
+    "<node>"
+    "  <interface name='" SM_DBUS_INTERFACE "'>"
+    "    <method name='GetState'>"
+    "      <arg type='a{sv}' name='controls' direction='out'/>"
+    "    </method>"
+    "    <method name='SetControls'>"
+    "      <arg type='a{sv}' name='controls' direction='in'/>"
+    "    </method>"
+    "    <method name='ListScenes'>"
+    "      <arg type='as' name='names' direction='out'/>"
+    "    </method>"
+    "    <method name='SaveScene'>"
+    "      <arg type='s' name='name' direction='in'/>"
+    "    </method>"
+    "    <method name='RecallScene'>"
+    "      <arg type='s' name='name' direction='in'/>"
+    "    </method>"
+    "    <signal name='ControlsChanged'>"
+    "      <arg type='a{sv}' name='controls'/>"
+    "    </signal>"
+    "    <property name='CardName' type='s' access='read'/>"
+    "  </interface>"
+    "</node>";
+
+/**
+ * @brief Structure holding the state of the D-Bus service.
+ */
+struct _SmDBusService
+{
+    GObject parent_instance; ///< Parent object.
+
+    /* Other members, including private data. */
+    SmApp *app; ///< The application object (not referenced, it owns the service).
+    GDBusNodeInfo *node_info; ///< Parsed introspection data.
+    GDBusConnection *connection; ///< Connection the interface is exported on, or NULL.
+    gchar *object_path; ///< Object path of the exported interface.
+    guint registration_id; ///< Registration ID of the exported interface, or 0.
+    SmControlsMonitor *monitor; ///< Monitor announcing the changed controls.
+};
+
+G_DEFINE_TYPE(SmDBusService, sm_dbus_service, G_TYPE_OBJECT);
+
+static void
+sm_dbus_service_controls_changed_cb(SmControlsMonitor *monitor, GVariant *controls, gpointer user_data)
+{
+    SmDBusService *self = SM_DBUS_SERVICE(user_data);
+    GError *err = NULL;
+
+    if (!self->connection)
+    {
+        return;
+    }
+    if (!g_dbus_connection_emit_signal(self->connection, NULL, self->object_path,
+            SM_DBUS_INTERFACE, "ControlsChanged",
+            g_variant_new("(@a{sv})", controls), &err))
+    {
+        g_warning("Could not emit ControlsChanged: %s", err->message);
+        g_error_free(err);
+    }
+}
+
+static void
+sm_dbus_service_method_call(GDBusConnection *connection,
+        const gchar *sender,
+        const gchar *object_path,
+        const gchar *interface_name,
+        const gchar *method_name,
+        GVariant *parameters,
+        GDBusMethodInvocation *invocation,
+        gpointer user_data)
+{
+    SmDBusService *self = SM_DBUS_SERVICE(user_data);
+    GVariant *controls;
+    const gchar *name;
+    gchar **names;
+    GError *err = NULL;
+    gboolean ret;
+
+    g_debug("sm_dbus_service_method_call: %s from %s", method_name, sender);
+    if (g_strcmp0(method_name, "GetState") == 0)
+    {
+        g_dbus_method_invocation_return_value(invocation,
+                g_variant_new("(@a{sv})", sm_controls_get_state(self->app)));
+        return;
+    }
+    if (g_strcmp0(method_name, "ListScenes") == 0)
+    {
+        names = sm_controls_list_scenes();
+        g_dbus_method_invocation_return_value(invocation,
+                g_variant_new("(^as)", names));
+        g_strfreev(names);
+        return;
+    }
+    if (g_strcmp0(method_name, "SetControls") == 0)
+    {
+        g_variant_get(parameters, "(@a{sv})", &controls);
+        ret = sm_controls_set(self->app, controls, &err);
+        g_variant_unref(controls);
+    }
+    else if (g_strcmp0(method_name, "SaveScene") == 0)
+    {
+        g_variant_get(parameters, "(&s)", &name);
+        ret = sm_controls_save_scene(self->app, name, &err);
+    }
+    else if (g_strcmp0(method_name, "RecallScene") == 0)
+    {
+        g_variant_get(parameters, "(&s)", &name);
+        ret = sm_controls_recall_scene(self->app, name, &err);
+    }
+    else
+    {
+        g_dbus_method_invocation_return_error(invocation, G_DBUS_ERROR,
+                G_DBUS_ERROR_UNKNOWN_METHOD, "Unknown method %s.", method_name);
+        return;
+    }
+    if (!ret)
+    {
+        g_dbus_method_invocation_take_error(invocation, err);
+        return;
+    }
+    g_dbus_method_invocation_return_value(invocation, NULL);
+}
+
+static GVariant*
+sm_dbus_service_get_property(GDBusConnection *connection,
+        const gchar *sender,
+        const gchar *object_path,
+        const gchar *interface_name,
+        const gchar *property_name,
+        GError **error,
+        gpointer user_data)
+{
+    SmDBusService *self = SM_DBUS_SERVICE(user_data);
+    const gchar *card_name;
+
+    if (g_strcmp0(property_name, "CardName") == 0)
+    {
+        card_name = sm_app_get_card_name(self->app);
+        return g_variant_new_string(card_name ? card_name : "");
+    }
+    g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_PROPERTY,
+            "Unknown property %s.", property_name);
+    return NULL;
+}
+
+static const GDBusInterfaceVTable sm_dbus_service_vtable =
+{
+    sm_dbus_service_method_call,
+    sm_dbus_service_get_property,
+    NULL
+};
+
+static void
+sm_dbus_service_dispose(GObject *object)
+{
+    SmDBusService *self = SM_DBUS_SERVICE(object);
+
+    sm_dbus_service_unregister(self);
+    g_clear_object(&self->monitor);
+    G_OBJECT_CLASS(sm_dbus_service_parent_class)->dispose(object);
+}
+
+static void
+sm_dbus_service_finalize(GObject *object)
+{
+    SmDBusService *self = SM_DBUS_SERVICE(object);
+
+    g_dbus_node_info_unref(self->node_info);
+    G_OBJECT_CLASS(sm_dbus_service_parent_class)->finalize(object);
+}
+
+static void
+sm_dbus_service_class_init(SmDBusServiceClass *klass)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS(klass);
+
+    object_class->dispose = sm_dbus_service_dispose;
+    object_class->finalize = sm_dbus_service_finalize;
+}
+
+static void
+sm_dbus_service_init(SmDBusService *self)
+{
+    self->node_info = g_dbus_node_info_new_for_xml(sm_dbus_introspection_xml, NULL);
+}
+
+SmDBusService*
+sm_dbus_service_new(SmApp *app)
+{
+    SmDBusService *self;
+
+    self = g_object_new(SM_TYPE_DBUS_SERVICE, NULL);
+    self->app = app;
+    self->monitor = sm_controls_monitor_new(app, 0);
+    g_signal_connect(self->monitor, "changed", G_CALLBACK(sm_dbus_service_controls_changed_cb), self);
+    return self;
+}
+
+gboolean
+sm_dbus_service_register(SmDBusService *self, GDBusConnection *connection,
+        const gchar *object_path, GError **err)
+{
+    sm_dbus_service_unregister(self);
+    self->registration_id = g_dbus_connection_register_object(connection, object_path,
+            self->node_info->interfaces[0], &sm_dbus_service_vtable, self, NULL, err);
+    if (!self->registration_id)
+    {
+        return FALSE;
+    }
+    self->connection = g_object_ref(connection);
+    self->object_path = g_strdup(object_path);
+    g_debug("sm_dbus_service_register: %s", object_path);
+    return TRUE;
+}
+
+void
+sm_dbus_service_unregister(SmDBusService *self)
+{
+    if (self->registration_id)
+    {
+        g_dbus_connection_unregister_object(self->connection, self->registration_id);
+        self->registration_id = 0;
+    }
+    g_clear_object(&self->connection);
+    g_clear_pointer(&self->object_path, g_free);
+}
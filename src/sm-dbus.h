@@ -0,0 +1,60 @@
+#ifndef __SM_DBUS_H__
+#define __SM_DBUS_H__
+/**
+ * @file
+ * @brief Header file for the D-Bus control interface.
+ *
+ * The `org.alsa.scarlettmixer.Mixer` interface is exported on the object
+ * path of the application. It gives access to the named controls (see
+ * sm-controls.h) in batches:
+ * * `GetState() -> a{sv}`: Values of all controls.
+ * * `SetControls(a{sv})`: Set several controls as one transaction.
+ * * `ListScenes() -> as`, `SaveScene(s)`, `RecallScene(s)`: Scenes.
+ * * `ControlsChanged(a{sv})` signal: The controls changed since the last
+ *   emission. Changes are collected until the main loop is idle, so a batch
+ *   of changes is announced by a single signal.
+ * * `CardName` property: Name of the sound card.
+ */
+#include <gio/gio.h>
+
+#include "sm-app.h"
+
+G_BEGIN_DECLS
+
+/**
+ * @brief Macro to get the type information of the D-Bus service.
+ */
+#define SM_TYPE_DBUS_SERVICE sm_dbus_service_get_type()
+/**
+ * @brief Macro declaring the final D-Bus service type.
+ */
+G_DECLARE_FINAL_TYPE(SmDBusService, sm_dbus_service, SM, DBUS_SERVICE, GObject);
+
+/**
+ * @brief Create a new D-Bus service.
+ * The service announces the changed controls with a @ref _SmControlsMonitor.
+ * @param app The application object.
+ * @return Pointer to new D-Bus service instance.
+ */
+SmDBusService *sm_dbus_service_new(SmApp *app);
+
+/**
+ * @brief Export the interface on a connection.
+ * @param self The D-Bus service.
+ * @param connection The D-Bus connection.
+ * @param object_path The object path.
+ * @param err The GError that will be initialized in case of an error.
+ * @return TRUE on success, FALSE otherwise.
+ */
+gboolean       sm_dbus_service_register(SmDBusService *self, GDBusConnection *connection,
+                                        const gchar *object_path, GError **err);
+
+/**
+ * @brief Remove the interface from the connection.
+ * @param self The D-Bus service.
+ */
+void           sm_dbus_service_unregister(SmDBusService *self);
+
+G_END_DECLS
+
+#endif /* __SM_DBUS_H__ */
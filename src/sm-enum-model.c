@@ -0,0 +1,58 @@
+/*
+ * sm-enum-model.c - Shared tree models for enum item name sets.
+ * Copyright (c) 2016 Martin Roesch <martin.roesch79@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "sm-enum-model.h"
+
+static GHashTable *sm_enum_models = NULL; ///< GtkListStore per interned item name set.
+
+GtkTreeModel *
+sm_enum_model_get(const gchar * const *items)
+{
+    const gchar * const *item;
+    GtkListStore *store;
+    GtkTreeIter iter;
+
+    if (!sm_enum_models)
+    {
+        sm_enum_models = g_hash_table_new(g_direct_hash, g_direct_equal);
+    }
+    // Interned sets are equal if their addresses are equal.
+    store = g_hash_table_lookup(sm_enum_models, items);
+    if (store)
+    {
+        return GTK_TREE_MODEL(store);
+    }
+    // Same columns as GtkComboBoxText: Text and ID.
+    store = gtk_list_store_new(2, G_TYPE_STRING, G_TYPE_STRING);
+    for (item = items; item && *item; item++)
+    {
+        gtk_list_store_insert_with_values(store, &iter, -1, 0, *item, -1);
+    }
+    g_hash_table_insert(sm_enum_models, (gpointer)items, store);
+    return GTK_TREE_MODEL(store);
+}
+
+void
+sm_enum_model_set_combo_box(GtkComboBox *combo, const gchar * const *items, gint active)
+{
+    gtk_combo_box_set_model(combo, items ? sm_enum_model_get(items) : NULL);
+    if (items && active >= 0)
+    {
+        gtk_combo_box_set_active(combo, active);
+    }
+}
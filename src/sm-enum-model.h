@@ -0,0 +1,35 @@
+#ifndef __SM_ENUM_MODEL_H__
+#define __SM_ENUM_MODEL_H__
+/**
+ * @file
+ * @brief Header file for the shared enum item tree models.
+ *
+ * All combo boxes displaying the same interned item name set (see
+ * @ref sm-enum.h) share one GtkListStore. The store has the column layout
+ * of GtkComboBoxText (text and id column), so it can be set as model of a
+ * GtkComboBoxText. The items of such a combo box must not be modified with
+ * the GtkComboBoxText functions, since this would modify all combo boxes.
+ */
+#include <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+/**
+ * @brief Get the shared model of an interned item name set.
+ * The model is created on first use and lives as long as the process.
+ * @param items The interned set.
+ * @return The shared model, owned by the module.
+ */
+GtkTreeModel *sm_enum_model_get(const gchar * const *items);
+
+/**
+ * @brief Display an interned item name set in a combo box.
+ * @param combo The combo box.
+ * @param items The interned set or NULL to clear the combo box.
+ * @param active Index of the item to select, or -1.
+ */
+void          sm_enum_model_set_combo_box(GtkComboBox *combo, const gchar * const *items, gint active);
+
+G_END_DECLS
+
+#endif /* __SM_ENUM_MODEL_H__ */
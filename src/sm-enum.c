@@ -0,0 +1,178 @@
+/*
+ * sm-enum.c - Interned enum item name sets.
+ * Copyright (c) 2016 Martin Roesch <martin.roesch79@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "sm-enum.h"
+
+#define SM_ENUM_NAME_LENGTH (64) ///< Maximal length of an ALSA enum item name.
+
+G_LOCK_DEFINE_STATIC(sm_enum_sets);
+static GHashTable *sm_enum_sets = NULL; ///< Set of interned item name arrays.
+
+static guint
+sm_enum_hash(gconstpointer key)
+{
+    const gchar * const *items = key;
+    guint hash = 5381;
+
+    // The item names are interned, so their addresses identify them.
+    for (; *items; items++)
+    {
+        hash = (hash << 5) + hash + g_direct_hash(*items);
+    }
+    return hash;
+}
+
+static gboolean
+sm_enum_equal(gconstpointer a, gconstpointer b)
+{
+    const gchar * const *items_a = a;
+    const gchar * const *items_b = b;
+
+    for (; *items_a && *items_b; items_a++, items_b++)
+    {
+        if (*items_a != *items_b)
+        {
+            return FALSE;
+        }
+    }
+    return *items_a == *items_b;
+}
+
+/*
+ * Look up the set of interned names and take ownership of the array.
+ */
+static const gchar * const *
+sm_enum_intern_array(const gchar **names)
+{
+    const gchar **items;
+
+    G_LOCK(sm_enum_sets);
+    if (!sm_enum_sets)
+    {
+        sm_enum_sets = g_hash_table_new(sm_enum_hash, sm_enum_equal);
+    }
+    items = g_hash_table_lookup(sm_enum_sets, names);
+    if (items)
+    {
+        g_free(names);
+    }
+    else
+    {
+        items = names;
+        g_hash_table_add(sm_enum_sets, items);
+    }
+    G_UNLOCK(sm_enum_sets);
+    return items;
+}
+
+const gchar * const *
+sm_enum_intern(const gchar * const *items)
+{
+    const gchar **names;
+    guint idx, length;
+
+    if (!items)
+    {
+        return NULL;
+    }
+    length = g_strv_length((gchar**)items);
+    names = g_new0(const gchar*, length + 1);
+    for (idx = 0; idx < length; idx++)
+    {
+        names[idx] = g_intern_string(items[idx]);
+    }
+    return sm_enum_intern_array(names);
+}
+
+const gchar * const *
+sm_enum_intern_elem(snd_mixer_elem_t *elem)
+{
+    const gchar **names;
+    gchar buf[SM_ENUM_NAME_LENGTH];
+    int idx, length, err;
+
+    length = snd_mixer_selem_get_enum_items(elem);
+    if (length < 0)
+    {
+        g_warning("sm_enum_intern_elem: Cannot get enum items: %s", snd_strerror(length));
+        return NULL;
+    }
+    names = g_new0(const gchar*, length + 1);
+    for (idx = 0; idx < length; idx++)
+    {
+        err = snd_mixer_selem_get_enum_item_name(elem, idx, sizeof(buf), buf);
+        if (err < 0)
+        {
+            g_warning("sm_enum_intern_elem: Cannot get enum item name: %s", snd_strerror(err));
+            g_free(names);
+            return NULL;
+        }
+        names[idx] = g_intern_string(buf);
+    }
+    return sm_enum_intern_array(names);
+}
+
+const gchar *
+sm_enum_get_name(const gchar * const *items, gint idx)
+{
+    gint i;
+
+    if (!items || idx < 0)
+    {
+        return NULL;
+    }
+    for (i = 0; items[i]; i++)
+    {
+        if (i == idx)
+        {
+            return items[i];
+        }
+    }
+    return NULL;
+}
+
+gint
+sm_enum_find(const gchar * const *items, const gchar *name)
+{
+    gint i;
+
+    if (!items || !name)
+    {
+        return -1;
+    }
+    for (i = 0; items[i]; i++)
+    {
+        if (g_strcmp0(items[i], name) == 0)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+GList *
+sm_enum_to_list(const gchar * const *items)
+{
+    GList *ret = NULL;
+
+    for (; items && *items; items++)
+    {
+        ret = g_list_prepend(ret, g_strdup(*items));
+    }
+    return g_list_reverse(ret);
+}
@@ -0,0 +1,56 @@
+#ifndef __SM_ENUM_H__
+#define __SM_ENUM_H__
+/**
+ * @file
+ * @brief Header file for the interned enum item name sets.
+ *
+ * The sources and switches of a card share a few sets of enum item names.
+ * An item name set is read once per ALSA mixer element and interned: Equal
+ * sets share one NULL terminated array of interned strings, which stays
+ * valid for the lifetime of the process and can be compared by pointer.
+ */
+#include <glib.h>
+#include <alsa/asoundlib.h>
+
+G_BEGIN_DECLS
+
+/**
+ * @brief Intern a set of item names.
+ * @param items NULL terminated array of item names.
+ * @return The interned set, NULL if items is NULL.
+ */
+const gchar * const *sm_enum_intern(const gchar * const *items);
+
+/**
+ * @brief Read and intern the item names of an ALSA enumerated mixer element.
+ * @param elem The ALSA mixer element.
+ * @return The interned set, NULL on error.
+ */
+const gchar * const *sm_enum_intern_elem(snd_mixer_elem_t *elem);
+
+/**
+ * @brief Get the name of an item.
+ * @param items The interned set.
+ * @param idx The item index.
+ * @return The item name or NULL if the index is out of range.
+ */
+const gchar         *sm_enum_get_name(const gchar * const *items, gint idx);
+
+/**
+ * @brief Find an item by name.
+ * @param items The interned set or NULL.
+ * @param name The item name.
+ * @return The item index or -1 if there is no item with this name.
+ */
+gint                 sm_enum_find(const gchar * const *items, const gchar *name);
+
+/**
+ * @brief Copy an interned set to a list.
+ * @param items The interned set or NULL.
+ * @return List of newly allocated item names, free with g_list_free_full().
+ */
+GList               *sm_enum_to_list(const gchar * const *items);
+
+G_END_DECLS
+
+#endif /* __SM_ENUM_H__ */
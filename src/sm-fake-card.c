@@ -0,0 +1,1064 @@
+/*
+ * sm-fake-card.c - In-memory fake sound card.
+ * Copyright (c) 2016 Martin Roesch <martin.roesch79@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <gio/gio.h>
+#include <alsa/mixer_abst.h>
+#include <json-glib/json-glib.h>
+
+#include "sm-fake-card.h"
+#include "sm-metrics.h"
+
+#define SM_FAKE_CARD_MAX_CHANNELS (SND_MIXER_SCHN_LAST + 1) ///< Maximum number of channels of an element.
+
+/**
+ * @brief Type definition for an element of the fake card.
+ */
+typedef struct _SmFakeElem SmFakeElem;
+
+/**
+ * @brief Structure holding an element of the fake card.
+ */
+struct _SmFakeElem
+{
+    sm_selem_t selem; ///< Simple element header, alsa-lib expects it first.
+    SmFakeCard *card; ///< The owning fake card (not referenced).
+    guint weight; ///< Position in the topology, keeps the order of the elements.
+    guint channels; ///< Number of channels.
+    long min; ///< Minimum raw volume.
+    long max; ///< Maximum raw volume.
+    long min_db; ///< Volume in hundredths of a dB at the minimum raw volume.
+    long max_db; ///< Volume in hundredths of a dB at the maximum raw volume.
+    long volume[SM_FAKE_CARD_MAX_CHANNELS]; ///< Raw volume per channel.
+    int sw[SM_FAKE_CARD_MAX_CHANNELS]; ///< Switch per channel.
+    gchar **items; ///< Item names of an enumeration, NULL for other elements.
+    guint n_items; ///< Number of items.
+    gboolean enum_playback; ///< TRUE if the enumeration is a playback enumeration.
+    gboolean enum_capture; ///< TRUE if the enumeration is a capture enumeration.
+    unsigned int item[SM_FAKE_CARD_MAX_CHANNELS]; ///< Selected item per channel.
+    snd_mixer_elem_t *elem; ///< The mixer element, or NULL if not attached.
+    gboolean pending; ///< TRUE if a value change event is queued.
+};
+
+/**
+ * @brief Structure holding the state of the fake card.
+ */
+struct _SmFakeCard
+{
+    GObject parent_instance; ///< Parent object.
+
+    /* Other members, including private data. */
+    gchar *name; ///< Card name.
+    gulong write_latency; ///< Duration of a write in microseconds.
+    GPtrArray *elems; ///< The @ref _SmFakeElem elements in topology order.
+    guint event_source; ///< Idle source delivering the queued events, or 0.
+};
+
+G_DEFINE_TYPE(SmFakeCard, sm_fake_card, G_TYPE_OBJECT);
+
+static SmFakeCard *sm_fake_card_default = NULL;
+static gboolean sm_fake_card_default_loaded = FALSE;
+
+static SmFakeElem*
+sm_fake_elem(snd_mixer_elem_t *elem)
+{
+    return snd_mixer_elem_get_private(elem);
+}
+
+static void
+sm_fake_elem_free(gpointer data)
+{
+    SmFakeElem *fe = data;
+
+    snd_mixer_selem_id_free(fe->selem.id);
+    g_strfreev(fe->items);
+    g_free(fe);
+}
+
+static gboolean
+sm_fake_card_dispatch_cb(gpointer user_data)
+{
+    SmFakeCard *self = SM_FAKE_CARD(user_data);
+    SmFakeElem *fe;
+    gint64 start;
+    guint idx;
+
+    self->event_source = 0;
+    start = g_get_monotonic_time();
+    for (idx = 0; idx < self->elems->len; idx++)
+    {
+        fe = g_ptr_array_index(self->elems, idx);
+        if (fe->pending)
+        {
+            fe->pending = FALSE;
+            if (fe->elem)
+            {
+                snd_mixer_elem_value(fe->elem);
+            }
+        }
+    }
+    // Recorded like the dispatch of the hardware events in snd_mixer_handle_events().
+    sm_metrics_observe_dispatch(g_get_monotonic_time() - start);
+    return G_SOURCE_REMOVE;
+}
+
+static void
+sm_fake_elem_queue_event(SmFakeElem *fe)
+{
+    fe->pending = TRUE;
+    if (!fe->card->event_source)
+    {
+        // Ahead of the idle sources, like the poll of the hardware events.
+        fe->card->event_source = g_idle_add_full(G_PRIORITY_DEFAULT, sm_fake_card_dispatch_cb, fe->card, NULL);
+    }
+}
+
+/*
+ * Simulate the control transfer of a write. The event is delivered from the
+ * main loop, like the events of the hardware arrive through poll.
+ */
+static void
+sm_fake_elem_write(SmFakeElem *fe, gboolean changed)
+{
+    if (fe->card->write_latency)
+    {
+        g_usleep(fe->card->write_latency);
+    }
+    if (changed)
+    {
+        sm_fake_elem_queue_event(fe);
+    }
+}
+
+/*
+ * Called by alsa-lib when the mixer frees the element.
+ */
+static void
+sm_fake_elem_detach(snd_mixer_elem_t *elem)
+{
+    SmFakeElem *fe = sm_fake_elem(elem);
+
+    fe->elem = NULL;
+    fe->pending = FALSE;
+}
+
+static int
+sm_fake_elem_is(snd_mixer_elem_t *elem, int dir, int cmd, int val)
+{
+    SmFakeElem *fe = sm_fake_elem(elem);
+
+    switch (cmd)
+    {
+    case SM_OPS_IS_ACTIVE:
+        return 1;
+    case SM_OPS_IS_MONO:
+        return fe->channels == 1;
+    case SM_OPS_IS_CHANNEL:
+        return val >= 0 && (guint)val < fe->channels;
+    case SM_OPS_IS_ENUMERATED:
+        if (val == 1)
+        {
+            return dir == SM_PLAY ? fe->enum_playback : fe->enum_capture;
+        }
+        return fe->items != NULL;
+    case SM_OPS_IS_ENUMCNT:
+        return fe->n_items;
+    default:
+        return 0;
+    }
+}
+
+static int
+sm_fake_elem_get_range(snd_mixer_elem_t *elem, int dir, long *min, long *max)
+{
+    SmFakeElem *fe = sm_fake_elem(elem);
+
+    if (dir != SM_PLAY)
+    {
+        return -EINVAL;
+    }
+    *min = fe->min;
+    *max = fe->max;
+    return 0;
+}
+
+static int
+sm_fake_elem_set_range(snd_mixer_elem_t *elem, int dir, long min, long max)
+{
+    // The range of the hardware is fixed.
+    return -EINVAL;
+}
+
+static int
+sm_fake_elem_get_dB_range(snd_mixer_elem_t *elem, int dir, long *min, long *max)
+{
+    SmFakeElem *fe = sm_fake_elem(elem);
+
+    if (dir != SM_PLAY)
+    {
+        return -EINVAL;
+    }
+    *min = fe->min_db;
+    *max = fe->max_db;
+    return 0;
+}
+
+/*
+ * The raw volume steps are equally spaced in dB, like the Scarlett gain stages.
+ */
+static int
+sm_fake_elem_ask_vol_dB(snd_mixer_elem_t *elem, int dir, long value, long *db_value)
+{
+    SmFakeElem *fe = sm_fake_elem(elem);
+
+    if (dir != SM_PLAY)
+    {
+        return -EINVAL;
+    }
+    value = CLAMP(value, fe->min, fe->max);
+    if (fe->max == fe->min)
+    {
+        *db_value = fe->min_db;
+        return 0;
+    }
+    *db_value = fe->min_db + (value - fe->min) * (fe->max_db - fe->min_db) / (fe->max - fe->min);
+    return 0;
+}
+
+static int
+sm_fake_elem_ask_dB_vol(snd_mixer_elem_t *elem, int dir, long db_value, long *value, int xdir)
+{
+    SmFakeElem *fe = sm_fake_elem(elem);
+    long num, den;
+
+    if (dir != SM_PLAY)
+    {
+        return -EINVAL;
+    }
+    if (fe->max_db <= fe->min_db)
+    {
+        *value = fe->min;
+        return 0;
+    }
+    db_value = CLAMP(db_value, fe->min_db, fe->max_db);
+    num = (db_value - fe->min_db) * (fe->max - fe->min);
+    den = fe->max_db - fe->min_db;
+    if (xdir > 0)
+    {
+        *value = fe->min + (num + den - 1) / den;
+    }
+    else if (xdir < 0)
+    {
+        *value = fe->min + num / den;
+    }
+    else
+    {
+        *value = fe->min + (num + den / 2) / den;
+    }
+    return 0;
+}
+
+static int
+sm_fake_elem_get_volume(snd_mixer_elem_t *elem, int dir, snd_mixer_selem_channel_id_t channel, long *value)
+{
+    SmFakeElem *fe = sm_fake_elem(elem);
+
+    if (dir != SM_PLAY || channel < 0 || (guint)channel >= fe->channels)
+    {
+        return -EINVAL;
+    }
+    *value = fe->volume[channel];
+    return 0;
+}
+
+static int
+sm_fake_elem_get_dB(snd_mixer_elem_t *elem, int dir, snd_mixer_selem_channel_id_t channel, long *value)
+{
+    long raw;
+    int err;
+
+    err = sm_fake_elem_get_volume(elem, dir, channel, &raw);
+    if (err < 0)
+    {
+        return err;
+    }
+    return sm_fake_elem_ask_vol_dB(elem, dir, raw, value);
+}
+
+static int
+sm_fake_elem_set_volume(snd_mixer_elem_t *elem, int dir, snd_mixer_selem_channel_id_t channel, long value)
+{
+    SmFakeElem *fe = sm_fake_elem(elem);
+    gboolean changed;
+    guint idx;
+
+    if (dir != SM_PLAY || channel < 0 || (guint)channel >= fe->channels)
+    {
+        return -EINVAL;
+    }
+    value = CLAMP(value, fe->min, fe->max);
+    changed = FALSE;
+    for (idx = 0; idx < fe->channels; idx++)
+    {
+        if ((idx == (guint)channel || (fe->selem.caps & SM_CAP_PVOLUME_JOIN))
+                && fe->volume[idx] != value)
+        {
+            fe->volume[idx] = value;
+            changed = TRUE;
+        }
+    }
+    sm_fake_elem_write(fe, changed);
+    return 0;
+}
+
+static int
+sm_fake_elem_set_dB(snd_mixer_elem_t *elem, int dir, snd_mixer_selem_channel_id_t channel, long value, int xdir)
+{
+    long raw;
+    int err;
+
+    err = sm_fake_elem_ask_dB_vol(elem, dir, value, &raw, xdir);
+    if (err < 0)
+    {
+        return err;
+    }
+    return sm_fake_elem_set_volume(elem, dir, channel, raw);
+}
+
+static int
+sm_fake_elem_get_switch(snd_mixer_elem_t *elem, int dir, snd_mixer_selem_channel_id_t channel, int *value)
+{
+    SmFakeElem *fe = sm_fake_elem(elem);
+
+    if (dir != SM_PLAY || channel < 0 || (guint)channel >= fe->channels)
+    {
+        return -EINVAL;
+    }
+    *value = fe->sw[channel];
+    return 0;
+}
+
+static int
+sm_fake_elem_set_switch(snd_mixer_elem_t *elem, int dir, snd_mixer_selem_channel_id_t channel, int value)
+{
+    SmFakeElem *fe = sm_fake_elem(elem);
+    gboolean changed;
+    guint idx;
+
+    if (dir != SM_PLAY || channel < 0 || (guint)channel >= fe->channels)
+    {
+        return -EINVAL;
+    }
+    value = value ? 1 : 0;
+    changed = FALSE;
+    for (idx = 0; idx < fe->channels; idx++)
+    {
+        if ((idx == (guint)channel || (fe->selem.caps & SM_CAP_PSWITCH_JOIN))
+                && fe->sw[idx] != value)
+        {
+            fe->sw[idx] = value;
+            changed = TRUE;
+        }
+    }
+    sm_fake_elem_write(fe, changed);
+    return 0;
+}
+
+static int
+sm_fake_elem_enum_item_name(snd_mixer_elem_t *elem, unsigned int item, size_t maxlen, char *buf)
+{
+    SmFakeElem *fe = sm_fake_elem(elem);
+
+    if (item >= fe->n_items)
+    {
+        return -EINVAL;
+    }
+    g_strlcpy(buf, fe->items[item], maxlen);
+    return 0;
+}
+
+static int
+sm_fake_elem_get_enum_item(snd_mixer_elem_t *elem, snd_mixer_selem_channel_id_t channel, unsigned int *itemp)
+{
+    SmFakeElem *fe = sm_fake_elem(elem);
+
+    if (channel < 0 || (guint)channel >= fe->channels)
+    {
+        return -EINVAL;
+    }
+    *itemp = fe->item[channel];
+    return 0;
+}
+
+static int
+sm_fake_elem_set_enum_item(snd_mixer_elem_t *elem, snd_mixer_selem_channel_id_t channel, unsigned int item)
+{
+    SmFakeElem *fe = sm_fake_elem(elem);
+    gboolean changed;
+
+    if (channel < 0 || (guint)channel >= fe->channels || item >= fe->n_items)
+    {
+        return -EINVAL;
+    }
+    changed = fe->item[channel] != item;
+    fe->item[channel] = item;
+    sm_fake_elem_write(fe, changed);
+    return 0;
+}
+
+static struct sm_elem_ops sm_fake_elem_ops = {
+    .is = sm_fake_elem_is,
+    .get_range = sm_fake_elem_get_range,
+    .set_range = sm_fake_elem_set_range,
+    .get_dB_range = sm_fake_elem_get_dB_range,
+    .ask_vol_dB = sm_fake_elem_ask_vol_dB,
+    .ask_dB_vol = sm_fake_elem_ask_dB_vol,
+    .get_volume = sm_fake_elem_get_volume,
+    .get_dB = sm_fake_elem_get_dB,
+    .set_volume = sm_fake_elem_set_volume,
+    .set_dB = sm_fake_elem_set_dB,
+    .get_switch = sm_fake_elem_get_switch,
+    .set_switch = sm_fake_elem_set_switch,
+    .enum_item_name = sm_fake_elem_enum_item_name,
+    .get_enum_item = sm_fake_elem_get_enum_item,
+    .set_enum_item = sm_fake_elem_set_enum_item
+};
+
+static gint64
+sm_fake_card_get_int(JsonObject *jo, const gchar *member, gint64 def)
+{
+    return json_object_has_member(jo, member) ? json_object_get_int_member(jo, member) : def;
+}
+
+static gboolean
+sm_fake_card_get_bool(JsonObject *jo, const gchar *member)
+{
+    return json_object_has_member(jo, member) && json_object_get_boolean_member(jo, member);
+}
+
+/*
+ * Read the "values" member of a volume, switch or enumeration into one value
+ * per channel, a single value is used for all channels.
+ */
+static gboolean
+sm_fake_card_load_values(JsonObject *jo, const gchar *name, guint channels,
+        long min, long max, long *values, GError **err)
+{
+    JsonArray *ja;
+    guint idx, len;
+    gint64 value;
+
+    for (idx = 0; idx < channels; idx++)
+    {
+        values[idx] = min;
+    }
+    if (!json_object_has_member(jo, "values"))
+    {
+        return TRUE;
+    }
+    ja = json_object_get_array_member(jo, "values");
+    len = ja ? json_array_get_length(ja) : 0;
+    if (len != 1 && len != channels)
+    {
+        g_set_error(err, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                "Element %s has %u values for %u channels", name, len, channels);
+        return FALSE;
+    }
+    for (idx = 0; idx < channels; idx++)
+    {
+        value = json_array_get_int_element(ja, len == 1 ? 0 : idx);
+        if (value < min || value > max)
+        {
+            g_set_error(err, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                    "Value %" G_GINT64_FORMAT " of element %s is out of range", value, name);
+            return FALSE;
+        }
+        values[idx] = value;
+    }
+    return TRUE;
+}
+
+static SmFakeElem*
+sm_fake_card_load_elem(SmFakeCard *self, JsonObject *jo, guint weight, GError **err)
+{
+    SmFakeElem *fe;
+    JsonObject *part;
+    JsonArray *ja;
+    const gchar *name, *kind;
+    long values[SM_FAKE_CARD_MAX_CHANNELS];
+    gint64 channels;
+    guint idx;
+
+    name = json_object_has_member(jo, "name") ? json_object_get_string_member(jo, "name") : NULL;
+    if (!name || !*name)
+    {
+        g_set_error(err, G_IO_ERROR, G_IO_ERROR_INVALID_DATA, "Element %u has no name", weight);
+        return NULL;
+    }
+    channels = sm_fake_card_get_int(jo, "channels", 1);
+    if (channels < 1 || channels > SM_FAKE_CARD_MAX_CHANNELS)
+    {
+        g_set_error(err, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                "Element %s has an invalid number of channels", name);
+        return NULL;
+    }
+
+    fe = g_new0(SmFakeElem, 1);
+    fe->card = self;
+    fe->weight = weight;
+    fe->channels = channels;
+    fe->selem.ops = &sm_fake_elem_ops;
+    snd_mixer_selem_id_malloc(&fe->selem.id);
+    snd_mixer_selem_id_set_name(fe->selem.id, name);
+    snd_mixer_selem_id_set_index(fe->selem.id, sm_fake_card_get_int(jo, "index", 0));
+
+    if (json_object_has_member(jo, "volume"))
+    {
+        part = json_object_get_object_member(jo, "volume");
+        fe->selem.caps |= SM_CAP_PVOLUME;
+        if (sm_fake_card_get_bool(part, "joined"))
+        {
+            fe->selem.caps |= SM_CAP_PVOLUME_JOIN;
+        }
+        fe->min = sm_fake_card_get_int(part, "min", 0);
+        fe->max = sm_fake_card_get_int(part, "max", 0);
+        fe->min_db = sm_fake_card_get_int(part, "min_db", 0);
+        fe->max_db = sm_fake_card_get_int(part, "max_db", 0);
+        if (fe->max < fe->min || fe->max_db < fe->min_db)
+        {
+            g_set_error(err, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                    "Element %s has an invalid volume range", name);
+            sm_fake_elem_free(fe);
+            return NULL;
+        }
+        if (!sm_fake_card_load_values(part, name, fe->channels, fe->min, fe->max, fe->volume, err))
+        {
+            sm_fake_elem_free(fe);
+            return NULL;
+        }
+    }
+    if (json_object_has_member(jo, "switch"))
+    {
+        part = json_object_get_object_member(jo, "switch");
+        fe->selem.caps |= SM_CAP_PSWITCH;
+        if (sm_fake_card_get_bool(part, "joined"))
+        {
+            fe->selem.caps |= SM_CAP_PSWITCH_JOIN;
+        }
+        if (!sm_fake_card_load_values(part, name, fe->channels, 0, 1, values, err))
+        {
+            sm_fake_elem_free(fe);
+            return NULL;
+        }
+        for (idx = 0; idx < fe->channels; idx++)
+        {
+            fe->sw[idx] = values[idx];
+        }
+    }
+    if (json_object_has_member(jo, "enum"))
+    {
+        part = json_object_get_object_member(jo, "enum");
+        kind = json_object_has_member(part, "kind") ? json_object_get_string_member(part, "kind") : "global";
+        if (g_strcmp0(kind, "playback") == 0)
+        {
+            fe->enum_playback = TRUE;
+            fe->selem.caps |= SM_CAP_PENUM;
+        }
+        else if (g_strcmp0(kind, "capture") == 0)
+        {
+            fe->enum_capture = TRUE;
+            fe->selem.caps |= SM_CAP_CENUM;
+        }
+        else if (g_strcmp0(kind, "global") == 0)
+        {
+            fe->selem.caps |= SM_CAP_PENUM | SM_CAP_CENUM;
+        }
+        else
+        {
+            g_set_error(err, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                    "Element %s has an unknown enumeration kind %s", name, kind);
+            sm_fake_elem_free(fe);
+            return NULL;
+        }
+        ja = json_object_has_member(part, "items") ? json_object_get_array_member(part, "items") : NULL;
+        fe->n_items = ja ? json_array_get_length(ja) : 0;
+        if (fe->n_items == 0)
+        {
+            g_set_error(err, G_IO_ERROR, G_IO_ERROR_INVALID_DATA, "Element %s has no items", name);
+            sm_fake_elem_free(fe);
+            return NULL;
+        }
+        fe->items = g_new0(gchar*, fe->n_items + 1);
+        for (idx = 0; idx < fe->n_items; idx++)
+        {
+            fe->items[idx] = g_strdup(json_array_get_string_element(ja, idx));
+        }
+        if (!sm_fake_card_load_values(part, name, fe->channels, 0, fe->n_items - 1, values, err))
+        {
+            sm_fake_elem_free(fe);
+            return NULL;
+        }
+        for (idx = 0; idx < fe->channels; idx++)
+        {
+            fe->item[idx] = values[idx];
+        }
+    }
+    if (!fe->selem.caps)
+    {
+        g_set_error(err, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                "Element %s has neither volume, switch nor enumeration", name);
+        sm_fake_elem_free(fe);
+        return NULL;
+    }
+    return fe;
+}
+
+static void
+sm_fake_card_finalize(GObject *object)
+{
+    SmFakeCard *self = SM_FAKE_CARD(object);
+
+    if (self->event_source)
+    {
+        g_source_remove(self->event_source);
+    }
+    g_ptr_array_unref(self->elems);
+    g_free(self->name);
+    G_OBJECT_CLASS(sm_fake_card_parent_class)->finalize(object);
+}
+
+static void
+sm_fake_card_class_init(SmFakeCardClass *klass)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS(klass);
+
+    object_class->finalize = sm_fake_card_finalize;
+}
+
+static void
+sm_fake_card_init(SmFakeCard *self)
+{
+    self->elems = g_ptr_array_new_with_free_func(sm_fake_elem_free);
+}
+
+SmFakeCard*
+sm_fake_card_new_from_file(const gchar *filename, GError **err)
+{
+    SmFakeCard *self;
+    JsonParser *jp;
+    JsonNode *root;
+    JsonObject *jo;
+    JsonArray *ja;
+    SmFakeElem *fe;
+    guint idx;
+
+    jp = json_parser_new();
+    if (!json_parser_load_from_file(jp, filename, err))
+    {
+        g_object_unref(jp);
+        return NULL;
+    }
+    root = json_parser_get_root(jp);
+    if (!root || !JSON_NODE_HOLDS_OBJECT(root)
+            || !json_object_has_member(json_node_get_object(root), "card_name")
+            || !json_object_has_member(json_node_get_object(root), "elements"))
+    {
+        g_set_error(err, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                "%s is no topology file", filename);
+        g_object_unref(jp);
+        return NULL;
+    }
+    jo = json_node_get_object(root);
+
+    self = g_object_new(SM_TYPE_FAKE_CARD, NULL);
+    self->name = g_strdup(json_object_get_string_member(jo, "card_name"));
+    self->write_latency = MAX(sm_fake_card_get_int(jo, "write_latency_us", 0), 0);
+    ja = json_object_get_array_member(jo, "elements");
+    for (idx = 0; ja && idx < json_array_get_length(ja); idx++)
+    {
+        fe = sm_fake_card_load_elem(self, json_array_get_object_element(ja, idx), idx, err);
+        if (!fe)
+        {
+            g_prefix_error(err, "%s: ", filename);
+            g_object_unref(self);
+            g_object_unref(jp);
+            return NULL;
+        }
+        g_ptr_array_add(self->elems, fe);
+    }
+    g_object_unref(jp);
+    g_debug("sm_fake_card_new_from_file: Loaded %u elements of %s.", self->elems->len, self->name);
+    return self;
+}
+
+SmFakeCard*
+sm_fake_card_get_default(void)
+{
+    const gchar *env;
+    GError *err = NULL;
+
+    if (sm_fake_card_default_loaded)
+    {
+        return sm_fake_card_default;
+    }
+    sm_fake_card_default_loaded = TRUE;
+    env = g_getenv("SCARLETTMIXER_FAKE_CARD");
+    if (env && *env)
+    {
+        sm_fake_card_default = sm_fake_card_new_from_file(env, &err);
+        if (!sm_fake_card_default)
+        {
+            g_warning("Cannot load fake card: %s", err->message);
+            g_error_free(err);
+        }
+    }
+    return sm_fake_card_default;
+}
+
+const gchar*
+sm_fake_card_get_name(SmFakeCard *self)
+{
+    return self->name;
+}
+
+int
+sm_fake_card_attach(SmFakeCard *self, snd_mixer_t *mixer)
+{
+    snd_mixer_class_t *class;
+    snd_mixer_elem_t *elem;
+    SmFakeElem *fe;
+    guint idx;
+    int err;
+
+    for (idx = 0; idx < self->elems->len; idx++)
+    {
+        if (((SmFakeElem*)g_ptr_array_index(self->elems, idx))->elem)
+        {
+            // Like the hardware, the elements belong to one mixer at a time here.
+            return -EBUSY;
+        }
+    }
+    err = snd_mixer_class_malloc(&class);
+    if (err < 0)
+    {
+        return err;
+    }
+    snd_mixer_class_set_compare(class, snd_mixer_selem_compare);
+    err = snd_mixer_class_register(class, mixer);
+    if (err < 0)
+    {
+        snd_mixer_class_free(class);
+        return err;
+    }
+    // Elements added so far are freed with the mixer on error.
+    for (idx = 0; idx < self->elems->len; idx++)
+    {
+        fe = g_ptr_array_index(self->elems, idx);
+        err = snd_mixer_elem_new(&elem, SND_MIXER_ELEM_SIMPLE, fe->weight, fe, sm_fake_elem_detach);
+        if (err < 0)
+        {
+            return err;
+        }
+        fe->elem = elem;
+        err = snd_mixer_elem_add(elem, class);
+        if (err < 0)
+        {
+            snd_mixer_elem_free(elem);
+            return err;
+        }
+    }
+    return 0;
+}
+
+static SmFakeElem*
+sm_fake_card_find_elem(SmFakeCard *self, const gchar *name, guint index, guint channel)
+{
+    SmFakeElem *fe;
+    guint idx;
+
+    for (idx = 0; idx < self->elems->len; idx++)
+    {
+        fe = g_ptr_array_index(self->elems, idx);
+        if (g_strcmp0(snd_mixer_selem_id_get_name(fe->selem.id), name) == 0
+                && snd_mixer_selem_id_get_index(fe->selem.id) == index)
+        {
+            return channel < fe->channels ? fe : NULL;
+        }
+    }
+    return NULL;
+}
+
+gboolean
+sm_fake_card_set_volume(SmFakeCard *self, const gchar *name, guint index,
+        guint channel, long value)
+{
+    SmFakeElem *fe;
+
+    fe = sm_fake_card_find_elem(self, name, index, channel);
+    if (!fe || !(fe->selem.caps & SM_CAP_PVOLUME))
+    {
+        return FALSE;
+    }
+    value = CLAMP(value, fe->min, fe->max);
+    if (fe->volume[channel] != value)
+    {
+        fe->volume[channel] = value;
+        sm_fake_elem_queue_event(fe);
+    }
+    return TRUE;
+}
+
+gboolean
+sm_fake_card_set_switch(SmFakeCard *self, const gchar *name, guint index,
+        guint channel, int value)
+{
+    SmFakeElem *fe;
+
+    fe = sm_fake_card_find_elem(self, name, index, channel);
+    if (!fe || !(fe->selem.caps & SM_CAP_PSWITCH))
+    {
+        return FALSE;
+    }
+    value = value ? 1 : 0;
+    if (fe->sw[channel] != value)
+    {
+        fe->sw[channel] = value;
+        sm_fake_elem_queue_event(fe);
+    }
+    return TRUE;
+}
+
+gboolean
+sm_fake_card_set_enum_item(SmFakeCard *self, const gchar *name, guint index,
+        guint channel, guint item)
+{
+    SmFakeElem *fe;
+
+    fe = sm_fake_card_find_elem(self, name, index, channel);
+    if (!fe || item >= fe->n_items)
+    {
+        return FALSE;
+    }
+    if (fe->item[channel] != item)
+    {
+        fe->item[channel] = item;
+        sm_fake_elem_queue_event(fe);
+    }
+    return TRUE;
+}
+
+static guint
+sm_fake_card_count_channels(snd_mixer_elem_t *elem)
+{
+    guint channels;
+
+    channels = 0;
+    while (channels < SM_FAKE_CARD_MAX_CHANNELS
+            && (snd_mixer_selem_has_playback_channel(elem, channels)
+                || snd_mixer_selem_has_capture_channel(elem, channels)))
+    {
+        channels++;
+    }
+    return MAX(channels, 1);
+}
+
+static void
+sm_fake_card_capture_volume(JsonBuilder *jb, snd_mixer_elem_t *elem, guint channels)
+{
+    long min, max, value, raw_min;
+    guint idx;
+
+    jb = json_builder_begin_object(jb);
+    raw_min = 0;
+    if (snd_mixer_selem_get_playback_volume_range(elem, &min, &max) >= 0)
+    {
+        raw_min = min;
+        jb = json_builder_set_member_name(jb, "min");
+        jb = json_builder_add_int_value(jb, min);
+        jb = json_builder_set_member_name(jb, "max");
+        jb = json_builder_add_int_value(jb, max);
+    }
+    if (snd_mixer_selem_get_playback_dB_range(elem, &min, &max) >= 0)
+    {
+        jb = json_builder_set_member_name(jb, "min_db");
+        jb = json_builder_add_int_value(jb, min);
+        jb = json_builder_set_member_name(jb, "max_db");
+        jb = json_builder_add_int_value(jb, max);
+    }
+    jb = json_builder_set_member_name(jb, "joined");
+    jb = json_builder_add_boolean_value(jb, snd_mixer_selem_has_playback_volume_joined(elem));
+    jb = json_builder_set_member_name(jb, "values");
+    jb = json_builder_begin_array(jb);
+    for (idx = 0; idx < channels; idx++)
+    {
+        if (snd_mixer_selem_get_playback_volume(elem, idx, &value) < 0)
+        {
+            value = raw_min;
+        }
+        jb = json_builder_add_int_value(jb, value);
+    }
+    jb = json_builder_end_array(jb);
+    jb = json_builder_end_object(jb);
+}
+
+static void
+sm_fake_card_capture_switch(JsonBuilder *jb, snd_mixer_elem_t *elem, guint channels)
+{
+    int value;
+    guint idx;
+
+    jb = json_builder_begin_object(jb);
+    jb = json_builder_set_member_name(jb, "joined");
+    jb = json_builder_add_boolean_value(jb, snd_mixer_selem_has_playback_switch_joined(elem));
+    jb = json_builder_set_member_name(jb, "values");
+    jb = json_builder_begin_array(jb);
+    for (idx = 0; idx < channels; idx++)
+    {
+        if (snd_mixer_selem_get_playback_switch(elem, idx, &value) < 0)
+        {
+            value = 0;
+        }
+        jb = json_builder_add_int_value(jb, value ? 1 : 0);
+    }
+    jb = json_builder_end_array(jb);
+    jb = json_builder_end_object(jb);
+}
+
+static void
+sm_fake_card_capture_enum(JsonBuilder *jb, snd_mixer_elem_t *elem, guint channels)
+{
+    gchar buf[64];
+    unsigned int item;
+    int n_items, idx;
+
+    jb = json_builder_begin_object(jb);
+    jb = json_builder_set_member_name(jb, "kind");
+    if (snd_mixer_selem_is_enum_playback(elem))
+    {
+        jb = json_builder_add_string_value(jb, "playback");
+    }
+    else if (snd_mixer_selem_is_enum_capture(elem))
+    {
+        jb = json_builder_add_string_value(jb, "capture");
+    }
+    else
+    {
+        jb = json_builder_add_string_value(jb, "global");
+    }
+    jb = json_builder_set_member_name(jb, "items");
+    jb = json_builder_begin_array(jb);
+    n_items = snd_mixer_selem_get_enum_items(elem);
+    for (idx = 0; idx < n_items; idx++)
+    {
+        if (snd_mixer_selem_get_enum_item_name(elem, idx, sizeof(buf), buf) < 0)
+        {
+            buf[0] = '\0';
+        }
+        jb = json_builder_add_string_value(jb, buf);
+    }
+    jb = json_builder_end_array(jb);
+    jb = json_builder_set_member_name(jb, "values");
+    jb = json_builder_begin_array(jb);
+    for (idx = 0; idx < (int)channels; idx++)
+    {
+        if (snd_mixer_selem_get_enum_item(elem, idx, &item) < 0)
+        {
+            item = 0;
+        }
+        jb = json_builder_add_int_value(jb, item);
+    }
+    jb = json_builder_end_array(jb);
+    jb = json_builder_end_object(jb);
+}
+
+JsonNode*
+sm_fake_card_capture(snd_mixer_t *mixer, const gchar *card_name)
+{
+    JsonBuilder *jb;
+    JsonNode *jn;
+    snd_mixer_elem_t *elem;
+    guint channels;
+
+    jb = json_builder_new();
+    jb = json_builder_begin_object(jb);
+
+    jb = json_builder_set_member_name(jb, "card_name");
+    jb = json_builder_add_string_value(jb, card_name);
+
+    // The latency of the interface is not measured, writes would change the mixer.
+    jb = json_builder_set_member_name(jb, "write_latency_us");
+    jb = json_builder_add_int_value(jb, 0);
+
+    jb = json_builder_set_member_name(jb, "elements");
+    jb = json_builder_begin_array(jb);
+    for (elem = snd_mixer_first_elem(mixer); elem; elem = snd_mixer_elem_next(elem))
+    {
+        channels = sm_fake_card_count_channels(elem);
+        jb = json_builder_begin_object(jb);
+        jb = json_builder_set_member_name(jb, "name");
+        jb = json_builder_add_string_value(jb, snd_mixer_selem_get_name(elem));
+        if (snd_mixer_selem_get_index(elem))
+        {
+            jb = json_builder_set_member_name(jb, "index");
+            jb = json_builder_add_int_value(jb, snd_mixer_selem_get_index(elem));
+        }
+        jb = json_builder_set_member_name(jb, "channels");
+        jb = json_builder_add_int_value(jb, channels);
+        if (snd_mixer_selem_has_playback_volume(elem))
+        {
+            jb = json_builder_set_member_name(jb, "volume");
+            sm_fake_card_capture_volume(jb, elem, channels);
+        }
+        if (snd_mixer_selem_has_playback_switch(elem))
+        {
+            jb = json_builder_set_member_name(jb, "switch");
+            sm_fake_card_capture_switch(jb, elem, channels);
+        }
+        if (snd_mixer_selem_is_enumerated(elem))
+        {
+            jb = json_builder_set_member_name(jb, "enum");
+            sm_fake_card_capture_enum(jb, elem, channels);
+        }
+        jb = json_builder_end_object(jb);
+    }
+    jb = json_builder_end_array(jb);
+
+    jb = json_builder_end_object(jb);
+    jn = json_builder_get_root(jb);
+    g_object_unref(jb);
+    return jn;
+}
+
+gboolean
+sm_fake_card_write_topology(snd_mixer_t *mixer, const gchar *card_name,
+        const gchar *filename, GError **err)
+{
+    JsonNode *jn;
+    JsonGenerator *jg;
+    gboolean ret;
+
+    jn = sm_fake_card_capture(mixer, card_name);
+    jg = json_generator_new();
+    json_generator_set_root(jg, jn);
+    json_generator_set_pretty(jg, TRUE);
+    ret = json_generator_to_file(jg, filename, err);
+    g_object_unref(jg);
+    json_node_free(jn);
+    return ret;
+}
@@ -0,0 +1,155 @@
+#ifndef __SM_FAKE_CARD_H__
+#define __SM_FAKE_CARD_H__
+/**
+ * @file
+ * @brief Header file for the in-memory fake sound card.
+ *
+ * The fake card is a control backend which replaces the ALSA sound card. Its
+ * elements are registered as a simple mixer class of alsa-lib, so the model
+ * (channels, sources and switches) uses the same `snd_mixer_selem_*` calls
+ * as with the hardware. The elements are described by a topology file:
+ *
+ *     {
+ *         "card_name": "Scarlett 6i6 USB",
+ *         "write_latency_us": 500,
+ *         "elements": [
+ *             {
+ *                 "name": "Master",
+ *                 "channels": 2,
+ *                 "volume": { "min": 0, "max": 127, "min_db": -12700, "max_db": 0,
+ *                             "joined": false, "values": [100, 100] },
+ *                 "switch": { "joined": true, "values": [1] }
+ *             },
+ *             {
+ *                 "name": "Input Source 01",
+ *                 "enum": { "kind": "capture", "items": ["Off", "Analog 1"], "values": [1] }
+ *             }
+ *         ]
+ *     }
+ *
+ * The dB values are given in hundredths of a dB like in alsa-lib. The kind of
+ * an enumeration is `playback`, `capture` or `global`. Missing values are
+ * initialized to the minimum, a single value is used for all channels.
+ *
+ * Every write blocks for the write latency, like a control transfer to the
+ * interface, and queues a value change event which is delivered from the main
+ * loop. The values live as long as the fake card, so they survive closing and
+ * reopening the mixer.
+ *
+ * The application uses the fake card instead of the hardware if the
+ * environment variable `SCARLETTMIXER_FAKE_CARD` names a topology file.
+ * The topology file of an interface, including the current values, is
+ * captured from its open mixer with sm_fake_card_write_topology().
+ */
+#include <glib-object.h>
+#include <alsa/asoundlib.h>
+#include <json-glib/json-glib.h>
+
+G_BEGIN_DECLS
+
+/**
+ * @brief Macro to get the type information of the fake card.
+ */
+#define SM_TYPE_FAKE_CARD sm_fake_card_get_type()
+/**
+ * @brief Macro declaring the final fake card type.
+ */
+G_DECLARE_FINAL_TYPE(SmFakeCard, sm_fake_card, SM, FAKE_CARD, GObject);
+
+/**
+ * @brief Load a fake card from a topology file.
+ * @param filename Path of the topology file.
+ * @param err The GError that will be initialized in case of an error.
+ * @return Pointer to new fake card instance, or NULL on error.
+ */
+SmFakeCard  *sm_fake_card_new_from_file(const gchar *filename, GError **err);
+
+/**
+ * @brief Get the fake card selected by the environment.
+ * The topology file named by `SCARLETTMIXER_FAKE_CARD` is loaded on the first
+ * call, errors are reported as warnings.
+ * @return The fake card (owned by the module), or NULL if none is selected.
+ */
+SmFakeCard  *sm_fake_card_get_default(void);
+
+/**
+ * @brief Get the name of the fake card.
+ * @param self The fake card.
+ * @return The card name (owned by the fake card).
+ */
+const gchar *sm_fake_card_get_name(SmFakeCard *self);
+
+/**
+ * @brief Register the elements of the fake card with a mixer.
+ * Replaces snd_mixer_selem_register() and snd_mixer_load() for the hardware.
+ * The fake card must outlive the mixer.
+ * @param self The fake card.
+ * @param mixer The opened mixer, its callback should already be set.
+ * @return 0 on success, a negative error code otherwise.
+ */
+int          sm_fake_card_attach(SmFakeCard *self, snd_mixer_t *mixer);
+
+/**
+ * @brief Change the raw volume of a channel like a change made on the interface.
+ * No write latency is simulated, a value change event is queued if the
+ * volume changed.
+ * @param self The fake card.
+ * @param name Name of the element.
+ * @param index Index of the element.
+ * @param channel The channel.
+ * @param value The raw volume.
+ * @return TRUE on success, FALSE if there is no such volume.
+ */
+gboolean     sm_fake_card_set_volume(SmFakeCard *self, const gchar *name, guint index,
+        guint channel, long value);
+
+/**
+ * @brief Change the switch of a channel like a change made on the interface.
+ * @see sm_fake_card_set_volume
+ * @param self The fake card.
+ * @param name Name of the element.
+ * @param index Index of the element.
+ * @param channel The channel.
+ * @param value The switch value.
+ * @return TRUE on success, FALSE if there is no such switch.
+ */
+gboolean     sm_fake_card_set_switch(SmFakeCard *self, const gchar *name, guint index,
+        guint channel, int value);
+
+/**
+ * @brief Change the selected item of a channel like a change made on the interface.
+ * @see sm_fake_card_set_volume
+ * @param self The fake card.
+ * @param name Name of the element.
+ * @param index Index of the element.
+ * @param channel The channel.
+ * @param item Index of the item.
+ * @return TRUE on success, FALSE if there is no such enumeration or item.
+ */
+gboolean     sm_fake_card_set_enum_item(SmFakeCard *self, const gchar *name, guint index,
+        guint channel, guint item);
+
+/**
+ * @brief Capture the topology and the current values of a mixer.
+ * The elements are recorded in the order of the mixer. The write latency is
+ * not measured, it is recorded as 0.
+ * @param mixer The opened mixer.
+ * @param card_name Name of the card.
+ * @return The topology in the format of the topology files.
+ */
+JsonNode    *sm_fake_card_capture(snd_mixer_t *mixer, const gchar *card_name);
+
+/**
+ * @brief Capture the topology and the current values of a mixer to a topology file.
+ * @param mixer The opened mixer.
+ * @param card_name Name of the card.
+ * @param filename Path of the topology file.
+ * @param err The GError that will be initialized in case of an error.
+ * @return TRUE on success, FALSE otherwise.
+ */
+gboolean     sm_fake_card_write_topology(snd_mixer_t *mixer, const gchar *card_name,
+        const gchar *filename, GError **err);
+
+G_END_DECLS
+
+#endif /* __SM_FAKE_CARD_H__ */
@@ -0,0 +1,1163 @@
+/*
+ * sm-http.c - HTTP and WebSocket server.
+ * Copyright (c) 2016 Martin Roesch <martin.roesch79@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include <json-glib/json-glib.h>
+
+#include "sm-http.h"
+#include "sm-controls.h"
+#include "sm-controls-monitor.h"
+#include "sm-metrics.h"
+
+#define SM_HTTP_TICK_INTERVAL (50) ///< Minimal time between two delta frames in milliseconds.
+#define SM_HTTP_MAX_CONNECTIONS (16) ///< Maximal number of open connections.
+#define SM_HTTP_MAX_HEADERS (64) ///< Maximal number of header lines of a request.
+#define SM_HTTP_MAX_LINE (8192) ///< Maximal length of a request or header line, including the line end.
+#define SM_HTTP_MAX_MESSAGE (65536) ///< Maximal size of a received WebSocket message.
+#define SM_HTTP_MAX_QUEUED (32) ///< Number of queued frames above which deltas are skipped.
+#define SM_HTTP_MAX_QUEUED_FRAMES (64) ///< Number of queued frames at which a WebSocket client is closed.
+#define SM_HTTP_READ_SIZE (4096) ///< Size of the receive buffer of a connection.
+
+#define SM_WS_OPCODE_CONTINUATION (0x0) ///< WebSocket continuation frame.
+#define SM_WS_OPCODE_TEXT (0x1) ///< WebSocket text frame.
+#define SM_WS_OPCODE_BINARY (0x2) ///< WebSocket binary frame.
+#define SM_WS_OPCODE_CLOSE (0x8) ///< WebSocket close frame.
+#define SM_WS_OPCODE_PING (0x9) ///< WebSocket ping frame.
+#define SM_WS_OPCODE_PONG (0xa) ///< WebSocket pong frame.
+#define SM_WS_CLOSE_PROTOCOL_ERROR (1002) ///< Close status of an invalid frame.
+#define SM_WS_CLOSE_POLICY_VIOLATION (1008) ///< Close status of a client not reading its frames.
+#define SM_WS_CLOSE_TOO_BIG (1009) ///< Close status of a message exceeding the limit.
+
+static const gchar sm_ws_guid[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"; ///< Key suffix of the handshake (RFC 6455).
+
+/**
+ * @brief Structure holding the state of the HTTP server.
+ */
+struct _SmHttpServer
+{
+    GObject parent_instance; ///< Parent object.
+
+    /* Other members, including private data. */
+    SmApp *app; ///< The application object (not referenced, it owns the server).
+    GSocketService *service; ///< Listening socket service, or NULL.
+    GList *connections; ///< List of the open SmHttpConnection.
+    SmControlsMonitor *monitor; ///< Monitor announcing the changed controls, or NULL.
+    gint64 sequence; ///< Sequence number of the last delta frame.
+};
+
+/**
+ * @brief Structure holding the state of a client connection.
+ * Pending asynchronous operations hold a reference, so the structure outlives
+ * a connection closed while reading or writing.
+ */
+typedef struct
+{
+    gint ref_count; ///< Reference count.
+    SmHttpServer *server; ///< The server, or NULL when the connection is closed.
+    GSocketConnection *connection; ///< The client connection.
+    GBufferedInputStream *input; ///< Buffered input stream of the connection.
+    GCancellable *cancellable; ///< Cancels the pending operations on close.
+    gchar *request_line; ///< First line of the HTTP request, or NULL.
+    GHashTable *headers; ///< Request headers by lower case name.
+    gboolean websocket; ///< Indicates if the connection was upgraded to a WebSocket.
+    GByteArray *received; ///< Received WebSocket data not yet parsed.
+    GByteArray *message; ///< Payload of the WebSocket message being received.
+    guint8 message_opcode; ///< Opcode of the first frame of the message.
+    GQueue *queue; ///< Queue of GBytes to send.
+    GBytes *sending; ///< Data being written, or NULL.
+    GBytes *queued_snapshot; ///< Snapshot frame waiting in the queue, or NULL.
+    gboolean close_after_send; ///< Indicates if the connection is closed once the queue is empty.
+    guint8 buffer[SM_HTTP_READ_SIZE]; ///< Receive buffer.
+} SmHttpConnection;
+
+G_DEFINE_TYPE(SmHttpServer, sm_http_server, G_TYPE_OBJECT);
+
+static void sm_http_connection_write_next(SmHttpConnection *conn);
+static void sm_http_connection_read_frames(SmHttpConnection *conn);
+
+static SmHttpConnection*
+sm_http_connection_ref(SmHttpConnection *conn)
+{
+    conn->ref_count++;
+    return conn;
+}
+
+static void
+sm_http_connection_unref(SmHttpConnection *conn)
+{
+    if (--conn->ref_count > 0)
+    {
+        return;
+    }
+    g_object_unref(conn->input);
+    g_object_unref(conn->connection);
+    g_object_unref(conn->cancellable);
+    g_free(conn->request_line);
+    g_hash_table_unref(conn->headers);
+    g_byte_array_unref(conn->received);
+    g_byte_array_unref(conn->message);
+    g_queue_free_full(conn->queue, (GDestroyNotify)g_bytes_unref);
+    if (conn->sending)
+    {
+        g_bytes_unref(conn->sending);
+    }
+    g_free(conn);
+}
+
+static void
+sm_http_connection_close(SmHttpConnection *conn)
+{
+    SmHttpServer *server = conn->server;
+
+    if (!server)
+    {
+        return;
+    }
+    conn->server = NULL;
+    server->connections = g_list_remove(server->connections, conn);
+    g_cancellable_cancel(conn->cancellable);
+    // Closing the socket works while operations are pending, unlike closing the stream.
+    g_socket_close(g_socket_connection_get_socket(conn->connection), NULL);
+    sm_http_connection_unref(conn);
+}
+
+static void
+sm_http_connection_write_cb(GObject *source, GAsyncResult *res, gpointer user_data)
+{
+    SmHttpConnection *conn = user_data;
+    GError *err = NULL;
+    gssize written;
+    gsize size;
+
+    written = g_output_stream_write_bytes_finish(G_OUTPUT_STREAM(source), res, &err);
+    if (written < 0)
+    {
+        if (!g_error_matches(err, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        {
+            g_debug("sm_http_connection_write_cb: %s", err->message);
+        }
+        g_error_free(err);
+        sm_http_connection_close(conn);
+        sm_http_connection_unref(conn);
+        return;
+    }
+    size = g_bytes_get_size(conn->sending);
+    if ((gsize)written < size)
+    {
+        g_queue_push_head(conn->queue, g_bytes_new_from_bytes(conn->sending, written, size - written));
+    }
+    g_clear_pointer(&conn->sending, g_bytes_unref);
+    sm_http_connection_write_next(conn);
+    sm_http_connection_unref(conn);
+}
+
+static void
+sm_http_connection_write_next(SmHttpConnection *conn)
+{
+    if (!conn->server || conn->sending)
+    {
+        return;
+    }
+    if (g_queue_is_empty(conn->queue))
+    {
+        if (conn->close_after_send)
+        {
+            sm_http_connection_close(conn);
+        }
+        return;
+    }
+    conn->sending = g_queue_pop_head(conn->queue);
+    if (conn->sending == conn->queued_snapshot)
+    {
+        conn->queued_snapshot = NULL;
+    }
+    g_output_stream_write_bytes_async(g_io_stream_get_output_stream(G_IO_STREAM(conn->connection)),
+            conn->sending, G_PRIORITY_DEFAULT, conn->cancellable,
+            sm_http_connection_write_cb, sm_http_connection_ref(conn));
+}
+
+/*
+ * Queue data to send, takes ownership of bytes.
+ */
+static void
+sm_http_connection_send(SmHttpConnection *conn, GBytes *bytes)
+{
+    if (!conn->server)
+    {
+        g_bytes_unref(bytes);
+        return;
+    }
+    g_queue_push_tail(conn->queue, bytes);
+    sm_http_connection_write_next(conn);
+}
+
+static void
+sm_http_connection_respond(SmHttpConnection *conn, guint status, const gchar *reason,
+        const gchar *content_type, const gchar *body, const gchar *extra_headers)
+{
+    GString *response;
+
+    response = g_string_new(NULL);
+    g_string_append_printf(response,
+            "HTTP/1.1 %u %s\r\n"
+            "Content-Type: %s\r\n"
+            "Content-Length: %" G_GSIZE_FORMAT "\r\n"
+            "Cache-Control: no-store\r\n"
+            "Connection: close\r\n"
+            "%s\r\n",
+            status, reason, content_type, strlen(body), extra_headers ? extra_headers : "");
+    g_string_append(response, body);
+    conn->close_after_send = TRUE;
+    sm_http_connection_send(conn, g_string_free_to_bytes(response));
+}
+
+static void
+sm_http_connection_respond_error(SmHttpConnection *conn, guint status, const gchar *reason)
+{
+    gchar *body;
+
+    body = g_strdup_printf("%u %s\n", status, reason);
+    sm_http_connection_respond(conn, status, reason, "text/plain; charset=utf-8", body, NULL);
+    g_free(body);
+}
+
+static GBytes*
+sm_http_frame_new(guint8 opcode, const guint8 *data, gsize len)
+{
+    GByteArray *frame;
+    guint8 header[10];
+    gsize header_len, idx;
+
+    // Server frames are not masked.
+    header[0] = 0x80 | opcode;
+    if (len < 126)
+    {
+        header[1] = len;
+        header_len = 2;
+    }
+    else if (len <= G_MAXUINT16)
+    {
+        header[1] = 126;
+        header[2] = len >> 8;
+        header[3] = len & 0xff;
+        header_len = 4;
+    }
+    else
+    {
+        header[1] = 127;
+        for (idx = 0; idx < 8; idx++)
+        {
+            header[2 + idx] = ((guint64)len >> (56 - 8 * idx)) & 0xff;
+        }
+        header_len = 10;
+    }
+    frame = g_byte_array_sized_new(header_len + len);
+    g_byte_array_append(frame, header, header_len);
+    g_byte_array_append(frame, data, len);
+    return g_byte_array_free_to_bytes(frame);
+}
+
+static void
+sm_http_connection_send_close(SmHttpConnection *conn, guint16 status)
+{
+    guint8 payload[2];
+
+    payload[0] = status >> 8;
+    payload[1] = status & 0xff;
+    sm_http_connection_send(conn, sm_http_frame_new(SM_WS_OPCODE_CLOSE, payload, sizeof(payload)));
+    conn->close_after_send = TRUE;
+}
+
+/*
+ * Queue a WebSocket frame, takes ownership of frame. Nothing is sent after a
+ * close frame. A client whose queue is full does not read its frames: the
+ * queued frames are dropped and the connection is closed. Returns TRUE if the
+ * frame was queued.
+ */
+static gboolean
+sm_http_connection_queue_frame(SmHttpConnection *conn, GBytes *frame)
+{
+    if (!conn->server || conn->close_after_send)
+    {
+        g_bytes_unref(frame);
+        return FALSE;
+    }
+    if (g_queue_get_length(conn->queue) >= SM_HTTP_MAX_QUEUED_FRAMES)
+    {
+        g_debug("sm_http_connection_queue_frame: Client does not read its frames, closing it.");
+        g_bytes_unref(frame);
+        // The queue holds whole frames only, the rest of a partial write is being sent.
+        g_queue_free_full(conn->queue, (GDestroyNotify)g_bytes_unref);
+        conn->queue = g_queue_new();
+        conn->queued_snapshot = NULL;
+        sm_http_connection_send_close(conn, SM_WS_CLOSE_POLICY_VIOLATION);
+        return FALSE;
+    }
+    sm_http_connection_send(conn, frame);
+    return TRUE;
+}
+
+static void
+sm_http_connection_send_frame(SmHttpConnection *conn, guint8 opcode, const guint8 *data, gsize len)
+{
+    sm_http_connection_queue_frame(conn, sm_http_frame_new(opcode, data, len));
+}
+
+static void
+sm_http_connection_send_text(SmHttpConnection *conn, const gchar *text)
+{
+    sm_http_connection_send_frame(conn, SM_WS_OPCODE_TEXT, (const guint8*)text, strlen(text));
+}
+
+/*
+ * Queue a snapshot frame. It holds all controls, so it replaces a snapshot
+ * still waiting in the queue, e.g. when a client sends several resyncs.
+ */
+static void
+sm_http_connection_send_snapshot(SmHttpConnection *conn, const gchar *text)
+{
+    GBytes *frame;
+
+    if (conn->queued_snapshot)
+    {
+        g_queue_remove(conn->queue, conn->queued_snapshot);
+        g_clear_pointer(&conn->queued_snapshot, g_bytes_unref);
+    }
+    frame = sm_http_frame_new(SM_WS_OPCODE_TEXT, (const guint8*)text, strlen(text));
+    // Unless it is written right away, the frame is the last one in the queue.
+    if (sm_http_connection_queue_frame(conn, frame) && g_queue_peek_tail(conn->queue) == frame)
+    {
+        conn->queued_snapshot = frame;
+    }
+}
+
+static gchar*
+sm_http_node_to_data(JsonNode *node)
+{
+    JsonGenerator *generator;
+    gchar *data;
+
+    generator = json_generator_new();
+    json_generator_set_root(generator, node);
+    data = json_generator_to_data(generator, NULL);
+    g_object_unref(generator);
+    json_node_free(node);
+    return data;
+}
+
+/*
+ * Build a frame of the given type holding the controls and the current
+ * sequence number. The card name is only included in snapshots.
+ */
+static gchar*
+sm_http_server_build_frame(SmHttpServer *self, const gchar *type, GVariant *controls)
+{
+    JsonBuilder *builder;
+    JsonNode *node;
+    const gchar *card_name;
+
+    builder = json_builder_new();
+    json_builder_begin_object(builder);
+    if (type)
+    {
+        json_builder_set_member_name(builder, "type");
+        json_builder_add_string_value(builder, type);
+    }
+    json_builder_set_member_name(builder, "sequence");
+    json_builder_add_int_value(builder, self->sequence);
+    if (g_strcmp0(type, "delta") != 0)
+    {
+        card_name = sm_app_get_card_name(self->app);
+        json_builder_set_member_name(builder, "card_name");
+        if (card_name)
+        {
+            json_builder_add_string_value(builder, card_name);
+        }
+        else
+        {
+            json_builder_add_null_value(builder);
+        }
+    }
+    json_builder_set_member_name(builder, "controls");
+    json_builder_add_value(builder, json_gvariant_serialize(controls));
+    json_builder_end_object(builder);
+    node = json_builder_get_root(builder);
+    g_object_unref(builder);
+    return sm_http_node_to_data(node);
+}
+
+static gchar*
+sm_http_server_build_snapshot(SmHttpServer *self, const gchar *type)
+{
+    GVariant *state;
+    gchar *data;
+
+    state = g_variant_ref_sink(sm_controls_get_state(self->app));
+    data = sm_http_server_build_frame(self, type, state);
+    g_variant_unref(state);
+    return data;
+}
+
+static void
+sm_http_connection_send_error(SmHttpConnection *conn, const gchar *message)
+{
+    JsonBuilder *builder;
+    gchar *data;
+
+    builder = json_builder_new();
+    json_builder_begin_object(builder);
+    json_builder_set_member_name(builder, "type");
+    json_builder_add_string_value(builder, "error");
+    json_builder_set_member_name(builder, "message");
+    json_builder_add_string_value(builder, message);
+    json_builder_end_object(builder);
+    data = sm_http_node_to_data(json_builder_get_root(builder));
+    g_object_unref(builder);
+    sm_http_connection_send_text(conn, data);
+    g_free(data);
+}
+
+/*
+ * Convert the members of a JSON object to an a{sv} dictionary of control
+ * values. Numbers are volumes, the type of all other values is kept.
+ */
+static GVariant*
+sm_http_controls_from_json(JsonObject *object, GError **err)
+{
+    GVariantBuilder builder;
+    GList *members, *item;
+    JsonNode *node;
+    GType type;
+
+    g_variant_builder_init(&builder, G_VARIANT_TYPE_VARDICT);
+    members = json_object_get_members(object);
+    for (item = members; item; item = g_list_next(item))
+    {
+        node = json_object_get_member(object, item->data);
+        type = JSON_NODE_HOLDS_VALUE(node) ? json_node_get_value_type(node) : G_TYPE_INVALID;
+        if (type == G_TYPE_INT64 || type == G_TYPE_DOUBLE)
+        {
+            g_variant_builder_add(&builder, "{sv}", item->data,
+                    g_variant_new_double(json_node_get_double(node)));
+        }
+        else if (type == G_TYPE_BOOLEAN)
+        {
+            g_variant_builder_add(&builder, "{sv}", item->data,
+                    g_variant_new_boolean(json_node_get_boolean(node)));
+        }
+        else if (type == G_TYPE_STRING)
+        {
+            g_variant_builder_add(&builder, "{sv}", item->data,
+                    g_variant_new_string(json_node_get_string(node)));
+        }
+        else
+        {
+            g_set_error(err, SM_CONTROLS_ERROR, SM_CONTROLS_ERROR_INVALID_VALUE,
+                    "Invalid value of %s.", (const gchar*)item->data);
+            g_list_free(members);
+            g_variant_builder_clear(&builder);
+            return NULL;
+        }
+    }
+    g_list_free(members);
+    return g_variant_ref_sink(g_variant_builder_end(&builder));
+}
+
+static void
+sm_http_connection_handle_message(SmHttpConnection *conn, const gchar *data, gsize len)
+{
+    JsonParser *parser;
+    JsonNode *root;
+    JsonObject *object;
+    GVariant *controls;
+    GError *err = NULL;
+    gchar *frame;
+
+    parser = json_parser_new();
+    if (!json_parser_load_from_data(parser, data, len, &err))
+    {
+        sm_http_connection_send_error(conn, err->message);
+        g_error_free(err);
+        g_object_unref(parser);
+        return;
+    }
+    root = json_parser_get_root(parser);
+    object = JSON_NODE_HOLDS_OBJECT(root) ? json_node_get_object(root) : NULL;
+    if (object && json_object_has_member(object, "resync"))
+    {
+        frame = sm_http_server_build_snapshot(conn->server, "snapshot");
+        sm_http_connection_send_snapshot(conn, frame);
+        g_free(frame);
+    }
+    else if (object && json_object_has_member(object, "set")
+            && JSON_NODE_HOLDS_OBJECT(json_object_get_member(object, "set")))
+    {
+        controls = sm_http_controls_from_json(json_object_get_object_member(object, "set"), &err);
+        if (!controls || !sm_controls_set(conn->server->app, controls, &err))
+        {
+            sm_http_connection_send_error(conn, err->message);
+            g_error_free(err);
+        }
+        if (controls)
+        {
+            g_variant_unref(controls);
+        }
+    }
+    else
+    {
+        sm_http_connection_send_error(conn, "Unknown request.");
+    }
+    g_object_unref(parser);
+}
+
+/*
+ * Parse the complete frames of the received data. Returns FALSE if the
+ * connection is being closed.
+ */
+static gboolean
+sm_http_connection_parse_frames(SmHttpConnection *conn)
+{
+    guint8 *data, *payload;
+    guint8 opcode;
+    gboolean fin;
+    guint64 len;
+    gsize header_len, idx;
+
+    while (conn->received->len >= 2 && !conn->close_after_send)
+    {
+        data = conn->received->data;
+        fin = (data[0] & 0x80) != 0;
+        opcode = data[0] & 0x0f;
+        len = data[1] & 0x7f;
+        header_len = 2;
+        if (len == 126)
+        {
+            if (conn->received->len < 4)
+            {
+                break;
+            }
+            len = (data[2] << 8) | data[3];
+            header_len = 4;
+        }
+        else if (len == 127)
+        {
+            if (conn->received->len < 10)
+            {
+                break;
+            }
+            len = 0;
+            for (idx = 0; idx < 8; idx++)
+            {
+                len = (len << 8) | data[2 + idx];
+            }
+            header_len = 10;
+        }
+        // Client frames must be masked.
+        if (!(data[1] & 0x80))
+        {
+            sm_http_connection_send_close(conn, SM_WS_CLOSE_PROTOCOL_ERROR);
+            return FALSE;
+        }
+        if (len > SM_HTTP_MAX_MESSAGE)
+        {
+            sm_http_connection_send_close(conn, SM_WS_CLOSE_TOO_BIG);
+            return FALSE;
+        }
+        if (conn->received->len < header_len + 4 + len)
+        {
+            break;
+        }
+        payload = data + header_len + 4;
+        for (idx = 0; idx < len; idx++)
+        {
+            payload[idx] ^= data[header_len + idx % 4];
+        }
+
+        switch (opcode)
+        {
+        case SM_WS_OPCODE_CLOSE:
+            sm_http_connection_send_frame(conn, SM_WS_OPCODE_CLOSE, payload, MIN(len, 2));
+            conn->close_after_send = TRUE;
+            return FALSE;
+        case SM_WS_OPCODE_PING:
+            sm_http_connection_send_frame(conn, SM_WS_OPCODE_PONG, payload, len);
+            break;
+        case SM_WS_OPCODE_PONG:
+            break;
+        case SM_WS_OPCODE_CONTINUATION:
+        case SM_WS_OPCODE_TEXT:
+        case SM_WS_OPCODE_BINARY:
+            if ((opcode == SM_WS_OPCODE_CONTINUATION) == (conn->message->len == 0 && conn->message_opcode == 0))
+            {
+                sm_http_connection_send_close(conn, SM_WS_CLOSE_PROTOCOL_ERROR);
+                return FALSE;
+            }
+            if (opcode != SM_WS_OPCODE_CONTINUATION)
+            {
+                conn->message_opcode = opcode;
+            }
+            if (conn->message->len + len > SM_HTTP_MAX_MESSAGE)
+            {
+                sm_http_connection_send_close(conn, SM_WS_CLOSE_TOO_BIG);
+                return FALSE;
+            }
+            g_byte_array_append(conn->message, payload, len);
+            if (fin)
+            {
+                // Binary messages are ignored.
+                if (conn->message_opcode == SM_WS_OPCODE_TEXT)
+                {
+                    sm_http_connection_handle_message(conn, (const gchar*)conn->message->data, conn->message->len);
+                }
+                g_byte_array_set_size(conn->message, 0);
+                conn->message_opcode = 0;
+            }
+            break;
+        default:
+            sm_http_connection_send_close(conn, SM_WS_CLOSE_PROTOCOL_ERROR);
+            return FALSE;
+        }
+        g_byte_array_remove_range(conn->received, 0, header_len + 4 + len);
+    }
+    return conn->server != NULL && !conn->close_after_send;
+}
+
+static void
+sm_http_connection_read_frames_cb(GObject *source, GAsyncResult *res, gpointer user_data)
+{
+    SmHttpConnection *conn = user_data;
+    GError *err = NULL;
+    gssize len;
+
+    len = g_input_stream_read_finish(G_INPUT_STREAM(source), res, &err);
+    if (len <= 0 || !conn->server)
+    {
+        if (err && !g_error_matches(err, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        {
+            g_debug("sm_http_connection_read_frames_cb: %s", err->message);
+        }
+        g_clear_error(&err);
+        sm_http_connection_close(conn);
+        sm_http_connection_unref(conn);
+        return;
+    }
+    g_byte_array_append(conn->received, conn->buffer, len);
+    if (sm_http_connection_parse_frames(conn))
+    {
+        sm_http_connection_read_frames(conn);
+    }
+    sm_http_connection_unref(conn);
+}
+
+static void
+sm_http_connection_read_frames(SmHttpConnection *conn)
+{
+    // Reading from the buffered input stream returns the data buffered behind the request first.
+    g_input_stream_read_async(G_INPUT_STREAM(conn->input), conn->buffer, sizeof(conn->buffer),
+            G_PRIORITY_DEFAULT, conn->cancellable,
+            sm_http_connection_read_frames_cb, sm_http_connection_ref(conn));
+}
+
+/*
+ * Check if a Host header value or the host of an origin names the local
+ * machine. The port is ignored.
+ */
+static gboolean
+sm_http_is_local_host(const gchar *host)
+{
+    const gchar *end;
+    gchar *name;
+    gboolean ret;
+
+    if (host[0] == '[')
+    {
+        host++;
+        end = strchr(host, ']');
+    }
+    else
+    {
+        end = strpbrk(host, ":/");
+    }
+    name = end ? g_strndup(host, end - host) : g_strdup(host);
+    ret = g_ascii_strcasecmp(name, "localhost") == 0
+        || g_strcmp0(name, "127.0.0.1") == 0
+        || g_strcmp0(name, "::1") == 0;
+    g_free(name);
+    return ret;
+}
+
+/*
+ * Accept requests without Origin (not from a browser) and from pages served
+ * by the local machine only. Sandboxed frames and data: or file: pages of any
+ * site send the opaque origin "null", so it is foreign. The Host check
+ * defeats DNS rebinding.
+ */
+static gboolean
+sm_http_connection_check_origin(SmHttpConnection *conn)
+{
+    const gchar *host, *origin;
+
+    host = g_hash_table_lookup(conn->headers, "host");
+    if (!host || !sm_http_is_local_host(host))
+    {
+        return FALSE;
+    }
+    origin = g_hash_table_lookup(conn->headers, "origin");
+    if (!origin)
+    {
+        return TRUE;
+    }
+    if (g_str_has_prefix(origin, "http://"))
+    {
+        return sm_http_is_local_host(origin + strlen("http://"));
+    }
+    if (g_str_has_prefix(origin, "https://"))
+    {
+        return sm_http_is_local_host(origin + strlen("https://"));
+    }
+    return FALSE;
+}
+
+/*
+ * Check if a comma separated header value contains a token.
+ */
+static gboolean
+sm_http_header_has_token(const gchar *value, const gchar *token)
+{
+    gchar **tokens;
+    gboolean ret;
+    guint idx;
+
+    if (!value)
+    {
+        return FALSE;
+    }
+    ret = FALSE;
+    tokens = g_strsplit(value, ",", -1);
+    for (idx = 0; tokens[idx] && !ret; idx++)
+    {
+        ret = g_ascii_strcasecmp(g_strstrip(tokens[idx]), token) == 0;
+    }
+    g_strfreev(tokens);
+    return ret;
+}
+
+static void
+sm_http_connection_upgrade(SmHttpConnection *conn)
+{
+    GChecksum *checksum;
+    guint8 digest[20];
+    gsize digest_len;
+    const gchar *key;
+    gchar *accept, *response, *frame;
+
+    key = g_hash_table_lookup(conn->headers, "sec-websocket-key");
+    if (!sm_http_header_has_token(g_hash_table_lookup(conn->headers, "upgrade"), "websocket")
+            || !sm_http_header_has_token(g_hash_table_lookup(conn->headers, "connection"), "upgrade")
+            || !key)
+    {
+        sm_http_connection_respond_error(conn, 400, "Bad Request");
+        return;
+    }
+    if (g_strcmp0(g_hash_table_lookup(conn->headers, "sec-websocket-version"), "13") != 0)
+    {
+        sm_http_connection_respond(conn, 426, "Upgrade Required", "text/plain; charset=utf-8",
+                "426 Upgrade Required\n", "Sec-WebSocket-Version: 13\r\n");
+        return;
+    }
+    checksum = g_checksum_new(G_CHECKSUM_SHA1);
+    g_checksum_update(checksum, (const guchar*)key, -1);
+    g_checksum_update(checksum, (const guchar*)sm_ws_guid, -1);
+    digest_len = sizeof(digest);
+    g_checksum_get_digest(checksum, digest, &digest_len);
+    g_checksum_free(checksum);
+    accept = g_base64_encode(digest, digest_len);
+    response = g_strdup_printf("HTTP/1.1 101 Switching Protocols\r\n"
+            "Upgrade: websocket\r\n"
+            "Connection: Upgrade\r\n"
+            "Sec-WebSocket-Accept: %s\r\n"
+            "\r\n", accept);
+    g_free(accept);
+    sm_http_connection_send(conn, g_bytes_new_take(response, strlen(response)));
+    conn->websocket = TRUE;
+
+    frame = sm_http_server_build_snapshot(conn->server, "snapshot");
+    sm_http_connection_send_snapshot(conn, frame);
+    g_free(frame);
+    sm_http_connection_read_frames(conn);
+}
+
+static void
+sm_http_connection_handle_request(SmHttpConnection *conn)
+{
+    gchar **parts, *path, *query, *body, *extra_headers;
+    const gchar *origin;
+
+    parts = g_strsplit(conn->request_line, " ", 3);
+    if (g_strv_length(parts) != 3 || !g_str_has_prefix(parts[2], "HTTP/1."))
+    {
+        sm_http_connection_respond_error(conn, 400, "Bad Request");
+        g_strfreev(parts);
+        return;
+    }
+    if (g_strcmp0(parts[0], "GET") != 0)
+    {
+        sm_http_connection_respond(conn, 405, "Method Not Allowed", "text/plain; charset=utf-8",
+                "405 Method Not Allowed\n", "Allow: GET\r\n");
+        g_strfreev(parts);
+        return;
+    }
+    if (!sm_http_connection_check_origin(conn))
+    {
+        sm_http_connection_respond_error(conn, 403, "Forbidden");
+        g_strfreev(parts);
+        return;
+    }
+    path = parts[1];
+    query = strchr(path, '?');
+    if (query)
+    {
+        *query = '\0';
+    }
+    g_debug("sm_http_connection_handle_request: GET %s", path);
+
+    if (g_strcmp0(path, "/ws") == 0)
+    {
+        sm_http_connection_upgrade(conn);
+        g_strfreev(parts);
+        return;
+    }
+    if (g_strcmp0(path, "/state") == 0)
+    {
+        body = sm_http_node_to_data(sm_app_config_to_json_node(conn->server->app));
+    }
+    else if (g_strcmp0(path, "/controls") == 0)
+    {
+        body = sm_http_server_build_snapshot(conn->server, NULL);
+    }
+    else if (g_strcmp0(path, "/metrics") == 0)
+    {
+        body = sm_metrics_format();
+        sm_http_connection_respond(conn, 200, "OK", "text/plain; version=0.0.4", body, NULL);
+        g_free(body);
+        g_strfreev(parts);
+        return;
+    }
+    else
+    {
+        sm_http_connection_respond_error(conn, 404, "Not Found");
+        g_strfreev(parts);
+        return;
+    }
+    // Pages served from another local port may read the state, the origin passed the check above.
+    origin = g_hash_table_lookup(conn->headers, "origin");
+    extra_headers = g_strdup_printf("X-Sequence: %" G_GINT64_FORMAT "\r\n%s%s%s",
+            conn->server->sequence,
+            origin ? "Access-Control-Allow-Origin: " : "",
+            origin ? origin : "",
+            origin ? "\r\n" : "");
+    sm_http_connection_respond(conn, 200, "OK", "application/json", body, extra_headers);
+    g_free(extra_headers);
+    g_free(body);
+    g_strfreev(parts);
+}
+
+/*
+ * Handle a request or header line. Returns FALSE once the request was
+ * answered, no more lines are read then.
+ */
+static gboolean
+sm_http_connection_handle_line(SmHttpConnection *conn, gchar *line)
+{
+    gchar *value;
+
+    g_strchomp(line);
+    if (!conn->request_line)
+    {
+        conn->request_line = line;
+        return TRUE;
+    }
+    if (line[0] == '\0')
+    {
+        // End of the headers, the request has no body.
+        g_free(line);
+        sm_http_connection_handle_request(conn);
+        return FALSE;
+    }
+    value = strchr(line, ':');
+    if (!value || g_hash_table_size(conn->headers) >= SM_HTTP_MAX_HEADERS)
+    {
+        g_free(line);
+        sm_http_connection_respond_error(conn, 400, "Bad Request");
+        return FALSE;
+    }
+    *value++ = '\0';
+    g_hash_table_replace(conn->headers, g_ascii_strdown(g_strstrip(line), -1), g_strdup(g_strstrip(value)));
+    g_free(line);
+    return TRUE;
+}
+
+/*
+ * Take the next complete line out of the buffer of the input stream, or
+ * return NULL if none is buffered.
+ */
+static gchar*
+sm_http_connection_take_line(SmHttpConnection *conn)
+{
+    const gchar *buf, *end;
+    gsize available;
+    gchar *line;
+
+    buf = g_buffered_input_stream_peek_buffer(conn->input, &available);
+    end = memchr(buf, '\n', available);
+    if (!end)
+    {
+        return NULL;
+    }
+    line = g_strndup(buf, end - buf);
+    // The bytes are buffered, skipping does not block.
+    g_input_stream_skip(G_INPUT_STREAM(conn->input), end - buf + 1, NULL, NULL);
+    return line;
+}
+
+static void sm_http_connection_read_lines(SmHttpConnection *conn);
+
+static void
+sm_http_connection_fill_cb(GObject *source, GAsyncResult *res, gpointer user_data)
+{
+    SmHttpConnection *conn = user_data;
+    GError *err = NULL;
+    gssize len;
+
+    len = g_buffered_input_stream_fill_finish(G_BUFFERED_INPUT_STREAM(source), res, &err);
+    if (len <= 0 || !conn->server)
+    {
+        if (err && !g_error_matches(err, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        {
+            g_debug("sm_http_connection_fill_cb: %s", err->message);
+        }
+        g_clear_error(&err);
+        sm_http_connection_close(conn);
+        sm_http_connection_unref(conn);
+        return;
+    }
+    sm_http_connection_read_lines(conn);
+}
+
+/*
+ * Handle the buffered lines and read more until the request is complete.
+ * The buffer of the input stream holds at most SM_HTTP_MAX_LINE bytes, a line
+ * which does not fit is rejected. Consumes a reference of the connection.
+ */
+static void
+sm_http_connection_read_lines(SmHttpConnection *conn)
+{
+    gchar *line;
+
+    while ((line = sm_http_connection_take_line(conn)))
+    {
+        if (!sm_http_connection_handle_line(conn, line))
+        {
+            sm_http_connection_unref(conn);
+            return;
+        }
+    }
+    if (g_buffered_input_stream_get_available(conn->input) >= SM_HTTP_MAX_LINE)
+    {
+        if (conn->request_line)
+        {
+            sm_http_connection_respond_error(conn, 431, "Request Header Fields Too Large");
+        }
+        else
+        {
+            sm_http_connection_respond_error(conn, 400, "Bad Request");
+        }
+        sm_http_connection_unref(conn);
+        return;
+    }
+    g_buffered_input_stream_fill_async(conn->input, -1,
+            G_PRIORITY_DEFAULT, conn->cancellable, sm_http_connection_fill_cb, conn);
+}
+
+static gboolean
+sm_http_server_incoming_cb(GSocketService *service, GSocketConnection *connection,
+        GObject *source_object, gpointer user_data)
+{
+    SmHttpServer *self = SM_HTTP_SERVER(user_data);
+    SmHttpConnection *conn;
+
+    if (g_list_length(self->connections) >= SM_HTTP_MAX_CONNECTIONS)
+    {
+        // The connection is closed when the service drops its reference.
+        g_debug("sm_http_server_incoming_cb: Too many connections.");
+        return TRUE;
+    }
+    conn = g_new0(SmHttpConnection, 1);
+    conn->ref_count = 1;
+    conn->server = self;
+    conn->connection = g_object_ref(connection);
+    conn->input = G_BUFFERED_INPUT_STREAM(g_buffered_input_stream_new_sized(
+                g_io_stream_get_input_stream(G_IO_STREAM(connection)), SM_HTTP_MAX_LINE));
+    conn->cancellable = g_cancellable_new();
+    conn->headers = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+    conn->received = g_byte_array_new();
+    conn->message = g_byte_array_new();
+    conn->queue = g_queue_new();
+    self->connections = g_list_prepend(self->connections, conn);
+    sm_http_connection_read_lines(sm_http_connection_ref(conn));
+    return TRUE;
+}
+
+/*
+ * Send a delta or snapshot frame to all WebSocket clients. Deltas are skipped
+ * for clients which do not keep up, they notice the gap in the sequence
+ * numbers.
+ */
+static void
+sm_http_server_broadcast(SmHttpServer *self, const gchar *frame, gboolean snapshot)
+{
+    SmHttpConnection *conn;
+    GList *item, *next;
+
+    for (item = g_list_first(self->connections); item; item = next)
+    {
+        next = g_list_next(item);
+        conn = item->data;
+        if (!conn->websocket || conn->close_after_send)
+        {
+            continue;
+        }
+        if (snapshot)
+        {
+            sm_http_connection_send_snapshot(conn, frame);
+        }
+        else if (g_queue_get_length(conn->queue) < SM_HTTP_MAX_QUEUED)
+        {
+            sm_http_connection_send_text(conn, frame);
+        }
+    }
+}
+
+static void
+sm_http_server_controls_changed_cb(SmControlsMonitor *monitor, GVariant *controls, gpointer user_data)
+{
+    SmHttpServer *self = SM_HTTP_SERVER(user_data);
+    gchar *frame;
+
+    self->sequence++;
+    frame = sm_http_server_build_frame(self, "delta", controls);
+    sm_http_server_broadcast(self, frame, FALSE);
+    g_free(frame);
+}
+
+/*
+ * Connected before the monitor is created, so clients get the snapshot of the
+ * new mixer objects before the monitor announces their values.
+ */
+static void
+sm_http_server_model_changed_cb(SmApp *app, gpointer user_data)
+{
+    SmHttpServer *self = SM_HTTP_SERVER(user_data);
+    gchar *frame;
+
+    frame = sm_http_server_build_snapshot(self, "snapshot");
+    sm_http_server_broadcast(self, frame, TRUE);
+    g_free(frame);
+}
+
+static void
+sm_http_server_dispose(GObject *object)
+{
+    SmHttpServer *self = SM_HTTP_SERVER(object);
+
+    sm_http_server_stop(self);
+    G_OBJECT_CLASS(sm_http_server_parent_class)->dispose(object);
+}
+
+static void
+sm_http_server_class_init(SmHttpServerClass *klass)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS(klass);
+
+    object_class->dispose = sm_http_server_dispose;
+}
+
+static void
+sm_http_server_init(SmHttpServer *self)
+{
+}
+
+SmHttpServer*
+sm_http_server_new(SmApp *app)
+{
+    SmHttpServer *self;
+
+    self = g_object_new(SM_TYPE_HTTP_SERVER, NULL);
+    self->app = app;
+    return self;
+}
+
+gboolean
+sm_http_server_start(SmHttpServer *self, guint16 port, GError **err)
+{
+    GInetAddress *inet_address;
+    GSocketAddress *socket_address;
+    gboolean ret;
+
+    sm_http_server_stop(self);
+    self->service = g_socket_service_new();
+    inet_address = g_inet_address_new_loopback(G_SOCKET_FAMILY_IPV4);
+    socket_address = g_inet_socket_address_new(inet_address, port);
+    ret = g_socket_listener_add_address(G_SOCKET_LISTENER(self->service), socket_address,
+            G_SOCKET_TYPE_STREAM, G_SOCKET_PROTOCOL_TCP, NULL, NULL, err);
+    g_object_unref(socket_address);
+    g_object_unref(inet_address);
+    if (!ret)
+    {
+        g_clear_object(&self->service);
+        return FALSE;
+    }
+    g_signal_connect(self->service, "incoming", G_CALLBACK(sm_http_server_incoming_cb), self);
+    g_socket_service_start(self->service);
+    g_signal_connect(self->app, "model-changed", G_CALLBACK(sm_http_server_model_changed_cb), self);
+    self->monitor = sm_controls_monitor_new(self->app, SM_HTTP_TICK_INTERVAL);
+    g_signal_connect(self->monitor, "changed", G_CALLBACK(sm_http_server_controls_changed_cb), self);
+    g_debug("sm_http_server_start: Listening on 127.0.0.1:%u.", port);
+    return TRUE;
+}
+
+void
+sm_http_server_stop(SmHttpServer *self)
+{
+    g_clear_object(&self->monitor);
+    if (self->app)
+    {
+        g_signal_handlers_disconnect_by_data(self->app, self);
+    }
+    if (self->service)
+    {
+        g_socket_service_stop(self->service);
+        g_socket_listener_close(G_SOCKET_LISTENER(self->service));
+        g_signal_handlers_disconnect_by_data(self->service, self);
+        g_clear_object(&self->service);
+    }
+    while (self->connections)
+    {
+        sm_http_connection_close(self->connections->data);
+    }
+}
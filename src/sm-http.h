@@ -0,0 +1,69 @@
+#ifndef __SM_HTTP_H__
+#define __SM_HTTP_H__
+/**
+ * @file
+ * @brief Header file for the HTTP and WebSocket server.
+ *
+ * The server listens on the loopback interface and serves browser based
+ * controllers on the same machine:
+ * * `GET /state`: The configuration in the format of the configuration files.
+ * * `GET /controls`: The named controls (see sm-controls.h) as
+ *   `{"sequence": n, "card_name": "...", "controls": {"name": value, ...}}`.
+ * * `GET /ws`: WebSocket streaming the changes of the controls.
+ * * `GET /metrics`: The operational metrics (see sm-metrics.h).
+ *
+ * A WebSocket client first receives a frame of type `snapshot` holding all
+ * controls, then frames of type `delta` holding the controls changed since
+ * the previous frame. Changes are coalesced, at most one delta is sent per
+ * tick. Every delta increments the sequence number; a snapshot carries the
+ * sequence number of the last delta it includes. A client which sees a gap in
+ * the sequence numbers, e.g. because it could not keep up and deltas were
+ * skipped, sends `{"resync": true}` to get a new snapshot; a snapshot not yet
+ * sent is replaced by the new one. Controls are set with
+ * `{"set": {"name": value, ...}}`; all of them are checked before any is
+ * written, errors are answered with a frame of type `error`. A client which
+ * does not read its frames is closed with status 1008 (policy violation).
+ *
+ * Requests whose Host or Origin header names another host than the local
+ * one are rejected, so web pages from other sites cannot use the server.
+ */
+#include <gio/gio.h>
+
+#include "sm-app.h"
+
+G_BEGIN_DECLS
+
+/**
+ * @brief Macro to get the type information of the HTTP server.
+ */
+#define SM_TYPE_HTTP_SERVER sm_http_server_get_type()
+/**
+ * @brief Macro declaring the final HTTP server type.
+ */
+G_DECLARE_FINAL_TYPE(SmHttpServer, sm_http_server, SM, HTTP_SERVER, GObject);
+
+/**
+ * @brief Create a new HTTP server.
+ * @param app The application object.
+ * @return Pointer to new HTTP server instance.
+ */
+SmHttpServer *sm_http_server_new(SmApp *app);
+
+/**
+ * @brief Listen on the loopback interface and start serving requests.
+ * @param self The HTTP server.
+ * @param port TCP port.
+ * @param err The GError that will be initialized in case of an error.
+ * @return TRUE on success, FALSE otherwise.
+ */
+gboolean      sm_http_server_start(SmHttpServer *self, guint16 port, GError **err);
+
+/**
+ * @brief Stop listening and close all connections.
+ * @param self The HTTP server.
+ */
+void          sm_http_server_stop(SmHttpServer *self);
+
+G_END_DECLS
+
+#endif /* __SM_HTTP_H__ */
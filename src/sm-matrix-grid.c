@@ -0,0 +1,716 @@
+/*
+ * sm-matrix-grid.c - GTK+ widget for the whole matrix mixer.
+ * Copyright (c) 2016 Martin Roesch <martin.roesch79@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtk/gtk.h>
+
+#include "sm-matrix-grid.h"
+#include "sm-taper.h"
+
+#define SM_MATRIX_GRID_LABEL_WIDTH (120) ///< Width of the row label column in pixels.
+#define SM_MATRIX_GRID_HEADER_HEIGHT (24) ///< Height of the column header row in pixels.
+#define SM_MATRIX_GRID_CELL_WIDTH (56) ///< Width of a gain cell in pixels.
+#define SM_MATRIX_GRID_CELL_HEIGHT (24) ///< Height of a gain cell in pixels.
+#define SM_MATRIX_GRID_DRAG_STEP (0.25) ///< Gain change in dB per dragged pixel.
+#define SM_MATRIX_GRID_FINE_STEP (0.05) ///< Gain change in dB per dragged pixel with Shift pressed.
+#define SM_MATRIX_GRID_KEY_STEP (1.0) ///< Gain change in dB per key press or scroll step.
+#define SM_MATRIX_GRID_PAGE_STEP (6.0) ///< Gain change in dB per page key press.
+
+/**
+ * @brief Structure holding the state of the matrix grid widget.
+ */
+struct _SmMatrixGrid
+{
+    GtkDrawingArea parent_instance; ///< Parent object.
+
+    /* Other members, including private data. */
+    guint n_rows; ///< Number of matrix inputs.
+    guint n_cols; ///< Number of mixes.
+    guint *row_ids; ///< Channel id of every row.
+    gchar *col_ids; ///< Mix id of every column.
+    gfloat *gains; ///< Gains in dB of all cells in row-major order.
+    SmChannel **cells; ///< Channel of every cell in row-major order, or NULL.
+    gdouble min_db; ///< Minimal gain in dB.
+    gdouble max_db; ///< Maximal gain in dB.
+    const SmTaper *taper; ///< Taper of the gain range.
+    guint focus_row; ///< Row of the focused cell.
+    guint focus_col; ///< Column of the focused cell.
+    gboolean dragging; ///< Indicates if the focused cell is dragged.
+    gdouble drag_y; ///< Pointer position at the start of the drag.
+    gdouble drag_db; ///< Gain of the dragged cell at the start of the drag.
+    gboolean suspended; ///< Indicates if redraws are suspended.
+    gboolean stale; ///< Indicates if a gain changed while the redraws were suspended.
+};
+
+G_DEFINE_TYPE(SmMatrixGrid, sm_matrix_grid, GTK_TYPE_DRAWING_AREA);
+
+static void
+sm_matrix_grid_clear(SmMatrixGrid *self)
+{
+    guint idx;
+
+    for (idx = 0; idx < self->n_rows * self->n_cols; idx++)
+    {
+        if (self->cells[idx])
+        {
+            g_signal_handlers_disconnect_by_data(self->cells[idx], self);
+            g_object_unref(self->cells[idx]);
+        }
+    }
+    g_clear_pointer(&self->cells, g_free);
+    g_clear_pointer(&self->gains, g_free);
+    g_clear_pointer(&self->row_ids, g_free);
+    g_clear_pointer(&self->col_ids, g_free);
+    self->n_rows = 0;
+    self->n_cols = 0;
+    self->focus_row = 0;
+    self->focus_col = 0;
+    self->dragging = FALSE;
+}
+
+static gint
+sm_matrix_grid_compare_uint(gconstpointer a, gconstpointer b)
+{
+    guint ua = *(const guint*)a;
+    guint ub = *(const guint*)b;
+
+    return ua < ub ? -1 : (ua > ub ? 1 : 0);
+}
+
+static gint
+sm_matrix_grid_compare_char(gconstpointer a, gconstpointer b)
+{
+    return *(const gchar*)a - *(const gchar*)b;
+}
+
+static gint
+sm_matrix_grid_find_row(SmMatrixGrid *self, guint id)
+{
+    guint row;
+
+    for (row = 0; row < self->n_rows; row++)
+    {
+        if (self->row_ids[row] == id)
+        {
+            return row;
+        }
+    }
+    return -1;
+}
+
+static gint
+sm_matrix_grid_find_col(SmMatrixGrid *self, gchar mix_id)
+{
+    guint col;
+
+    for (col = 0; col < self->n_cols; col++)
+    {
+        if (self->col_ids[col] == mix_id)
+        {
+            return col;
+        }
+    }
+    return -1;
+}
+
+static void
+sm_matrix_grid_get_cell_rect(SmMatrixGrid *self, guint row, guint col, GdkRectangle *rect)
+{
+    rect->x = SM_MATRIX_GRID_LABEL_WIDTH + col * SM_MATRIX_GRID_CELL_WIDTH;
+    rect->y = SM_MATRIX_GRID_HEADER_HEIGHT + row * SM_MATRIX_GRID_CELL_HEIGHT;
+    rect->width = SM_MATRIX_GRID_CELL_WIDTH;
+    rect->height = SM_MATRIX_GRID_CELL_HEIGHT;
+}
+
+static void
+sm_matrix_grid_queue_draw_cell(SmMatrixGrid *self, guint row, guint col)
+{
+    GdkRectangle rect;
+
+    sm_matrix_grid_get_cell_rect(self, row, col, &rect);
+    gtk_widget_queue_draw_area(GTK_WIDGET(self), rect.x, rect.y, rect.width, rect.height);
+}
+
+static gboolean
+sm_matrix_grid_hit_test(SmMatrixGrid *self, gdouble x, gdouble y, guint *row, guint *col)
+{
+    gint r, c;
+
+    if (x < SM_MATRIX_GRID_LABEL_WIDTH || y < SM_MATRIX_GRID_HEADER_HEIGHT)
+    {
+        return FALSE;
+    }
+    c = (gint)(x - SM_MATRIX_GRID_LABEL_WIDTH) / SM_MATRIX_GRID_CELL_WIDTH;
+    r = (gint)(y - SM_MATRIX_GRID_HEADER_HEIGHT) / SM_MATRIX_GRID_CELL_HEIGHT;
+    if (r >= (gint)self->n_rows || c >= (gint)self->n_cols)
+    {
+        return FALSE;
+    }
+    *row = r;
+    *col = c;
+    return TRUE;
+}
+
+static void
+sm_matrix_grid_set_focus_cell(SmMatrixGrid *self, guint row, guint col)
+{
+    if (row == self->focus_row && col == self->focus_col)
+    {
+        return;
+    }
+    sm_matrix_grid_queue_draw_cell(self, self->focus_row, self->focus_col);
+    self->focus_row = row;
+    self->focus_col = col;
+    sm_matrix_grid_queue_draw_cell(self, row, col);
+}
+
+static void
+sm_matrix_grid_channel_changed_cb(SmChannel *channel, gpointer user_data)
+{
+    SmMatrixGrid *self = SM_MATRIX_GRID(user_data);
+    gdouble vol_db;
+    guint idx;
+
+    for (idx = 0; idx < self->n_rows * self->n_cols; idx++)
+    {
+        if (self->cells[idx] == channel)
+        {
+            if (self->suspended)
+            {
+                // The gains stay current, the grid is redrawn once when resumed.
+                if (sm_channel_volume_get_db(channel, SND_MIXER_SCHN_MONO, &vol_db))
+                {
+                    self->gains[idx] = (gfloat)vol_db;
+                }
+                self->stale = TRUE;
+                return;
+            }
+            if (sm_channel_volume_get_db(channel, SND_MIXER_SCHN_MONO, &vol_db)
+                    && (gfloat)vol_db != self->gains[idx])
+            {
+                self->gains[idx] = (gfloat)vol_db;
+                sm_matrix_grid_queue_draw_cell(self, idx / self->n_cols, idx % self->n_cols);
+            }
+            // The display name is shown in the row label.
+            gtk_widget_queue_draw_area(GTK_WIDGET(self),
+                    0, SM_MATRIX_GRID_HEADER_HEIGHT + (idx / self->n_cols) * SM_MATRIX_GRID_CELL_HEIGHT,
+                    SM_MATRIX_GRID_LABEL_WIDTH, SM_MATRIX_GRID_CELL_HEIGHT);
+            return;
+        }
+    }
+}
+
+static void
+sm_matrix_grid_draw_text(GtkWidget *widget, cairo_t *cr, const gchar *text, const GdkRectangle *rect, gdouble xalign)
+{
+    PangoLayout *layout;
+    gint width, height;
+
+    layout = gtk_widget_create_pango_layout(widget, text);
+    pango_layout_set_width(layout, (rect->width - 8) * PANGO_SCALE);
+    pango_layout_set_ellipsize(layout, PANGO_ELLIPSIZE_END);
+    pango_layout_get_pixel_size(layout, &width, &height);
+    cairo_move_to(cr,
+            rect->x + 4 + xalign * (rect->width - 8 - width),
+            rect->y + (rect->height - height) / 2);
+    pango_cairo_show_layout(cr, layout);
+    g_object_unref(layout);
+}
+
+static const gchar*
+sm_matrix_grid_get_row_name(SmMatrixGrid *self, guint row)
+{
+    guint col;
+
+    for (col = 0; col < self->n_cols; col++)
+    {
+        if (self->cells[row * self->n_cols + col])
+        {
+            return sm_channel_get_display_name(self->cells[row * self->n_cols + col]);
+        }
+    }
+    return "";
+}
+
+static gboolean
+sm_matrix_grid_draw(GtkWidget *widget, cairo_t *cr)
+{
+    SmMatrixGrid *self = SM_MATRIX_GRID(widget);
+    GtkStyleContext *context;
+    GdkRGBA color;
+    GdkRectangle rect, clip;
+    gdouble fraction, lower, upper;
+    gchar text[16];
+    guint row, col, idx;
+
+    context = gtk_widget_get_style_context(widget);
+    gtk_style_context_get_color(context, gtk_widget_get_state_flags(widget), &color);
+    if (!gdk_cairo_get_clip_rectangle(cr, &clip))
+    {
+        return FALSE;
+    }
+
+    // Column headers
+    gdk_cairo_set_source_rgba(cr, &color);
+    for (col = 0; col < self->n_cols; col++)
+    {
+        sm_matrix_grid_get_cell_rect(self, 0, col, &rect);
+        rect.y = 0;
+        rect.height = SM_MATRIX_GRID_HEADER_HEIGHT;
+        g_snprintf(text, sizeof(text), "Mix %c", self->col_ids[col]);
+        sm_matrix_grid_draw_text(widget, cr, text, &rect, 0.5);
+    }
+
+    for (row = 0; row < self->n_rows; row++)
+    {
+        // Skip the rows outside of the invalid area.
+        sm_matrix_grid_get_cell_rect(self, row, 0, &rect);
+        if (rect.y + rect.height <= clip.y || rect.y >= clip.y + clip.height)
+        {
+            continue;
+        }
+        rect.x = 0;
+        rect.width = SM_MATRIX_GRID_LABEL_WIDTH;
+        gdk_cairo_set_source_rgba(cr, &color);
+        sm_matrix_grid_draw_text(widget, cr, sm_matrix_grid_get_row_name(self, row), &rect, 0.0);
+
+        for (col = 0; col < self->n_cols; col++)
+        {
+            idx = row * self->n_cols + col;
+            sm_matrix_grid_get_cell_rect(self, row, col, &rect);
+
+            // Frame
+            cairo_set_line_width(cr, 1.0);
+            cairo_set_source_rgba(cr, 46 / 255.0, 52 / 255.0, 54 / 255.0, 0.2);
+            cairo_rectangle(cr, rect.x + 0.5, rect.y + 0.5, rect.width - 1, rect.height - 1);
+            cairo_stroke(cr);
+            if (!self->cells[idx])
+            {
+                continue;
+            }
+
+            // Gain bar, scaled like the fader of the mix strips.
+            lower = sm_taper_get_lower(self->taper);
+            upper = sm_taper_get_upper(self->taper);
+            fraction = upper > lower
+                    ? (sm_taper_db_to_value(self->taper, self->gains[idx]) - lower) / (upper - lower)
+                    : 0.0;
+            fraction = CLAMP(fraction, 0.0, 1.0);
+            if (self->gains[idx] > 0.0)
+            {
+                cairo_set_source_rgb(cr, 0xf5 / 255.0, 0x79 / 255.0, 0x00 / 255.0);
+            }
+            else
+            {
+                cairo_set_source_rgb(cr, 0x4a / 255.0, 0x90 / 255.0, 0xd9 / 255.0);
+            }
+            cairo_rectangle(cr, rect.x + 1, rect.y + 1, (rect.width - 2) * fraction, rect.height - 2);
+            cairo_fill(cr);
+
+            if (self->gains[idx] <= self->min_db)
+            {
+                g_strlcpy(text, "-inf", sizeof(text));
+            }
+            else
+            {
+                g_strlcpy(text, sm_taper_get_label(self->taper,
+                            sm_taper_db_to_value(self->taper, self->gains[idx])), sizeof(text));
+            }
+            gdk_cairo_set_source_rgba(cr, &color);
+            sm_matrix_grid_draw_text(widget, cr, text, &rect, 1.0);
+
+            if (row == self->focus_row && col == self->focus_col && gtk_widget_has_focus(widget))
+            {
+                gtk_render_focus(context, cr, rect.x + 1, rect.y + 1, rect.width - 2, rect.height - 2);
+            }
+        }
+    }
+    return FALSE;
+}
+
+static void
+sm_matrix_grid_get_preferred_width(GtkWidget *widget, gint *minimum, gint *natural)
+{
+    SmMatrixGrid *self = SM_MATRIX_GRID(widget);
+
+    *minimum = *natural = SM_MATRIX_GRID_LABEL_WIDTH + self->n_cols * SM_MATRIX_GRID_CELL_WIDTH;
+}
+
+static void
+sm_matrix_grid_get_preferred_height(GtkWidget *widget, gint *minimum, gint *natural)
+{
+    SmMatrixGrid *self = SM_MATRIX_GRID(widget);
+
+    *minimum = *natural = SM_MATRIX_GRID_HEADER_HEIGHT + self->n_rows * SM_MATRIX_GRID_CELL_HEIGHT;
+}
+
+static void
+sm_matrix_grid_add_gain(SmMatrixGrid *self, gdouble delta_db)
+{
+    guint idx;
+
+    if (self->n_rows == 0)
+    {
+        return;
+    }
+    idx = self->focus_row * self->n_cols + self->focus_col;
+    sm_matrix_grid_set_gain(self, self->focus_row, self->focus_col, self->gains[idx] + delta_db);
+}
+
+static gboolean
+sm_matrix_grid_button_press_event(GtkWidget *widget, GdkEventButton *event)
+{
+    SmMatrixGrid *self = SM_MATRIX_GRID(widget);
+    guint row, col;
+
+    if (event->button != GDK_BUTTON_PRIMARY
+            || !sm_matrix_grid_hit_test(self, event->x, event->y, &row, &col))
+    {
+        return FALSE;
+    }
+    gtk_widget_grab_focus(widget);
+    sm_matrix_grid_set_focus_cell(self, row, col);
+    if (event->type == GDK_2BUTTON_PRESS)
+    {
+        // Double click resets the cell to unity gain.
+        sm_matrix_grid_set_gain(self, row, col, 0.0);
+        self->dragging = FALSE;
+        return TRUE;
+    }
+    self->dragging = self->cells[row * self->n_cols + col] != NULL;
+    self->drag_y = event->y;
+    self->drag_db = self->gains[row * self->n_cols + col];
+    return TRUE;
+}
+
+static gboolean
+sm_matrix_grid_motion_notify_event(GtkWidget *widget, GdkEventMotion *event)
+{
+    SmMatrixGrid *self = SM_MATRIX_GRID(widget);
+    gdouble step;
+
+    if (!self->dragging)
+    {
+        return FALSE;
+    }
+    step = (event->state & GDK_SHIFT_MASK) ? SM_MATRIX_GRID_FINE_STEP : SM_MATRIX_GRID_DRAG_STEP;
+    sm_matrix_grid_set_gain(self, self->focus_row, self->focus_col,
+            self->drag_db + (self->drag_y - event->y) * step);
+    return TRUE;
+}
+
+static gboolean
+sm_matrix_grid_button_release_event(GtkWidget *widget, GdkEventButton *event)
+{
+    SmMatrixGrid *self = SM_MATRIX_GRID(widget);
+
+    if (event->button != GDK_BUTTON_PRIMARY)
+    {
+        return FALSE;
+    }
+    self->dragging = FALSE;
+    return TRUE;
+}
+
+static gboolean
+sm_matrix_grid_scroll_event(GtkWidget *widget, GdkEventScroll *event)
+{
+    SmMatrixGrid *self = SM_MATRIX_GRID(widget);
+    guint row, col;
+
+    if (!sm_matrix_grid_hit_test(self, event->x, event->y, &row, &col))
+    {
+        return FALSE;
+    }
+    sm_matrix_grid_set_focus_cell(self, row, col);
+    switch (event->direction)
+    {
+        case GDK_SCROLL_UP:
+            sm_matrix_grid_add_gain(self, SM_MATRIX_GRID_KEY_STEP);
+            return TRUE;
+        case GDK_SCROLL_DOWN:
+            sm_matrix_grid_add_gain(self, -SM_MATRIX_GRID_KEY_STEP);
+            return TRUE;
+        default:
+            return FALSE;
+    }
+}
+
+static gboolean
+sm_matrix_grid_key_press_event(GtkWidget *widget, GdkEventKey *event)
+{
+    SmMatrixGrid *self = SM_MATRIX_GRID(widget);
+
+    if (self->n_rows == 0)
+    {
+        return FALSE;
+    }
+    switch (event->keyval)
+    {
+        case GDK_KEY_Up:
+        case GDK_KEY_KP_Up:
+            if (self->focus_row == 0)
+                return FALSE;
+            sm_matrix_grid_set_focus_cell(self, self->focus_row - 1, self->focus_col);
+            return TRUE;
+        case GDK_KEY_Down:
+        case GDK_KEY_KP_Down:
+            if (self->focus_row + 1 >= self->n_rows)
+                return FALSE;
+            sm_matrix_grid_set_focus_cell(self, self->focus_row + 1, self->focus_col);
+            return TRUE;
+        case GDK_KEY_Left:
+        case GDK_KEY_KP_Left:
+            if (self->focus_col == 0)
+                return FALSE;
+            sm_matrix_grid_set_focus_cell(self, self->focus_row, self->focus_col - 1);
+            return TRUE;
+        case GDK_KEY_Right:
+        case GDK_KEY_KP_Right:
+            if (self->focus_col + 1 >= self->n_cols)
+                return FALSE;
+            sm_matrix_grid_set_focus_cell(self, self->focus_row, self->focus_col + 1);
+            return TRUE;
+        case GDK_KEY_plus:
+        case GDK_KEY_KP_Add:
+            sm_matrix_grid_add_gain(self, SM_MATRIX_GRID_KEY_STEP);
+            return TRUE;
+        case GDK_KEY_minus:
+        case GDK_KEY_KP_Subtract:
+            sm_matrix_grid_add_gain(self, -SM_MATRIX_GRID_KEY_STEP);
+            return TRUE;
+        case GDK_KEY_Page_Up:
+        case GDK_KEY_KP_Page_Up:
+            sm_matrix_grid_add_gain(self, SM_MATRIX_GRID_PAGE_STEP);
+            return TRUE;
+        case GDK_KEY_Page_Down:
+        case GDK_KEY_KP_Page_Down:
+            sm_matrix_grid_add_gain(self, -SM_MATRIX_GRID_PAGE_STEP);
+            return TRUE;
+        case GDK_KEY_Home:
+        case GDK_KEY_KP_Home:
+            sm_matrix_grid_set_gain(self, self->focus_row, self->focus_col, self->max_db);
+            return TRUE;
+        case GDK_KEY_End:
+        case GDK_KEY_KP_End:
+            sm_matrix_grid_set_gain(self, self->focus_row, self->focus_col, self->min_db);
+            return TRUE;
+        case GDK_KEY_0:
+        case GDK_KEY_KP_0:
+            sm_matrix_grid_set_gain(self, self->focus_row, self->focus_col, 0.0);
+            return TRUE;
+        default:
+            return FALSE;
+    }
+}
+
+static gboolean
+sm_matrix_grid_focus_change_event(GtkWidget *widget, GdkEventFocus *event)
+{
+    SmMatrixGrid *self = SM_MATRIX_GRID(widget);
+
+    if (self->n_rows > 0)
+    {
+        sm_matrix_grid_queue_draw_cell(self, self->focus_row, self->focus_col);
+    }
+    return FALSE;
+}
+
+static void
+sm_matrix_grid_dispose(GObject *gobject)
+{
+    sm_matrix_grid_clear(SM_MATRIX_GRID(gobject));
+    G_OBJECT_CLASS(sm_matrix_grid_parent_class)->dispose(gobject);
+}
+
+static void
+sm_matrix_grid_class_init(SmMatrixGridClass *klass)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS(klass);
+    GtkWidgetClass *widget_class = GTK_WIDGET_CLASS(klass);
+
+    object_class->dispose = sm_matrix_grid_dispose;
+    widget_class->draw = sm_matrix_grid_draw;
+    widget_class->get_preferred_width = sm_matrix_grid_get_preferred_width;
+    widget_class->get_preferred_height = sm_matrix_grid_get_preferred_height;
+    widget_class->button_press_event = sm_matrix_grid_button_press_event;
+    widget_class->motion_notify_event = sm_matrix_grid_motion_notify_event;
+    widget_class->button_release_event = sm_matrix_grid_button_release_event;
+    widget_class->scroll_event = sm_matrix_grid_scroll_event;
+    widget_class->key_press_event = sm_matrix_grid_key_press_event;
+    widget_class->focus_in_event = sm_matrix_grid_focus_change_event;
+    widget_class->focus_out_event = sm_matrix_grid_focus_change_event;
+}
+
+static void
+sm_matrix_grid_init(SmMatrixGrid *self)
+{
+    gtk_widget_set_can_focus(GTK_WIDGET(self), TRUE);
+    gtk_widget_add_events(GTK_WIDGET(self),
+            GDK_BUTTON_PRESS_MASK | GDK_BUTTON_RELEASE_MASK | GDK_BUTTON1_MOTION_MASK
+            | GDK_SCROLL_MASK | GDK_KEY_PRESS_MASK | GDK_FOCUS_CHANGE_MASK);
+    self->min_db = -128.0;
+    self->max_db = 6.0;
+    self->taper = sm_taper_get_default(self->min_db, self->max_db, 0.0);
+}
+
+GtkWidget*
+sm_matrix_grid_new()
+{
+    return g_object_new(SM_TYPE_MATRIX_GRID, NULL);
+}
+
+void
+sm_matrix_grid_set_channels(SmMatrixGrid *self, GList *channels)
+{
+    GArray *row_ids, *col_ids;
+    SmChannel *ch;
+    GList *item;
+    guint id;
+    gchar mix_id;
+    gdouble vol_db, step_db;
+    gint row, col;
+    guint idx;
+    gboolean has_range = FALSE;
+
+    sm_matrix_grid_clear(self);
+    row_ids = g_array_new(FALSE, FALSE, sizeof(guint));
+    col_ids = g_array_new(FALSE, FALSE, sizeof(gchar));
+    for (item = g_list_first(channels); item; item = g_list_next(item))
+    {
+        ch = SM_CHANNEL(item->data);
+        if (sm_channel_get_channel_type(ch) != SM_CHANNEL_MIX)
+        {
+            continue;
+        }
+        id = sm_channel_get_id(ch);
+        mix_id = sm_channel_get_mix_id(ch);
+        for (idx = 0; idx < row_ids->len && g_array_index(row_ids, guint, idx) != id; idx++);
+        if (idx == row_ids->len)
+        {
+            g_array_append_val(row_ids, id);
+        }
+        for (idx = 0; idx < col_ids->len && g_array_index(col_ids, gchar, idx) != mix_id; idx++);
+        if (idx == col_ids->len)
+        {
+            g_array_append_val(col_ids, mix_id);
+        }
+        if (!has_range)
+        {
+            has_range = sm_channel_volume_get_range_db(ch, &self->min_db, &self->max_db);
+            step_db = 0.0;
+            if (has_range && sm_channel_volume_get_step_db(ch, &step_db))
+            {
+                self->taper = sm_taper_get_default(self->min_db, self->max_db, step_db);
+            }
+        }
+    }
+    g_array_sort(row_ids, sm_matrix_grid_compare_uint);
+    g_array_sort(col_ids, sm_matrix_grid_compare_char);
+    self->n_rows = row_ids->len;
+    self->n_cols = col_ids->len;
+    self->row_ids = (guint*)g_array_free(row_ids, FALSE);
+    self->col_ids = (gchar*)g_array_free(col_ids, FALSE);
+    self->gains = g_new(gfloat, self->n_rows * self->n_cols);
+    self->cells = g_new0(SmChannel*, self->n_rows * self->n_cols);
+    for (idx = 0; idx < self->n_rows * self->n_cols; idx++)
+    {
+        self->gains[idx] = (gfloat)self->min_db;
+    }
+
+    for (item = g_list_first(channels); item; item = g_list_next(item))
+    {
+        ch = SM_CHANNEL(item->data);
+        if (sm_channel_get_channel_type(ch) != SM_CHANNEL_MIX)
+        {
+            continue;
+        }
+        row = sm_matrix_grid_find_row(self, sm_channel_get_id(ch));
+        col = sm_matrix_grid_find_col(self, sm_channel_get_mix_id(ch));
+        idx = row * self->n_cols + col;
+        if (self->cells[idx])
+        {
+            g_warning("Duplicate matrix channel %s!", sm_channel_get_name(ch));
+            continue;
+        }
+        self->cells[idx] = g_object_ref(ch);
+        if (sm_channel_volume_get_db(ch, SND_MIXER_SCHN_MONO, &vol_db))
+        {
+            self->gains[idx] = (gfloat)vol_db;
+        }
+        g_signal_connect(ch, "changed", G_CALLBACK(sm_matrix_grid_channel_changed_cb), self);
+    }
+    gtk_widget_queue_resize(GTK_WIDGET(self));
+}
+
+const gfloat*
+sm_matrix_grid_get_gains(SmMatrixGrid *self, guint *n_rows, guint *n_cols)
+{
+    if (n_rows)
+    {
+        *n_rows = self->n_rows;
+    }
+    if (n_cols)
+    {
+        *n_cols = self->n_cols;
+    }
+    return self->gains;
+}
+
+gboolean
+sm_matrix_grid_set_gain(SmMatrixGrid *self, guint row, guint col, gdouble gain_db)
+{
+    guint idx;
+
+    if (row >= self->n_rows || col >= self->n_cols)
+    {
+        return FALSE;
+    }
+    idx = row * self->n_cols + col;
+    if (!self->cells[idx])
+    {
+        return FALSE;
+    }
+    // Snap to the volume steps of the hardware.
+    gain_db = sm_taper_value_to_db(self->taper, sm_taper_db_to_value(self->taper, gain_db));
+    if (!sm_channel_volume_set_db(self->cells[idx], SND_MIXER_SCHN_MONO, gain_db))
+    {
+        g_warning("sm_matrix_grid_set_gain: Cannot set volume in dB.");
+        return FALSE;
+    }
+    if ((gfloat)gain_db != self->gains[idx])
+    {
+        self->gains[idx] = (gfloat)gain_db;
+        sm_matrix_grid_queue_draw_cell(self, row, col);
+    }
+    return TRUE;
+}
+
+void
+sm_matrix_grid_set_suspended(SmMatrixGrid *self, gboolean suspended)
+{
+    if (self->suspended == suspended)
+    {
+        return;
+    }
+    self->suspended = suspended;
+    if (!suspended && self->stale)
+    {
+        self->stale = FALSE;
+        gtk_widget_queue_draw(GTK_WIDGET(self));
+    }
+}
@@ -0,0 +1,74 @@
+#ifndef __SM_MATRIX_GRID_H__
+#define __SM_MATRIX_GRID_H__
+/**
+ * @file
+ * @brief Header file for the matrix grid widget.
+ *
+ * The matrix grid draws all Matrix Mix channels as one grid of gain cells,
+ * one row per matrix input and one column per mix. It is an alternative to
+ * the mix strip pages, which create several widgets per matrix input.
+ * The gains are edited by dragging a cell vertically, with the scroll wheel
+ * or with the keyboard.
+ */
+#include <gtk/gtk.h>
+
+#include "sm-channel.h"
+
+G_BEGIN_DECLS
+
+/**
+ * @brief Macro to get the type information of the matrix grid widget.
+ */
+#define SM_TYPE_MATRIX_GRID sm_matrix_grid_get_type()
+/**
+ * @brief Macro declaring the final matrix grid widget type.
+ */
+G_DECLARE_FINAL_TYPE(SmMatrixGrid, sm_matrix_grid, SM, MATRIX_GRID, GtkDrawingArea);
+
+/**
+ * @brief Create a new matrix grid instance.
+ * @return Pointer to new matrix grid instance.
+ */
+GtkWidget*   sm_matrix_grid_new();
+
+/**
+ * @brief Set the Matrix Mix channels displayed by the grid.
+ * The rows are ordered by the channel id, the columns by the mix id.
+ * Channels of another type are ignored.
+ * @param self The matrix grid widget.
+ * @param channels List of @ref _SmChannel Matrix Mix channels.
+ */
+void         sm_matrix_grid_set_channels(SmMatrixGrid *self, GList *channels);
+
+/**
+ * @brief Get the gains of all cells.
+ * @param self The matrix grid widget.
+ * @param n_rows Return location for the number of rows, or NULL.
+ * @param n_cols Return location for the number of columns, or NULL.
+ * @return Array of n_rows * n_cols gains in dB in row-major order, owned by
+ * the grid. Cells without a channel hold the minimal gain.
+ */
+const gfloat* sm_matrix_grid_get_gains(SmMatrixGrid *self, guint *n_rows, guint *n_cols);
+
+/**
+ * @brief Set the gain of a cell.
+ * @param self The matrix grid widget.
+ * @param row The row index.
+ * @param col The column index.
+ * @param gain_db The gain in dB, clamped to the volume range.
+ * @return TRUE on success, FALSE if the cell has no channel.
+ */
+gboolean     sm_matrix_grid_set_gain(SmMatrixGrid *self, guint row, guint col, gdouble gain_db);
+
+/**
+ * @brief Suspend or resume the redraws of the grid.
+ * While suspended, the gains still follow the channels but no cell is
+ * invalidated. Resuming redraws the grid once if a gain changed.
+ * @param self The matrix grid widget.
+ * @param suspended TRUE to suspend the redraws, FALSE to resume them.
+ */
+void         sm_matrix_grid_set_suspended(SmMatrixGrid *self, gboolean suspended);
+
+G_END_DECLS
+
+#endif /* __SM_MATRIX_GRID_H__ */
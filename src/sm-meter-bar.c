@@ -0,0 +1,280 @@
+/*
+ * sm-meter-bar.c - GTK+ widget drawing the level of a capture channel.
+ * Copyright (c) 2016 Martin Roesch <martin.roesch79@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtk/gtk.h>
+
+#include "sm-meter-bar.h"
+
+#define SM_METER_BAR_WIDTH (15) ///< Natural width of the bar in pixels.
+#define SM_METER_BAR_HOLD_HEIGHT (2) ///< Height of the hold line in pixels.
+
+/**
+ * @brief Structure holding the state of the meter bar widget.
+ */
+struct _SmMeterBar
+{
+    GtkWidget parent_instance; ///< Parent object.
+
+    /* Other members, including private data. */
+    SmMeter *meter; ///< SmMeter providing the levels, or NULL.
+    gulong updated_handler_id; ///< Signal handler for the "updated" signal of the meter.
+    gint channel; ///< Displayed capture channel, or -1.
+    const SmTaper *taper; ///< Taper scaling the levels, or NULL.
+    SmMeterLevel level; ///< Displayed level.
+    gint peak_px; ///< Height of the drawn peak bar.
+    gint rms_px; ///< Height of the drawn RMS bar.
+    gint hold_px; ///< Height of the drawn hold line.
+};
+
+G_DEFINE_TYPE(SmMeterBar, sm_meter_bar, GTK_TYPE_WIDGET);
+
+static gint
+sm_meter_bar_db_to_px(SmMeterBar *self, gdouble db, gint height)
+{
+    gdouble lower, upper, fraction;
+
+    if (!self->taper)
+    {
+        return 0;
+    }
+    lower = sm_taper_get_lower(self->taper);
+    upper = sm_taper_get_upper(self->taper);
+    if (upper <= lower)
+    {
+        return 0;
+    }
+    fraction = (sm_taper_db_to_value(self->taper, db) - lower) / (upper - lower);
+    return (gint)(CLAMP(fraction, 0.0, 1.0) * height + 0.5);
+}
+
+static void
+sm_meter_bar_clear_level(SmMeterBar *self)
+{
+    gdouble floor_db;
+
+    floor_db = self->meter ? sm_meter_get_floor_db(self->meter) : -G_MAXDOUBLE;
+    self->level.peak_db = floor_db;
+    self->level.rms_db = floor_db;
+    self->level.hold_db = floor_db;
+    self->level.clips = 0;
+}
+
+/*
+ * Extend the invalid row span [top, bottom) of the bar by the rows between
+ * the old and the new height of a bar (measured from the bottom).
+ */
+static void
+sm_meter_bar_damage(gint old_px, gint new_px, gint extra, gint height, gint *top, gint *bottom)
+{
+    if (old_px == new_px)
+    {
+        return;
+    }
+    *top = MIN(*top, height - MAX(old_px, new_px) - extra);
+    *bottom = MAX(*bottom, height - MIN(old_px, new_px) + extra);
+}
+
+static void
+sm_meter_bar_refresh(SmMeterBar *self)
+{
+    gint height, peak_px, rms_px, hold_px;
+    gint top, bottom;
+
+    if (!self->meter || !sm_meter_get_level(self->meter, self->channel, &self->level))
+    {
+        sm_meter_bar_clear_level(self);
+    }
+    if (!gtk_widget_is_drawable(GTK_WIDGET(self)))
+    {
+        return;
+    }
+
+    height = gtk_widget_get_allocated_height(GTK_WIDGET(self));
+    peak_px = sm_meter_bar_db_to_px(self, self->level.peak_db, height);
+    rms_px = sm_meter_bar_db_to_px(self, self->level.rms_db, height);
+    hold_px = sm_meter_bar_db_to_px(self, self->level.hold_db, height);
+
+    // Only invalidate the rows which changed since the last frame.
+    top = height;
+    bottom = 0;
+    sm_meter_bar_damage(self->peak_px, peak_px, 0, height, &top, &bottom);
+    sm_meter_bar_damage(self->rms_px, rms_px, 0, height, &top, &bottom);
+    sm_meter_bar_damage(self->hold_px, hold_px, SM_METER_BAR_HOLD_HEIGHT, height, &top, &bottom);
+    if (top < bottom)
+    {
+        top = MAX(top, 0);
+        bottom = MIN(bottom, height);
+        gtk_widget_queue_draw_area(GTK_WIDGET(self),
+                0, top,
+                gtk_widget_get_allocated_width(GTK_WIDGET(self)), bottom - top);
+    }
+    self->peak_px = peak_px;
+    self->rms_px = rms_px;
+    self->hold_px = hold_px;
+}
+
+static void
+sm_meter_bar_meter_updated_cb(SmMeter *meter, gpointer user_data)
+{
+    sm_meter_bar_refresh(SM_METER_BAR(user_data));
+}
+
+static gboolean
+sm_meter_bar_draw(GtkWidget *widget, cairo_t *cr)
+{
+    SmMeterBar *self = SM_METER_BAR(widget);
+    gint width, height, zero_px;
+
+    width = gtk_widget_get_allocated_width(widget);
+    height = gtk_widget_get_allocated_height(widget);
+    self->peak_px = sm_meter_bar_db_to_px(self, self->level.peak_db, height);
+    self->rms_px = sm_meter_bar_db_to_px(self, self->level.rms_db, height);
+    self->hold_px = sm_meter_bar_db_to_px(self, self->level.hold_db, height);
+    zero_px = sm_meter_bar_db_to_px(self, 0.0, height);
+
+    // Frame.
+    cairo_set_line_width(cr, 1.0);
+    cairo_set_source_rgba(cr, 46 / 255.0, 52 / 255.0, 54 / 255.0, 0.2);
+    cairo_rectangle(cr, 0.5, 0.5, width - 1, height - 1);
+    cairo_stroke(cr);
+
+    // Peak bar, orange above 0 dB.
+    if (self->peak_px > 0)
+    {
+        cairo_set_source_rgb(cr, 0x7a / 255.0, 0xd9 / 255.0, 0x4a / 255.0);
+        cairo_rectangle(cr, 1, height - MIN(self->peak_px, zero_px), width - 2, MIN(self->peak_px, zero_px));
+        cairo_fill(cr);
+        if (self->peak_px > zero_px)
+        {
+            cairo_set_source_rgb(cr, 0xf5 / 255.0, 0x79 / 255.0, 0x00 / 255.0);
+            cairo_rectangle(cr, 1, height - self->peak_px, width - 2, self->peak_px - zero_px);
+            cairo_fill(cr);
+        }
+    }
+
+    // RMS bar inside the peak bar.
+    if (self->rms_px > 0)
+    {
+        cairo_set_source_rgb(cr, 0x5e / 255.0, 0xc6 / 255.0, 0x2a / 255.0);
+        cairo_rectangle(cr, width / 4, height - self->rms_px, width - 2 * (width / 4), self->rms_px);
+        cairo_fill(cr);
+    }
+
+    // Hold line.
+    if (self->hold_px > 0)
+    {
+        if (self->hold_px > zero_px)
+        {
+            cairo_set_source_rgb(cr, 0xc2 / 255.0, 0x60 / 255.0, 0x00 / 255.0);
+        }
+        else
+        {
+            cairo_set_source_rgb(cr, 0x5e / 255.0, 0xc6 / 255.0, 0x2a / 255.0);
+        }
+        cairo_rectangle(cr, 1, height - self->hold_px, width - 2,
+                MIN(self->hold_px, SM_METER_BAR_HOLD_HEIGHT));
+        cairo_fill(cr);
+    }
+    return FALSE;
+}
+
+static void
+sm_meter_bar_get_preferred_width(GtkWidget *widget, gint *minimum, gint *natural)
+{
+    *minimum = *natural = SM_METER_BAR_WIDTH;
+}
+
+static void
+sm_meter_bar_get_preferred_height(GtkWidget *widget, gint *minimum, gint *natural)
+{
+    *minimum = *natural = 2 * SM_METER_BAR_WIDTH;
+}
+
+static void
+sm_meter_bar_dispose(GObject *gobject)
+{
+    sm_meter_bar_set_meter(SM_METER_BAR(gobject), NULL);
+    G_OBJECT_CLASS(sm_meter_bar_parent_class)->dispose(gobject);
+}
+
+static void
+sm_meter_bar_class_init(SmMeterBarClass *klass)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS(klass);
+    GtkWidgetClass *widget_class = GTK_WIDGET_CLASS(klass);
+
+    object_class->dispose = sm_meter_bar_dispose;
+    widget_class->draw = sm_meter_bar_draw;
+    widget_class->get_preferred_width = sm_meter_bar_get_preferred_width;
+    widget_class->get_preferred_height = sm_meter_bar_get_preferred_height;
+}
+
+static void
+sm_meter_bar_init(SmMeterBar *self)
+{
+    gtk_widget_set_has_window(GTK_WIDGET(self), FALSE);
+    self->channel = -1;
+    sm_meter_bar_clear_level(self);
+}
+
+GtkWidget*
+sm_meter_bar_new()
+{
+    return g_object_new(SM_TYPE_METER_BAR, NULL);
+}
+
+void
+sm_meter_bar_set_taper(SmMeterBar *self, const SmTaper *taper)
+{
+    self->taper = taper;
+    gtk_widget_queue_draw(GTK_WIDGET(self));
+}
+
+void
+sm_meter_bar_set_meter(SmMeterBar *self, SmMeter *meter)
+{
+    if (self->meter == meter)
+    {
+        return;
+    }
+    if (self->meter)
+    {
+        g_signal_handler_disconnect(self->meter, self->updated_handler_id);
+        g_clear_object(&self->meter);
+    }
+    if (meter)
+    {
+        self->meter = g_object_ref(meter);
+        self->updated_handler_id = g_signal_connect(meter,
+                "updated",
+                G_CALLBACK(sm_meter_bar_meter_updated_cb),
+                self);
+    }
+    sm_meter_bar_refresh(self);
+}
+
+void
+sm_meter_bar_set_channel(SmMeterBar *self, gint channel)
+{
+    if (self->channel == channel)
+    {
+        return;
+    }
+    self->channel = channel;
+    sm_meter_bar_refresh(self);
+}
@@ -0,0 +1,59 @@
+#ifndef __SM_METER_BAR_H__
+#define __SM_METER_BAR_H__
+/**
+ * @file
+ * @brief Header file for the level meter bar widget.
+ *
+ * The meter bar draws the peak, RMS and hold level of a capture channel of a
+ * @ref _SmMeter. It is redrawn on the "updated" signal of the meter, only the
+ * rows which changed since the last frame are invalidated.
+ */
+#include <gtk/gtk.h>
+
+#include "sm-meter.h"
+#include "sm-taper.h"
+
+G_BEGIN_DECLS
+
+/**
+ * @brief Macro to get the type information of the meter bar widget.
+ */
+#define SM_TYPE_METER_BAR sm_meter_bar_get_type()
+/**
+ * @brief Macro declaring the final meter bar widget type.
+ */
+G_DECLARE_FINAL_TYPE(SmMeterBar, sm_meter_bar, SM, METER_BAR, GtkWidget);
+
+/**
+ * @brief Create a new meter bar instance.
+ * @return Pointer to new meter bar instance.
+ */
+GtkWidget*   sm_meter_bar_new();
+
+/**
+ * @brief Set the taper scaling the levels.
+ * The levels are scaled like the volume fader using the same taper, so the
+ * bar lines up with the fader. Levels outside the range of the taper are
+ * clamped.
+ * @param self The meter bar widget.
+ * @param taper The taper or NULL to show an empty bar.
+ */
+void         sm_meter_bar_set_taper(SmMeterBar *self, const SmTaper *taper);
+
+/**
+ * @brief Set the level meter providing the levels.
+ * @param self The meter bar widget.
+ * @param meter The level meter or NULL.
+ */
+void         sm_meter_bar_set_meter(SmMeterBar *self, SmMeter *meter);
+
+/**
+ * @brief Set the displayed capture channel.
+ * @param self The meter bar widget.
+ * @param channel The capture channel index or -1 to show an empty bar.
+ */
+void         sm_meter_bar_set_channel(SmMeterBar *self, gint channel);
+
+G_END_DECLS
+
+#endif /* __SM_METER_BAR_H__ */
@@ -0,0 +1,380 @@
+/*
+ * sm-meter-kernel.c - Sample kernels of the level meter.
+ * Copyright (c) 2016 Martin Roesch <martin.roesch79@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+
+#include "sm-meter-kernel.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define SM_METER_KERNEL_X86 (1)
+#include <immintrin.h>
+#else
+#define SM_METER_KERNEL_X86 (0)
+#endif
+
+#define SM_METER_KERNEL_SCALE (1.0f / 2147483648.0f) ///< Factor to normalize S32 samples.
+#define SM_METER_KERNEL_CLIP (0x7fffff00) ///< Absolute S32 value of a clipped 24 bit sample.
+#define SM_METER_KERNEL_CLIP_S16 (0x7fff0000) ///< Absolute S32 value of a clipped 16 bit sample.
+#define SM_METER_KERNEL_BLOCK (256) ///< Frames summed up in single precision before they are added to the accumulator.
+#define SM_METER_KERNEL_UNPACK (64) ///< Frames converted to S32 at once by the packed format kernels.
+
+/**
+ * @brief Function accumulating interleaved S32_LE frames.
+ * Samples with an absolute value of at least clip are counted as clipped.
+ */
+typedef void (*SmMeterKernelScanFunc)(const gint32 *frames, guint channels,
+        gsize n_frames, gint32 clip, SmMeterAccu *accu);
+
+static SmMeterKernelScanFunc sm_meter_kernel_scan = NULL;
+static const gchar *sm_meter_kernel_name = NULL;
+
+static inline void
+sm_meter_kernel_scan_sample(gint32 sample, gint32 clip, SmMeterAccu *accu, gfloat *sum)
+{
+    gfloat value;
+
+    value = (gfloat)sample * SM_METER_KERNEL_SCALE;
+    if (fabsf(value) > accu->peak)
+    {
+        accu->peak = fabsf(value);
+    }
+    *sum += value * value;
+    if (sample >= clip || sample <= -clip)
+    {
+        accu->clips++;
+    }
+}
+
+static void
+sm_meter_kernel_scan_s32_scalar(const gint32 *frames, guint channels,
+        gsize n_frames, gint32 clip, SmMeterAccu *accu)
+{
+    gfloat sum[SM_METER_KERNEL_MAX_CHANNELS];
+    gsize frame, block, n;
+    guint ch;
+
+    for (block = 0; block < n_frames; block += SM_METER_KERNEL_BLOCK)
+    {
+        n = MIN(SM_METER_KERNEL_BLOCK, n_frames - block);
+        for (ch = 0; ch < channels; ch++)
+        {
+            sum[ch] = 0.0f;
+        }
+        for (frame = block; frame < block + n; frame++)
+        {
+            for (ch = 0; ch < channels; ch++)
+            {
+                sm_meter_kernel_scan_sample(frames[frame * channels + ch], clip, &accu[ch], &sum[ch]);
+            }
+        }
+        for (ch = 0; ch < channels; ch++)
+        {
+            accu[ch].sum += sum[ch];
+        }
+    }
+    for (ch = 0; ch < channels; ch++)
+    {
+        accu[ch].count += n_frames;
+    }
+}
+
+void
+sm_meter_kernel_scan_s32_reference(const gint32 *frames, guint channels,
+        gsize n_frames, SmMeterAccu *accu)
+{
+    sm_meter_kernel_scan_s32_scalar(frames, channels, n_frames, SM_METER_KERNEL_CLIP, accu);
+}
+
+#if SM_METER_KERNEL_X86
+/*
+ * The vector kernels process one frame at a time: Each vector holds
+ * consecutive channels, the channels which do not fill a vector are
+ * processed with the scalar code.
+ */
+__attribute__((target("sse2")))
+static void
+sm_meter_kernel_scan_s32_sse2(const gint32 *frames, guint channels,
+        gsize n_frames, gint32 clip_abs, SmMeterAccu *accu)
+{
+    __m128 peak[SM_METER_KERNEL_MAX_CHANNELS / 4];
+    __m128 sum[SM_METER_KERNEL_MAX_CHANNELS / 4];
+    __m128i clips[SM_METER_KERNEL_MAX_CHANNELS / 4];
+    const __m128 scale = _mm_set1_ps(SM_METER_KERNEL_SCALE);
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    const __m128i clip_high = _mm_set1_epi32(clip_abs - 1);
+    const __m128i clip_low = _mm_set1_epi32(-clip_abs + 1);
+    gfloat tail_sum[4];
+    gfloat lanes[4];
+    gint32 counts[4];
+    const gint32 *row;
+    __m128i x, clip;
+    __m128 value;
+    gsize frame, block, n;
+    guint vectors, ch, v, idx;
+
+    vectors = channels / 4;
+    for (v = 0; v < vectors; v++)
+    {
+        peak[v] = _mm_setzero_ps();
+        clips[v] = _mm_setzero_si128();
+    }
+    for (block = 0; block < n_frames; block += SM_METER_KERNEL_BLOCK)
+    {
+        n = MIN(SM_METER_KERNEL_BLOCK, n_frames - block);
+        for (v = 0; v < vectors; v++)
+        {
+            sum[v] = _mm_setzero_ps();
+        }
+        for (ch = vectors * 4; ch < channels; ch++)
+        {
+            tail_sum[ch - vectors * 4] = 0.0f;
+        }
+        for (frame = block; frame < block + n; frame++)
+        {
+            row = frames + frame * channels;
+            for (v = 0; v < vectors; v++)
+            {
+                x = _mm_loadu_si128((const __m128i*)(row + v * 4));
+                value = _mm_mul_ps(_mm_cvtepi32_ps(x), scale);
+                peak[v] = _mm_max_ps(peak[v], _mm_andnot_ps(sign, value));
+                sum[v] = _mm_add_ps(sum[v], _mm_mul_ps(value, value));
+                clip = _mm_or_si128(_mm_cmpgt_epi32(x, clip_high), _mm_cmplt_epi32(x, clip_low));
+                clips[v] = _mm_sub_epi32(clips[v], clip);
+            }
+            for (ch = vectors * 4; ch < channels; ch++)
+            {
+                sm_meter_kernel_scan_sample(row[ch], clip_abs, &accu[ch], &tail_sum[ch - vectors * 4]);
+            }
+        }
+        for (v = 0; v < vectors; v++)
+        {
+            _mm_storeu_ps(lanes, sum[v]);
+            for (idx = 0; idx < 4; idx++)
+            {
+                accu[v * 4 + idx].sum += lanes[idx];
+            }
+        }
+        for (ch = vectors * 4; ch < channels; ch++)
+        {
+            accu[ch].sum += tail_sum[ch - vectors * 4];
+        }
+    }
+    for (v = 0; v < vectors; v++)
+    {
+        _mm_storeu_ps(lanes, peak[v]);
+        _mm_storeu_si128((__m128i*)counts, clips[v]);
+        for (idx = 0; idx < 4; idx++)
+        {
+            accu[v * 4 + idx].peak = MAX(accu[v * 4 + idx].peak, lanes[idx]);
+            accu[v * 4 + idx].clips += counts[idx];
+        }
+    }
+    for (ch = 0; ch < channels; ch++)
+    {
+        accu[ch].count += n_frames;
+    }
+}
+
+__attribute__((target("avx2,fma")))
+static void
+sm_meter_kernel_scan_s32_avx2(const gint32 *frames, guint channels,
+        gsize n_frames, gint32 clip_abs, SmMeterAccu *accu)
+{
+    __m256 peak[SM_METER_KERNEL_MAX_CHANNELS / 8];
+    __m256 sum[SM_METER_KERNEL_MAX_CHANNELS / 8];
+    __m256i clips[SM_METER_KERNEL_MAX_CHANNELS / 8];
+    const __m256 scale = _mm256_set1_ps(SM_METER_KERNEL_SCALE);
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+    const __m256i clip = _mm256_set1_epi32(clip_abs - 1);
+    gfloat tail_sum[8];
+    gfloat lanes[8];
+    gint32 counts[8];
+    const gint32 *row;
+    __m256i x;
+    __m256 value;
+    gsize frame, block, n;
+    guint vectors, ch, v, idx;
+
+    vectors = channels / 8;
+    for (v = 0; v < vectors; v++)
+    {
+        peak[v] = _mm256_setzero_ps();
+        clips[v] = _mm256_setzero_si256();
+    }
+    for (block = 0; block < n_frames; block += SM_METER_KERNEL_BLOCK)
+    {
+        n = MIN(SM_METER_KERNEL_BLOCK, n_frames - block);
+        for (v = 0; v < vectors; v++)
+        {
+            sum[v] = _mm256_setzero_ps();
+        }
+        for (ch = vectors * 8; ch < channels; ch++)
+        {
+            tail_sum[ch - vectors * 8] = 0.0f;
+        }
+        for (frame = block; frame < block + n; frame++)
+        {
+            row = frames + frame * channels;
+            for (v = 0; v < vectors; v++)
+            {
+                x = _mm256_loadu_si256((const __m256i*)(row + v * 8));
+                value = _mm256_mul_ps(_mm256_cvtepi32_ps(x), scale);
+                peak[v] = _mm256_max_ps(peak[v], _mm256_andnot_ps(sign, value));
+                sum[v] = _mm256_fmadd_ps(value, value, sum[v]);
+                // abs() keeps INT32_MIN negative, which is clipped as well.
+                x = _mm256_abs_epi32(x);
+                clips[v] = _mm256_sub_epi32(clips[v],
+                        _mm256_or_si256(_mm256_cmpgt_epi32(x, clip),
+                                _mm256_cmpgt_epi32(_mm256_setzero_si256(), x)));
+            }
+            for (ch = vectors * 8; ch < channels; ch++)
+            {
+                sm_meter_kernel_scan_sample(row[ch], clip_abs, &accu[ch], &tail_sum[ch - vectors * 8]);
+            }
+        }
+        for (v = 0; v < vectors; v++)
+        {
+            _mm256_storeu_ps(lanes, sum[v]);
+            for (idx = 0; idx < 8; idx++)
+            {
+                accu[v * 8 + idx].sum += lanes[idx];
+            }
+        }
+        for (ch = vectors * 8; ch < channels; ch++)
+        {
+            accu[ch].sum += tail_sum[ch - vectors * 8];
+        }
+    }
+    for (v = 0; v < vectors; v++)
+    {
+        _mm256_storeu_ps(lanes, peak[v]);
+        _mm256_storeu_si256((__m256i*)counts, clips[v]);
+        for (idx = 0; idx < 8; idx++)
+        {
+            accu[v * 8 + idx].peak = MAX(accu[v * 8 + idx].peak, lanes[idx]);
+            accu[v * 8 + idx].clips += counts[idx];
+        }
+    }
+    for (ch = 0; ch < channels; ch++)
+    {
+        accu[ch].count += n_frames;
+    }
+}
+#endif
+
+static void
+sm_meter_kernel_select(void)
+{
+    const gchar *env;
+
+    env = g_getenv("SCARLETTMIXER_METER_KERNEL");
+    sm_meter_kernel_scan = sm_meter_kernel_scan_s32_scalar;
+    sm_meter_kernel_name = "scalar";
+#if SM_METER_KERNEL_X86
+    __builtin_cpu_init();
+    if (g_strcmp0(env, "scalar") == 0)
+    {
+        return;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")
+            && g_strcmp0(env, "sse2") != 0)
+    {
+        sm_meter_kernel_scan = sm_meter_kernel_scan_s32_avx2;
+        sm_meter_kernel_name = "avx2";
+    }
+    else if (__builtin_cpu_supports("sse2"))
+    {
+        sm_meter_kernel_scan = sm_meter_kernel_scan_s32_sse2;
+        sm_meter_kernel_name = "sse2";
+    }
+#endif
+    g_debug("sm_meter_kernel_select: Using %s kernel.", sm_meter_kernel_name);
+}
+
+static SmMeterKernelScanFunc
+sm_meter_kernel_get_scan(void)
+{
+    static gsize selected = 0;
+
+    if (g_once_init_enter(&selected))
+    {
+        sm_meter_kernel_select();
+        g_once_init_leave(&selected, 1);
+    }
+    return sm_meter_kernel_scan;
+}
+
+const gchar*
+sm_meter_kernel_get_name(void)
+{
+    sm_meter_kernel_get_scan();
+    return sm_meter_kernel_name;
+}
+
+void
+sm_meter_kernel_scan_s32(const gint32 *frames, guint channels,
+        gsize n_frames, SmMeterAccu *accu)
+{
+    g_return_if_fail(channels <= SM_METER_KERNEL_MAX_CHANNELS);
+    sm_meter_kernel_get_scan()(frames, channels, n_frames, SM_METER_KERNEL_CLIP, accu);
+}
+
+void
+sm_meter_kernel_scan_s24_3le(const guint8 *frames, guint channels,
+        gsize n_frames, SmMeterAccu *accu)
+{
+    gint32 buffer[SM_METER_KERNEL_UNPACK * SM_METER_KERNEL_MAX_CHANNELS];
+    SmMeterKernelScanFunc scan;
+    gsize block, n, idx;
+
+    g_return_if_fail(channels <= SM_METER_KERNEL_MAX_CHANNELS);
+    scan = sm_meter_kernel_get_scan();
+    for (block = 0; block < n_frames; block += SM_METER_KERNEL_UNPACK)
+    {
+        n = MIN(SM_METER_KERNEL_UNPACK, n_frames - block);
+        for (idx = 0; idx < n * channels; idx++, frames += 3)
+        {
+            buffer[idx] = (gint32)((guint32)frames[0] << 8
+                    | (guint32)frames[1] << 16
+                    | (guint32)frames[2] << 24);
+        }
+        scan(buffer, channels, n, SM_METER_KERNEL_CLIP, accu);
+    }
+}
+
+void
+sm_meter_kernel_scan_s16(const gint16 *frames, guint channels,
+        gsize n_frames, SmMeterAccu *accu)
+{
+    gint32 buffer[SM_METER_KERNEL_UNPACK * SM_METER_KERNEL_MAX_CHANNELS];
+    SmMeterKernelScanFunc scan;
+    gsize block, n, idx;
+
+    g_return_if_fail(channels <= SM_METER_KERNEL_MAX_CHANNELS);
+    scan = sm_meter_kernel_get_scan();
+    for (block = 0; block < n_frames; block += SM_METER_KERNEL_UNPACK)
+    {
+        n = MIN(SM_METER_KERNEL_UNPACK, n_frames - block);
+        for (idx = 0; idx < n * channels; idx++)
+        {
+            buffer[idx] = (gint32)((guint32)(guint16)*frames++ << 16);
+        }
+        // The unpacked samples end in 16 zero bits, +32767 becomes 0x7fff0000.
+        scan(buffer, channels, n, SM_METER_KERNEL_CLIP_S16, accu);
+    }
+}
@@ -0,0 +1,89 @@
+#ifndef __SM_METER_KERNEL_H__
+#define __SM_METER_KERNEL_H__
+/**
+ * @file
+ * @brief Header file for the level meter sample kernels.
+ *
+ * The kernels scan interleaved multichannel frames in a single pass and
+ * accumulate the absolute peak, the sum of squares and the number of clipped
+ * samples of every channel. On x86 the SSE2 or AVX2 implementation is
+ * selected at runtime, other platforms use the scalar implementation.
+ * The `SCARLETTMIXER_METER_KERNEL` environment variable (`scalar`, `sse2` or
+ * `avx2`) forces an implementation, e.g. to compare the results.
+ */
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/**
+ * @brief Maximal number of interleaved channels the kernels accept.
+ */
+#define SM_METER_KERNEL_MAX_CHANNELS (32)
+
+/**
+ * @brief Type definition for the sample accumulator of a channel.
+ */
+typedef struct _SmMeterAccu SmMeterAccu;
+
+/**
+ * @brief Structure holding the accumulated samples of a channel.
+ * Sample values are normalized to [-1.0, 1.0).
+ */
+struct _SmMeterAccu
+{
+    gfloat peak; ///< Highest absolute sample value.
+    gdouble sum; ///< Sum of the squared sample values.
+    guint64 count; ///< Number of accumulated samples.
+    guint64 clips; ///< Number of samples at full scale (24 bit, 16 bit for S16_LE frames).
+};
+
+/**
+ * @brief Get the name of the selected kernel implementation.
+ * @return "scalar", "sse2" or "avx2".
+ */
+const gchar* sm_meter_kernel_get_name(void);
+
+/**
+ * @brief Accumulate interleaved S32_LE frames.
+ * @param frames The interleaved frames.
+ * @param channels Number of channels per frame, at most @ref SM_METER_KERNEL_MAX_CHANNELS.
+ * @param n_frames Number of frames.
+ * @param accu Array of channels accumulators to update.
+ */
+void         sm_meter_kernel_scan_s32(const gint32 *frames, guint channels,
+                                      gsize n_frames, SmMeterAccu *accu);
+
+/**
+ * @brief Accumulate interleaved S24_3LE frames.
+ * @param frames The interleaved frames (3 bytes per sample).
+ * @param channels Number of channels per frame, at most @ref SM_METER_KERNEL_MAX_CHANNELS.
+ * @param n_frames Number of frames.
+ * @param accu Array of channels accumulators to update.
+ */
+void         sm_meter_kernel_scan_s24_3le(const guint8 *frames, guint channels,
+                                          gsize n_frames, SmMeterAccu *accu);
+
+/**
+ * @brief Accumulate interleaved S16_LE frames.
+ * @param frames The interleaved frames.
+ * @param channels Number of channels per frame, at most @ref SM_METER_KERNEL_MAX_CHANNELS.
+ * @param n_frames Number of frames.
+ * @param accu Array of channels accumulators to update.
+ */
+void         sm_meter_kernel_scan_s16(const gint16 *frames, guint channels,
+                                      gsize n_frames, SmMeterAccu *accu);
+
+/**
+ * @brief Accumulate interleaved S32_LE frames with the scalar reference implementation.
+ * Used to verify the vectorized kernels.
+ * @param frames The interleaved frames.
+ * @param channels Number of channels per frame, at most @ref SM_METER_KERNEL_MAX_CHANNELS.
+ * @param n_frames Number of frames.
+ * @param accu Array of channels accumulators to update.
+ */
+void         sm_meter_kernel_scan_s32_reference(const gint32 *frames, guint channels,
+                                                gsize n_frames, SmMeterAccu *accu);
+
+G_END_DECLS
+
+#endif /* __SM_METER_KERNEL_H__ */
@@ -0,0 +1,603 @@
+/*
+ * sm-meter.c - Level meter reading the capture PCM of the Scarlett card.
+ * Copyright (c) 2016 Martin Roesch <martin.roesch79@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+#include <poll.h>
+#include <string.h>
+#include <alsa/asoundlib.h>
+
+#include "sm-meter.h"
+#include "sm-meter-kernel.h"
+#include "sm-source.h"
+#include "sm-enum.h"
+
+#define SM_METER_MAX_CHANNELS SM_METER_KERNEL_MAX_CHANNELS ///< Maximal number of metered capture channels.
+#define SM_METER_FLOOR_DB (-90.0) ///< Level in dBFS below which a signal is treated as silence.
+#define SM_METER_FALLBACK (20.0) ///< Fall back rate of the peak level in dB/s.
+#define SM_METER_HOLD_TIME (1500000) ///< Time in us the highest peak level is held.
+#define SM_METER_POLL_TIMEOUT (100) ///< Timeout in ms of the capture thread to check for a stop request.
+#define SM_METER_PERIOD_TIME (10000) ///< Requested period time of the capture PCM in us.
+
+/**
+ * @brief Structure holding the capture PCM state of the level meter.
+ */
+struct _SmMeter
+{
+    GObject parent_instance; ///< Parent object.
+
+    /* Other members, including private data. */
+    GThread *thread; ///< Capture thread.
+    gint running; ///< Indicates if the capture thread should keep running (atomic).
+    gchar *device; ///< Name of the capture PCM device.
+    gboolean suspended; ///< Indicates if the capture thread is stopped until @ref sm_meter_resume.
+    GMutex lock; ///< Lock protecting @ref _SmMeter::accu and @ref _SmMeter::n_channels.
+    guint n_channels; ///< Number of metered capture channels.
+    SmMeterAccu accu[SM_METER_MAX_CHANNELS]; ///< Samples accumulated by the capture thread since the last update.
+    SmMeterLevel levels[SM_METER_MAX_CHANNELS]; ///< Displayed levels.
+    gint64 hold_time[SM_METER_MAX_CHANNELS]; ///< Time the hold level was set.
+    gint64 last_update; ///< Time of the last update.
+    GList *sources; ///< List of @ref _SmSource input sources routing the capture channels.
+    gchar **routing; ///< Selected source name per capture channel.
+    gint idle; ///< Indicates if the levels are silent and no updates are expected (atomic).
+    gfloat silence; ///< Sample value corresponding to @ref SM_METER_FLOOR_DB.
+};
+
+G_DEFINE_TYPE(SmMeter, sm_meter, G_TYPE_OBJECT);
+
+enum
+{
+    SM_METER_SIGNAL_UPDATED, ///< Levels updated signal.
+    SM_METER_SIGNAL_ROUTING_CHANGED, ///< Capture routing changed signal.
+    SM_METER_SIGNAL_ACTIVE, ///< Signal above silence after the levels were idle.
+    N_SIGNALS ///< Number of signals.
+};
+
+static int sm_meter_signals[N_SIGNALS] = {0};
+
+static void
+sm_meter_clear_sources(SmMeter *self)
+{
+    GList *item;
+
+    for (item = g_list_first(self->sources); item; item = g_list_next(item))
+    {
+        g_signal_handlers_disconnect_by_data(item->data, self);
+    }
+    g_list_free_full(self->sources, g_object_unref);
+    self->sources = NULL;
+}
+
+static void
+sm_meter_dispose(GObject *gobject)
+{
+    SmMeter *self = SM_METER(gobject);
+
+    sm_meter_stop(self);
+    sm_meter_clear_sources(self);
+    G_OBJECT_CLASS(sm_meter_parent_class)->dispose(gobject);
+}
+
+static void
+sm_meter_finalize(GObject *gobject)
+{
+    SmMeter *self = SM_METER(gobject);
+
+    g_debug("sm_meter_finalize.");
+    g_free(self->device);
+    g_strfreev(self->routing);
+    g_mutex_clear(&self->lock);
+    G_OBJECT_CLASS(sm_meter_parent_class)->finalize(gobject);
+}
+
+static void
+sm_meter_class_init(SmMeterClass *klass)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS(klass);
+
+    object_class->dispose = sm_meter_dispose;
+    object_class->finalize = sm_meter_finalize;
+
+    sm_meter_signals[SM_METER_SIGNAL_UPDATED] =
+        g_signal_newv("updated",
+                      G_TYPE_FROM_CLASS(object_class),
+                      G_SIGNAL_RUN_LAST | G_SIGNAL_NO_RECURSE | G_SIGNAL_NO_HOOKS,
+                      NULL /* closure */,
+                      NULL /* accumulator */,
+                      NULL /* accumulator data */,
+                      NULL /* C marshaller */,
+                      G_TYPE_NONE /* return_type */,
+                      0     /* n_params */,
+                      NULL  /* param_types */);
+    sm_meter_signals[SM_METER_SIGNAL_ROUTING_CHANGED] =
+        g_signal_newv("routing-changed",
+                      G_TYPE_FROM_CLASS(object_class),
+                      G_SIGNAL_RUN_LAST | G_SIGNAL_NO_RECURSE | G_SIGNAL_NO_HOOKS,
+                      NULL /* closure */,
+                      NULL /* accumulator */,
+                      NULL /* accumulator data */,
+                      NULL /* C marshaller */,
+                      G_TYPE_NONE /* return_type */,
+                      0     /* n_params */,
+                      NULL  /* param_types */);
+    sm_meter_signals[SM_METER_SIGNAL_ACTIVE] =
+        g_signal_newv("active",
+                      G_TYPE_FROM_CLASS(object_class),
+                      G_SIGNAL_RUN_LAST | G_SIGNAL_NO_RECURSE | G_SIGNAL_NO_HOOKS,
+                      NULL /* closure */,
+                      NULL /* accumulator */,
+                      NULL /* accumulator data */,
+                      NULL /* C marshaller */,
+                      G_TYPE_NONE /* return_type */,
+                      0     /* n_params */,
+                      NULL  /* param_types */);
+}
+
+static void
+sm_meter_clear_levels(SmMeter *self)
+{
+    int idx;
+
+    for (idx = 0; idx < SM_METER_MAX_CHANNELS; idx++)
+    {
+        self->levels[idx].peak_db = SM_METER_FLOOR_DB;
+        self->levels[idx].rms_db = SM_METER_FLOOR_DB;
+        self->levels[idx].hold_db = SM_METER_FLOOR_DB;
+    }
+}
+
+static void
+sm_meter_init(SmMeter *self)
+{
+    g_mutex_init(&self->lock);
+    self->idle = TRUE;
+    self->silence = (gfloat)pow(10.0, SM_METER_FLOOR_DB / 20.0);
+    sm_meter_clear_levels(self);
+}
+
+static gboolean
+sm_meter_setup_pcm(snd_pcm_t *pcm, snd_pcm_format_t *format, guint *channels)
+{
+    snd_pcm_hw_params_t *hw;
+    snd_pcm_sw_params_t *sw;
+    snd_pcm_uframes_t period;
+    unsigned int period_time = SM_METER_PERIOD_TIME;
+    const snd_pcm_format_t formats[] = {
+        SND_PCM_FORMAT_S32_LE,
+        SND_PCM_FORMAT_S24_3LE,
+        SND_PCM_FORMAT_S16_LE
+    };
+    guint idx;
+    int err = 0;
+
+    snd_pcm_hw_params_alloca(&hw);
+    snd_pcm_sw_params_alloca(&sw);
+    snd_pcm_hw_params_any(pcm, hw);
+    err = snd_pcm_hw_params_set_access(pcm, hw, SND_PCM_ACCESS_MMAP_INTERLEAVED);
+    if (err < 0)
+    {
+        g_warning("sm_meter_setup_pcm: No mmap access: %s", snd_strerror(err));
+        return FALSE;
+    }
+    for (idx = 0; idx < G_N_ELEMENTS(formats); idx++)
+    {
+        *format = formats[idx];
+        err = snd_pcm_hw_params_set_format(pcm, hw, *format);
+        if (err >= 0)
+        {
+            break;
+        }
+    }
+    if (err < 0)
+    {
+        g_warning("sm_meter_setup_pcm: No supported sample format: %s", snd_strerror(err));
+        return FALSE;
+    }
+    // Meter as many capture channels as the card has.
+    *channels = SM_METER_MAX_CHANNELS;
+    snd_pcm_hw_params_set_channels_max(pcm, hw, channels);
+    snd_pcm_hw_params_set_channels_last(pcm, hw, channels);
+    snd_pcm_hw_params_set_period_time_near(pcm, hw, &period_time, NULL);
+    err = snd_pcm_hw_params(pcm, hw);
+    if (err < 0)
+    {
+        g_warning("sm_meter_setup_pcm: Cannot set hardware parameters: %s", snd_strerror(err));
+        return FALSE;
+    }
+    snd_pcm_hw_params_get_channels(hw, channels);
+    if (*channels > SM_METER_MAX_CHANNELS)
+    {
+        g_warning("sm_meter_setup_pcm: Too many capture channels: %u", *channels);
+        return FALSE;
+    }
+    snd_pcm_hw_params_get_period_size(hw, &period, NULL);
+
+    snd_pcm_sw_params_current(pcm, sw);
+    snd_pcm_sw_params_set_avail_min(pcm, sw, period);
+    err = snd_pcm_sw_params(pcm, sw);
+    if (err < 0)
+    {
+        g_warning("sm_meter_setup_pcm: Cannot set software parameters: %s", snd_strerror(err));
+        return FALSE;
+    }
+    g_debug("sm_meter_setup_pcm: %u channels, %s, %lu frames per period, %s kernel.",
+            *channels, snd_pcm_format_name(*format), period, sm_meter_kernel_get_name());
+    return TRUE;
+}
+
+static gboolean
+sm_meter_active_cb(gpointer user_data)
+{
+    SmMeter *self = SM_METER(user_data);
+
+    self->last_update = 0;
+    g_signal_emit(self, sm_meter_signals[SM_METER_SIGNAL_ACTIVE], 0);
+    return G_SOURCE_REMOVE;
+}
+
+/*
+ * Read all available frames from the mmap buffer and merge them into the
+ * accumulators of the meter.
+ */
+static int
+sm_meter_read(SmMeter *self, snd_pcm_t *pcm, snd_pcm_format_t format, guint channels)
+{
+    const snd_pcm_channel_area_t *areas;
+    snd_pcm_uframes_t offset, frames;
+    snd_pcm_sframes_t avail, committed;
+    SmMeterAccu local[SM_METER_MAX_CHANNELS] = {{ 0 }};
+    const guint8 *addr;
+    guint idx;
+    int err;
+
+    avail = snd_pcm_avail_update(pcm);
+    if (avail < 0)
+    {
+        return (int)avail;
+    }
+    while (avail > 0)
+    {
+        frames = avail;
+        err = snd_pcm_mmap_begin(pcm, &areas, &offset, &frames);
+        if (err < 0)
+        {
+            return err;
+        }
+        // The areas are interleaved: The first area points to the frames.
+        addr = (const guint8*)areas[0].addr
+            + (areas[0].first + offset * areas[0].step) / 8;
+        switch (format)
+        {
+            case SND_PCM_FORMAT_S32_LE:
+                sm_meter_kernel_scan_s32((const gint32*)addr, channels, frames, local);
+                break;
+            case SND_PCM_FORMAT_S24_3LE:
+                sm_meter_kernel_scan_s24_3le(addr, channels, frames, local);
+                break;
+            default:
+                sm_meter_kernel_scan_s16((const gint16*)addr, channels, frames, local);
+                break;
+        }
+        committed = snd_pcm_mmap_commit(pcm, offset, frames);
+        if (committed < 0 || (snd_pcm_uframes_t)committed != frames)
+        {
+            return committed < 0 ? (int)committed : -EPIPE;
+        }
+        avail -= frames;
+    }
+    g_mutex_lock(&self->lock);
+    for (idx = 0; idx < channels; idx++)
+    {
+        self->accu[idx].peak = MAX(self->accu[idx].peak, local[idx].peak);
+        self->accu[idx].sum += local[idx].sum;
+        self->accu[idx].count += local[idx].count;
+        self->accu[idx].clips += local[idx].clips;
+        if (local[idx].peak > self->silence
+                && g_atomic_int_compare_and_exchange(&self->idle, TRUE, FALSE))
+        {
+            // Wake up the display updates in the main thread.
+            g_idle_add_full(G_PRIORITY_DEFAULT, sm_meter_active_cb,
+                    g_object_ref(self), g_object_unref);
+        }
+    }
+    g_mutex_unlock(&self->lock);
+    return 0;
+}
+
+static gpointer
+sm_meter_capture_thread(gpointer data)
+{
+    SmMeter *self = SM_METER(data);
+    snd_pcm_t *pcm;
+    snd_pcm_format_t format;
+    struct pollfd *pfds;
+    unsigned short revents;
+    guint channels;
+    int npfds, err;
+
+    err = snd_pcm_open(&pcm, self->device, SND_PCM_STREAM_CAPTURE, SND_PCM_NONBLOCK);
+    if (err < 0)
+    {
+        g_warning("Cannot open capture PCM %s: %s", self->device, snd_strerror(err));
+        g_atomic_int_set(&self->running, FALSE);
+        return NULL;
+    }
+    if (!sm_meter_setup_pcm(pcm, &format, &channels))
+    {
+        snd_pcm_close(pcm);
+        g_atomic_int_set(&self->running, FALSE);
+        return NULL;
+    }
+    g_mutex_lock(&self->lock);
+    self->n_channels = channels;
+    g_mutex_unlock(&self->lock);
+
+    npfds = snd_pcm_poll_descriptors_count(pcm);
+    pfds = g_malloc(sizeof(*pfds) * npfds);
+    snd_pcm_poll_descriptors(pcm, pfds, npfds);
+    snd_pcm_start(pcm);
+    while (g_atomic_int_get(&self->running))
+    {
+        if (poll(pfds, npfds, SM_METER_POLL_TIMEOUT) <= 0)
+        {
+            continue;
+        }
+        snd_pcm_poll_descriptors_revents(pcm, pfds, npfds, &revents);
+        if (revents & POLLERR)
+        {
+            err = -EPIPE;
+        }
+        else if (revents & POLLIN)
+        {
+            err = sm_meter_read(self, pcm, format, channels);
+        }
+        else
+        {
+            continue;
+        }
+        if (err < 0)
+        {
+            // Overrun or suspend: Restart the capture.
+            g_debug("sm_meter_capture_thread: Recover from %s.", snd_strerror(err));
+            err = snd_pcm_recover(pcm, err, 1);
+            if (err < 0)
+            {
+                g_warning("Cannot recover capture PCM %s: %s", self->device, snd_strerror(err));
+                break;
+            }
+            snd_pcm_start(pcm);
+        }
+    }
+    g_free(pfds);
+    snd_pcm_close(pcm);
+    g_mutex_lock(&self->lock);
+    self->n_channels = 0;
+    g_mutex_unlock(&self->lock);
+    g_atomic_int_set(&self->running, FALSE);
+    return NULL;
+}
+
+static void
+sm_meter_update_routing(SmMeter *self)
+{
+    GPtrArray *routing;
+    GList *item;
+    const gchar *name;
+
+    routing = g_ptr_array_new();
+    for (item = g_list_first(self->sources); item; item = g_list_next(item))
+    {
+        name = sm_enum_get_name(sm_source_get_items(SM_SOURCE(item->data)),
+                sm_source_get_selected_item_index(SM_SOURCE(item->data)));
+        g_ptr_array_add(routing, g_strdup(name ? name : ""));
+    }
+    g_ptr_array_add(routing, NULL);
+    g_strfreev(self->routing);
+    self->routing = (gchar**)g_ptr_array_free(routing, FALSE);
+    g_signal_emit(self, sm_meter_signals[SM_METER_SIGNAL_ROUTING_CHANGED], 0);
+}
+
+static void
+sm_meter_source_changed_cb(SmSource *src, gpointer user_data)
+{
+    sm_meter_update_routing(SM_METER(user_data));
+}
+
+SmMeter*
+sm_meter_new()
+{
+    return g_object_new(SM_TYPE_METER, NULL);
+}
+
+static gboolean
+sm_meter_spawn(SmMeter *self)
+{
+    g_atomic_int_set(&self->running, TRUE);
+    self->thread = g_thread_new("sm-meter", sm_meter_capture_thread, self);
+    return self->thread != NULL;
+}
+
+gboolean
+sm_meter_start(SmMeter *self, int card_number)
+{
+    const gchar *env;
+
+    sm_meter_stop(self);
+    g_free(self->device);
+    env = g_getenv("SCARLETTMIXER_METER_DEVICE");
+    if (env && *env)
+    {
+        self->device = g_strdup(env);
+    }
+    else
+    {
+        self->device = g_strdup_printf("dsnoop:%d", card_number);
+    }
+    return sm_meter_spawn(self);
+}
+
+void
+sm_meter_stop(SmMeter *self)
+{
+    self->suspended = FALSE;
+    if (!self->thread)
+    {
+        return;
+    }
+    g_atomic_int_set(&self->running, FALSE);
+    g_thread_join(self->thread);
+    self->thread = NULL;
+    memset(self->accu, 0, sizeof(self->accu));
+    sm_meter_clear_levels(self);
+    g_atomic_int_set(&self->idle, TRUE);
+    g_signal_emit(self, sm_meter_signals[SM_METER_SIGNAL_UPDATED], 0);
+}
+
+void
+sm_meter_suspend(SmMeter *self)
+{
+    if (!self->thread)
+    {
+        return;
+    }
+    sm_meter_stop(self);
+    self->suspended = TRUE;
+}
+
+gboolean
+sm_meter_resume(SmMeter *self)
+{
+    if (!self->suspended)
+    {
+        return FALSE;
+    }
+    self->suspended = FALSE;
+    return sm_meter_spawn(self);
+}
+
+gboolean
+sm_meter_is_running(SmMeter *self)
+{
+    return g_atomic_int_get(&self->running);
+}
+
+void
+sm_meter_set_input_sources(SmMeter *self, GList *sources)
+{
+    GList *item;
+
+    sm_meter_clear_sources(self);
+    for (item = g_list_first(sources); item; item = g_list_next(item))
+    {
+        self->sources = g_list_append(self->sources, g_object_ref(item->data));
+        g_signal_connect(item->data, "changed",
+                G_CALLBACK(sm_meter_source_changed_cb), self);
+    }
+    sm_meter_update_routing(self);
+}
+
+gint
+sm_meter_find_channel(SmMeter *self, const gchar *item_name)
+{
+    gint idx;
+
+    if (!self->routing || !item_name || !*item_name)
+    {
+        return -1;
+    }
+    for (idx = 0; idx < SM_METER_MAX_CHANNELS && self->routing[idx]; idx++)
+    {
+        if (g_strcmp0(self->routing[idx], item_name) == 0)
+        {
+            return idx;
+        }
+    }
+    return -1;
+}
+
+gboolean
+sm_meter_update(SmMeter *self, gint64 time)
+{
+    SmMeterAccu accu[SM_METER_MAX_CHANNELS];
+    SmMeterLevel *level;
+    gdouble fallback, peak_db;
+    gboolean active = FALSE;
+    guint idx, n;
+
+    g_mutex_lock(&self->lock);
+    n = self->n_channels;
+    memcpy(accu, self->accu, sizeof(SmMeterAccu) * n);
+    memset(self->accu, 0, sizeof(SmMeterAccu) * n);
+    g_mutex_unlock(&self->lock);
+
+    fallback = 0.0;
+    if (self->last_update > 0 && time > self->last_update)
+    {
+        fallback = SM_METER_FALLBACK * (time - self->last_update) / G_USEC_PER_SEC;
+    }
+    self->last_update = time;
+    for (idx = 0; idx < n; idx++)
+    {
+        level = &self->levels[idx];
+        peak_db = SM_METER_FLOOR_DB;
+        level->rms_db = SM_METER_FLOOR_DB;
+        if (accu[idx].peak > self->silence)
+        {
+            peak_db = 20.0 * log10(accu[idx].peak);
+        }
+        if (accu[idx].count > 0 && accu[idx].sum > 0.0)
+        {
+            level->rms_db = MAX(10.0 * log10(accu[idx].sum / accu[idx].count), SM_METER_FLOOR_DB);
+        }
+        level->peak_db = MAX(peak_db, MAX(level->peak_db - fallback, SM_METER_FLOOR_DB));
+        level->clips += accu[idx].clips;
+        if (level->peak_db >= level->hold_db)
+        {
+            level->hold_db = level->peak_db;
+            self->hold_time[idx] = time;
+        }
+        else if (time - self->hold_time[idx] > SM_METER_HOLD_TIME)
+        {
+            level->hold_db = MAX(level->peak_db, level->hold_db - fallback);
+        }
+        // The hold level is the last one to fall back to silence.
+        active |= level->hold_db > SM_METER_FLOOR_DB;
+    }
+    if (!active)
+    {
+        g_atomic_int_set(&self->idle, TRUE);
+    }
+    g_signal_emit(self, sm_meter_signals[SM_METER_SIGNAL_UPDATED], 0);
+    return active;
+}
+
+gdouble
+sm_meter_get_floor_db(SmMeter *self)
+{
+    return SM_METER_FLOOR_DB;
+}
+
+gboolean
+sm_meter_get_level(SmMeter *self, gint channel, SmMeterLevel *level)
+{
+    if (channel < 0 || (guint)channel >= self->n_channels || !sm_meter_is_running(self))
+    {
+        return FALSE;
+    }
+    *level = self->levels[channel];
+    return TRUE;
+}
@@ -0,0 +1,134 @@
+#ifndef __SM_METER_H__
+#define __SM_METER_H__
+/**
+ * @file
+ * @brief Header file for the scarlett mixer level meter object.
+ *
+ * The level meter reads the capture PCM of the Scarlett card on a dedicated
+ * thread and computes the peak and RMS level of every capture channel.
+ * The capture channels are routed by the input sources, so a signal can be
+ * metered if an input source selects it.
+ */
+#include <glib.h>
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+/**
+ * @brief Macro to get the type information of the level meter object.
+ */
+#define SM_TYPE_METER sm_meter_get_type()
+/**
+ * @brief Macro declaring the final level meter object type.
+ */
+G_DECLARE_FINAL_TYPE(SmMeter, sm_meter, SM, METER, GObject);
+
+/**
+ * @brief Type definition for the level of a capture channel.
+ */
+typedef struct _SmMeterLevel SmMeterLevel;
+
+/**
+ * @brief Structure holding the level of a capture channel in dBFS.
+ */
+struct _SmMeterLevel
+{
+    gdouble peak_db; ///< Peak level with fall back.
+    gdouble rms_db; ///< RMS level of the last display interval.
+    gdouble hold_db; ///< Highest peak level of the hold interval.
+    guint64 clips; ///< Number of clipped samples since the meter was started.
+};
+
+/**
+ * @brief Create a new level meter instance.
+ * @return Pointer to new level meter instance.
+ */
+SmMeter*     sm_meter_new();
+
+/**
+ * @brief Start reading the capture PCM of a sound card.
+ * The PCM is opened through the `dsnoop` plugin, so other capture clients
+ * can share it. The `SCARLETTMIXER_METER_DEVICE` environment variable
+ * overrides the PCM device name. A running meter is stopped first.
+ * @param self The level meter object.
+ * @param card_number ALSA card number.
+ * @return TRUE if the capture thread was started, FALSE otherwise.
+ */
+gboolean     sm_meter_start(SmMeter *self, int card_number);
+
+/**
+ * @brief Stop reading the capture PCM.
+ * @param self The level meter object.
+ */
+void         sm_meter_stop(SmMeter *self);
+
+/**
+ * @brief Stop reading the capture PCM until the meter is resumed.
+ * Unlike @ref sm_meter_stop, the PCM device is kept, so that
+ * @ref sm_meter_resume reopens it. Does nothing if the meter is not running.
+ * @param self The level meter object.
+ */
+void         sm_meter_suspend(SmMeter *self);
+
+/**
+ * @brief Restart reading the capture PCM of a suspended meter.
+ * @param self The level meter object.
+ * @return TRUE if the capture thread was restarted, FALSE if the meter was
+ * not suspended or the thread could not be started.
+ */
+gboolean     sm_meter_resume(SmMeter *self);
+
+/**
+ * @brief Check whether the capture thread is running.
+ * @param self The level meter object.
+ * @return TRUE if the capture thread is running, FALSE otherwise.
+ */
+gboolean     sm_meter_is_running(SmMeter *self);
+
+/**
+ * @brief Set the input sources which route the signals to the capture channels.
+ * The n-th input source feeds the n-th capture channel.
+ * Emits the "routing-changed" signal.
+ * @param self The level meter object.
+ * @param sources List of @ref _SmSource input sources.
+ */
+void         sm_meter_set_input_sources(SmMeter *self, GList *sources);
+
+/**
+ * @brief Find the capture channel carrying a signal.
+ * @param self The level meter object.
+ * @param item_name Source name of the signal (e.g. "Analog 1").
+ * @return The capture channel index or -1 if the signal is not captured.
+ */
+gint         sm_meter_find_channel(SmMeter *self, const gchar *item_name);
+
+/**
+ * @brief Update the displayed levels from the samples read since the last call.
+ * Should be called once per frame while the levels are active. Emits the
+ * "updated" signal. Once all levels have fallen back to silence, the meter
+ * is idle and emits the "active" signal as soon as a signal is captured.
+ * @param self The level meter object.
+ * @param time Monotonic time of the update in microseconds.
+ * @return TRUE if further updates are needed, FALSE if all levels are silent.
+ */
+gboolean     sm_meter_update(SmMeter *self, gint64 time);
+
+/**
+ * @brief Get the level which is treated as silence.
+ * @param self The level meter object.
+ * @return The level in dBFS.
+ */
+gdouble      sm_meter_get_floor_db(SmMeter *self);
+
+/**
+ * @brief Get the displayed level of a capture channel.
+ * @param self The level meter object.
+ * @param channel The capture channel index.
+ * @param level The level to fill in.
+ * @return TRUE on success, FALSE if the channel is not captured.
+ */
+gboolean     sm_meter_get_level(SmMeter *self, gint channel, SmMeterLevel *level);
+
+G_END_DECLS
+
+#endif /* __SM_METER_H__ */
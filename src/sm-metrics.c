@@ -0,0 +1,243 @@
+/*
+ * sm-metrics.c - Operational metrics.
+ * Copyright (c) 2016 Martin Roesch <martin.roesch79@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "sm-metrics.h"
+
+#define SM_METRICS_N_BOUNDS (10) ///< Number of finite histogram buckets.
+#define SM_METRICS_PREFIX "scarlettmixer_" ///< Prefix of the metric names.
+
+/**
+ * @brief Type definition for a histogram.
+ */
+typedef struct _SmMetricsHistogram SmMetricsHistogram;
+
+/**
+ * @brief Structure holding a histogram of durations.
+ */
+struct _SmMetricsHistogram
+{
+    const gdouble *bounds; ///< Upper bounds of the finite buckets in seconds.
+    guint64 buckets[SM_METRICS_N_BOUNDS + 1]; ///< Number of observations per bucket, the last is unbounded.
+    gdouble sum; ///< Sum of the observations in seconds.
+    guint64 count; ///< Number of observations.
+};
+
+static const gdouble sm_metrics_dispatch_bounds[SM_METRICS_N_BOUNDS] =
+    { 0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1 };
+static const gdouble sm_metrics_apply_bounds[SM_METRICS_N_BOUNDS] =
+    { 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0 };
+
+static const gchar *sm_metrics_control_names[SM_METRICS_N_CONTROLS] =
+    { "volume", "mute", "source", "switch" };
+static const gchar *sm_metrics_result_names[SM_METRICS_N_WRITE_RESULTS] =
+    { "done", "skipped", "failed" };
+static const gchar *sm_metrics_switch_names[SM_METRICS_N_SWITCHES] =
+    { "clock_source", "sync_status" };
+
+static guint64 sm_metrics_events = 0;
+static guint64 sm_metrics_writes[SM_METRICS_N_CONTROLS][SM_METRICS_N_WRITE_RESULTS];
+static guint64 sm_metrics_apply_failures = 0;
+static SmMetricsHistogram sm_metrics_dispatch = { sm_metrics_dispatch_bounds };
+static SmMetricsHistogram sm_metrics_apply = { sm_metrics_apply_bounds };
+static gchar *sm_metrics_switch_items[SM_METRICS_N_SWITCHES];
+static guint64 sm_metrics_switch_changes[SM_METRICS_N_SWITCHES];
+
+static void
+sm_metrics_histogram_observe(SmMetricsHistogram *histogram, gint64 usec)
+{
+    gdouble value;
+    guint idx;
+
+    value = usec / 1000000.0;
+    idx = 0;
+    while (idx < SM_METRICS_N_BOUNDS && value > histogram->bounds[idx])
+    {
+        idx++;
+    }
+    histogram->buckets[idx]++;
+    histogram->sum += value;
+    histogram->count++;
+}
+
+static void
+sm_metrics_append_header(GString *out, const gchar *name, const gchar *type, const gchar *help)
+{
+    g_string_append_printf(out, "# HELP " SM_METRICS_PREFIX "%s %s\n", name, help);
+    g_string_append_printf(out, "# TYPE " SM_METRICS_PREFIX "%s %s\n", name, type);
+}
+
+static void
+sm_metrics_append_counter(GString *out, const gchar *name, const gchar *help, guint64 value)
+{
+    sm_metrics_append_header(out, name, "counter", help);
+    g_string_append_printf(out, SM_METRICS_PREFIX "%s %" G_GUINT64_FORMAT "\n", name, value);
+}
+
+static void
+sm_metrics_append_histogram(GString *out, const gchar *name, const gchar *help,
+        const SmMetricsHistogram *histogram)
+{
+    gchar buf[G_ASCII_DTOSTR_BUF_SIZE];
+    guint64 cumulative;
+    guint idx;
+
+    sm_metrics_append_header(out, name, "histogram", help);
+    cumulative = 0;
+    for (idx = 0; idx < SM_METRICS_N_BOUNDS; idx++)
+    {
+        cumulative += histogram->buckets[idx];
+        g_string_append_printf(out, SM_METRICS_PREFIX "%s_bucket{le=\"%s\"} %" G_GUINT64_FORMAT "\n",
+                name, g_ascii_formatd(buf, sizeof(buf), "%g", histogram->bounds[idx]), cumulative);
+    }
+    g_string_append_printf(out, SM_METRICS_PREFIX "%s_bucket{le=\"+Inf\"} %" G_GUINT64_FORMAT "\n",
+            name, histogram->count);
+    g_string_append_printf(out, SM_METRICS_PREFIX "%s_sum %s\n",
+            name, g_ascii_formatd(buf, sizeof(buf), "%.6f", histogram->sum));
+    g_string_append_printf(out, SM_METRICS_PREFIX "%s_count %" G_GUINT64_FORMAT "\n",
+            name, histogram->count);
+}
+
+/*
+ * Append a label value, escaping backslash, double quote and line feed.
+ */
+static void
+sm_metrics_append_label_value(GString *out, const gchar *value)
+{
+    for (; *value; value++)
+    {
+        switch (*value)
+        {
+        case '\\':
+            g_string_append(out, "\\\\");
+            break;
+        case '"':
+            g_string_append(out, "\\\"");
+            break;
+        case '\n':
+            g_string_append(out, "\\n");
+            break;
+        default:
+            g_string_append_c(out, *value);
+            break;
+        }
+    }
+}
+
+void
+sm_metrics_count_event(void)
+{
+    sm_metrics_events++;
+}
+
+void
+sm_metrics_observe_dispatch(gint64 usec)
+{
+    sm_metrics_histogram_observe(&sm_metrics_dispatch, usec);
+}
+
+void
+sm_metrics_count_write(SmMetricsControl control, SmMetricsWriteResult result)
+{
+    sm_metrics_writes[control][result]++;
+}
+
+void
+sm_metrics_observe_apply(gint64 usec, gboolean ok)
+{
+    sm_metrics_histogram_observe(&sm_metrics_apply, usec);
+    if (!ok)
+    {
+        sm_metrics_apply_failures++;
+    }
+}
+
+void
+sm_metrics_set_switch_item(SmMetricsSwitch sw, const gchar *item)
+{
+    if (g_strcmp0(sm_metrics_switch_items[sw], item) == 0)
+    {
+        return;
+    }
+    // Opening or closing the mixer is no transition.
+    if (sm_metrics_switch_items[sw] && item)
+    {
+        sm_metrics_switch_changes[sw]++;
+    }
+    g_free(sm_metrics_switch_items[sw]);
+    sm_metrics_switch_items[sw] = g_strdup(item);
+}
+
+gchar*
+sm_metrics_format(void)
+{
+    GString *out;
+    gchar *name;
+    guint control, result, sw;
+
+    out = g_string_new(NULL);
+    sm_metrics_append_counter(out, "mixer_events_total",
+            "Value change events received from the mixer.", sm_metrics_events);
+    sm_metrics_append_histogram(out, "mixer_dispatch_seconds",
+            "Time spent dispatching the pending mixer events.", &sm_metrics_dispatch);
+
+    sm_metrics_append_header(out, "mixer_writes_total", "counter",
+            "Writes to the mixer by control kind and result.");
+    for (control = 0; control < SM_METRICS_N_CONTROLS; control++)
+    {
+        for (result = 0; result < SM_METRICS_N_WRITE_RESULTS; result++)
+        {
+            g_string_append_printf(out,
+                    SM_METRICS_PREFIX "mixer_writes_total{control=\"%s\",result=\"%s\"} %" G_GUINT64_FORMAT "\n",
+                    sm_metrics_control_names[control], sm_metrics_result_names[result],
+                    sm_metrics_writes[control][result]);
+        }
+    }
+
+    sm_metrics_append_histogram(out, "config_apply_seconds",
+            "Time spent applying configuration files.", &sm_metrics_apply);
+    sm_metrics_append_counter(out, "config_apply_failures_total",
+            "Configuration files which could not be applied.", sm_metrics_apply_failures);
+
+    for (sw = 0; sw < SM_METRICS_N_SWITCHES; sw++)
+    {
+        sm_metrics_append_header(out, sm_metrics_switch_names[sw], "gauge",
+                "Selected item, 1 for the current item, no sample while the mixer is closed.");
+        if (sm_metrics_switch_items[sw])
+        {
+            g_string_append_printf(out, SM_METRICS_PREFIX "%s{item=\"", sm_metrics_switch_names[sw]);
+            sm_metrics_append_label_value(out, sm_metrics_switch_items[sw]);
+            g_string_append(out, "\"} 1\n");
+        }
+        name = g_strconcat(sm_metrics_switch_names[sw], "_changes_total", NULL);
+        sm_metrics_append_counter(out, name, "Changes of the selected item.", sm_metrics_switch_changes[sw]);
+        g_free(name);
+    }
+    return g_string_free(out, FALSE);
+}
+
+gboolean
+sm_metrics_write_file(const gchar *filename, GError **err)
+{
+    gchar *data;
+    gboolean ret;
+
+    data = sm_metrics_format();
+    ret = g_file_set_contents(filename, data, -1, err);
+    g_free(data);
+    return ret;
+}
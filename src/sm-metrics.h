@@ -0,0 +1,101 @@
+#ifndef __SM_METRICS_H__
+#define __SM_METRICS_H__
+/**
+ * @file
+ * @brief Header file for the operational metrics.
+ *
+ * The metrics module counts mixer events and writes, records the time spent
+ * dispatching mixer events and applying configurations, and follows the
+ * clock source and sync status. Recording only increments counters, so it is
+ * always active. The metrics are formatted in the Prometheus text exposition
+ * format, served by the HTTP server at `/metrics` or written to a file for
+ * the textfile collector of the node exporter.
+ */
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/**
+ * @brief Enumeration of the kinds of written controls.
+ */
+typedef enum
+{
+    SM_METRICS_CONTROL_VOLUME, ///< Channel volume.
+    SM_METRICS_CONTROL_MUTE, ///< Channel mute.
+    SM_METRICS_CONTROL_SOURCE, ///< Channel or input source.
+    SM_METRICS_CONTROL_SWITCH, ///< Switch.
+    SM_METRICS_N_CONTROLS ///< Number of control kinds.
+} SmMetricsControl;
+
+/**
+ * @brief Enumeration of the results of a write.
+ */
+typedef enum
+{
+    SM_METRICS_WRITE_DONE, ///< The value was written.
+    SM_METRICS_WRITE_SKIPPED, ///< The write was skipped, the mixer already had the value.
+    SM_METRICS_WRITE_FAILED, ///< ALSA reported an error.
+    SM_METRICS_N_WRITE_RESULTS ///< Number of write results.
+} SmMetricsWriteResult;
+
+/**
+ * @brief Enumeration of the followed switches.
+ */
+typedef enum
+{
+    SM_METRICS_SWITCH_CLOCK_SOURCE, ///< Clock source.
+    SM_METRICS_SWITCH_SYNC_STATUS, ///< Sync status.
+    SM_METRICS_N_SWITCHES ///< Number of followed switches.
+} SmMetricsSwitch;
+
+/**
+ * @brief Count a value change event received from the mixer.
+ */
+void     sm_metrics_count_event(void);
+
+/**
+ * @brief Record the time spent dispatching the pending mixer events.
+ * @param usec Duration in microseconds.
+ */
+void     sm_metrics_observe_dispatch(gint64 usec);
+
+/**
+ * @brief Count a write to the mixer.
+ * @param control The kind of the written control.
+ * @param result The result of the write.
+ */
+void     sm_metrics_count_write(SmMetricsControl control, SmMetricsWriteResult result);
+
+/**
+ * @brief Record the time spent applying a configuration file.
+ * @param usec Duration in microseconds.
+ * @param ok TRUE if the configuration was applied, FALSE otherwise.
+ */
+void     sm_metrics_observe_apply(gint64 usec, gboolean ok);
+
+/**
+ * @brief Set the selected item of a followed switch.
+ * A change from one item to another is counted as transition.
+ * @param sw The switch.
+ * @param item The item name, or NULL if the mixer is closed.
+ */
+void     sm_metrics_set_switch_item(SmMetricsSwitch sw, const gchar *item);
+
+/**
+ * @brief Format all metrics in the Prometheus text exposition format.
+ * @return The formatted metrics, free with g_free().
+ */
+gchar   *sm_metrics_format(void);
+
+/**
+ * @brief Write the formatted metrics to a file.
+ * The file is replaced atomically, so readers never see a partial file.
+ * @param filename Path of the file.
+ * @param err The GError that will be initialized in case of an error.
+ * @return TRUE on success, FALSE otherwise.
+ */
+gboolean sm_metrics_write_file(const gchar *filename, GError **err);
+
+G_END_DECLS
+
+#endif /* __SM_METRICS_H__ */
@@ -0,0 +1,676 @@
+/*
+ * sm-midi.c - MIDI control surface client.
+ * Copyright (c) 2016 Martin Roesch <martin.roesch79@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+#include <string.h>
+#include <alsa/asoundlib.h>
+#include <gio/gio.h>
+
+#include "config.h"
+#include "sm-midi.h"
+#include "sm-controls.h"
+#include "sm-controls-monitor.h"
+
+#define SM_MIDI_WRITE_INTERVAL (20) ///< Minimal time between two writes to the mixer in milliseconds.
+#define SM_MIDI_FEEDBACK_INTERVAL (20) ///< Minimal time between two feedback updates in milliseconds.
+#define SM_MIDI_TOUCH_TIMEOUT (250) ///< Time in milliseconds a moved controller gets no feedback.
+#define SM_MIDI_MAPPINGS_FILE "midi-mappings" ///< File name of the stored mappings.
+#define SM_MIDI_CC_MAX (0x7f) ///< Maximal value of a 7-bit controller.
+#define SM_MIDI_CC14_MAX (0x3fff) ///< Maximal value of a 14-bit controller or NRPN.
+
+/**
+ * @brief Types of controller mappings.
+ */
+typedef enum
+{
+    SM_MIDI_MAPPING_CC, ///< 7-bit control change.
+    SM_MIDI_MAPPING_CC14, ///< 14-bit control change, MSB on CC n and LSB on CC n + 32.
+    SM_MIDI_MAPPING_NRPN, ///< Non-registered parameter number with 14-bit data entry.
+    SM_MIDI_N_MAPPING_TYPES ///< Number of mapping types.
+} SmMidiMappingType;
+
+static const gchar *sm_midi_mapping_type_names[SM_MIDI_N_MAPPING_TYPES] = { "cc", "cc14", "nrpn" };
+
+/**
+ * @brief Structure holding the mapping of a controller to a control.
+ */
+typedef struct
+{
+    gchar *control; ///< The control name.
+    SmMidiMappingType type; ///< Type of the controller.
+    guint channel; ///< MIDI channel 0-15.
+    guint number; ///< Controller or parameter number.
+    gint value; ///< Last value received from or sent to the controller, or -1.
+    gint64 touched; ///< Monotonic time the last value was received in microseconds.
+} SmMidiMapping;
+
+/**
+ * @brief Structure holding the state of the MIDI client.
+ */
+struct _SmMidiClient
+{
+    GObject parent_instance; ///< Parent object.
+
+    /* Other members, including private data. */
+    SmApp *app; ///< The application object (not referenced, it owns the client).
+    snd_seq_t *seq; ///< ALSA sequencer handle, or NULL.
+    int port; ///< Sequencer port.
+    guint watch_id; ///< Source ID of the sequencer poll descriptor watch, or 0.
+    GPtrArray *mappings; ///< Array of @ref SmMidiMapping.
+    gchar *learn_control; ///< Control to bind to the next received controller, or NULL.
+    guint8 cc_msb[16][32]; ///< Last MSB of the 14-bit controllers of each channel.
+    gint nrpn[16]; ///< Selected NRPN of each channel, or -1.
+    guint8 nrpn_msb[16]; ///< Last data entry MSB of each channel.
+    GHashTable *pending; ///< Control values not yet written to the mixer.
+    guint write_id; ///< Source ID writing the pending values, or 0.
+    gint64 last_write; ///< Monotonic time of the last write in microseconds.
+    SmControlsMonitor *monitor; ///< Monitor announcing the changed controls, or NULL.
+};
+
+G_DEFINE_TYPE(SmMidiClient, sm_midi_client, G_TYPE_OBJECT);
+
+static void
+sm_midi_mapping_free(gpointer data)
+{
+    SmMidiMapping *mapping = data;
+
+    g_free(mapping->control);
+    g_free(mapping);
+}
+
+static guint
+sm_midi_mapping_get_max(SmMidiMapping *mapping)
+{
+    return mapping->type == SM_MIDI_MAPPING_CC ? SM_MIDI_CC_MAX : SM_MIDI_CC14_MAX;
+}
+
+static gchar*
+sm_midi_client_get_mappings_filename()
+{
+    return g_build_filename(g_get_user_config_dir(), PACKAGE, SM_MIDI_MAPPINGS_FILE, NULL);
+}
+
+static void
+sm_midi_client_load_mappings(SmMidiClient *self)
+{
+    GKeyFile *keyfile;
+    SmMidiMapping *mapping;
+    gchar **groups, *filename, *type;
+    gsize idx;
+    gint channel, number;
+    GError *err = NULL;
+
+    keyfile = g_key_file_new();
+    filename = sm_midi_client_get_mappings_filename();
+    if (!g_key_file_load_from_file(keyfile, filename, G_KEY_FILE_NONE, &err))
+    {
+        if (!g_error_matches(err, G_FILE_ERROR, G_FILE_ERROR_NOENT))
+        {
+            g_warning("Could not read MIDI mappings %s: %s", filename, err->message);
+        }
+        g_error_free(err);
+        g_free(filename);
+        g_key_file_free(keyfile);
+        return;
+    }
+    // One group per control: type (cc, cc14 or nrpn), channel (1-16) and number.
+    groups = g_key_file_get_groups(keyfile, NULL);
+    for (idx = 0; groups[idx]; idx++)
+    {
+        type = g_key_file_get_string(keyfile, groups[idx], "type", NULL);
+        channel = g_key_file_get_integer(keyfile, groups[idx], "channel", NULL);
+        number = g_key_file_get_integer(keyfile, groups[idx], "number", NULL);
+        mapping = g_new0(SmMidiMapping, 1);
+        for (mapping->type = 0; mapping->type < SM_MIDI_N_MAPPING_TYPES; mapping->type++)
+        {
+            if (g_strcmp0(type, sm_midi_mapping_type_names[mapping->type]) == 0)
+            {
+                break;
+            }
+        }
+        g_free(type);
+        if (mapping->type == SM_MIDI_N_MAPPING_TYPES || channel < 1 || channel > 16
+                || number < 0 || number > (mapping->type == SM_MIDI_MAPPING_NRPN ? SM_MIDI_CC14_MAX : SM_MIDI_CC_MAX))
+        {
+            g_warning("Invalid MIDI mapping of %s in %s.", groups[idx], filename);
+            g_free(mapping);
+            continue;
+        }
+        mapping->control = g_strdup(groups[idx]);
+        mapping->channel = channel - 1;
+        mapping->number = number;
+        mapping->value = -1;
+        g_ptr_array_add(self->mappings, mapping);
+    }
+    g_strfreev(groups);
+    g_free(filename);
+    g_key_file_free(keyfile);
+}
+
+static void
+sm_midi_client_save_mappings(SmMidiClient *self)
+{
+    GKeyFile *keyfile;
+    SmMidiMapping *mapping;
+    gchar *filename, *dirname;
+    guint idx;
+    GError *err = NULL;
+
+    keyfile = g_key_file_new();
+    for (idx = 0; idx < self->mappings->len; idx++)
+    {
+        mapping = g_ptr_array_index(self->mappings, idx);
+        g_key_file_set_string(keyfile, mapping->control, "type", sm_midi_mapping_type_names[mapping->type]);
+        g_key_file_set_integer(keyfile, mapping->control, "channel", mapping->channel + 1);
+        g_key_file_set_integer(keyfile, mapping->control, "number", mapping->number);
+    }
+    filename = sm_midi_client_get_mappings_filename();
+    dirname = g_path_get_dirname(filename);
+    g_mkdir_with_parents(dirname, 0700);
+    if (!g_key_file_save_to_file(keyfile, filename, &err))
+    {
+        g_warning("Could not write MIDI mappings %s: %s", filename, err->message);
+        g_error_free(err);
+    }
+    g_free(dirname);
+    g_free(filename);
+    g_key_file_free(keyfile);
+}
+
+static void
+sm_midi_client_send(SmMidiClient *self, SmMidiMapping *mapping)
+{
+    snd_seq_event_t ev;
+
+    snd_seq_ev_clear(&ev);
+    snd_seq_ev_set_source(&ev, self->port);
+    snd_seq_ev_set_subs(&ev);
+    snd_seq_ev_set_direct(&ev);
+    snd_seq_ev_set_controller(&ev, mapping->channel, mapping->number, mapping->value);
+    // The sequencer splits 14-bit events into MSB and LSB control changes for MIDI ports.
+    if (mapping->type == SM_MIDI_MAPPING_CC14)
+    {
+        ev.type = SND_SEQ_EVENT_CONTROL14;
+    }
+    else if (mapping->type == SM_MIDI_MAPPING_NRPN)
+    {
+        ev.type = SND_SEQ_EVENT_NONREGPARAM;
+    }
+    snd_seq_event_output(self->seq, &ev);
+}
+
+/*
+ * Send the changed controls to the controllers. Controllers moved recently
+ * get no feedback, so a motorized fader does not fight the hand moving it
+ * with the values rounded to the volume steps.
+ */
+static void
+sm_midi_client_controls_changed_cb(SmControlsMonitor *monitor, GVariant *controls, gpointer user_data)
+{
+    SmMidiClient *self = SM_MIDI_CLIENT(user_data);
+    SmMidiMapping *mapping;
+    GVariant *value;
+    gdouble fraction;
+    gboolean sent, touched;
+    gint64 now;
+    guint idx;
+    gint midi_value;
+
+    if (!self->seq)
+    {
+        return;
+    }
+    sent = FALSE;
+    now = g_get_monotonic_time();
+    for (idx = 0; idx < self->mappings->len; idx++)
+    {
+        mapping = g_ptr_array_index(self->mappings, idx);
+        value = g_variant_lookup_value(controls, mapping->control, NULL);
+        if (!value)
+        {
+            continue;
+        }
+        // Buttons always get the state, e.g. to light the mute LED.
+        touched = now - mapping->touched < SM_MIDI_TOUCH_TIMEOUT * 1000
+            && !g_variant_is_of_type(value, G_VARIANT_TYPE_BOOLEAN);
+        if (!touched && sm_controls_value_to_fraction(self->app, mapping->control, value, &fraction))
+        {
+            midi_value = (gint)round(fraction * sm_midi_mapping_get_max(mapping));
+            if (midi_value != mapping->value || g_variant_is_of_type(value, G_VARIANT_TYPE_BOOLEAN))
+            {
+                mapping->value = midi_value;
+                sm_midi_client_send(self, mapping);
+                sent = TRUE;
+            }
+        }
+        g_variant_unref(value);
+    }
+    if (sent)
+    {
+        snd_seq_drain_output(self->seq);
+    }
+}
+
+static gboolean
+sm_midi_client_write_cb(gpointer user_data)
+{
+    SmMidiClient *self = SM_MIDI_CLIENT(user_data);
+    GVariantBuilder builder;
+    GHashTableIter iter;
+    gpointer name, value;
+    GError *err = NULL;
+
+    self->write_id = 0;
+    self->last_write = g_get_monotonic_time();
+    g_variant_builder_init(&builder, G_VARIANT_TYPE_VARDICT);
+    g_hash_table_iter_init(&iter, self->pending);
+    while (g_hash_table_iter_next(&iter, &name, &value))
+    {
+        g_variant_builder_add(&builder, "{sv}", name, value);
+    }
+    g_hash_table_remove_all(self->pending);
+    if (!sm_controls_set(self->app, g_variant_builder_end(&builder), &err))
+    {
+        g_debug("sm_midi_client_write_cb: %s", err->message);
+        g_error_free(err);
+    }
+    return G_SOURCE_REMOVE;
+}
+
+/*
+ * Queue a control value. Only the latest value of each control is written,
+ * at most every SM_MIDI_WRITE_INTERVAL milliseconds.
+ */
+static void
+sm_midi_client_queue_write(SmMidiClient *self, const gchar *control, GVariant *value)
+{
+    gint64 delay;
+
+    g_hash_table_replace(self->pending, g_strdup(control), g_variant_ref_sink(value));
+    if (self->write_id)
+    {
+        return;
+    }
+    delay = self->last_write + SM_MIDI_WRITE_INTERVAL * 1000 - g_get_monotonic_time();
+    if (delay <= 0)
+    {
+        self->write_id = g_idle_add(sm_midi_client_write_cb, self);
+    }
+    else
+    {
+        self->write_id = g_timeout_add((guint)(delay / 1000) + 1, sm_midi_client_write_cb, self);
+    }
+}
+
+static void
+sm_midi_client_handle_value(SmMidiClient *self, SmMidiMappingType type,
+        guint channel, guint number, gint midi_value)
+{
+    SmMidiMapping *mapping;
+    GVariant *value, *muted;
+    guint idx, max;
+
+    for (idx = 0; idx < self->mappings->len; idx++)
+    {
+        mapping = g_ptr_array_index(self->mappings, idx);
+        if (mapping->type != type || mapping->channel != channel || mapping->number != number)
+        {
+            continue;
+        }
+        max = sm_midi_mapping_get_max(mapping);
+        mapping->touched = g_get_monotonic_time();
+        if (g_str_has_suffix(mapping->control, "/mute"))
+        {
+            // Buttons send the maximum when pressed and 0 when released.
+            mapping->value = midi_value;
+            if ((guint)midi_value <= max / 2)
+            {
+                continue;
+            }
+            muted = self->monitor ? sm_controls_monitor_lookup(self->monitor, mapping->control) : NULL;
+            value = g_variant_new_boolean(!(muted && g_variant_get_boolean(muted)));
+        }
+        else
+        {
+            if (midi_value == mapping->value)
+            {
+                continue;
+            }
+            mapping->value = midi_value;
+            value = sm_controls_value_from_fraction(self->app, mapping->control, (gdouble)midi_value / max);
+        }
+        if (value)
+        {
+            sm_midi_client_queue_write(self, mapping->control, value);
+        }
+    }
+}
+
+static void
+sm_midi_client_learn_controller(SmMidiClient *self, SmMidiMappingType type, guint channel, guint number)
+{
+    SmMidiMapping *mapping;
+    guint idx;
+
+    if (!self->learn_control)
+    {
+        return;
+    }
+    // A controller drives a single control, and a control is driven by a single controller.
+    for (idx = self->mappings->len; idx > 0; idx--)
+    {
+        mapping = g_ptr_array_index(self->mappings, idx - 1);
+        if (g_strcmp0(mapping->control, self->learn_control) == 0
+                || (mapping->type == type && mapping->channel == channel && mapping->number == number))
+        {
+            g_ptr_array_remove_index(self->mappings, idx - 1);
+        }
+    }
+    mapping = g_new0(SmMidiMapping, 1);
+    mapping->control = self->learn_control;
+    mapping->type = type;
+    mapping->channel = channel;
+    mapping->number = number;
+    mapping->value = -1;
+    g_ptr_array_add(self->mappings, mapping);
+    self->learn_control = NULL;
+    g_debug("Learned %s %u on channel %u for %s.", sm_midi_mapping_type_names[type],
+            number, channel + 1, mapping->control);
+    sm_midi_client_save_mappings(self);
+}
+
+/*
+ * Upgrade the 7-bit mapping of a controller whose LSB was received.
+ */
+static void
+sm_midi_client_upgrade_controller(SmMidiClient *self, guint channel, guint number)
+{
+    SmMidiMapping *mapping;
+    guint idx;
+
+    for (idx = 0; idx < self->mappings->len; idx++)
+    {
+        mapping = g_ptr_array_index(self->mappings, idx);
+        if (mapping->type == SM_MIDI_MAPPING_CC && mapping->channel == channel && mapping->number == number)
+        {
+            g_debug("Controller %u on channel %u has 14 bit.", number, channel + 1);
+            mapping->type = SM_MIDI_MAPPING_CC14;
+            mapping->value = -1;
+            sm_midi_client_save_mappings(self);
+        }
+    }
+}
+
+void
+sm_midi_client_handle_controller(SmMidiClient *self, guint channel, guint param, guint value)
+{
+    value &= SM_MIDI_CC_MAX;
+    channel &= 0x0f;
+    // Data entry belongs to the selected NRPN, otherwise CC 6 and 38 are plain controllers.
+    if (self->nrpn[channel] >= 0 && (param == 6 || param == 38))
+    {
+        sm_midi_client_learn_controller(self, SM_MIDI_MAPPING_NRPN, channel, self->nrpn[channel]);
+        if (param == 6)
+        {
+            self->nrpn_msb[channel] = value;
+            value = value << 7;
+        }
+        else
+        {
+            value = (self->nrpn_msb[channel] << 7) | value;
+        }
+        sm_midi_client_handle_value(self, SM_MIDI_MAPPING_NRPN, channel, self->nrpn[channel], value);
+    }
+    else if (param < 32)
+    {
+        sm_midi_client_learn_controller(self, SM_MIDI_MAPPING_CC, channel, param);
+        self->cc_msb[channel][param] = value;
+        sm_midi_client_handle_value(self, SM_MIDI_MAPPING_CC, channel, param, value);
+        sm_midi_client_handle_value(self, SM_MIDI_MAPPING_CC14, channel, param, value << 7);
+    }
+    else if (param < 64)
+    {
+        sm_midi_client_upgrade_controller(self, channel, param - 32);
+        sm_midi_client_handle_value(self, SM_MIDI_MAPPING_CC14, channel, param - 32,
+                (self->cc_msb[channel][param - 32] << 7) | value);
+    }
+    else if (param == 99)
+    {
+        // NRPN MSB, the LSB follows.
+        self->nrpn[channel] = value << 7;
+    }
+    else if (param == 98)
+    {
+        self->nrpn[channel] = (self->nrpn[channel] >= 0 ? self->nrpn[channel] & 0x3f80 : 0) | value;
+    }
+    else if (param == 101 || param == 100)
+    {
+        // An RPN is selected, data entry is not for us.
+        self->nrpn[channel] = -1;
+    }
+    else
+    {
+        sm_midi_client_learn_controller(self, SM_MIDI_MAPPING_CC, channel, param);
+        sm_midi_client_handle_value(self, SM_MIDI_MAPPING_CC, channel, param, value);
+    }
+}
+
+static void
+sm_midi_client_handle_event(SmMidiClient *self, snd_seq_event_t *ev)
+{
+    guint channel;
+
+    channel = ev->data.control.channel & 0x0f;
+    switch (ev->type)
+    {
+        case SND_SEQ_EVENT_CONTROLLER:
+            sm_midi_client_handle_controller(self, channel, ev->data.control.param, ev->data.control.value);
+            break;
+        case SND_SEQ_EVENT_CONTROL14:
+            if (ev->data.control.param < 32)
+            {
+                sm_midi_client_learn_controller(self, SM_MIDI_MAPPING_CC14, channel, ev->data.control.param);
+                sm_midi_client_handle_value(self, SM_MIDI_MAPPING_CC14, channel, ev->data.control.param,
+                        ev->data.control.value & SM_MIDI_CC14_MAX);
+            }
+            break;
+        case SND_SEQ_EVENT_NONREGPARAM:
+            sm_midi_client_learn_controller(self, SM_MIDI_MAPPING_NRPN, channel,
+                    ev->data.control.param & SM_MIDI_CC14_MAX);
+            sm_midi_client_handle_value(self, SM_MIDI_MAPPING_NRPN, channel,
+                    ev->data.control.param & SM_MIDI_CC14_MAX, ev->data.control.value & SM_MIDI_CC14_MAX);
+            break;
+        default:
+            break;
+    }
+}
+
+static gboolean
+sm_midi_client_gioch_callback(GIOChannel *source,
+        GIOCondition condition,
+        gpointer data)
+{
+    SmMidiClient *self = SM_MIDI_CLIENT(data);
+    snd_seq_event_t *ev;
+    int err;
+
+    if (condition & (G_IO_ERR | G_IO_HUP))
+    {
+        g_warning("Lost connection to the ALSA sequencer.");
+        self->watch_id = 0;
+        return FALSE;
+    }
+    // Read all queued events, so a burst of controller moves results in one write.
+    while ((err = snd_seq_event_input(self->seq, &ev)) >= 0)
+    {
+        if (ev)
+        {
+            sm_midi_client_handle_event(self, ev);
+        }
+    }
+    if (err == -ENOSPC)
+    {
+        g_debug("sm_midi_client_gioch_callback: Sequencer input overrun.");
+    }
+    return TRUE;
+}
+
+static void
+sm_midi_client_dispose(GObject *object)
+{
+    SmMidiClient *self = SM_MIDI_CLIENT(object);
+
+    sm_midi_client_close(self);
+    G_OBJECT_CLASS(sm_midi_client_parent_class)->dispose(object);
+}
+
+static void
+sm_midi_client_finalize(GObject *object)
+{
+    SmMidiClient *self = SM_MIDI_CLIENT(object);
+
+    g_ptr_array_unref(self->mappings);
+    g_hash_table_unref(self->pending);
+    g_free(self->learn_control);
+    G_OBJECT_CLASS(sm_midi_client_parent_class)->finalize(object);
+}
+
+static void
+sm_midi_client_class_init(SmMidiClientClass *klass)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS(klass);
+
+    object_class->dispose = sm_midi_client_dispose;
+    object_class->finalize = sm_midi_client_finalize;
+}
+
+static void
+sm_midi_client_init(SmMidiClient *self)
+{
+    guint channel;
+
+    self->mappings = g_ptr_array_new_with_free_func(sm_midi_mapping_free);
+    self->pending = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+            (GDestroyNotify)g_variant_unref);
+    for (channel = 0; channel < G_N_ELEMENTS(self->nrpn); channel++)
+    {
+        self->nrpn[channel] = -1;
+    }
+}
+
+SmMidiClient*
+sm_midi_client_new(SmApp *app)
+{
+    SmMidiClient *self;
+
+    self = g_object_new(SM_TYPE_MIDI_CLIENT, NULL);
+    self->app = app;
+    sm_midi_client_load_mappings(self);
+    return self;
+}
+
+gboolean
+sm_midi_client_open(SmMidiClient *self, GError **err)
+{
+    struct pollfd pfd;
+    GIOChannel *gioch;
+    int ret;
+
+    sm_midi_client_close(self);
+    ret = snd_seq_open(&self->seq, "default", SND_SEQ_OPEN_DUPLEX, SND_SEQ_NONBLOCK);
+    if (ret < 0)
+    {
+        g_set_error(err, G_IO_ERROR, G_IO_ERROR_FAILED,
+                "Cannot open the ALSA sequencer: %s", snd_strerror(ret));
+        self->seq = NULL;
+        return FALSE;
+    }
+    snd_seq_set_client_name(self->seq, PACKAGE_NAME);
+    self->port = snd_seq_create_simple_port(self->seq, "Control",
+            SND_SEQ_PORT_CAP_READ | SND_SEQ_PORT_CAP_SUBS_READ
+            | SND_SEQ_PORT_CAP_WRITE | SND_SEQ_PORT_CAP_SUBS_WRITE,
+            SND_SEQ_PORT_TYPE_MIDI_GENERIC | SND_SEQ_PORT_TYPE_APPLICATION);
+    if (self->port < 0)
+    {
+        g_set_error(err, G_IO_ERROR, G_IO_ERROR_FAILED,
+                "Cannot create sequencer port: %s", snd_strerror(self->port));
+        snd_seq_close(self->seq);
+        self->seq = NULL;
+        return FALSE;
+    }
+    // The sequencer has a single poll descriptor for input.
+    if (snd_seq_poll_descriptors(self->seq, &pfd, 1, POLLIN) == 1)
+    {
+        gioch = g_io_channel_unix_new(pfd.fd);
+        self->watch_id = g_io_add_watch(gioch, G_IO_IN | G_IO_ERR | G_IO_HUP,
+                sm_midi_client_gioch_callback, self);
+        g_io_channel_unref(gioch);
+    }
+    self->monitor = sm_controls_monitor_new(self->app, SM_MIDI_FEEDBACK_INTERVAL);
+    g_signal_connect(self->monitor, "changed", G_CALLBACK(sm_midi_client_controls_changed_cb), self);
+    g_debug("sm_midi_client_open: Client %d, port %d.", snd_seq_client_id(self->seq), self->port);
+    return TRUE;
+}
+
+void
+sm_midi_client_close(SmMidiClient *self)
+{
+    g_clear_object(&self->monitor);
+    if (self->watch_id)
+    {
+        g_source_remove(self->watch_id);
+        self->watch_id = 0;
+    }
+    if (self->write_id)
+    {
+        g_source_remove(self->write_id);
+        self->write_id = 0;
+    }
+    g_hash_table_remove_all(self->pending);
+    if (self->seq)
+    {
+        snd_seq_close(self->seq);
+        self->seq = NULL;
+    }
+}
+
+void
+sm_midi_client_learn(SmMidiClient *self, const gchar *control)
+{
+    g_free(self->learn_control);
+    self->learn_control = g_strdup(control);
+    g_debug("sm_midi_client_learn: Waiting for a controller for %s.", control);
+}
+
+void
+sm_midi_client_forget(SmMidiClient *self, const gchar *control)
+{
+    SmMidiMapping *mapping;
+    guint idx;
+
+    for (idx = 0; idx < self->mappings->len; idx++)
+    {
+        mapping = g_ptr_array_index(self->mappings, idx);
+        if (g_strcmp0(mapping->control, control) == 0)
+        {
+            g_ptr_array_remove_index(self->mappings, idx);
+            sm_midi_client_save_mappings(self);
+            return;
+        }
+    }
+}
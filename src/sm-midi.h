@@ -0,0 +1,88 @@
+#ifndef __SM_MIDI_H__
+#define __SM_MIDI_H__
+/**
+ * @file
+ * @brief Header file for the MIDI control surface client.
+ *
+ * The client creates an ALSA sequencer port, which is connected to MIDI
+ * controllers with e.g. `aconnect`. Controllers are mapped to the named
+ * controls (see sm-controls.h) by learning: after @ref sm_midi_client_learn()
+ * the next control change received is bound to the control. Supported are
+ * 7-bit control changes, 14-bit control changes (MSB on CC 0-31, LSB on
+ * CC 32-63) and NRPNs. A 7-bit mapping is upgraded to 14 bit, when the LSB of
+ * its controller is received.
+ *
+ * Volume controls follow the fader law of the volume faders, mute controls
+ * toggle when the button is pressed, source and item controls select an
+ * item by the position of the controller. Writes to the mixer are coalesced,
+ * so a fast knob twist results in a write at most every few milliseconds.
+ * Changes made by other means are sent back to the controller, so motorized
+ * faders and LEDs follow the mixer.
+ *
+ * The mappings are stored in `midi-mappings` in the user configuration
+ * directory of the application.
+ */
+#include <glib-object.h>
+
+#include "sm-app.h"
+
+G_BEGIN_DECLS
+
+/**
+ * @brief Macro to get the type information of the MIDI client.
+ */
+#define SM_TYPE_MIDI_CLIENT sm_midi_client_get_type()
+/**
+ * @brief Macro declaring the final MIDI client type.
+ */
+G_DECLARE_FINAL_TYPE(SmMidiClient, sm_midi_client, SM, MIDI_CLIENT, GObject);
+
+/**
+ * @brief Create a new MIDI client and load the stored mappings.
+ * @param app The application object.
+ * @return Pointer to new MIDI client instance.
+ */
+SmMidiClient *sm_midi_client_new(SmApp *app);
+
+/**
+ * @brief Open the sequencer and create the port.
+ * @param self The MIDI client.
+ * @param err The GError that will be initialized in case of an error.
+ * @return TRUE on success, FALSE otherwise.
+ */
+gboolean      sm_midi_client_open(SmMidiClient *self, GError **err);
+
+/**
+ * @brief Close the sequencer.
+ * @param self The MIDI client.
+ */
+void          sm_midi_client_close(SmMidiClient *self);
+
+/**
+ * @brief Bind the next received controller to a control.
+ * The previous mapping of the control and the controller are replaced.
+ * @param self The MIDI client.
+ * @param control The control name.
+ */
+void          sm_midi_client_learn(SmMidiClient *self, const gchar *control);
+
+/**
+ * @brief Remove the mapping of a control.
+ * @param self The MIDI client.
+ * @param control The control name.
+ */
+void          sm_midi_client_forget(SmMidiClient *self, const gchar *control);
+
+/**
+ * @brief Handle a 7-bit control change as received from the sequencer.
+ * NRPN numbers (CC 99 and 98) and their data entry (CC 6 and 38) are combined.
+ * @param self The MIDI client.
+ * @param channel MIDI channel 0-15.
+ * @param param The controller number.
+ * @param value The controller value.
+ */
+void          sm_midi_client_handle_controller(SmMidiClient *self, guint channel, guint param, guint value);
+
+G_END_DECLS
+
+#endif /* __SM_MIDI_H__ */
@@ -17,9 +17,23 @@
  */
 
 #include <gtk/gtk.h>
-#include <math.h>
 
 #include "sm-mix-strip.h"
+#include "sm-meter-bar.h"
+#include "sm-enum.h"
+#include "sm-source-selector.h"
+#include "sm-taper.h"
+
+/**
+ * @brief Flags of the mix strip widgets which differ from the state of the SmChannels.
+ */
+enum
+{
+    SM_MIX_STRIP_DIRTY_SOURCE = 1 << 0, ///< Source selector.
+    SM_MIX_STRIP_DIRTY_VOLUME = 1 << 1, ///< Volume and balance scales.
+    SM_MIX_STRIP_DIRTY_NAME = 1 << 2, ///< Name entry.
+    SM_MIX_STRIP_DIRTY_METER = 1 << 3, ///< Capture channel of the meter bar.
+};
 
 /**
  * @brief Structure representing the mix strip widget class.
@@ -52,34 +66,34 @@ struct _SmMixStripPrivate
     gchar mix_ids[3]; ///< The Matrix Mix ids this mix strip widget is associated with.
     gulong changed_handler_id[2]; ///< Signal handlers for the "changed" signal of the associated SmChannels.
     GtkEntry *name_entry; ///< Widget to set the name of this mix strip widget.
-    GtkComboBoxText *source_comboboxtext; ///< Drop down widget to select the input channels.
+    SmSourceSelector *source_selector; ///< Selector widget to select the input channels.
     GtkScale *balance_scale; ///< Widget to set the balance.
     GtkScale *volume_scale; ///< Widget to set the volume.
     GtkAdjustment *volume_adjustment; ///< Widget to display the volume ticks.
-    GtkLevelBar *levelbar; ///< Widget to show the volume level.
+    SmMeterBar *meterbar; ///< Widget to show the signal level.
+    SmMeter *meter; ///< SmMeter providing the signal level, or NULL.
+    gulong meter_routing_handler_id; ///< Signal handler for the "routing-changed" signal of the meter.
+    const SmTaper *taper; ///< Taper of the volume scales.
+    guint dirty; ///< Flags of the widgets to update on the next frame.
+    guint tick_id; ///< Tick callback updating the dirty widgets, or 0.
+    gboolean suspended; ///< Indicates if widget updates are suspended.
+    gboolean stale; ///< Indicates if a channel changed while the updates were suspended.
 };
 
 G_DEFINE_TYPE_WITH_PRIVATE(SmMixStrip, sm_mix_strip, GTK_TYPE_BOX);
 
-static gdouble
-vol_to_value(gdouble vol_db) {
-    return pow(10, vol_db / 60.0);
-}
-
-static gdouble
-value_to_vol(gdouble value) {
-    return 60.0*log10(value);
-}
-
 static void
-scale_source_comboboxtext_changed_cb(GtkComboBox *combo,
+scale_source_selector_changed_cb(SmSourceSelector *selector,
         gpointer     user_data)
 {
     SmMixStripPrivate *priv;
     int active_idx;
 
     priv = sm_mix_strip_get_instance_private(user_data);
-    active_idx = gtk_combo_box_get_active(combo);
+    active_idx = sm_source_selector_get_active(selector);
+    if (active_idx < 0) {
+        return;
+    }
     if(priv->channel[0]) {
         sm_channel_source_set_selected_item_index(priv->channel[0], SND_MIXER_SCHN_MONO, active_idx);
     }
@@ -90,48 +104,61 @@ scale_source_comboboxtext_changed_cb(GtkComboBox *combo,
 
 static gchar*
 volume_scale_format_value_cb(GtkScale *scale,
-        gdouble value)
+        gdouble value,
+        gpointer user_data)
 {
-    return g_strdup_printf("%0.*f",
-            gtk_scale_get_digits(scale), value_to_vol(value));
+    SmMixStripPrivate *priv;
+
+    priv = sm_mix_strip_get_instance_private(user_data);
+    // The labels are formatted once per step of the taper.
+    return g_strdup(priv->taper ? sm_taper_get_label(priv->taper, value) : "");
 }
 
 static void
-sm_mix_strip_set_balance(SmMixStrip *strip)
+sm_mix_strip_get_balance(SmMixStrip *strip, gdouble *val, gdouble *balance)
 {
     SmMixStripPrivate *priv;
     gdouble vol_db;
     gdouble value[2] = { 0.0, 0.0 };
-    gdouble val = 0.0;
-    gdouble balance = 0.0;
 
     priv = sm_mix_strip_get_instance_private(strip);
     if (priv->channel[0])
     {
         sm_channel_volume_get_db(priv->channel[0], SND_MIXER_SCHN_MONO, &vol_db);
-        value[0] = vol_to_value(vol_db);
+        value[0] = sm_taper_db_to_value(priv->taper, vol_db);
     }
     if (priv->channel[1])
     {
         sm_channel_volume_get_db(priv->channel[1], SND_MIXER_SCHN_MONO, &vol_db);
-        value[1] = vol_to_value(vol_db);
+        value[1] = sm_taper_db_to_value(priv->taper, vol_db);
     }
+    *balance = 0.0;
     if (value[0] > value[1])
     {
         if (value[0] > 0)
         {
-            balance = (value[1] / value[0]) - 1.0;
+            *balance = (value[1] / value[0]) - 1.0;
         }
-        val = value[0];
+        *val = value[0];
     }
     else
     {
         if (value[1] > 0)
         {
-            balance = 1 - (value[0] / value[1]);
+            *balance = 1 - (value[0] / value[1]);
         }
-        val = value[1];
+        *val = value[1];
     }
+}
+
+static void
+sm_mix_strip_set_balance(SmMixStrip *strip)
+{
+    SmMixStripPrivate *priv;
+    gdouble val, balance;
+
+    priv = sm_mix_strip_get_instance_private(strip);
+    sm_mix_strip_get_balance(strip, &val, &balance);
     gtk_range_set_value(GTK_RANGE(priv->balance_scale), balance);
     gtk_range_set_value(GTK_RANGE(priv->volume_scale), val);
 }
@@ -145,10 +172,10 @@ sm_mix_strip_set_volume(SmMixStrip *strip, gdouble vol, gdouble balance)
     priv = sm_mix_strip_get_instance_private(strip);
     if (priv->channel[0])
     {
-        vol_db = value_to_vol(vol);
+        vol_db = sm_taper_value_to_db(priv->taper, vol);
         if (balance > 0)
         {
-            vol_db = value_to_vol(vol * (1.0 - balance));
+            vol_db = sm_taper_value_to_db(priv->taper, vol * (1.0 - balance));
         }
         if (!sm_channel_volume_set_db(priv->channel[0], SND_MIXER_SCHN_MONO, vol_db))
         {
@@ -157,10 +184,10 @@ sm_mix_strip_set_volume(SmMixStrip *strip, gdouble vol, gdouble balance)
     }
     if (priv->channel[1])
     {
-        vol_db = value_to_vol(vol);
+        vol_db = sm_taper_value_to_db(priv->taper, vol);
         if (balance < 0)
         {
-            vol_db = value_to_vol(vol * (1.0 + balance));
+            vol_db = sm_taper_value_to_db(priv->taper, vol * (1.0 + balance));
         }
         if(!sm_channel_volume_set_db(priv->channel[1], SND_MIXER_SCHN_MONO, vol_db))
         {
@@ -196,7 +223,7 @@ volume_scale_value_changed_cb(GtkRange *range, gpointer user_data)
     priv = sm_mix_strip_get_instance_private(user_data);
     balance = gtk_range_get_value(GTK_RANGE(priv->balance_scale));
     vol = gtk_range_get_value(range);
-    vol_db = value_to_vol(vol);
+    vol_db = sm_taper_value_to_db(priv->taper, vol);
     g_debug("volume_scale_value_changed_cb: %f dB", vol_db);
     sm_mix_strip_set_volume(SM_MIX_STRIP(user_data), vol, balance);
 }
@@ -230,28 +257,123 @@ name_entry_changed_cb(GtkEditable *editable, gpointer user_data)
     sm_mix_strip_set_name(strip, name);
 }
 
+static void
+sm_mix_strip_update_meter_channel(SmMixStripPrivate *priv)
+{
+    SmChannel *channel;
+    gint idx;
+
+    channel = priv->channel[0] ? priv->channel[0] : priv->channel[1];
+    if (!priv->meter || !channel)
+    {
+        sm_meter_bar_set_channel(priv->meterbar, -1);
+        return;
+    }
+    idx = sm_channel_source_get_selected_item_index(channel, SND_MIXER_SCHN_MONO);
+    sm_meter_bar_set_channel(priv->meterbar, sm_meter_find_channel(priv->meter,
+            sm_enum_get_name(sm_channel_source_get_items(channel, SND_MIXER_SCHN_MONO), idx)));
+}
+
+static gboolean
+sm_mix_strip_tick_cb(GtkWidget *widget, GdkFrameClock *frame_clock, gpointer user_data);
+
+/*
+ * Update the dirty widgets in the update phase of the next frame, so that a
+ * burst of changes (e.g. loading a configuration) is laid out and painted
+ * once.
+ */
+static void
+sm_mix_strip_queue_update(SmMixStrip *strip, guint dirty)
+{
+    SmMixStripPrivate *priv;
+
+    priv = sm_mix_strip_get_instance_private(strip);
+    priv->dirty |= dirty;
+    if (priv->dirty && !priv->tick_id && !priv->suspended)
+    {
+        priv->tick_id = gtk_widget_add_tick_callback(GTK_WIDGET(strip),
+                sm_mix_strip_tick_cb, strip, NULL);
+    }
+}
+
+static gboolean
+sm_mix_strip_tick_cb(GtkWidget *widget, GdkFrameClock *frame_clock, gpointer user_data)
+{
+    SmMixStripPrivate *priv;
+    SmChannel *channel;
+    guint dirty;
+    int idx;
+
+    priv = sm_mix_strip_get_instance_private(SM_MIX_STRIP(user_data));
+    // Widget updates may change the channels again, which queues a new update.
+    dirty = priv->dirty;
+    priv->dirty = 0;
+    priv->tick_id = 0;
+    channel = priv->channel[0] ? priv->channel[0] : priv->channel[1];
+    if (channel && (dirty & SM_MIX_STRIP_DIRTY_SOURCE))
+    {
+        idx = sm_channel_source_get_selected_item_index(channel, SND_MIXER_SCHN_MONO);
+        if (idx >= 0)
+        {
+            sm_source_selector_set_active(priv->source_selector, idx);
+        }
+    }
+    if (channel && (dirty & SM_MIX_STRIP_DIRTY_VOLUME))
+    {
+        sm_mix_strip_set_balance(SM_MIX_STRIP(user_data));
+    }
+    if (channel && (dirty & SM_MIX_STRIP_DIRTY_NAME))
+    {
+        gtk_entry_set_text(priv->name_entry, sm_channel_get_display_name(channel));
+    }
+    if (dirty & SM_MIX_STRIP_DIRTY_METER)
+    {
+        sm_mix_strip_update_meter_channel(priv);
+    }
+    return G_SOURCE_REMOVE;
+}
+
+static void
+sm_mix_strip_meter_routing_changed_cb(SmMeter *meter, gpointer user_data)
+{
+    sm_mix_strip_queue_update(SM_MIX_STRIP(user_data), SM_MIX_STRIP_DIRTY_METER);
+}
+
 static void
 sm_mix_strip_channel_changed_cb(SmChannel *channel, gpointer user_data)
 {
     SmMixStripPrivate *priv;
-    const gchar *name;
+    gdouble val, balance;
+    guint dirty;
     int idx;
 
     priv = sm_mix_strip_get_instance_private(user_data);
+    if (priv->suspended)
+    {
+        // Compare the widgets once when the updates are resumed.
+        priv->stale = TRUE;
+        return;
+    }
     g_debug("sm_mix_strip_channel_changed_cb: %s.", gtk_entry_get_text(priv->name_entry));
+    dirty = 0;
     idx = sm_channel_source_get_selected_item_index(channel, SND_MIXER_SCHN_MONO);
     if (idx < 0) {
         g_warning("Could not get selected item!");
     }
-    else {
-        gtk_combo_box_set_active(GTK_COMBO_BOX(priv->source_comboboxtext), idx);
+    else if (idx != sm_source_selector_get_active(priv->source_selector)) {
+        dirty |= SM_MIX_STRIP_DIRTY_SOURCE | SM_MIX_STRIP_DIRTY_METER;
+    }
+    sm_mix_strip_get_balance(SM_MIX_STRIP(user_data), &val, &balance);
+    if (val != gtk_range_get_value(GTK_RANGE(priv->volume_scale)) ||
+            balance != gtk_range_get_value(GTK_RANGE(priv->balance_scale)))
+    {
+        dirty |= SM_MIX_STRIP_DIRTY_VOLUME;
     }
-    sm_mix_strip_set_balance(SM_MIX_STRIP(user_data));
-    name = sm_channel_get_display_name(channel);
-    if (g_strcmp0(gtk_entry_get_text(priv->name_entry), name) != 0)
+    if (g_strcmp0(gtk_entry_get_text(priv->name_entry), sm_channel_get_display_name(channel)) != 0)
     {
-        gtk_entry_set_text(priv->name_entry, name);
+        dirty |= SM_MIX_STRIP_DIRTY_NAME;
     }
+    sm_mix_strip_queue_update(SM_MIX_STRIP(user_data), dirty);
 }
 
 static void
@@ -260,18 +382,30 @@ sm_mix_strip_dispose(GObject *object)
     SmMixStripPrivate *priv;
 
     priv = sm_mix_strip_get_instance_private(SM_MIX_STRIP(object));
+    if (priv->tick_id)
+    {
+        gtk_widget_remove_tick_callback(GTK_WIDGET(object), priv->tick_id);
+        priv->tick_id = 0;
+    }
     if (priv->channel[0])
     {
         g_debug("sm_mix_strip_dispose: %s", sm_channel_get_name(priv->channel[0]));
         g_signal_handler_disconnect(priv->channel[0], priv->changed_handler_id[0]);
+        g_object_unref(priv->channel[0]);
         priv->channel[0] = NULL;
     }
     if (priv->channel[1])
     {
         g_debug("sm_mix_strip_dispose: %s", sm_channel_get_name(priv->channel[1]));
         g_signal_handler_disconnect(priv->channel[1], priv->changed_handler_id[1]);
+        g_object_unref(priv->channel[1]);
         priv->channel[1] = NULL;
     }
+    if (priv->meter)
+    {
+        g_signal_handler_disconnect(priv->meter, priv->meter_routing_handler_id);
+        g_clear_object(&priv->meter);
+    }
     G_OBJECT_CLASS(sm_mix_strip_parent_class)->dispose(object);
 }
 
@@ -293,12 +427,14 @@ sm_mix_strip_class_init(SmMixStripClass *class)
     gtk_css_provider_load_from_resource(GTK_CSS_PROVIDER(provider),
             "/org/alsa/scarlettmixer/sm-strip.css");
     g_object_unref(provider);
+    g_type_ensure(SM_TYPE_METER_BAR);
+    g_type_ensure(SM_TYPE_SOURCE_SELECTOR);
     gtk_widget_class_set_template_from_resource(GTK_WIDGET_CLASS(class),
             "/org/alsa/scarlettmixer/sm-mix-strip.ui");
     gtk_widget_class_bind_template_child_private(GTK_WIDGET_CLASS(class),
             SmMixStrip, name_entry);
     gtk_widget_class_bind_template_child_private(GTK_WIDGET_CLASS(class),
-            SmMixStrip, source_comboboxtext);
+            SmMixStrip, source_selector);
     gtk_widget_class_bind_template_child_private(GTK_WIDGET_CLASS(class),
             SmMixStrip, volume_scale);
     gtk_widget_class_bind_template_child_private(GTK_WIDGET_CLASS(class),
@@ -306,10 +442,10 @@ sm_mix_strip_class_init(SmMixStripClass *class)
     gtk_widget_class_bind_template_child_private(GTK_WIDGET_CLASS(class),
             SmMixStrip, volume_adjustment);
     gtk_widget_class_bind_template_child_private(GTK_WIDGET_CLASS(class),
-            SmMixStrip, levelbar);
+            SmMixStrip, meterbar);
 
     gtk_widget_class_bind_template_callback(GTK_WIDGET_CLASS(class),
-            scale_source_comboboxtext_changed_cb);
+            scale_source_selector_changed_cb);
     gtk_widget_class_bind_template_callback(GTK_WIDGET_CLASS(class),
             volume_scale_format_value_cb);
     gtk_widget_class_bind_template_callback(GTK_WIDGET_CLASS(class),
@@ -343,7 +479,7 @@ sm_mix_strip_add_channel(SmMixStrip *strip, SmChannel *channel)
     {
         return FALSE;
     }
-    priv->channel[mix_idx] = channel;
+    priv->channel[mix_idx] = g_object_ref(channel);
 
     // Update volume and balance scale
     sm_mix_strip_set_balance(strip);
@@ -361,8 +497,7 @@ sm_mix_strip_new(SmChannel *channel)
 {
     SmMixStrip *strip;
     SmMixStripPrivate *priv;
-    GList *list;
-    gdouble min_db, max_db;
+    gdouble min_db, max_db, step_db;
     int mix_idx, mix_idx2, idx;
 
     if (sm_channel_get_channel_type(channel) != SM_CHANNEL_MIX)
@@ -374,7 +509,7 @@ sm_mix_strip_new(SmChannel *channel)
     priv->channel_id = sm_channel_get_id(channel);
     mix_idx = (sm_channel_get_mix_id(channel) -'A') % 2;
     mix_idx2 = (mix_idx + 1) % 2;
-    priv->channel[mix_idx] = channel;
+    priv->channel[mix_idx] = g_object_ref(channel);
     priv->channel[mix_idx2] = NULL;
     priv->mix_ids[2] = '\0';
     priv->mix_ids[mix_idx] = sm_channel_get_mix_id(channel);
@@ -385,31 +520,24 @@ sm_mix_strip_new(SmChannel *channel)
 
     gtk_entry_set_text(priv->name_entry, sm_channel_get_display_name(priv->channel[mix_idx]));
 
-    list = sm_channel_source_get_item_names(priv->channel[mix_idx], SND_MIXER_SCHN_MONO);
-    for(list = g_list_first(list); list; list = g_list_next(list))
-    {
-        gtk_combo_box_text_append_text(priv->source_comboboxtext, (gchar*)list->data);
-        g_free(list->data);
-    }
-    g_list_free(list);
     idx = sm_channel_source_get_selected_item_index(priv->channel[mix_idx], SND_MIXER_SCHN_MONO);
     if (idx < 0)
     {
         g_warning("Could not get selected item!");
     }
-    else
-    {
-        gtk_combo_box_set_active(GTK_COMBO_BOX(priv->source_comboboxtext), idx);
-    }
+    sm_source_selector_set_items(priv->source_selector,
+            sm_channel_source_get_items(priv->channel[mix_idx], SND_MIXER_SCHN_MONO), idx);
 
+    min_db = max_db = step_db = 0.0;
     if (sm_channel_volume_get_range_db(priv->channel[mix_idx], &min_db, &max_db))
     {
-        gtk_adjustment_set_lower(priv->volume_adjustment, vol_to_value(min_db));
-        gtk_adjustment_set_upper(priv->volume_adjustment, vol_to_value(max_db));
-        gtk_level_bar_set_min_value(priv->levelbar, vol_to_value(min_db));
-        gtk_level_bar_set_max_value(priv->levelbar, vol_to_value(max_db));
-        gtk_level_bar_add_offset_value(priv->levelbar, GTK_LEVEL_BAR_OFFSET_HIGH, 1.01);
+        sm_channel_volume_get_step_db(priv->channel[mix_idx], &step_db);
     }
+    priv->taper = sm_taper_get_default(min_db, max_db, step_db);
+    gtk_adjustment_set_lower(priv->volume_adjustment, sm_taper_get_lower(priv->taper));
+    gtk_adjustment_set_upper(priv->volume_adjustment, sm_taper_get_upper(priv->taper));
+    sm_meter_bar_set_taper(priv->meterbar, priv->taper);
+    gtk_scale_add_mark(priv->volume_scale, sm_taper_db_to_value(priv->taper, 0.0), GTK_POS_RIGHT, "0");
 
     // Update volume and balance scale
     sm_mix_strip_set_balance(strip);
@@ -429,12 +557,30 @@ sm_mix_strip_init(SmMixStrip *strip)
 
     priv = sm_mix_strip_get_instance_private(strip);
     gtk_widget_init_template(GTK_WIDGET(strip));
-    gtk_scale_add_mark(priv->volume_scale, vol_to_value(0.0), GTK_POS_RIGHT, "0");
     gtk_scale_add_mark(priv->balance_scale, -1, GTK_POS_BOTTOM, "L");
     gtk_scale_add_mark(priv->balance_scale, 0, GTK_POS_BOTTOM, "C");
     gtk_scale_add_mark(priv->balance_scale, 1, GTK_POS_BOTTOM, "R");
 }
 
+void
+sm_mix_strip_set_meter(SmMixStrip *strip, SmMeter *meter)
+{
+    SmMixStripPrivate *priv;
+
+    priv = sm_mix_strip_get_instance_private(strip);
+    if (priv->meter)
+    {
+        return;
+    }
+    priv->meter = g_object_ref(meter);
+    sm_meter_bar_set_meter(priv->meterbar, meter);
+    priv->meter_routing_handler_id = g_signal_connect(meter,
+            "routing-changed",
+            G_CALLBACK(sm_mix_strip_meter_routing_changed_cb),
+            strip);
+    sm_mix_strip_update_meter_channel(priv);
+}
+
 gchar*
 sm_mix_strip_get_mix_ids(SmMixStrip *strip)
 {
@@ -443,3 +589,34 @@ sm_mix_strip_get_mix_ids(SmMixStrip *strip)
     priv = sm_mix_strip_get_instance_private(strip);
     return priv->mix_ids;
 }
+
+void
+sm_mix_strip_set_suspended(SmMixStrip *strip, gboolean suspended)
+{
+    SmMixStripPrivate *priv;
+    SmChannel *channel;
+
+    priv = sm_mix_strip_get_instance_private(strip);
+    if (priv->suspended == suspended)
+    {
+        return;
+    }
+    priv->suspended = suspended;
+    if (suspended)
+    {
+        // Keep the dirty flags for the commit after resuming.
+        if (priv->tick_id)
+        {
+            gtk_widget_remove_tick_callback(GTK_WIDGET(strip), priv->tick_id);
+            priv->tick_id = 0;
+        }
+        return;
+    }
+    channel = priv->channel[0] ? priv->channel[0] : priv->channel[1];
+    if (priv->stale && channel)
+    {
+        sm_mix_strip_channel_changed_cb(channel, strip);
+    }
+    priv->stale = FALSE;
+    sm_mix_strip_queue_update(strip, 0);
+}
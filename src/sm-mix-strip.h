@@ -10,6 +10,7 @@
 #include <gtk/gtk.h>
 
 #include "sm-channel.h"
+#include "sm-meter.h"
 
 /**
  * @brief Macro to get the type information of the mix strip object.
@@ -58,4 +59,23 @@ gboolean    sm_mix_strip_add_channel(SmMixStrip *strip, SmChannel *channel);
  */
 gchar      *sm_mix_strip_get_mix_ids(SmMixStrip *strip);
 
+/**
+ * @brief Display the signal level of a meter in the level bar of the mix strip.
+ * The level bar shows the level of the capture channel which carries the
+ * selected input of the mix strip.
+ * @param strip The mix strip object.
+ * @param meter The level meter.
+ */
+void        sm_mix_strip_set_meter(SmMixStrip *strip, SmMeter *meter);
+
+/**
+ * @brief Suspend or resume the updates of the mix strip widgets.
+ * While suspended, changes of the channels are only recorded. Resuming
+ * compares the widgets with the channels once and updates the differing
+ * ones on the next frame.
+ * @param strip The mix strip object.
+ * @param suspended TRUE to suspend the updates, FALSE to resume them.
+ */
+void        sm_mix_strip_set_suspended(SmMixStrip *strip, gboolean suspended);
+
 #endif /* __SM_MIX_STRIP_H */
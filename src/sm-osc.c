@@ -0,0 +1,772 @@
+/*
+ * sm-osc.c - OSC server.
+ * Copyright (c) 2016 Martin Roesch <martin.roesch79@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include "sm-osc.h"
+#include "sm-controls.h"
+#include "sm-controls-monitor.h"
+
+#define SM_OSC_MAX_PACKET (8192) ///< Maximal size of a received or sent packet.
+#define SM_OSC_MAX_BUNDLE_DEPTH (8) ///< Maximal nesting of received bundles.
+#define SM_OSC_MAX_SUBSCRIBERS (16) ///< Maximal number of subscribed clients.
+#define SM_OSC_FEEDBACK_INTERVAL (40) ///< Minimal time between two feedback bundles in milliseconds.
+#define SM_OSC_SUBSCRIPTION_TIMEOUT (60) ///< Time in seconds a subscription lasts unless renewed.
+#define SM_OSC_DUMP_INTERVAL (1000) ///< Minimal time between two full dumps to remote clients in milliseconds.
+#define SM_OSC_MAX_READS (64) ///< Maximal number of packets read per main loop iteration.
+
+static const gchar sm_osc_bundle_tag[8] = "#bundle"; ///< Bundle marker including the terminating NUL.
+
+/**
+ * @brief Structure holding the state of the OSC server.
+ */
+struct _SmOscServer
+{
+    GObject parent_instance; ///< Parent object.
+
+    /* Other members, including private data. */
+    SmApp *app; ///< The application object (not referenced, it owns the server).
+    GSocket *socket; ///< Bound UDP socket, or NULL.
+    GSource *source; ///< Source dispatching received packets, or NULL.
+    GHashTable *pending; ///< Checked control values not yet written to the mixer.
+    guint apply_id; ///< Idle source ID writing the pending values, or 0.
+    GList *subscribers; ///< List of @ref SmOscSubscriber.
+    gint64 last_dump; ///< Monotonic time of the last full dump to a remote client in microseconds.
+    SmControlsMonitor *monitor; ///< Monitor announcing the changed controls, or NULL.
+};
+
+/**
+ * @brief Structure holding a subscribed client.
+ */
+typedef struct
+{
+    GSocketAddress *address; ///< Address of the client.
+    gint64 expires; ///< Monotonic time the subscription ends unless renewed in microseconds.
+} SmOscSubscriber;
+
+/**
+ * @brief Subscription change requested by a packet.
+ */
+typedef enum
+{
+    SM_OSC_SUBSCRIPTION_NONE, ///< No subscription message.
+    SM_OSC_SUBSCRIPTION_SUBSCRIBE, ///< Subscribe or renew the subscription.
+    SM_OSC_SUBSCRIPTION_UNSUBSCRIBE ///< End the subscription.
+} SmOscSubscription;
+
+/**
+ * @brief Structure holding the read position in a received packet.
+ */
+typedef struct
+{
+    const guint8 *data; ///< Packet data.
+    gsize len; ///< Packet length.
+    gsize pos; ///< Read position.
+} SmOscReader;
+
+G_DEFINE_TYPE(SmOscServer, sm_osc_server, G_TYPE_OBJECT);
+
+static gboolean
+sm_osc_read_int32(SmOscReader *reader, guint32 *value)
+{
+    if (reader->len - reader->pos < 4)
+    {
+        return FALSE;
+    }
+    memcpy(value, reader->data + reader->pos, 4);
+    *value = GUINT32_FROM_BE(*value);
+    reader->pos += 4;
+    return TRUE;
+}
+
+static gboolean
+sm_osc_read_int64(SmOscReader *reader, guint64 *value)
+{
+    if (reader->len - reader->pos < 8)
+    {
+        return FALSE;
+    }
+    memcpy(value, reader->data + reader->pos, 8);
+    *value = GUINT64_FROM_BE(*value);
+    reader->pos += 8;
+    return TRUE;
+}
+
+static gboolean
+sm_osc_read_string(SmOscReader *reader, const gchar **str)
+{
+    const guint8 *end;
+    gsize size;
+
+    end = memchr(reader->data + reader->pos, '\0', reader->len - reader->pos);
+    if (!end)
+    {
+        return FALSE;
+    }
+    // Strings are padded with NULs to a multiple of 4 bytes.
+    size = ((end - (reader->data + reader->pos)) / 4 + 1) * 4;
+    if (reader->len - reader->pos < size)
+    {
+        return FALSE;
+    }
+    *str = (const gchar*)reader->data + reader->pos;
+    reader->pos += size;
+    return TRUE;
+}
+
+/*
+ * Read the argument of a message as integer, double, boolean or string.
+ */
+static GVariant*
+sm_osc_read_argument(SmOscReader *reader, gchar type)
+{
+    union { guint32 i; gfloat f; } v32;
+    union { guint64 i; gdouble d; } v64;
+    const gchar *str;
+
+    switch (type)
+    {
+        case 'i':
+            return sm_osc_read_int32(reader, &v32.i) ? g_variant_new_int32((gint32)v32.i) : NULL;
+        case 'f':
+            return sm_osc_read_int32(reader, &v32.i) ? g_variant_new_double(v32.f) : NULL;
+        case 'd':
+            return sm_osc_read_int64(reader, &v64.i) ? g_variant_new_double(v64.d) : NULL;
+        case 's':
+            return sm_osc_read_string(reader, &str) && g_utf8_validate(str, -1, NULL)
+                ? g_variant_new_string(str) : NULL;
+        case 'T':
+            return g_variant_new_boolean(TRUE);
+        case 'F':
+            return g_variant_new_boolean(FALSE);
+        default:
+            return NULL;
+    }
+}
+
+/*
+ * Convert an argument to the value type of the control, see sm-osc.h.
+ * Returns a new reference.
+ */
+static GVariant*
+sm_osc_convert_argument(const gchar *name, GVariant *arg)
+{
+    if (g_str_has_suffix(name, "/volume"))
+    {
+        if (g_variant_is_of_type(arg, G_VARIANT_TYPE_INT32))
+        {
+            return g_variant_ref_sink(g_variant_new_double(g_variant_get_int32(arg)));
+        }
+    }
+    else if (g_str_has_suffix(name, "/mute"))
+    {
+        if (g_variant_is_of_type(arg, G_VARIANT_TYPE_INT32))
+        {
+            return g_variant_ref_sink(g_variant_new_boolean(g_variant_get_int32(arg) != 0));
+        }
+        if (g_variant_is_of_type(arg, G_VARIANT_TYPE_DOUBLE))
+        {
+            return g_variant_ref_sink(g_variant_new_boolean(g_variant_get_double(arg) != 0.0));
+        }
+    }
+    return g_variant_ref(arg);
+}
+
+static gchar*
+sm_osc_address_to_name(const gchar *address)
+{
+    return g_strdelimit(g_strdup(address + 1), "_", ' ');
+}
+
+static gchar*
+sm_osc_name_to_address(const gchar *name)
+{
+    return g_strdelimit(g_strconcat("/", name, NULL), " ", '_');
+}
+
+static void
+sm_osc_append_int32(GByteArray *packet, guint32 value)
+{
+    value = GUINT32_TO_BE(value);
+    g_byte_array_append(packet, (const guint8*)&value, 4);
+}
+
+static void
+sm_osc_append_string(GByteArray *packet, const gchar *str)
+{
+    static const guint8 padding[4] = { 0 };
+    gsize len;
+
+    len = strlen(str);
+    g_byte_array_append(packet, (const guint8*)str, len);
+    g_byte_array_append(packet, padding, 4 - len % 4);
+}
+
+/*
+ * Append a message of a control value, prefixed by its size as bundle element.
+ */
+static void
+sm_osc_append_control(GByteArray *packet, const gchar *name, GVariant *value)
+{
+    union { guint32 i; gfloat f; } v32;
+    gchar *address;
+    guint size_pos;
+
+    size_pos = packet->len;
+    sm_osc_append_int32(packet, 0);
+    address = sm_osc_name_to_address(name);
+    sm_osc_append_string(packet, address);
+    g_free(address);
+    if (g_variant_is_of_type(value, G_VARIANT_TYPE_DOUBLE))
+    {
+        sm_osc_append_string(packet, ",f");
+        v32.f = (gfloat)g_variant_get_double(value);
+        sm_osc_append_int32(packet, v32.i);
+    }
+    else if (g_variant_is_of_type(value, G_VARIANT_TYPE_BOOLEAN))
+    {
+        sm_osc_append_string(packet, g_variant_get_boolean(value) ? ",T" : ",F");
+    }
+    else
+    {
+        sm_osc_append_string(packet, ",s");
+        sm_osc_append_string(packet, g_variant_get_string(value, NULL));
+    }
+    v32.i = GUINT32_TO_BE(packet->len - size_pos - 4);
+    memcpy(packet->data + size_pos, &v32.i, 4);
+}
+
+/*
+ * Send a packet. Returns FALSE if the client refused it, i.e. it is gone.
+ */
+static gboolean
+sm_osc_server_send(SmOscServer *self, GSocketAddress *address, GByteArray *packet)
+{
+    gboolean refused;
+    GError *err = NULL;
+
+    if (g_socket_send_to(self->socket, address, (const gchar*)packet->data, packet->len, NULL, &err) < 0)
+    {
+        g_debug("sm_osc_server_send: %s", err->message);
+        refused = g_error_matches(err, G_IO_ERROR, G_IO_ERROR_CONNECTION_REFUSED);
+        g_error_free(err);
+        return !refused;
+    }
+    return TRUE;
+}
+
+/*
+ * Send the controls as bundles, each fitting into a single datagram.
+ * Returns FALSE if the client refused them.
+ */
+static gboolean
+sm_osc_server_send_controls(SmOscServer *self, GSocketAddress *address, GVariant *controls)
+{
+    GByteArray *packet, *element;
+    GVariantIter iter;
+    GVariant *value;
+    const gchar *name;
+    guint bundle_len;
+    gboolean sent = TRUE;
+
+    packet = g_byte_array_sized_new(SM_OSC_MAX_PACKET);
+    element = g_byte_array_new();
+    g_byte_array_append(packet, (const guint8*)sm_osc_bundle_tag, sizeof(sm_osc_bundle_tag));
+    // Time tag 1 means immediately.
+    sm_osc_append_int32(packet, 0);
+    sm_osc_append_int32(packet, 1);
+    bundle_len = packet->len;
+    g_variant_iter_init(&iter, controls);
+    while (sent && g_variant_iter_next(&iter, "{&sv}", &name, &value))
+    {
+        g_byte_array_set_size(element, 0);
+        sm_osc_append_control(element, name, value);
+        g_variant_unref(value);
+        if (packet->len + element->len > SM_OSC_MAX_PACKET && packet->len > bundle_len)
+        {
+            sent = sm_osc_server_send(self, address, packet);
+            g_byte_array_set_size(packet, bundle_len);
+        }
+        g_byte_array_append(packet, element->data, element->len);
+    }
+    if (sent && packet->len > bundle_len)
+    {
+        sent = sm_osc_server_send(self, address, packet);
+    }
+    g_byte_array_unref(element);
+    g_byte_array_unref(packet);
+    return sent;
+}
+
+static void
+sm_osc_subscriber_free(gpointer data)
+{
+    SmOscSubscriber *subscriber = data;
+
+    g_object_unref(subscriber->address);
+    g_free(subscriber);
+}
+
+/*
+ * Drop the subscriptions which were not renewed in time.
+ */
+static void
+sm_osc_server_expire_subscribers(SmOscServer *self)
+{
+    SmOscSubscriber *subscriber;
+    GList *item, *next;
+    gint64 now;
+
+    now = g_get_monotonic_time();
+    for (item = g_list_first(self->subscribers); item; item = next)
+    {
+        next = g_list_next(item);
+        subscriber = item->data;
+        if (now >= subscriber->expires)
+        {
+            g_debug("sm_osc_server_expire_subscribers: Subscription expired.");
+            sm_osc_subscriber_free(subscriber);
+            self->subscribers = g_list_delete_link(self->subscribers, item);
+        }
+    }
+}
+
+static void
+sm_osc_server_controls_changed_cb(SmControlsMonitor *monitor, GVariant *controls, gpointer user_data)
+{
+    SmOscServer *self = SM_OSC_SERVER(user_data);
+    SmOscSubscriber *subscriber;
+    GList *item, *next;
+
+    sm_osc_server_expire_subscribers(self);
+    for (item = g_list_first(self->subscribers); item; item = next)
+    {
+        next = g_list_next(item);
+        subscriber = item->data;
+        if (!sm_osc_server_send_controls(self, subscriber->address, controls))
+        {
+            g_debug("sm_osc_server_controls_changed_cb: Subscriber refused the feedback, dropping it.");
+            sm_osc_subscriber_free(subscriber);
+            self->subscribers = g_list_delete_link(self->subscribers, item);
+        }
+    }
+}
+
+static GList*
+sm_osc_server_find_subscriber(SmOscServer *self, GSocketAddress *address)
+{
+    GInetSocketAddress *a, *b;
+    GList *item;
+
+    a = G_INET_SOCKET_ADDRESS(address);
+    for (item = g_list_first(self->subscribers); item; item = g_list_next(item))
+    {
+        b = G_INET_SOCKET_ADDRESS(((SmOscSubscriber*)item->data)->address);
+        if (g_inet_socket_address_get_port(a) == g_inet_socket_address_get_port(b)
+                && g_inet_address_equal(g_inet_socket_address_get_address(a),
+                                        g_inet_socket_address_get_address(b)))
+        {
+            return item;
+        }
+    }
+    return NULL;
+}
+
+static void
+sm_osc_server_unsubscribe(SmOscServer *self, GSocketAddress *address)
+{
+    GList *item;
+
+    item = sm_osc_server_find_subscriber(self, address);
+    if (item)
+    {
+        sm_osc_subscriber_free(item->data);
+        self->subscribers = g_list_delete_link(self->subscribers, item);
+    }
+}
+
+/*
+ * Subscribe a client or renew its subscription, and send the values of all
+ * controls. The full dump is much larger than the request, so remote clients,
+ * whose address may be spoofed, get it at most every SM_OSC_DUMP_INTERVAL.
+ */
+static void
+sm_osc_server_subscribe(SmOscServer *self, GSocketAddress *address)
+{
+    SmOscSubscriber *subscriber;
+    GInetAddress *inet_address;
+    GVariant *state;
+    GList *item;
+    gint64 now;
+
+    now = g_get_monotonic_time();
+    sm_osc_server_expire_subscribers(self);
+    item = sm_osc_server_find_subscriber(self, address);
+    if (item)
+    {
+        subscriber = item->data;
+    }
+    else
+    {
+        if (g_list_length(self->subscribers) >= SM_OSC_MAX_SUBSCRIBERS)
+        {
+            g_warning("Too many OSC subscribers, ignoring /subscribe.");
+            return;
+        }
+        subscriber = g_new0(SmOscSubscriber, 1);
+        subscriber->address = g_object_ref(address);
+        self->subscribers = g_list_append(self->subscribers, subscriber);
+    }
+    subscriber->expires = now + SM_OSC_SUBSCRIPTION_TIMEOUT * G_USEC_PER_SEC;
+    inet_address = g_inet_socket_address_get_address(G_INET_SOCKET_ADDRESS(address));
+    if (!g_inet_address_get_is_loopback(inet_address))
+    {
+        if (self->last_dump && now - self->last_dump < SM_OSC_DUMP_INTERVAL * 1000)
+        {
+            g_debug("sm_osc_server_subscribe: Skipping the full dump to a remote client.");
+            return;
+        }
+        self->last_dump = now;
+    }
+    state = g_variant_ref_sink(sm_controls_get_state(self->app));
+    if (!sm_osc_server_send_controls(self, address, state))
+    {
+        sm_osc_server_unsubscribe(self, address);
+    }
+    g_variant_unref(state);
+}
+
+/*
+ * Add the control set by a message to the batch, or note a subscription
+ * change. Both are applied only if the whole packet is accepted.
+ */
+static gboolean
+sm_osc_server_read_message(SmOscReader *reader, GVariantDict *batch,
+        SmOscSubscription *subscription)
+{
+    const gchar *address, *types;
+    GVariant *arg, *value;
+    gchar *name;
+
+    if (!sm_osc_read_string(reader, &address) || address[0] != '/')
+    {
+        return FALSE;
+    }
+    if (g_strcmp0(address, "/subscribe") == 0)
+    {
+        *subscription = SM_OSC_SUBSCRIPTION_SUBSCRIBE;
+        return TRUE;
+    }
+    if (g_strcmp0(address, "/unsubscribe") == 0)
+    {
+        *subscription = SM_OSC_SUBSCRIPTION_UNSUBSCRIBE;
+        return TRUE;
+    }
+    if (!sm_osc_read_string(reader, &types) || types[0] != ',' || strlen(types) != 2)
+    {
+        g_debug("sm_osc_server_read_message: %s needs a single argument.", address);
+        return FALSE;
+    }
+    arg = sm_osc_read_argument(reader, types[1]);
+    if (!arg)
+    {
+        g_debug("sm_osc_server_read_message: Invalid argument of %s.", address);
+        return FALSE;
+    }
+    g_variant_ref_sink(arg);
+    name = sm_osc_address_to_name(address);
+    value = sm_osc_convert_argument(name, arg);
+    g_variant_dict_insert_value(batch, name, value);
+    g_variant_unref(value);
+    g_variant_unref(arg);
+    g_free(name);
+    return TRUE;
+}
+
+static gboolean
+sm_osc_server_read_packet(SmOscReader *reader, GVariantDict *batch,
+        SmOscSubscription *subscription, guint depth)
+{
+    SmOscReader element;
+    guint32 size;
+    guint64 time_tag;
+
+    if (reader->len - reader->pos < sizeof(sm_osc_bundle_tag)
+            || memcmp(reader->data + reader->pos, sm_osc_bundle_tag, sizeof(sm_osc_bundle_tag)) != 0)
+    {
+        return sm_osc_server_read_message(reader, batch, subscription);
+    }
+    reader->pos += sizeof(sm_osc_bundle_tag);
+    if (depth >= SM_OSC_MAX_BUNDLE_DEPTH || !sm_osc_read_int64(reader, &time_tag))
+    {
+        return FALSE;
+    }
+    while (reader->pos < reader->len)
+    {
+        if (!sm_osc_read_int32(reader, &size) || size > reader->len - reader->pos)
+        {
+            return FALSE;
+        }
+        element.data = reader->data + reader->pos;
+        element.len = size;
+        element.pos = 0;
+        if (!sm_osc_server_read_packet(&element, batch, subscription, depth + 1))
+        {
+            return FALSE;
+        }
+        reader->pos += size;
+    }
+    return TRUE;
+}
+
+static gboolean
+sm_osc_server_apply_cb(gpointer user_data)
+{
+    SmOscServer *self = SM_OSC_SERVER(user_data);
+    GVariantBuilder builder;
+    GHashTableIter iter;
+    gpointer name, value;
+    GError *err = NULL;
+
+    self->apply_id = 0;
+    g_variant_builder_init(&builder, G_VARIANT_TYPE_VARDICT);
+    g_hash_table_iter_init(&iter, self->pending);
+    while (g_hash_table_iter_next(&iter, &name, &value))
+    {
+        g_variant_builder_add(&builder, "{sv}", name, value);
+    }
+    g_hash_table_remove_all(self->pending);
+    if (!sm_controls_set(self->app, g_variant_builder_end(&builder), &err))
+    {
+        g_warning("Could not apply OSC controls: %s", err->message);
+        g_error_free(err);
+    }
+    return G_SOURCE_REMOVE;
+}
+
+static void
+sm_osc_server_apply_subscription(SmOscServer *self, SmOscSubscription subscription, GSocketAddress *sender)
+{
+    switch (subscription)
+    {
+        case SM_OSC_SUBSCRIPTION_SUBSCRIBE:
+            sm_osc_server_subscribe(self, sender);
+            break;
+        case SM_OSC_SUBSCRIPTION_UNSUBSCRIBE:
+            sm_osc_server_unsubscribe(self, sender);
+            break;
+        default:
+            break;
+    }
+}
+
+/*
+ * Check the controls of a packet as one batch and merge them into the
+ * pending values. The values are written once all received packets are read.
+ */
+static void
+sm_osc_server_handle_packet(SmOscServer *self, const guint8 *data, gsize len, GSocketAddress *sender)
+{
+    SmOscReader reader = { data, len, 0 };
+    SmOscSubscription subscription = SM_OSC_SUBSCRIPTION_NONE;
+    GVariantDict batch;
+    GVariant *controls, *value;
+    GVariantIter iter;
+    gchar *name;
+    GError *err = NULL;
+
+    g_variant_dict_init(&batch, NULL);
+    if (!sm_osc_server_read_packet(&reader, &batch, &subscription, 0))
+    {
+        g_debug("sm_osc_server_handle_packet: Malformed packet of %" G_GSIZE_FORMAT " bytes.", len);
+        g_variant_dict_clear(&batch);
+        return;
+    }
+    controls = g_variant_ref_sink(g_variant_dict_end(&batch));
+    if (g_variant_n_children(controls) == 0)
+    {
+        g_variant_unref(controls);
+        sm_osc_server_apply_subscription(self, subscription, sender);
+        return;
+    }
+    if (!sm_controls_validate(self->app, controls, &err))
+    {
+        g_debug("sm_osc_server_handle_packet: %s", err->message);
+        g_error_free(err);
+        g_variant_unref(controls);
+        return;
+    }
+    sm_osc_server_apply_subscription(self, subscription, sender);
+    g_variant_iter_init(&iter, controls);
+    while (g_variant_iter_next(&iter, "{sv}", &name, &value))
+    {
+        g_hash_table_replace(self->pending, name, value);
+    }
+    g_variant_unref(controls);
+    if (!self->apply_id)
+    {
+        self->apply_id = g_idle_add(sm_osc_server_apply_cb, self);
+    }
+}
+
+static gboolean
+sm_osc_server_receive_cb(GSocket *socket, GIOCondition condition, gpointer user_data)
+{
+    SmOscServer *self = SM_OSC_SERVER(user_data);
+    guint8 buffer[SM_OSC_MAX_PACKET];
+    GSocketAddress *sender;
+    GError *err = NULL;
+    gssize len;
+    guint reads;
+
+    // Read the queued packets, so a burst of fader moves results in one write.
+    // The number is bounded, so a flood does not starve the main loop; the
+    // rest is read in the next iteration.
+    for (reads = 0; reads < SM_OSC_MAX_READS; reads++)
+    {
+        len = g_socket_receive_from(socket, &sender, (gchar*)buffer, sizeof(buffer), NULL, &err);
+        if (len < 0)
+        {
+            if (g_error_matches(err, G_IO_ERROR, G_IO_ERROR_CONNECTION_REFUSED))
+            {
+                // A client of a previous send is gone, the feedback drops it.
+                g_clear_error(&err);
+                continue;
+            }
+            if (!g_error_matches(err, G_IO_ERROR, G_IO_ERROR_WOULD_BLOCK))
+            {
+                g_warning("Could not receive OSC packet: %s", err->message);
+            }
+            g_error_free(err);
+            break;
+        }
+        // The size of OSC packets is a multiple of 4 bytes.
+        if (len % 4 == 0)
+        {
+            sm_osc_server_handle_packet(self, buffer, len, sender);
+        }
+        g_object_unref(sender);
+    }
+    return G_SOURCE_CONTINUE;
+}
+
+static void
+sm_osc_server_dispose(GObject *object)
+{
+    SmOscServer *self = SM_OSC_SERVER(object);
+
+    sm_osc_server_stop(self);
+    G_OBJECT_CLASS(sm_osc_server_parent_class)->dispose(object);
+}
+
+static void
+sm_osc_server_finalize(GObject *object)
+{
+    SmOscServer *self = SM_OSC_SERVER(object);
+
+    g_hash_table_unref(self->pending);
+    G_OBJECT_CLASS(sm_osc_server_parent_class)->finalize(object);
+}
+
+static void
+sm_osc_server_class_init(SmOscServerClass *klass)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS(klass);
+
+    object_class->dispose = sm_osc_server_dispose;
+    object_class->finalize = sm_osc_server_finalize;
+}
+
+static void
+sm_osc_server_init(SmOscServer *self)
+{
+    self->pending = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+            (GDestroyNotify)g_variant_unref);
+}
+
+SmOscServer*
+sm_osc_server_new(SmApp *app)
+{
+    SmOscServer *self;
+
+    self = g_object_new(SM_TYPE_OSC_SERVER, NULL);
+    self->app = app;
+    return self;
+}
+
+gboolean
+sm_osc_server_start(SmOscServer *self, const gchar *address, guint16 port, GError **err)
+{
+    GInetAddress *inet_address;
+    GSocketAddress *socket_address;
+    gboolean ret;
+
+    sm_osc_server_stop(self);
+    inet_address = g_inet_address_new_from_string(address);
+    if (!inet_address)
+    {
+        g_set_error(err, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT,
+                "Invalid OSC address \"%s\".", address);
+        return FALSE;
+    }
+    self->socket = g_socket_new(g_inet_address_get_family(inet_address),
+            G_SOCKET_TYPE_DATAGRAM, G_SOCKET_PROTOCOL_UDP, err);
+    if (!self->socket)
+    {
+        g_object_unref(inet_address);
+        return FALSE;
+    }
+    g_socket_set_blocking(self->socket, FALSE);
+    socket_address = g_inet_socket_address_new(inet_address, port);
+    ret = g_socket_bind(self->socket, socket_address, TRUE, err);
+    g_object_unref(socket_address);
+    g_object_unref(inet_address);
+    if (!ret)
+    {
+        g_clear_object(&self->socket);
+        return FALSE;
+    }
+    self->source = g_socket_create_source(self->socket, G_IO_IN, NULL);
+    g_source_set_callback(self->source, (GSourceFunc)sm_osc_server_receive_cb, self, NULL);
+    g_source_attach(self->source, NULL);
+    self->monitor = sm_controls_monitor_new(self->app, SM_OSC_FEEDBACK_INTERVAL);
+    g_signal_connect(self->monitor, "changed", G_CALLBACK(sm_osc_server_controls_changed_cb), self);
+    g_debug("sm_osc_server_start: Listening on %s:%u.", address, port);
+    return TRUE;
+}
+
+void
+sm_osc_server_stop(SmOscServer *self)
+{
+    g_clear_object(&self->monitor);
+    if (self->source)
+    {
+        g_source_destroy(self->source);
+        g_clear_pointer(&self->source, g_source_unref);
+    }
+    g_clear_object(&self->socket);
+    if (self->apply_id)
+    {
+        g_source_remove(self->apply_id);
+        self->apply_id = 0;
+    }
+    g_hash_table_remove_all(self->pending);
+    g_list_free_full(self->subscribers, sm_osc_subscriber_free);
+    self->subscribers = NULL;
+    self->last_dump = 0;
+}
@@ -0,0 +1,68 @@
+#ifndef __SM_OSC_H__
+#define __SM_OSC_H__
+/**
+ * @file
+ * @brief Header file for the OSC server.
+ *
+ * The server receives Open Sound Control messages on a UDP port. The address
+ * of a message is the control name (see sm-controls.h) with a leading `/`
+ * and `_` instead of spaces, e.g. `/Master_1/left/volume`. It takes a single
+ * argument:
+ * * `volume`: Volume in dB (`f`, `d` or `i`).
+ * * `mute`: `T`, `F` or a number, non-zero mutes.
+ * * `source`, `item`: Name of the item (`s`).
+ *
+ * All messages of a bundle are checked and written as one batch, an invalid
+ * message rejects the whole bundle. Time tags are ignored. Writes received
+ * while the main loop is busy are coalesced, so only the latest value of a
+ * control reaches the mixer.
+ *
+ * A client sending `/subscribe` receives the values of all controls, and then
+ * bundles of the changed controls at a bounded rate, until it sends
+ * `/unsubscribe`. A subscription expires after a minute unless renewed with
+ * another `/subscribe`, and ends when the client refuses the feedback. Clients
+ * on other hosts get the values of all controls at most once per second. A
+ * `/subscribe` in a rejected bundle has no effect.
+ */
+#include <gio/gio.h>
+
+#include "sm-app.h"
+
+G_BEGIN_DECLS
+
+/**
+ * @brief Macro to get the type information of the OSC server.
+ */
+#define SM_TYPE_OSC_SERVER sm_osc_server_get_type()
+/**
+ * @brief Macro declaring the final OSC server type.
+ */
+G_DECLARE_FINAL_TYPE(SmOscServer, sm_osc_server, SM, OSC_SERVER, GObject);
+
+/**
+ * @brief Create a new OSC server.
+ * @param app The application object.
+ * @return Pointer to new OSC server instance.
+ */
+SmOscServer *sm_osc_server_new(SmApp *app);
+
+/**
+ * @brief Bind the UDP socket and start receiving messages.
+ * @param self The OSC server.
+ * @param address Numeric IPv4 or IPv6 address of the interface to bind to,
+ * e.g. `127.0.0.1` for local clients only.
+ * @param port UDP port.
+ * @param err The GError that will be initialized in case of an error.
+ * @return TRUE on success, FALSE otherwise.
+ */
+gboolean     sm_osc_server_start(SmOscServer *self, const gchar *address, guint16 port, GError **err);
+
+/**
+ * @brief Close the socket and drop all subscribers.
+ * @param self The OSC server.
+ */
+void         sm_osc_server_stop(SmOscServer *self);
+
+G_END_DECLS
+
+#endif /* __SM_OSC_H__ */
@@ -50,6 +50,13 @@ struct _SmPrefsPrivate
     GSettings *settings; ///< GSettings object.
     GtkFileChooserButton *configfile_fchbtn; ///< File chooser dialog object.
     GtkLabel *compatible_card_lbl; ///< Label to display compatible card of selected settings file.
+    GtkSwitch *matrix_view_switch; ///< Switch to show the Matrix Mix channels in a single grid.
+    GtkComboBoxText *fader_law_comboboxtext; ///< Drop down widget to select the fader law.
+    GtkSwitch *run_in_background_switch; ///< Switch to keep the mixer open after the window is closed.
+    GtkSwitch *osc_switch; ///< Switch to enable the OSC server.
+    GtkSwitch *midi_switch; ///< Switch to enable the MIDI control surface client.
+    GtkSwitch *shm_switch; ///< Switch to enable the shared memory state export.
+    GtkSwitch *http_switch; ///< Switch to enable the HTTP server.
 };
 
 G_DEFINE_TYPE_WITH_PRIVATE(SmPrefs, sm_prefs, GTK_TYPE_WINDOW);
@@ -125,6 +132,20 @@ sm_prefs_class_init(SmPrefsClass *class)
             SmPrefs, configfile_fchbtn);
     gtk_widget_class_bind_template_child_private(GTK_WIDGET_CLASS(class),
             SmPrefs, compatible_card_lbl);
+    gtk_widget_class_bind_template_child_private(GTK_WIDGET_CLASS(class),
+            SmPrefs, matrix_view_switch);
+    gtk_widget_class_bind_template_child_private(GTK_WIDGET_CLASS(class),
+            SmPrefs, fader_law_comboboxtext);
+    gtk_widget_class_bind_template_child_private(GTK_WIDGET_CLASS(class),
+            SmPrefs, run_in_background_switch);
+    gtk_widget_class_bind_template_child_private(GTK_WIDGET_CLASS(class),
+            SmPrefs, osc_switch);
+    gtk_widget_class_bind_template_child_private(GTK_WIDGET_CLASS(class),
+            SmPrefs, midi_switch);
+    gtk_widget_class_bind_template_child_private(GTK_WIDGET_CLASS(class),
+            SmPrefs, shm_switch);
+    gtk_widget_class_bind_template_child_private(GTK_WIDGET_CLASS(class),
+            SmPrefs, http_switch);
 
     gtk_widget_class_bind_template_callback(GTK_WIDGET_CLASS(class),
             clear_btn_clicked_cb);
@@ -153,6 +174,27 @@ sm_prefs_new(SmAppWin *win)
         gtk_file_chooser_select_filename(GTK_FILE_CHOOSER(priv->configfile_fchbtn), configfile);
     }
     g_free(configfile);
+    g_settings_bind(priv->settings, "matrix-view",
+            priv->matrix_view_switch, "active",
+            G_SETTINGS_BIND_DEFAULT);
+    g_settings_bind(priv->settings, "fader-law",
+            priv->fader_law_comboboxtext, "active-id",
+            G_SETTINGS_BIND_DEFAULT);
+    g_settings_bind(priv->settings, "run-in-background",
+            priv->run_in_background_switch, "active",
+            G_SETTINGS_BIND_DEFAULT);
+    g_settings_bind(priv->settings, "osc-enabled",
+            priv->osc_switch, "active",
+            G_SETTINGS_BIND_DEFAULT);
+    g_settings_bind(priv->settings, "midi-enabled",
+            priv->midi_switch, "active",
+            G_SETTINGS_BIND_DEFAULT);
+    g_settings_bind(priv->settings, "shm-enabled",
+            priv->shm_switch, "active",
+            G_SETTINGS_BIND_DEFAULT);
+    g_settings_bind(priv->settings, "http-enabled",
+            priv->http_switch, "active",
+            G_SETTINGS_BIND_DEFAULT);
     return prefs;
 }
 
@@ -0,0 +1,299 @@
+/*
+ * sm-shm.c - Shared memory state export.
+ * Copyright (c) 2016 Martin Roesch <martin.roesch79@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <gio/gio.h>
+
+#include "config.h"
+#include "sm-shm.h"
+#include "sm-controls.h"
+#include "sm-controls-monitor.h"
+
+/**
+ * @brief Structure holding the state of the shared memory export.
+ */
+struct _SmShmExport
+{
+    GObject parent_instance; ///< Parent object.
+
+    /* Other members, including private data. */
+    SmApp *app; ///< The application object (not referenced, it outlives the export).
+    gchar *name; ///< Name of the shared memory object.
+    SmShmTable *table; ///< The mapped table, or NULL if not open.
+    GHashTable *index; ///< Position of every control in the table.
+    SmControlsMonitor *monitor; ///< Monitor of the control values, or NULL if not open.
+};
+
+G_DEFINE_TYPE(SmShmExport, sm_shm_export, G_TYPE_OBJECT);
+
+/*
+ * Make the sequence number odd, readers retry until the write has ended.
+ */
+static void
+sm_shm_export_begin_write(SmShmExport *self)
+{
+    g_atomic_int_inc(&self->table->sequence);
+}
+
+static void
+sm_shm_export_end_write(SmShmExport *self)
+{
+    g_atomic_int_inc(&self->table->sequence);
+}
+
+static void
+sm_shm_export_store(SmShmControl *control, GVariant *value)
+{
+    if (g_variant_is_of_type(value, G_VARIANT_TYPE_DOUBLE))
+    {
+        control->type = SM_SHM_TYPE_VOLUME;
+        control->volume = g_variant_get_double(value);
+    }
+    else if (g_variant_is_of_type(value, G_VARIANT_TYPE_BOOLEAN))
+    {
+        control->type = SM_SHM_TYPE_MUTE;
+        control->mute = g_variant_get_boolean(value) ? 1 : 0;
+    }
+    else if (g_variant_is_of_type(value, G_VARIANT_TYPE_STRING))
+    {
+        control->type = SM_SHM_TYPE_ITEM;
+        g_strlcpy(control->item, g_variant_get_string(value, NULL), sizeof(control->item));
+    }
+}
+
+/*
+ * Append a control to the table. Must be called between begin and end of a write.
+ */
+static void
+sm_shm_export_append(SmShmExport *self, const gchar *name, GVariant *value)
+{
+    SmShmControl *control;
+
+    if (self->table->n_controls >= SM_SHM_MAX_CONTROLS)
+    {
+        g_debug("sm_shm_export_append: No room for %s.", name);
+        return;
+    }
+    if (strlen(name) >= SM_SHM_NAME_SIZE)
+    {
+        g_debug("sm_shm_export_append: Name %s is too long.", name);
+        return;
+    }
+    control = &self->table->controls[self->table->n_controls];
+    memset(control, 0, sizeof(*control));
+    g_strlcpy(control->name, name, sizeof(control->name));
+    sm_shm_export_store(control, value);
+    g_hash_table_replace(self->index, g_strdup(name), GUINT_TO_POINTER(self->table->n_controls));
+    self->table->n_controls++;
+}
+
+/*
+ * Replace all controls of the table by the current state of the application.
+ */
+static void
+sm_shm_export_rebuild(SmShmExport *self)
+{
+    GVariantIter iter;
+    GVariant *state, *value;
+    const gchar *name;
+
+    state = g_variant_ref_sink(sm_controls_get_state(self->app));
+    sm_shm_export_begin_write(self);
+    g_hash_table_remove_all(self->index);
+    self->table->n_controls = 0;
+    memset(self->table->card_name, 0, sizeof(self->table->card_name));
+    if (sm_app_get_card_name(self->app))
+    {
+        g_strlcpy(self->table->card_name, sm_app_get_card_name(self->app), sizeof(self->table->card_name));
+    }
+    g_variant_iter_init(&iter, state);
+    while (g_variant_iter_next(&iter, "{&sv}", &name, &value))
+    {
+        sm_shm_export_append(self, name, value);
+        g_variant_unref(value);
+    }
+    self->table->layout++;
+    sm_shm_export_end_write(self);
+    g_variant_unref(state);
+}
+
+static void
+sm_shm_export_controls_changed_cb(SmControlsMonitor *monitor, GVariant *controls, gpointer user_data)
+{
+    SmShmExport *self = SM_SHM_EXPORT(user_data);
+    GVariantIter iter;
+    GVariant *value;
+    const gchar *name;
+    gpointer position;
+
+    sm_shm_export_begin_write(self);
+    g_variant_iter_init(&iter, controls);
+    while (g_variant_iter_next(&iter, "{&sv}", &name, &value))
+    {
+        if (g_hash_table_lookup_extended(self->index, name, NULL, &position))
+        {
+            sm_shm_export_store(&self->table->controls[GPOINTER_TO_UINT(position)], value);
+        }
+        g_variant_unref(value);
+    }
+    sm_shm_export_end_write(self);
+}
+
+/*
+ * Connected before the monitor is created, so the new layout is in place when
+ * the monitor announces the values of the new mixer objects.
+ */
+static void
+sm_shm_export_model_changed_cb(SmApp *app, gpointer user_data)
+{
+    sm_shm_export_rebuild(SM_SHM_EXPORT(user_data));
+}
+
+static void
+sm_shm_export_dispose(GObject *object)
+{
+    SmShmExport *self = SM_SHM_EXPORT(object);
+
+    sm_shm_export_close(self);
+    G_OBJECT_CLASS(sm_shm_export_parent_class)->dispose(object);
+}
+
+static void
+sm_shm_export_finalize(GObject *object)
+{
+    SmShmExport *self = SM_SHM_EXPORT(object);
+
+    g_hash_table_unref(self->index);
+    g_free(self->name);
+    G_OBJECT_CLASS(sm_shm_export_parent_class)->finalize(object);
+}
+
+static void
+sm_shm_export_class_init(SmShmExportClass *klass)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS(klass);
+
+    object_class->dispose = sm_shm_export_dispose;
+    object_class->finalize = sm_shm_export_finalize;
+}
+
+static void
+sm_shm_export_init(SmShmExport *self)
+{
+    self->index = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+}
+
+SmShmExport*
+sm_shm_export_new(SmApp *app)
+{
+    SmShmExport *self;
+
+    self = g_object_new(SM_TYPE_SHM_EXPORT, NULL);
+    self->app = app;
+    // One object per user, the application is unique per session.
+    self->name = g_strdup_printf("/%s-%u", PACKAGE, (guint)getuid());
+    return self;
+}
+
+gboolean
+sm_shm_export_open(SmShmExport *self, GError **err)
+{
+    struct stat st;
+    void *addr;
+    int fd, saved_errno;
+
+    sm_shm_export_close(self);
+    // Always start with a fresh object: A stale one left by a crashed instance
+    // is removed, and one created by someone else in between is refused.
+    if (shm_unlink(self->name) == 0)
+    {
+        g_debug("sm_shm_export_open: Removed stale shared memory object %s.", self->name);
+    }
+    fd = shm_open(self->name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0)
+    {
+        saved_errno = errno;
+        g_set_error(err, G_IO_ERROR, g_io_error_from_errno(saved_errno),
+                "Cannot create shared memory object %s: %s", self->name, g_strerror(saved_errno));
+        return FALSE;
+    }
+    if (fstat(fd, &st) < 0 || st.st_uid != getuid())
+    {
+        g_set_error(err, G_IO_ERROR, G_IO_ERROR_PERMISSION_DENIED,
+                "Shared memory object %s is not owned by the user.", self->name);
+        close(fd);
+        return FALSE;
+    }
+    if (ftruncate(fd, sizeof(SmShmTable)) < 0)
+    {
+        saved_errno = errno;
+        g_set_error(err, G_IO_ERROR, g_io_error_from_errno(saved_errno),
+                "Cannot resize shared memory object %s: %s", self->name, g_strerror(saved_errno));
+        close(fd);
+        shm_unlink(self->name);
+        return FALSE;
+    }
+    addr = mmap(NULL, sizeof(SmShmTable), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    saved_errno = errno;
+    close(fd);
+    if (addr == MAP_FAILED)
+    {
+        g_set_error(err, G_IO_ERROR, g_io_error_from_errno(saved_errno),
+                "Cannot map shared memory object %s: %s", self->name, g_strerror(saved_errno));
+        shm_unlink(self->name);
+        return FALSE;
+    }
+    self->table = addr;
+    self->table->magic = SM_SHM_MAGIC;
+    self->table->version = SM_SHM_VERSION;
+    self->table->reserved = 0;
+    sm_shm_export_rebuild(self);
+    g_signal_connect(self->app, "model-changed", G_CALLBACK(sm_shm_export_model_changed_cb), self);
+    self->monitor = sm_controls_monitor_new(self->app, 0);
+    g_signal_connect(self->monitor, "changed", G_CALLBACK(sm_shm_export_controls_changed_cb), self);
+    g_debug("sm_shm_export_open: Publishing %u controls in %s.", self->table->n_controls, self->name);
+    return TRUE;
+}
+
+void
+sm_shm_export_close(SmShmExport *self)
+{
+    g_clear_object(&self->monitor);
+    if (self->app)
+    {
+        g_signal_handlers_disconnect_by_data(self->app, self);
+    }
+    if (self->table)
+    {
+        // Readers which keep the object mapped see that no mixer is published.
+        sm_shm_export_begin_write(self);
+        self->table->n_controls = 0;
+        memset(self->table->card_name, 0, sizeof(self->table->card_name));
+        self->table->layout++;
+        sm_shm_export_end_write(self);
+        munmap(self->table, sizeof(SmShmTable));
+        self->table = NULL;
+        shm_unlink(self->name);
+    }
+    g_hash_table_remove_all(self->index);
+}
@@ -0,0 +1,129 @@
+#ifndef __SM_SHM_H__
+#define __SM_SHM_H__
+/**
+ * @file
+ * @brief Header file for the shared memory state export.
+ *
+ * The export publishes the values of the named controls (see sm-controls.h)
+ * in the POSIX shared memory object `/scarlettmixer-<uid>` as a
+ * @ref SmShmTable, so local programs can read the mixer state without
+ * polling ALSA or D-Bus. The table is updated whenever a control changes.
+ * The object is created anew with mode 0600 each time the export is opened,
+ * so only programs of the same user can read it, and a reader holding the
+ * previous object maps the name again.
+ *
+ * The table is protected by a sequence lock: the sequence number is odd
+ * while the table is written. A reader copies what it needs and retries if
+ * the sequence number was odd or changed meanwhile:
+ * @code
+ * SmShmTable *table = mmap(NULL, sizeof(SmShmTable), PROT_READ, MAP_SHARED, fd, 0);
+ * gint seq;
+ * do
+ * {
+ *     seq = __atomic_load_n(&table->sequence, __ATOMIC_ACQUIRE);
+ *     memcpy(&copy, table, sizeof(copy));
+ *     __atomic_thread_fence(__ATOMIC_ACQUIRE);
+ * } while ((seq & 1) || seq != __atomic_load_n(&table->sequence, __ATOMIC_RELAXED));
+ * @endcode
+ *
+ * The position of a control in the table only changes when the layout number
+ * changes, i.e. when another mixer is opened, so readers can look up the
+ * controls they show once per layout.
+ */
+#include <glib-object.h>
+
+#include "sm-app.h"
+
+G_BEGIN_DECLS
+
+/**
+ * @brief Magic number at the start of the table ("SMST").
+ */
+#define SM_SHM_MAGIC 0x534d5354
+/**
+ * @brief Version of the table layout, changed on incompatible changes.
+ */
+#define SM_SHM_VERSION 1
+/**
+ * @brief Maximal number of controls in the table.
+ */
+#define SM_SHM_MAX_CONTROLS 1024
+/**
+ * @brief Size of the control and card name fields including the terminator.
+ */
+#define SM_SHM_NAME_SIZE 64
+/**
+ * @brief Size of the item name field including the terminator.
+ */
+#define SM_SHM_ITEM_SIZE 32
+
+/**
+ * @brief Enumeration of the control types in the table.
+ */
+typedef enum
+{
+    SM_SHM_TYPE_VOLUME = 1, ///< Volume in dB, stored in SmShmControl::volume.
+    SM_SHM_TYPE_MUTE, ///< Mute, stored in SmShmControl::mute.
+    SM_SHM_TYPE_ITEM ///< Selected source or switch item, stored in SmShmControl::item.
+} SmShmType;
+
+/**
+ * @brief Structure holding one control in the table.
+ */
+typedef struct
+{
+    gchar name[SM_SHM_NAME_SIZE]; ///< Control name, zero terminated.
+    guint32 type; ///< Control type, see @ref SmShmType.
+    gint32 mute; ///< 1 if muted, 0 otherwise.
+    gdouble volume; ///< Volume in dB.
+    gchar item[SM_SHM_ITEM_SIZE]; ///< Name of the selected item, zero terminated.
+} SmShmControl;
+
+/**
+ * @brief Structure of the shared memory object.
+ */
+typedef struct
+{
+    guint32 magic; ///< @ref SM_SHM_MAGIC.
+    guint32 version; ///< @ref SM_SHM_VERSION.
+    gint sequence; ///< Sequence number, odd while the table is written.
+    guint32 layout; ///< Layout number, incremented when the controls are replaced.
+    guint32 n_controls; ///< Number of valid entries in controls.
+    guint32 reserved; ///< Reserved, 0.
+    gchar card_name[SM_SHM_NAME_SIZE]; ///< Name of the sound card, empty if no mixer is open.
+    SmShmControl controls[SM_SHM_MAX_CONTROLS]; ///< The controls.
+} SmShmTable;
+
+/**
+ * @brief Macro to get the type information of the shared memory export.
+ */
+#define SM_TYPE_SHM_EXPORT sm_shm_export_get_type()
+/**
+ * @brief Macro declaring the final shared memory export type.
+ */
+G_DECLARE_FINAL_TYPE(SmShmExport, sm_shm_export, SM, SHM_EXPORT, GObject);
+
+/**
+ * @brief Create a new shared memory export.
+ * @param app The application object.
+ * @return Pointer to new shared memory export instance.
+ */
+SmShmExport *sm_shm_export_new(SmApp *app);
+
+/**
+ * @brief Create the shared memory object and publish the current state.
+ * @param self The shared memory export.
+ * @param err The GError that will be initialized in case of an error.
+ * @return TRUE on success, FALSE otherwise.
+ */
+gboolean     sm_shm_export_open(SmShmExport *self, GError **err);
+
+/**
+ * @brief Stop updating the table and remove the shared memory object.
+ * @param self The shared memory export.
+ */
+void         sm_shm_export_close(SmShmExport *self);
+
+G_END_DECLS
+
+#endif /* __SM_SHM_H__ */
@@ -0,0 +1,306 @@
+/*
+ * sm-source-selector.c - GTK+ widget to select an item of an enum item set.
+ * Copyright (c) 2016 Martin Roesch <martin.roesch79@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtk/gtk.h>
+
+#include "sm-source-selector.h"
+#include "sm-enum.h"
+
+#define SM_SOURCE_SELECTOR_LIST_HEIGHT (300) ///< Minimal height of the scrolled item list in pixels.
+
+/**
+ * @brief Structure holding the state of the source selector widget.
+ */
+struct _SmSourceSelector
+{
+    GtkMenuButton parent_instance; ///< Parent object.
+
+    /* Other members, including private data. */
+    const gchar * const *items; ///< Interned item name set, or NULL.
+    gint active; ///< Active item index, or -1.
+    GtkLabel *label; ///< GtkLabel displaying the active item name.
+    GtkPopover *popover; ///< GtkPopover of the button, empty until the first opening.
+    GtkSearchEntry *search_entry; ///< GtkSearchEntry to filter the items, NULL until the first opening.
+    GtkListBox *list_box; ///< GtkListBox listing the items, NULL until the first opening.
+};
+
+G_DEFINE_TYPE(SmSourceSelector, sm_source_selector, GTK_TYPE_MENU_BUTTON);
+
+enum
+{
+    SM_SOURCE_SELECTOR_SIGNAL_CHANGED, ///< Active item changed signal.
+    N_SIGNALS ///< Number of signals.
+};
+
+static int sm_source_selector_signals[N_SIGNALS] = {0};
+
+static gboolean
+sm_source_selector_filter_func(GtkListBoxRow *row, gpointer user_data)
+{
+    SmSourceSelector *self = SM_SOURCE_SELECTOR(user_data);
+    const gchar *search, *name;
+
+    search = gtk_entry_get_text(GTK_ENTRY(self->search_entry));
+    if (!search || !*search)
+    {
+        return TRUE;
+    }
+    name = sm_enum_get_name(self->items, gtk_list_box_row_get_index(row));
+    return name && g_str_match_string(search, name, TRUE);
+}
+
+static void
+sm_source_selector_select_active_row(SmSourceSelector *self)
+{
+    GtkListBoxRow *row;
+
+    row = self->active >= 0 ? gtk_list_box_get_row_at_index(self->list_box, self->active) : NULL;
+    if (row)
+    {
+        gtk_list_box_select_row(self->list_box, row);
+    }
+    else
+    {
+        gtk_list_box_unselect_all(self->list_box);
+    }
+}
+
+static void
+sm_source_selector_row_activated_cb(GtkListBox *box, GtkListBoxRow *row, gpointer user_data)
+{
+    SmSourceSelector *self = SM_SOURCE_SELECTOR(user_data);
+
+    sm_source_selector_set_active(self, gtk_list_box_row_get_index(row));
+    gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(self), FALSE);
+}
+
+static void
+sm_source_selector_search_changed_cb(GtkSearchEntry *entry, gpointer user_data)
+{
+    gtk_list_box_invalidate_filter(SM_SOURCE_SELECTOR(user_data)->list_box);
+}
+
+static void
+sm_source_selector_search_activate_cb(GtkEntry *entry, gpointer user_data)
+{
+    SmSourceSelector *self = SM_SOURCE_SELECTOR(user_data);
+    GtkListBoxRow *row;
+    gint idx;
+
+    // Pick the first item matching the search.
+    for (idx = 0; (row = gtk_list_box_get_row_at_index(self->list_box, idx)); idx++)
+    {
+        if (gtk_widget_get_child_visible(GTK_WIDGET(row)))
+        {
+            sm_source_selector_row_activated_cb(self->list_box, row, self);
+            return;
+        }
+    }
+}
+
+/*
+ * Build the popover content. The item list is only needed once the user
+ * opens the selector, so it is not created together with the button.
+ */
+static void
+sm_source_selector_populate(SmSourceSelector *self)
+{
+    GtkWidget *box, *scrolled_window, *label;
+    gint idx;
+
+    box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 3);
+    gtk_container_set_border_width(GTK_CONTAINER(box), 3);
+    self->search_entry = GTK_SEARCH_ENTRY(gtk_search_entry_new());
+    g_signal_connect(self->search_entry, "search-changed",
+            G_CALLBACK(sm_source_selector_search_changed_cb), self);
+    g_signal_connect(self->search_entry, "activate",
+            G_CALLBACK(sm_source_selector_search_activate_cb), self);
+    gtk_box_pack_start(GTK_BOX(box), GTK_WIDGET(self->search_entry), FALSE, FALSE, 0);
+
+    self->list_box = GTK_LIST_BOX(gtk_list_box_new());
+    gtk_list_box_set_selection_mode(self->list_box, GTK_SELECTION_SINGLE);
+    gtk_list_box_set_filter_func(self->list_box, sm_source_selector_filter_func, self, NULL);
+    g_signal_connect(self->list_box, "row-activated",
+            G_CALLBACK(sm_source_selector_row_activated_cb), self);
+    for (idx = 0; self->items && self->items[idx]; idx++)
+    {
+        label = gtk_label_new(self->items[idx]);
+        gtk_widget_set_halign(label, GTK_ALIGN_START);
+        gtk_widget_set_margin_start(label, 6);
+        gtk_widget_set_margin_end(label, 6);
+        gtk_list_box_insert(self->list_box, label, -1);
+    }
+
+    scrolled_window = gtk_scrolled_window_new(NULL, NULL);
+    gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(scrolled_window),
+            GTK_POLICY_NEVER, GTK_POLICY_AUTOMATIC);
+    gtk_scrolled_window_set_min_content_height(GTK_SCROLLED_WINDOW(scrolled_window),
+            SM_SOURCE_SELECTOR_LIST_HEIGHT);
+    gtk_container_add(GTK_CONTAINER(scrolled_window), GTK_WIDGET(self->list_box));
+    gtk_box_pack_start(GTK_BOX(box), scrolled_window, TRUE, TRUE, 0);
+
+    gtk_widget_show_all(box);
+    gtk_container_add(GTK_CONTAINER(self->popover), box);
+}
+
+static void
+sm_source_selector_depopulate(SmSourceSelector *self)
+{
+    GtkWidget *child;
+
+    child = gtk_bin_get_child(GTK_BIN(self->popover));
+    if (child)
+    {
+        gtk_widget_destroy(child);
+    }
+    self->search_entry = NULL;
+    self->list_box = NULL;
+}
+
+static void
+sm_source_selector_toggled(GtkToggleButton *button)
+{
+    SmSourceSelector *self = SM_SOURCE_SELECTOR(button);
+
+    if (gtk_toggle_button_get_active(button))
+    {
+        if (!self->list_box)
+        {
+            sm_source_selector_populate(self);
+        }
+        gtk_entry_set_text(GTK_ENTRY(self->search_entry), "");
+        sm_source_selector_select_active_row(self);
+    }
+    GTK_TOGGLE_BUTTON_CLASS(sm_source_selector_parent_class)->toggled(button);
+    if (gtk_toggle_button_get_active(button))
+    {
+        gtk_widget_grab_focus(GTK_WIDGET(self->search_entry));
+    }
+}
+
+static void
+sm_source_selector_update_label(SmSourceSelector *self)
+{
+    const gchar *name;
+
+    name = sm_enum_get_name(self->items, self->active);
+    gtk_label_set_text(self->label, name ? name : "");
+}
+
+static void
+sm_source_selector_class_init(SmSourceSelectorClass *klass)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS(klass);
+    GtkToggleButtonClass *toggle_button_class = GTK_TOGGLE_BUTTON_CLASS(klass);
+
+    toggle_button_class->toggled = sm_source_selector_toggled;
+
+    sm_source_selector_signals[SM_SOURCE_SELECTOR_SIGNAL_CHANGED] =
+        g_signal_newv("changed",
+                      G_TYPE_FROM_CLASS(object_class),
+                      G_SIGNAL_RUN_LAST | G_SIGNAL_NO_RECURSE | G_SIGNAL_NO_HOOKS,
+                      NULL /* closure */,
+                      NULL /* accumulator */,
+                      NULL /* accumulator data */,
+                      NULL /* C marshaller */,
+                      G_TYPE_NONE /* return_type */,
+                      0     /* n_params */,
+                      NULL  /* param_types */);
+}
+
+static void
+sm_source_selector_init(SmSourceSelector *self)
+{
+    GtkWidget *box, *child;
+
+    self->active = -1;
+
+    // Replace the arrow added by GtkMenuButton by a label and an arrow.
+    child = gtk_bin_get_child(GTK_BIN(self));
+    if (child)
+    {
+        gtk_container_remove(GTK_CONTAINER(self), child);
+    }
+    box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 3);
+    self->label = GTK_LABEL(gtk_label_new(""));
+    gtk_label_set_xalign(self->label, 0.0);
+    gtk_box_pack_start(GTK_BOX(box), GTK_WIDGET(self->label), TRUE, TRUE, 0);
+    gtk_box_pack_end(GTK_BOX(box),
+            gtk_image_new_from_icon_name("pan-down-symbolic", GTK_ICON_SIZE_BUTTON),
+            FALSE, FALSE, 0);
+    gtk_widget_show_all(box);
+    gtk_container_add(GTK_CONTAINER(self), box);
+
+    self->popover = GTK_POPOVER(gtk_popover_new(GTK_WIDGET(self)));
+    gtk_menu_button_set_popover(GTK_MENU_BUTTON(self), GTK_WIDGET(self->popover));
+}
+
+GtkWidget*
+sm_source_selector_new()
+{
+    return g_object_new(SM_TYPE_SOURCE_SELECTOR, NULL);
+}
+
+void
+sm_source_selector_set_items(SmSourceSelector *self, const gchar * const *items, gint active)
+{
+    gint idx, width;
+
+    if (self->items != items)
+    {
+        sm_source_selector_depopulate(self);
+        self->items = items;
+        // Size the label for the longest name like a GtkComboBox does.
+        width = 0;
+        for (idx = 0; items && items[idx]; idx++)
+        {
+            width = MAX(width, (gint)g_utf8_strlen(items[idx], -1));
+        }
+        gtk_label_set_width_chars(self->label, width);
+        self->active = -1;
+    }
+    sm_source_selector_set_active(self, active);
+}
+
+gint
+sm_source_selector_get_active(SmSourceSelector *self)
+{
+    return self->active;
+}
+
+void
+sm_source_selector_set_active(SmSourceSelector *self, gint active)
+{
+    gboolean changed;
+
+    if (!sm_enum_get_name(self->items, active))
+    {
+        active = -1;
+    }
+    changed = (self->active != active);
+    self->active = active;
+    sm_source_selector_update_label(self);
+    if (self->list_box)
+    {
+        sm_source_selector_select_active_row(self);
+    }
+    if (changed)
+    {
+        g_signal_emit(self, sm_source_selector_signals[SM_SOURCE_SELECTOR_SIGNAL_CHANGED], 0);
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef __SM_SOURCE_SELECTOR_H__
+#define __SM_SOURCE_SELECTOR_H__
+/**
+ * @file
+ * @brief Header file for the source selector widget.
+ *
+ * The source selector is a button showing the name of the selected item of
+ * an interned item name set (see sm-enum.h). The popover listing the items,
+ * with a search entry to filter them, is only built when the button is
+ * opened for the first time. This keeps the many source selectors of the
+ * output and mix strips cheap compared to a GtkComboBox per selector.
+ */
+#include <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+/**
+ * @brief Macro to get the type information of the source selector widget.
+ */
+#define SM_TYPE_SOURCE_SELECTOR sm_source_selector_get_type()
+/**
+ * @brief Macro declaring the final source selector widget type.
+ */
+G_DECLARE_FINAL_TYPE(SmSourceSelector, sm_source_selector, SM, SOURCE_SELECTOR, GtkMenuButton);
+
+/**
+ * @brief Create a new source selector instance.
+ * @return Pointer to new source selector instance.
+ */
+GtkWidget*   sm_source_selector_new();
+
+/**
+ * @brief Set the selectable items.
+ * An already built item list is dropped and rebuilt on the next opening if
+ * the set changes. The "changed" signal is emitted if the active item index
+ * changes.
+ * @param self The source selector widget.
+ * @param items The interned item name set or NULL.
+ * @param active The active item index or -1.
+ */
+void         sm_source_selector_set_items(SmSourceSelector *self, const gchar * const *items, gint active);
+
+/**
+ * @brief Get the active item.
+ * @param self The source selector widget.
+ * @return The active item index or -1.
+ */
+gint         sm_source_selector_get_active(SmSourceSelector *self);
+
+/**
+ * @brief Set the active item.
+ * The "changed" signal is emitted if the active item index changes.
+ * @param self The source selector widget.
+ * @param active The active item index or -1.
+ */
+void         sm_source_selector_set_active(SmSourceSelector *self, gint active);
+
+G_END_DECLS
+
+#endif /* __SM_SOURCE_SELECTOR_H__ */
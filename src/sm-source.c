@@ -17,6 +17,9 @@
  */
 
 #include "sm-source.h"
+#include "sm-enum.h"
+#include "sm-metrics.h"
+#include "sm-trace.h"
 
 /**
  * @brief Structure holding the ALSA mixer elements belonging to an input source.
@@ -28,6 +31,9 @@ struct _SmSource
     /* Other members, including private data. */
     snd_mixer_elem_t *elem; ///< Input source ALSA mixer element.
     gchar *name; ///< Input source name.
+    const gchar * const *items; ///< Interned last-known source names, only set while no ALSA mixer element is attached.
+    const gchar * const *names; ///< Interned source names of the attached ALSA mixer element, read on first use.
+    int index; ///< Last-known index of the selected source.
 };
 
 G_DEFINE_TYPE(SmSource, sm_source, G_TYPE_OBJECT);
@@ -156,26 +162,28 @@ sm_source_mixer_elem_changed(SmSource *self, snd_mixer_elem_t *elem)
     }
 }
 
-GList*
-sm_source_get_item_names(SmSource *self)
+const gchar * const *
+sm_source_get_items(SmSource *self)
 {
-    int idx;
-    gchar buf[16];
-    gchar *name;
-    GList *ret = NULL;
-
+    if (self->items)
+    {
+        return self->items;
+    }
     if (!self->elem)
     {
         return NULL;
     }
-    for(idx = 0; idx < snd_mixer_selem_get_enum_items(self->elem); idx++)
+    if (!self->names)
     {
-        if(snd_mixer_selem_get_enum_item_name(self->elem, idx, 16, buf) == 0)
-        {
-            ret = g_list_prepend(ret, g_strdup(buf));
-        }
+        self->names = sm_enum_intern_elem(self->elem);
     }
-    return g_list_reverse(ret);
+    return self->names;
+}
+
+GList*
+sm_source_get_item_names(SmSource *self)
+{
+    return sm_enum_to_list(sm_source_get_items(self));
 }
 
 int
@@ -184,6 +192,10 @@ sm_source_get_selected_item_index(SmSource *self)
     int err;
     unsigned int idx;
 
+    if (self->items)
+    {
+        return self->index;
+    }
     if (!self->elem)
     {
         return -1;
@@ -200,18 +212,34 @@ sm_source_get_selected_item_index(SmSource *self)
 gboolean
 sm_source_set_selected_item_index(SmSource *self, unsigned int idx)
 {
+    unsigned int current;
     int err;
 
+    if (self->items)
+    {
+        self->index = idx;
+        return TRUE;
+    }
     if (!self->elem)
     {
         return FALSE;
     }
+    if (snd_mixer_selem_get_enum_item(self->elem, SND_MIXER_SCHN_FRONT_LEFT, &current) >= 0
+            && current == idx)
+    {
+        // Skip the write, the item is already selected.
+        sm_metrics_count_write(SM_METRICS_CONTROL_SOURCE, SM_METRICS_WRITE_SKIPPED);
+        return TRUE;
+    }
     err = snd_mixer_selem_set_enum_item(self->elem, SND_MIXER_SCHN_FRONT_LEFT, idx);
     if (err < 0)
     {
+        sm_metrics_count_write(SM_METRICS_CONTROL_SOURCE, SM_METRICS_WRITE_FAILED);
         g_warning("sm_source_get_selected_item_index: Cannot set selected item to index %d!", idx);
         return FALSE;
     }
+    sm_metrics_count_write(SM_METRICS_CONTROL_SOURCE, SM_METRICS_WRITE_DONE);
+    sm_trace_record_write(SM_TRACE_WRITE_ENUM, self->elem, SND_MIXER_SCHN_FRONT_LEFT, idx);
     return TRUE;
 }
 
@@ -266,3 +294,136 @@ sm_source_load_from_json_node(SmSource *self, JsonNode *node)
     sm_source_set_selected_item_index(self, (unsigned int)source_index);
     return TRUE;
 }
+
+JsonNode*
+sm_source_to_snapshot_node(SmSource *self)
+{
+    JsonBuilder *jb;
+    JsonNode *jn;
+    GList *list, *item;
+
+    jb = json_builder_new();
+    jb = json_builder_begin_object(jb);
+
+    jb = json_builder_set_member_name(jb, "name");
+    jb = json_builder_add_string_value(jb, self->name);
+
+    jb = json_builder_set_member_name(jb, "items");
+    jb = json_builder_begin_array(jb);
+    list = sm_source_get_item_names(self);
+    for (item = g_list_first(list); item; item = g_list_next(item))
+    {
+        jb = json_builder_add_string_value(jb, item->data);
+    }
+    g_list_free_full(list, g_free);
+    jb = json_builder_end_array(jb);
+
+    jb = json_builder_set_member_name(jb, "source_index");
+    jb = json_builder_add_int_value(jb, sm_source_get_selected_item_index(self));
+
+    jb = json_builder_end_object(jb);
+    jn = json_builder_get_root(jb);
+    g_object_unref(jb);
+    return jn;
+}
+
+/*
+ * Check if a snapshot node is a value of the given type.
+ */
+static gboolean
+sm_source_snapshot_holds(JsonNode *jn, GType type)
+{
+    return jn && JSON_NODE_HOLDS_VALUE(jn) && json_node_get_value_type(jn) == type;
+}
+
+/*
+ * Check the members of a snapshot input source before they are read.
+ */
+static gboolean
+sm_source_snapshot_is_valid(JsonObject *jo)
+{
+    JsonNode *jn;
+    JsonArray *ja;
+    guint i;
+
+    if (!sm_source_snapshot_holds(json_object_get_member(jo, "name"), G_TYPE_STRING)
+            || !sm_source_snapshot_holds(json_object_get_member(jo, "source_index"), G_TYPE_INT64))
+    {
+        return FALSE;
+    }
+    jn = json_object_get_member(jo, "items");
+    if (!jn || !JSON_NODE_HOLDS_ARRAY(jn))
+    {
+        return FALSE;
+    }
+    ja = json_node_get_array(jn);
+    for (i = 0; i < json_array_get_length(ja); i++)
+    {
+        if (!sm_source_snapshot_holds(json_array_get_element(ja, i), G_TYPE_STRING))
+        {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+SmSource*
+sm_source_new_from_snapshot_node(JsonNode *node)
+{
+    SmSource *self;
+    JsonObject *jo;
+    JsonArray *ja;
+    const gchar **names;
+    guint i;
+
+    if (!JSON_NODE_HOLDS_OBJECT(node))
+    {
+        return NULL;
+    }
+    jo = json_node_get_object(node);
+    if (!sm_source_snapshot_is_valid(jo))
+    {
+        g_warning("Invalid snapshot format: Incomplete input source!");
+        return NULL;
+    }
+    self = sm_source_new();
+    self->name = g_strdup(json_object_get_string_member(jo, "name"));
+    ja = json_object_get_array_member(jo, "items");
+    names = g_new0(const gchar*, json_array_get_length(ja) + 1);
+    for (i = 0; i < json_array_get_length(ja); i++)
+    {
+        names[i] = json_array_get_string_element(ja, i);
+    }
+    self->items = sm_enum_intern(names);
+    g_free(names);
+    self->index = json_object_get_int_member(jo, "source_index");
+    return self;
+}
+
+gboolean
+sm_source_reconcile(SmSource *self, SmSource *live)
+{
+    int idx;
+
+    if (!self->items
+            || !live->elem
+            || g_strcmp0(self->name, live->name) != 0)
+    {
+        return FALSE;
+    }
+    // Interned sets are equal if their addresses are equal.
+    if (sm_source_get_items(live) != self->items)
+    {
+        return FALSE;
+    }
+    idx = sm_source_get_selected_item_index(live);
+    self->elem = live->elem;
+    self->names = live->names;
+    self->items = NULL;
+    if (idx != self->index)
+    {
+        g_debug("sm_source_reconcile: %s differs from snapshot.", self->name);
+        g_signal_emit(self, sm_source_signals[SM_SOURCE_SIGNAL_CHANGED], 0);
+    }
+    return TRUE;
+}
@@ -58,10 +58,18 @@ gboolean     sm_source_has_mixer_elem(SmSource *self, snd_mixer_elem_t *elem);
  */
 void         sm_source_mixer_elem_changed(SmSource *self, snd_mixer_elem_t *elem);
 
+/**
+ * @brief Get the interned source names.
+ * The names are read from ALSA on first use, see @ref sm-enum.h.
+ * @param self The input source object.
+ * @return The interned set of source names or NULL.
+ */
+const gchar * const *sm_source_get_items(SmSource *self);
+
 /**
  * @brief Get the list of source names.
  * @param self The input source object.
- * @return The list of source names or NULL.
+ * @return The list of newly allocated source names or NULL.
  */
 GList*       sm_source_get_item_names(SmSource *self);
 
@@ -94,6 +102,33 @@ JsonNode*    sm_source_to_json_node(SmSource *self);
  * @return TRUE on success, FALSE otherwise.
  */
 gboolean     sm_source_load_from_json_node(SmSource *self, JsonNode *node);
+
+/**
+ * @brief Get a JSON object representation of the input source including its source names.
+ * @param self The input source object.
+ * @return The JSON object.
+ */
+JsonNode*    sm_source_to_snapshot_node(SmSource *self);
+
+/**
+ * @brief Create an input source from a snapshot JSON object.
+ * The input source has no ALSA mixer element attached until
+ * @ref sm_source_reconcile is called.
+ * @param node The JSON object created by @ref sm_source_to_snapshot_node.
+ * @return Pointer to new input source instance or NULL in case of an error.
+ */
+SmSource*    sm_source_new_from_snapshot_node(JsonNode *node);
+
+/**
+ * @brief Reconcile an input source created from a snapshot with a live input source.
+ * If the source names match, the ALSA mixer element of the live input source
+ * is attached. The SM_SOURCE_SIGNAL_CHANGED signal is only emitted if the
+ * selected source differs from the last-known state.
+ * @param self The input source created by @ref sm_source_new_from_snapshot_node.
+ * @param live The input source created from the ALSA mixer element.
+ * @return TRUE if the input source was reconciled, FALSE otherwise.
+ */
+gboolean     sm_source_reconcile(SmSource *self, SmSource *live);
 G_END_DECLS
 
 #endif /* __SM_SOURCE_H__ */
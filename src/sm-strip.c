@@ -17,9 +17,28 @@
  */
 
 #include <gtk/gtk.h>
-#include <math.h>
 
 #include "sm-strip.h"
+#include "sm-controls.h"
+#include "sm-meter-bar.h"
+#include "sm-enum.h"
+#include "sm-source-selector.h"
+#include "sm-taper.h"
+
+/**
+ * @brief Flags of the strip widgets which differ from the state of the SmChannel.
+ * The source, volume and mute flags apply to the left channel, shifted by
+ * @ref SM_STRIP_DIRTY_RIGHT_SHIFT they apply to the right channel.
+ */
+enum
+{
+    SM_STRIP_DIRTY_SOURCE = 1 << 0, ///< Source selector.
+    SM_STRIP_DIRTY_VOLUME = 1 << 1, ///< Volume scale.
+    SM_STRIP_DIRTY_MUTE = 1 << 2, ///< Mute toggle button.
+    SM_STRIP_DIRTY_METER = 1 << 6, ///< Capture channels of the meter bars.
+};
+
+#define SM_STRIP_DIRTY_RIGHT_SHIFT (3) ///< Shift of the dirty flags of the right channel.
 
 /**
  * @brief Structure representing the strip widget class.
@@ -50,54 +69,58 @@ struct _SmStripPrivate
     SmChannel *channel; ///< SmChannel associated with this strip widget.
     gulong changed_handler_id; ///< Signal handler for the "changed" signal of the associated SmChannel.
     GtkEntry *name_entry; ///< Widget to set the name of this mix strip widget.
-    GtkComboBoxText *left_scale_source_comboboxtext; ///< Drop down widget to select the input channel for the left channel of the associated SmChannel.
+    SmSourceSelector *left_scale_source_selector; ///< Selector widget to select the input channel for the left channel of the associated SmChannel.
     GtkScale *left_scale; ///< Widget to set the volume of the left channel.
     GtkAdjustment *left_adjustment; ///< Widget to display the volume ticks of the left channel.
-    GtkLevelBar *left_levelbar; ///< Widget to show the volume level of the left channel.
+    SmMeterBar *left_meterbar; ///< Widget to show the signal level of the left channel.
     GtkToggleButton *left_mute_togglebutton; ///< Widget to mute the left channel.
-    GtkComboBoxText *right_scale_source_comboboxtext; ///< Drop down widget to select the input channel for the right channel of the associated SmChannel.
+    SmSourceSelector *right_scale_source_selector; ///< Selector widget to select the input channel for the right channel of the associated SmChannel.
     GtkScale *right_scale; ///< Widget to set the volume of the right channel.
     GtkAdjustment *right_adjustment; ///< Widget to display the volume ticks of the right channel.
-    GtkLevelBar *right_levelbar; ///< Widget to show the volume level of the right channel.
+    SmMeterBar *right_meterbar; ///< Widget to show the signal level of the right channel.
     GtkToggleButton *right_mute_togglebutton; ///< Widget to mute the right channel.
     GtkToggleButton *join_togglebutton; ///< Widget to join the actions of both channels.
+    SmMeter *meter; ///< SmMeter providing the signal levels, or NULL.
+    gulong meter_routing_handler_id; ///< Signal handler for the "routing-changed" signal of the meter.
+    const SmTaper *taper; ///< Taper of the volume scales.
+    guint dirty; ///< Flags of the widgets to update on the next frame.
+    guint tick_id; ///< Tick callback updating the dirty widgets, or 0.
+    gboolean suspended; ///< Indicates if widget updates are suspended.
+    gboolean stale; ///< Indicates if the channel changed while the updates were suspended.
 };
 
 G_DEFINE_TYPE_WITH_PRIVATE(SmStrip, sm_strip, GTK_TYPE_BOX);
 
-static gdouble
-vol_to_value(gdouble vol_db) {
-    return pow(10, vol_db / 60.0);
-}
-
-static gdouble
-value_to_vol(gdouble value) {
-    return 60.0*log10(value);
-}
-
 static void
-scale_source_comboboxtext_changed_cb(GtkComboBox *combo,
+scale_source_selector_changed_cb(SmSourceSelector *selector,
         gpointer     user_data)
 {
     SmStripPrivate *priv;
     int active_idx;
 
     priv = sm_strip_get_instance_private(user_data);
-    active_idx = gtk_combo_box_get_active(combo);
-    if(GTK_WIDGET(combo) == GTK_WIDGET(priv->left_scale_source_comboboxtext)) {
+    active_idx = sm_source_selector_get_active(selector);
+    if (active_idx < 0) {
+        return;
+    }
+    if(selector == priv->left_scale_source_selector) {
         sm_channel_source_set_selected_item_index(priv->channel, SND_MIXER_SCHN_FRONT_LEFT, active_idx);
     }
-    else if(GTK_WIDGET(combo) == GTK_WIDGET(priv->right_scale_source_comboboxtext)) {
+    else if(selector == priv->right_scale_source_selector) {
         sm_channel_source_set_selected_item_index(priv->channel, SND_MIXER_SCHN_FRONT_RIGHT, active_idx);
     }
 }
 
 static gchar*
 scale_format_value_cb(GtkScale *scale,
-        gdouble value)
+        gdouble value,
+        gpointer user_data)
 {
-    return g_strdup_printf("%0.*f",
-            gtk_scale_get_digits(scale), value_to_vol(value));
+    SmStripPrivate *priv;
+
+    priv = sm_strip_get_instance_private(user_data);
+    // The labels are formatted once per step of the taper.
+    return g_strdup(priv->taper ? sm_taper_get_label(priv->taper, value) : "");
 }
 
 static void
@@ -111,18 +134,16 @@ scale_value_changed_cb(GtkRange *range, gpointer user_data)
 
     priv = sm_strip_get_instance_private(user_data);
     value = gtk_range_get_value(range);
-    vol_db = value_to_vol(value);
+    vol_db = sm_taper_value_to_db(priv->taper, value);
     if(GTK_WIDGET(range) == GTK_WIDGET(priv->left_scale)) {
         g_debug("scale_value_changed_cb: Left - %f dB", vol_db);
         ch = SND_MIXER_SCHN_FRONT_LEFT;
         other_range = GTK_RANGE(priv->right_scale);
-        gtk_level_bar_set_value(priv->left_levelbar, value);
     }
     if(GTK_WIDGET(range) == GTK_WIDGET(priv->right_scale)) {
         g_debug("scale_value_changed_cb: Right - %f dB", vol_db);
         ch = SND_MIXER_SCHN_FRONT_RIGHT;
         other_range = GTK_RANGE(priv->left_scale);
-        gtk_level_bar_set_value(priv->right_levelbar, value);
     }
     if(!sm_channel_volume_set_db(priv->channel, ch, vol_db))
     {
@@ -179,57 +200,178 @@ join_togglebutton_toggled_cb(GtkToggleButton *togglebutton, gpointer user_data)
     sm_channel_set_joint_volume(priv->channel, active);
 }
 
+static gint
+sm_strip_find_meter_channel(SmStripPrivate *priv, snd_mixer_selem_channel_id_t ch)
+{
+    gint idx;
+
+    if (!priv->meter || !sm_channel_has_source(priv->channel, ch))
+    {
+        return -1;
+    }
+    idx = sm_channel_source_get_selected_item_index(priv->channel, ch);
+    return sm_meter_find_channel(priv->meter,
+            sm_enum_get_name(sm_channel_source_get_items(priv->channel, ch), idx));
+}
+
 static void
-sm_strip_channel_changed_cb(SmChannel *channel, gpointer user_data)
+sm_strip_update_meter_channels(SmStripPrivate *priv)
+{
+    sm_meter_bar_set_channel(priv->left_meterbar,
+            sm_strip_find_meter_channel(priv, SND_MIXER_SCHN_FRONT_LEFT));
+    sm_meter_bar_set_channel(priv->right_meterbar,
+            sm_strip_find_meter_channel(priv, SND_MIXER_SCHN_FRONT_RIGHT));
+}
+
+static gboolean
+sm_strip_tick_cb(GtkWidget *widget, GdkFrameClock *frame_clock, gpointer user_data);
+
+/*
+ * Update the dirty widgets in the update phase of the next frame, so that a
+ * burst of changes (e.g. loading a configuration) is laid out and painted
+ * once.
+ */
+static void
+sm_strip_queue_update(SmStrip *strip, guint dirty)
 {
     SmStripPrivate *priv;
-    gdouble vol_db;
-    int mute;
-    int idx;
 
-    priv = sm_strip_get_instance_private(user_data);
-    g_debug("sm_strip_channel_changed_cb: %s.", gtk_editable_get_chars(GTK_EDITABLE(priv->name_entry), 0, -1));
-    if (sm_channel_has_source(channel, SND_MIXER_SCHN_FRONT_LEFT)) {
-        idx = sm_channel_source_get_selected_item_index(channel, SND_MIXER_SCHN_FRONT_LEFT);
-        if (idx < 0) {
-            g_warning("Could not get selected item!");
-        }
-        else {
-            gtk_combo_box_set_active(GTK_COMBO_BOX(priv->left_scale_source_comboboxtext), idx);
-        }
+    priv = sm_strip_get_instance_private(strip);
+    priv->dirty |= dirty;
+    if (priv->dirty && !priv->tick_id && !priv->suspended)
+    {
+        priv->tick_id = gtk_widget_add_tick_callback(GTK_WIDGET(strip),
+                sm_strip_tick_cb, strip, NULL);
     }
-    if (sm_channel_has_source(channel, SND_MIXER_SCHN_FRONT_RIGHT)) {
-        idx = sm_channel_source_get_selected_item_index(channel, SND_MIXER_SCHN_FRONT_RIGHT);
+}
+
+static guint
+sm_strip_check_channel(SmStripPrivate *priv, snd_mixer_selem_channel_id_t ch,
+        SmSourceSelector *selector, GtkRange *scale, GtkToggleButton *mute_togglebutton)
+{
+    gdouble vol_db;
+    guint dirty;
+    int idx, mute;
+
+    dirty = 0;
+    if (sm_channel_has_source(priv->channel, ch)) {
+        idx = sm_channel_source_get_selected_item_index(priv->channel, ch);
         if (idx < 0) {
             g_warning("Could not get selected item!");
         }
-        else {
-            gtk_combo_box_set_active(GTK_COMBO_BOX(priv->right_scale_source_comboboxtext), idx);
+        else if (idx != sm_source_selector_get_active(selector)) {
+            dirty |= SM_STRIP_DIRTY_SOURCE;
         }
     }
-    if (sm_channel_has_volume(priv->channel, SND_MIXER_SCHN_FRONT_LEFT))
+    if (sm_channel_has_volume(priv->channel, ch))
     {
-        sm_channel_volume_get_db(priv->channel, SND_MIXER_SCHN_FRONT_LEFT, &vol_db);
-        gtk_range_set_value(GTK_RANGE(priv->left_scale), vol_to_value(vol_db));
-        if (sm_channel_has_volume_mute(priv->channel, SND_MIXER_SCHN_FRONT_LEFT))
+        sm_channel_volume_get_db(priv->channel, ch, &vol_db);
+        if (sm_taper_db_to_value(priv->taper, vol_db) != gtk_range_get_value(scale))
+        {
+            dirty |= SM_STRIP_DIRTY_VOLUME;
+        }
+        if (sm_channel_has_volume_mute(priv->channel, ch))
         {
             // Get mute state: 0 = Muted, 1 = Unmuted
-            sm_channel_volume_get_mute(priv->channel, SND_MIXER_SCHN_FRONT_LEFT, &mute);
-            gtk_toggle_button_set_active(priv->left_mute_togglebutton, mute == 0);
+            sm_channel_volume_get_mute(priv->channel, ch, &mute);
+            if ((mute == 0) != gtk_toggle_button_get_active(mute_togglebutton))
+            {
+                dirty |= SM_STRIP_DIRTY_MUTE;
+            }
         }
     }
+    return dirty;
+}
 
-    if (sm_channel_has_volume(priv->channel, SND_MIXER_SCHN_FRONT_RIGHT))
+static void
+sm_strip_commit_channel(SmStripPrivate *priv, snd_mixer_selem_channel_id_t ch, guint dirty,
+        SmSourceSelector *selector, GtkRange *scale, GtkToggleButton *mute_togglebutton)
+{
+    gdouble vol_db;
+    int idx, mute;
+
+    if (dirty & SM_STRIP_DIRTY_SOURCE)
     {
-        sm_channel_volume_get_db(priv->channel, SND_MIXER_SCHN_FRONT_RIGHT, &vol_db);
-        gtk_range_set_value(GTK_RANGE(priv->right_scale), vol_to_value(vol_db));
-        if (sm_channel_has_volume_mute(priv->channel, SND_MIXER_SCHN_FRONT_RIGHT))
+        idx = sm_channel_source_get_selected_item_index(priv->channel, ch);
+        if (idx >= 0)
         {
-            // Get mute state: 0 = Muted, 1 = Unmuted
-            sm_channel_volume_get_mute(priv->channel, SND_MIXER_SCHN_FRONT_RIGHT, &mute);
-            gtk_toggle_button_set_active(priv->right_mute_togglebutton, mute == 0);
+            sm_source_selector_set_active(selector, idx);
         }
     }
+    if (dirty & SM_STRIP_DIRTY_VOLUME)
+    {
+        sm_channel_volume_get_db(priv->channel, ch, &vol_db);
+        gtk_range_set_value(scale, sm_taper_db_to_value(priv->taper, vol_db));
+    }
+    if (dirty & SM_STRIP_DIRTY_MUTE)
+    {
+        sm_channel_volume_get_mute(priv->channel, ch, &mute);
+        gtk_toggle_button_set_active(mute_togglebutton, mute == 0);
+    }
+}
+
+static gboolean
+sm_strip_tick_cb(GtkWidget *widget, GdkFrameClock *frame_clock, gpointer user_data)
+{
+    SmStripPrivate *priv;
+    guint dirty;
+
+    priv = sm_strip_get_instance_private(SM_STRIP(user_data));
+    // Widget updates may change the channel again, which queues a new update.
+    dirty = priv->dirty;
+    priv->dirty = 0;
+    priv->tick_id = 0;
+    if (priv->channel)
+    {
+        sm_strip_commit_channel(priv, SND_MIXER_SCHN_FRONT_LEFT, dirty,
+                priv->left_scale_source_selector,
+                GTK_RANGE(priv->left_scale),
+                priv->left_mute_togglebutton);
+        sm_strip_commit_channel(priv, SND_MIXER_SCHN_FRONT_RIGHT, dirty >> SM_STRIP_DIRTY_RIGHT_SHIFT,
+                priv->right_scale_source_selector,
+                GTK_RANGE(priv->right_scale),
+                priv->right_mute_togglebutton);
+    }
+    if (dirty & SM_STRIP_DIRTY_METER)
+    {
+        sm_strip_update_meter_channels(priv);
+    }
+    return G_SOURCE_REMOVE;
+}
+
+static void
+sm_strip_meter_routing_changed_cb(SmMeter *meter, gpointer user_data)
+{
+    sm_strip_queue_update(SM_STRIP(user_data), SM_STRIP_DIRTY_METER);
+}
+
+static void
+sm_strip_channel_changed_cb(SmChannel *channel, gpointer user_data)
+{
+    SmStripPrivate *priv;
+    guint dirty;
+
+    priv = sm_strip_get_instance_private(user_data);
+    if (priv->suspended)
+    {
+        // Compare the widgets once when the updates are resumed.
+        priv->stale = TRUE;
+        return;
+    }
+    g_debug("sm_strip_channel_changed_cb: %s.", sm_channel_get_name(channel));
+    dirty = sm_strip_check_channel(priv, SND_MIXER_SCHN_FRONT_LEFT,
+            priv->left_scale_source_selector,
+            GTK_RANGE(priv->left_scale),
+            priv->left_mute_togglebutton);
+    dirty |= sm_strip_check_channel(priv, SND_MIXER_SCHN_FRONT_RIGHT,
+            priv->right_scale_source_selector,
+            GTK_RANGE(priv->right_scale),
+            priv->right_mute_togglebutton) << SM_STRIP_DIRTY_RIGHT_SHIFT;
+    if (dirty & (SM_STRIP_DIRTY_SOURCE | (SM_STRIP_DIRTY_SOURCE << SM_STRIP_DIRTY_RIGHT_SHIFT)))
+    {
+        dirty |= SM_STRIP_DIRTY_METER;
+    }
+    sm_strip_queue_update(SM_STRIP(user_data), dirty);
 }
 
 static void
@@ -238,16 +380,74 @@ sm_strip_dispose(GObject *object)
     SmStripPrivate *priv;
 
     priv = sm_strip_get_instance_private(SM_STRIP(object));
+    if (priv->tick_id)
+    {
+        gtk_widget_remove_tick_callback(GTK_WIDGET(object), priv->tick_id);
+        priv->tick_id = 0;
+    }
     if (priv->channel)
         g_debug("sm_strip_dispose: %s", sm_channel_get_name(priv->channel));
     if (priv->channel)
     {
         g_signal_handler_disconnect(priv->channel, priv->changed_handler_id);
+        g_object_unref(priv->channel);
         priv->channel = NULL;
     }
+    if (priv->meter)
+    {
+        g_signal_handler_disconnect(priv->meter, priv->meter_routing_handler_id);
+        g_clear_object(&priv->meter);
+    }
     G_OBJECT_CLASS(sm_strip_parent_class)->dispose(object);
 }
 
+static void
+control_popover_closed_cb(GtkPopover *popover, gpointer user_data)
+{
+    gtk_widget_destroy(GTK_WIDGET(popover));
+}
+
+/*
+ * Offer to bind a MIDI controller to the volume or mute control of the
+ * clicked widget.
+ */
+static gboolean
+control_button_press_cb(GtkWidget *widget, GdkEventButton *event, gpointer user_data)
+{
+    SmStripPrivate *priv;
+    snd_mixer_selem_channel_id_t ch;
+    const gchar *prop;
+    gchar *name;
+    GMenu *menu;
+    GMenuItem *item;
+    GtkWidget *popover;
+
+    if (!gdk_event_triggers_context_menu((GdkEvent*)event))
+    {
+        return FALSE;
+    }
+    priv = sm_strip_get_instance_private(user_data);
+    ch = (widget == GTK_WIDGET(priv->right_scale) || widget == GTK_WIDGET(priv->right_mute_togglebutton))
+        ? SND_MIXER_SCHN_FRONT_RIGHT : SND_MIXER_SCHN_FRONT_LEFT;
+    prop = GTK_IS_SCALE(widget) ? "volume" : "mute";
+    name = sm_controls_get_channel_control_name(priv->channel, ch, prop);
+    menu = g_menu_new();
+    item = g_menu_item_new("MIDI Learn", NULL);
+    g_menu_item_set_action_and_target_value(item, "app.midi-learn", g_variant_new_string(name));
+    g_menu_append_item(menu, item);
+    g_object_unref(item);
+    item = g_menu_item_new("Forget MIDI Controller", NULL);
+    g_menu_item_set_action_and_target_value(item, "app.midi-forget", g_variant_new_string(name));
+    g_menu_append_item(menu, item);
+    g_object_unref(item);
+    popover = gtk_popover_new_from_model(widget, G_MENU_MODEL(menu));
+    g_signal_connect(popover, "closed", G_CALLBACK(control_popover_closed_cb), NULL);
+    gtk_widget_show(popover);
+    g_object_unref(menu);
+    g_free(name);
+    return TRUE;
+}
+
 static void
 sm_strip_class_init(SmStripClass *class)
 {
@@ -266,35 +466,37 @@ sm_strip_class_init(SmStripClass *class)
     gtk_css_provider_load_from_resource(GTK_CSS_PROVIDER(provider),
             "/org/alsa/scarlettmixer/sm-strip.css");
     g_object_unref(provider);
+    g_type_ensure(SM_TYPE_METER_BAR);
+    g_type_ensure(SM_TYPE_SOURCE_SELECTOR);
     gtk_widget_class_set_template_from_resource(GTK_WIDGET_CLASS(class),
             "/org/alsa/scarlettmixer/sm-strip.ui");
     gtk_widget_class_bind_template_child_private(GTK_WIDGET_CLASS(class),
             SmStrip, name_entry);
     gtk_widget_class_bind_template_child_private(GTK_WIDGET_CLASS(class),
-            SmStrip, left_scale_source_comboboxtext);
+            SmStrip, left_scale_source_selector);
     gtk_widget_class_bind_template_child_private(GTK_WIDGET_CLASS(class),
             SmStrip, left_scale);
     gtk_widget_class_bind_template_child_private(GTK_WIDGET_CLASS(class),
             SmStrip, left_adjustment);
     gtk_widget_class_bind_template_child_private(GTK_WIDGET_CLASS(class),
-            SmStrip, left_levelbar);
+            SmStrip, left_meterbar);
     gtk_widget_class_bind_template_child_private(GTK_WIDGET_CLASS(class),
             SmStrip, left_mute_togglebutton);
     gtk_widget_class_bind_template_child_private(GTK_WIDGET_CLASS(class),
-            SmStrip, right_scale_source_comboboxtext);
+            SmStrip, right_scale_source_selector);
     gtk_widget_class_bind_template_child_private(GTK_WIDGET_CLASS(class),
             SmStrip, right_scale);
     gtk_widget_class_bind_template_child_private(GTK_WIDGET_CLASS(class),
             SmStrip, right_adjustment);
     gtk_widget_class_bind_template_child_private(GTK_WIDGET_CLASS(class),
-            SmStrip, right_levelbar);
+            SmStrip, right_meterbar);
     gtk_widget_class_bind_template_child_private(GTK_WIDGET_CLASS(class),
             SmStrip, right_mute_togglebutton);
     gtk_widget_class_bind_template_child_private(GTK_WIDGET_CLASS(class),
             SmStrip, join_togglebutton);
 
     gtk_widget_class_bind_template_callback(GTK_WIDGET_CLASS(class),
-            scale_source_comboboxtext_changed_cb);
+            scale_source_selector_changed_cb);
     gtk_widget_class_bind_template_callback(GTK_WIDGET_CLASS(class),
             scale_format_value_cb);
     gtk_widget_class_bind_template_callback(GTK_WIDGET_CLASS(class),
@@ -310,13 +512,12 @@ sm_strip_new(SmChannel *channel)
 {
     SmStrip *strip;
     SmStripPrivate *priv;
-    GList *list;
-    gdouble vol_db, min_db, max_db;
+    gdouble vol_db, min_db, max_db, step_db;
     int idx, mute;
 
     strip = g_object_new(SM_STRIP_TYPE, NULL);
     priv = sm_strip_get_instance_private(strip);
-    priv->channel = channel;
+    priv->channel = g_object_ref(channel);
 
     idx = 0;
     gtk_editable_delete_text(GTK_EDITABLE(priv->name_entry), 0, -1);
@@ -334,70 +535,53 @@ sm_strip_new(SmChannel *channel)
     }
     if (sm_channel_has_source(priv->channel, SND_MIXER_SCHN_FRONT_LEFT))
     {
-        list = sm_channel_source_get_item_names(priv->channel, SND_MIXER_SCHN_FRONT_LEFT);
-        for(list = g_list_first(list); list; list = g_list_next(list))
-        {
-            gtk_combo_box_text_append_text(priv->left_scale_source_comboboxtext, (gchar*)list->data);
-            g_free(list->data);
-        }
-        g_list_free(list);
         idx = sm_channel_source_get_selected_item_index(priv->channel, SND_MIXER_SCHN_FRONT_LEFT);
         if (idx < 0)
         {
             g_warning("Could not get selected item!");
         }
-        else
-        {
-            gtk_combo_box_set_active(GTK_COMBO_BOX(priv->left_scale_source_comboboxtext), idx);
-        }
+        sm_source_selector_set_items(priv->left_scale_source_selector,
+                sm_channel_source_get_items(priv->channel, SND_MIXER_SCHN_FRONT_LEFT), idx);
     }
     else
     {
-        gtk_widget_hide(GTK_WIDGET(priv->left_scale_source_comboboxtext));
+        gtk_widget_hide(GTK_WIDGET(priv->left_scale_source_selector));
     }
     if (sm_channel_has_source(priv->channel, SND_MIXER_SCHN_FRONT_RIGHT))
     {
-        list = sm_channel_source_get_item_names(priv->channel, SND_MIXER_SCHN_FRONT_RIGHT);
-        for(list = g_list_first(list); list; list = g_list_next(list))
-        {
-            gtk_combo_box_text_append_text(priv->right_scale_source_comboboxtext, (gchar*)list->data);
-            g_free(list->data);
-        }
-        g_list_free(list);
         idx = sm_channel_source_get_selected_item_index(priv->channel, SND_MIXER_SCHN_FRONT_RIGHT);
         if (idx < 0)
         {
             g_warning("Could not get selected item!");
         }
-        else
-        {
-            gtk_combo_box_set_active(GTK_COMBO_BOX(priv->right_scale_source_comboboxtext), idx);
-        }
+        sm_source_selector_set_items(priv->right_scale_source_selector,
+                sm_channel_source_get_items(priv->channel, SND_MIXER_SCHN_FRONT_RIGHT), idx);
     }
     else
     {
-        gtk_widget_hide(GTK_WIDGET(priv->right_scale_source_comboboxtext));
+        gtk_widget_hide(GTK_WIDGET(priv->right_scale_source_selector));
     }
 
+    min_db = max_db = step_db = 0.0;
     if (sm_channel_volume_get_range_db(priv->channel, &min_db, &max_db))
     {
-        gtk_adjustment_set_lower(priv->left_adjustment, vol_to_value(min_db));
-        gtk_adjustment_set_upper(priv->left_adjustment, vol_to_value(max_db));
-        gtk_level_bar_set_min_value(priv->left_levelbar, vol_to_value(min_db));
-        gtk_level_bar_set_max_value(priv->left_levelbar, vol_to_value(max_db));
-        gtk_level_bar_add_offset_value(priv->left_levelbar, GTK_LEVEL_BAR_OFFSET_HIGH, 1.01);
+        sm_channel_volume_get_step_db(priv->channel, &step_db);
     }
+    priv->taper = sm_taper_get_default(min_db, max_db, step_db);
+    gtk_adjustment_set_lower(priv->left_adjustment, sm_taper_get_lower(priv->taper));
+    gtk_adjustment_set_upper(priv->left_adjustment, sm_taper_get_upper(priv->taper));
+    sm_meter_bar_set_taper(priv->left_meterbar, priv->taper);
+    gtk_scale_add_mark(priv->left_scale, sm_taper_db_to_value(priv->taper, 0.0), GTK_POS_RIGHT, "0");
 
     if (sm_channel_has_volume(priv->channel, SND_MIXER_SCHN_FRONT_RIGHT))
     {
-        gtk_adjustment_set_lower(priv->right_adjustment, vol_to_value(min_db));
-        gtk_adjustment_set_upper(priv->right_adjustment, vol_to_value(max_db));
-        gtk_level_bar_set_min_value(priv->right_levelbar, vol_to_value(min_db));
-        gtk_level_bar_set_max_value(priv->right_levelbar, vol_to_value(max_db));
-        gtk_level_bar_add_offset_value(priv->right_levelbar, GTK_LEVEL_BAR_OFFSET_HIGH, 1.01);
+        gtk_adjustment_set_lower(priv->right_adjustment, sm_taper_get_lower(priv->taper));
+        gtk_adjustment_set_upper(priv->right_adjustment, sm_taper_get_upper(priv->taper));
+        sm_meter_bar_set_taper(priv->right_meterbar, priv->taper);
+        gtk_scale_add_mark(priv->right_scale, sm_taper_db_to_value(priv->taper, 0.0), GTK_POS_LEFT, "0");
 
         sm_channel_volume_get_db(priv->channel, SND_MIXER_SCHN_FRONT_RIGHT, &vol_db);
-        gtk_range_set_value(GTK_RANGE(priv->right_scale), vol_to_value(vol_db));
+        gtk_range_set_value(GTK_RANGE(priv->right_scale), sm_taper_db_to_value(priv->taper, vol_db));
         if (sm_channel_has_volume_mute(priv->channel, SND_MIXER_SCHN_FRONT_RIGHT))
         {
             // Get mute state: 0 = Muted, 1 = Unmuted
@@ -411,9 +595,9 @@ sm_strip_new(SmChannel *channel)
     }
     else
     {
-        gtk_widget_hide(GTK_WIDGET(priv->right_scale_source_comboboxtext));
+        gtk_widget_hide(GTK_WIDGET(priv->right_scale_source_selector));
         gtk_widget_hide(GTK_WIDGET(priv->right_scale));
-        gtk_widget_hide(GTK_WIDGET(priv->right_levelbar));
+        gtk_widget_hide(GTK_WIDGET(priv->right_meterbar));
         gtk_widget_hide(GTK_WIDGET(priv->right_mute_togglebutton));
         gtk_widget_hide(GTK_WIDGET(priv->join_togglebutton));
     }
@@ -421,7 +605,7 @@ sm_strip_new(SmChannel *channel)
     if (sm_channel_has_volume(priv->channel, SND_MIXER_SCHN_FRONT_LEFT))
     {
         sm_channel_volume_get_db(priv->channel, SND_MIXER_SCHN_FRONT_LEFT, &vol_db);
-        gtk_range_set_value(GTK_RANGE(priv->left_scale), vol_to_value(vol_db));
+        gtk_range_set_value(GTK_RANGE(priv->left_scale), sm_taper_db_to_value(priv->taper, vol_db));
         if (sm_channel_has_volume_mute(priv->channel, SND_MIXER_SCHN_FRONT_LEFT))
         {
             // Get mute state: 0 = Muted, 1 = Unmuted
@@ -448,6 +632,57 @@ sm_strip_init(SmStrip *strip)
 
     priv = sm_strip_get_instance_private(strip);
     gtk_widget_init_template(GTK_WIDGET(strip));
-    gtk_scale_add_mark(priv->left_scale, vol_to_value(0.0), GTK_POS_RIGHT, "0");
-    gtk_scale_add_mark(priv->right_scale, vol_to_value(0.0), GTK_POS_LEFT, "0");
+    g_signal_connect(priv->left_scale, "button-press-event", G_CALLBACK(control_button_press_cb), strip);
+    g_signal_connect(priv->right_scale, "button-press-event", G_CALLBACK(control_button_press_cb), strip);
+    g_signal_connect(priv->left_mute_togglebutton, "button-press-event", G_CALLBACK(control_button_press_cb), strip);
+    g_signal_connect(priv->right_mute_togglebutton, "button-press-event", G_CALLBACK(control_button_press_cb), strip);
+}
+
+void
+sm_strip_set_meter(SmStrip *strip, SmMeter *meter)
+{
+    SmStripPrivate *priv;
+
+    priv = sm_strip_get_instance_private(strip);
+    if (priv->meter)
+    {
+        return;
+    }
+    priv->meter = g_object_ref(meter);
+    sm_meter_bar_set_meter(priv->left_meterbar, meter);
+    sm_meter_bar_set_meter(priv->right_meterbar, meter);
+    priv->meter_routing_handler_id = g_signal_connect(meter,
+            "routing-changed",
+            G_CALLBACK(sm_strip_meter_routing_changed_cb),
+            strip);
+    sm_strip_update_meter_channels(priv);
+}
+
+void
+sm_strip_set_suspended(SmStrip *strip, gboolean suspended)
+{
+    SmStripPrivate *priv;
+
+    priv = sm_strip_get_instance_private(strip);
+    if (priv->suspended == suspended)
+    {
+        return;
+    }
+    priv->suspended = suspended;
+    if (suspended)
+    {
+        // Keep the dirty flags for the commit after resuming.
+        if (priv->tick_id)
+        {
+            gtk_widget_remove_tick_callback(GTK_WIDGET(strip), priv->tick_id);
+            priv->tick_id = 0;
+        }
+        return;
+    }
+    if (priv->stale && priv->channel)
+    {
+        sm_strip_channel_changed_cb(priv->channel, strip);
+    }
+    priv->stale = FALSE;
+    sm_strip_queue_update(strip, 0);
 }
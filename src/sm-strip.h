@@ -10,6 +10,7 @@
 #include <gtk/gtk.h>
 
 #include "sm-channel.h"
+#include "sm-meter.h"
 
 /**
  * @brief Macro to get the type information of the strip object.
@@ -41,4 +42,24 @@ GType    sm_strip_get_type(void);
  */
 SmStrip *sm_strip_new(SmChannel *channel);
 
+/**
+ * @brief Display the signal levels of a meter in the level bars of the strip.
+ * The level bars show the level of the capture channel which carries the
+ * selected source of the channel. They stay empty if no capture channel
+ * carries the source.
+ * @param strip The strip widget.
+ * @param meter The level meter.
+ */
+void     sm_strip_set_meter(SmStrip *strip, SmMeter *meter);
+
+/**
+ * @brief Suspend or resume the updates of the strip widgets.
+ * While suspended, changes of the channel are only recorded. Resuming
+ * compares the widgets with the channel once and updates the differing ones
+ * on the next frame.
+ * @param strip The strip widget.
+ * @param suspended TRUE to suspend the updates, FALSE to resume them.
+ */
+void     sm_strip_set_suspended(SmStrip *strip, gboolean suspended);
+
 #endif /* __SM_STRIP_H */
@@ -17,6 +17,9 @@
  */
 
 #include "sm-switch.h"
+#include "sm-enum.h"
+#include "sm-metrics.h"
+#include "sm-trace.h"
 
 /**
  * @brief Structure holding the ALSA mixer elements belonging to an switch.
@@ -31,6 +34,9 @@ struct _SmSwitch
     gchar *name; ///< Switch name
     unsigned int id; ///< Switch ID.
     gchar *type_name; ///< Switch type name.
+    const gchar * const *items; ///< Interned last-known item names, only set while no ALSA mixer element is attached.
+    const gchar * const *names; ///< Interned item names of the attached ALSA mixer element, read on first use.
+    int index; ///< Last-known index of the selected item.
 };
 
 G_DEFINE_TYPE(SmSwitch, sm_switch, G_TYPE_OBJECT);
@@ -71,6 +77,7 @@ sm_switch_finalize(GObject *gobject)
 
     g_debug("sm_switch_finalize: %s", self->name);
     g_free(self->name);
+    g_free(self->type_name);
     /* Always chain up to the parent class; as with dispose(), finalize()
      * is guaranteed to exist on the parent's class virtual function table
      */
@@ -218,25 +225,28 @@ sm_switch_mixer_elem_changed(SmSwitch *self, snd_mixer_elem_t *elem)
     }
 }
 
-GList*
-sm_switch_get_item_names(SmSwitch *self)
+const gchar * const *
+sm_switch_get_items(SmSwitch *self)
 {
-    int idx;
-    gchar buf[16];
-    GList *ret = NULL;
-
+    if (self->items)
+    {
+        return self->items;
+    }
     if (!self->elem)
     {
         return NULL;
     }
-    for(idx = 0; idx < snd_mixer_selem_get_enum_items(self->elem); idx++)
+    if (!self->names)
     {
-        if(snd_mixer_selem_get_enum_item_name(self->elem, idx, 16, buf) == 0)
-        {
-            ret = g_list_prepend(ret, g_strdup(buf));
-        }
+        self->names = sm_enum_intern_elem(self->elem);
     }
-    return g_list_reverse(ret);
+    return self->names;
+}
+
+GList*
+sm_switch_get_item_names(SmSwitch *self)
+{
+    return sm_enum_to_list(sm_switch_get_items(self));
 }
 
 int
@@ -245,6 +255,10 @@ sm_switch_get_selected_item_index(SmSwitch *self)
     int err;
     unsigned int idx;
 
+    if (self->items)
+    {
+        return self->index;
+    }
     if (!self->elem)
     {
         return -1;
@@ -261,43 +275,42 @@ sm_switch_get_selected_item_index(SmSwitch *self)
 gboolean
 sm_switch_set_selected_item_index(SmSwitch *self, unsigned int idx)
 {
+    unsigned int current;
     int err;
 
+    if (self->items)
+    {
+        self->index = idx;
+        return TRUE;
+    }
     if (!self->elem)
     {
         return FALSE;
     }
+    if (snd_mixer_selem_get_enum_item(self->elem, SND_MIXER_SCHN_FRONT_LEFT, &current) >= 0
+            && current == idx)
+    {
+        // Skip the write, the item is already selected.
+        sm_metrics_count_write(SM_METRICS_CONTROL_SWITCH, SM_METRICS_WRITE_SKIPPED);
+        return TRUE;
+    }
     err = snd_mixer_selem_set_enum_item(self->elem, SND_MIXER_SCHN_FRONT_LEFT, idx);
     if (err < 0)
     {
+        sm_metrics_count_write(SM_METRICS_CONTROL_SWITCH, SM_METRICS_WRITE_FAILED);
         g_warning("sm_switch_get_selected_item_index: Cannot set selected item to index %d!", idx);
         return FALSE;
     }
+    sm_metrics_count_write(SM_METRICS_CONTROL_SWITCH, SM_METRICS_WRITE_DONE);
+    sm_trace_record_write(SM_TRACE_WRITE_ENUM, self->elem, SND_MIXER_SCHN_FRONT_LEFT, idx);
     return TRUE;
 }
 
 gchar*
 sm_switch_get_selected_item_name(SmSwitch *self)
 {
-    int err;
-    unsigned int idx;
-    gchar buf[16];
-
-    if (!self->elem)
-    {
-        return NULL;
-    }
-    err = snd_mixer_selem_get_enum_item(self->elem, SND_MIXER_SCHN_FRONT_LEFT, &idx);
-    if (err < 0)
-    {
-        g_warning("sm_switch_get_selected_item_name: Cannot get selected item index!");
-        return NULL;
-    }
-    if(snd_mixer_selem_get_enum_item_name(self->elem, idx, 16, buf) == 0)
-    {
-        return  g_strdup(buf);
-    }
-    return NULL;
+    return g_strdup(sm_enum_get_name(sm_switch_get_items(self),
+                sm_switch_get_selected_item_index(self)));
 }
 
 
@@ -352,3 +365,152 @@ sm_switch_load_from_json_node(SmSwitch *self, JsonNode *node)
     sm_switch_set_selected_item_index(self, (unsigned int)switch_index);
     return TRUE;
 }
+
+JsonNode*
+sm_switch_to_snapshot_node(SmSwitch *self)
+{
+    JsonBuilder *jb;
+    JsonNode *jn;
+    GList *list, *item;
+
+    jb = json_builder_new();
+    jb = json_builder_begin_object(jb);
+
+    jb = json_builder_set_member_name(jb, "name");
+    jb = json_builder_add_string_value(jb, self->name);
+
+    jb = json_builder_set_member_name(jb, "type");
+    jb = json_builder_add_int_value(jb, self->type);
+
+    jb = json_builder_set_member_name(jb, "type_name");
+    jb = json_builder_add_string_value(jb, self->type_name);
+
+    jb = json_builder_set_member_name(jb, "id");
+    jb = json_builder_add_int_value(jb, self->id);
+
+    jb = json_builder_set_member_name(jb, "items");
+    jb = json_builder_begin_array(jb);
+    list = sm_switch_get_item_names(self);
+    for (item = g_list_first(list); item; item = g_list_next(item))
+    {
+        jb = json_builder_add_string_value(jb, item->data);
+    }
+    g_list_free_full(list, g_free);
+    jb = json_builder_end_array(jb);
+
+    jb = json_builder_set_member_name(jb, "switch_index");
+    jb = json_builder_add_int_value(jb, sm_switch_get_selected_item_index(self));
+
+    jb = json_builder_end_object(jb);
+    jn = json_builder_get_root(jb);
+    g_object_unref(jb);
+    return jn;
+}
+
+/*
+ * Check if a snapshot node is a value of the given type.
+ */
+static gboolean
+sm_switch_snapshot_holds(JsonNode *jn, GType type)
+{
+    return jn && JSON_NODE_HOLDS_VALUE(jn) && json_node_get_value_type(jn) == type;
+}
+
+/*
+ * Check the members of a snapshot switch before they are read.
+ */
+static gboolean
+sm_switch_snapshot_is_valid(JsonObject *jo)
+{
+    JsonNode *jn;
+    JsonArray *ja;
+    guint i;
+
+    if (!sm_switch_snapshot_holds(json_object_get_member(jo, "name"), G_TYPE_STRING)
+            || !sm_switch_snapshot_holds(json_object_get_member(jo, "type"), G_TYPE_INT64)
+            || !sm_switch_snapshot_holds(json_object_get_member(jo, "type_name"), G_TYPE_STRING)
+            || !sm_switch_snapshot_holds(json_object_get_member(jo, "id"), G_TYPE_INT64)
+            || !sm_switch_snapshot_holds(json_object_get_member(jo, "switch_index"), G_TYPE_INT64))
+    {
+        return FALSE;
+    }
+    jn = json_object_get_member(jo, "items");
+    if (!jn || !JSON_NODE_HOLDS_ARRAY(jn))
+    {
+        return FALSE;
+    }
+    ja = json_node_get_array(jn);
+    for (i = 0; i < json_array_get_length(ja); i++)
+    {
+        if (!sm_switch_snapshot_holds(json_array_get_element(ja, i), G_TYPE_STRING))
+        {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+SmSwitch*
+sm_switch_new_from_snapshot_node(JsonNode *node)
+{
+    SmSwitch *self;
+    JsonObject *jo;
+    JsonArray *ja;
+    const gchar **names;
+    guint i;
+
+    if (!JSON_NODE_HOLDS_OBJECT(node))
+    {
+        return NULL;
+    }
+    jo = json_node_get_object(node);
+    if (!sm_switch_snapshot_is_valid(jo))
+    {
+        g_warning("Invalid snapshot format: Incomplete switch!");
+        return NULL;
+    }
+    self = sm_switch_new();
+    self->name = g_strdup(json_object_get_string_member(jo, "name"));
+    self->type = json_object_get_int_member(jo, "type");
+    self->type_name = g_strdup(json_object_get_string_member(jo, "type_name"));
+    self->id = json_object_get_int_member(jo, "id");
+    ja = json_object_get_array_member(jo, "items");
+    names = g_new0(const gchar*, json_array_get_length(ja) + 1);
+    for (i = 0; i < json_array_get_length(ja); i++)
+    {
+        names[i] = json_array_get_string_element(ja, i);
+    }
+    self->items = sm_enum_intern(names);
+    g_free(names);
+    self->index = json_object_get_int_member(jo, "switch_index");
+    return self;
+}
+
+gboolean
+sm_switch_reconcile(SmSwitch *self, SmSwitch *live)
+{
+    int idx;
+
+    if (!self->items
+            || !live->elem
+            || self->type != live->type
+            || g_strcmp0(self->name, live->name) != 0)
+    {
+        return FALSE;
+    }
+    // Interned sets are equal if their addresses are equal.
+    if (sm_switch_get_items(live) != self->items)
+    {
+        return FALSE;
+    }
+    idx = sm_switch_get_selected_item_index(live);
+    self->elem = live->elem;
+    self->names = live->names;
+    self->items = NULL;
+    if (idx != self->index)
+    {
+        g_debug("sm_switch_reconcile: %s differs from snapshot.", self->name);
+        g_signal_emit(self, sm_switch_signals[SM_SWITCH_SIGNAL_CHANGED], 0);
+    }
+    return TRUE;
+}
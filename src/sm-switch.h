@@ -87,10 +87,18 @@ gboolean         sm_switch_has_mixer_elem(SmSwitch *self, snd_mixer_elem_t *elem
  */
 void             sm_switch_mixer_elem_changed(SmSwitch *self, snd_mixer_elem_t *elem);
 
+/**
+ * @brief Get the interned item names of the switch.
+ * The names are read from ALSA on first use, see @ref sm-enum.h.
+ * @param self The switch object.
+ * @return The interned set of item names or NULL.
+ */
+const gchar * const *sm_switch_get_items(SmSwitch *self);
+
 /**
  * @brief Get the list of item names of the switch..
  * @param self The switch object.
- * @return The list of item names or NULL.
+ * @return The list of newly allocated item names or NULL.
  */
 GList*           sm_switch_get_item_names(SmSwitch *self);
 
@@ -130,6 +138,33 @@ JsonNode*        sm_switch_to_json_node(SmSwitch *self);
  * @return TRUE on success, FALSE otherwise.
  */
 gboolean         sm_switch_load_from_json_node(SmSwitch *self, JsonNode *node);
+
+/**
+ * @brief Get a JSON object representation of the switch including its item names.
+ * @param self The switch object.
+ * @return The JSON object.
+ */
+JsonNode*        sm_switch_to_snapshot_node(SmSwitch *self);
+
+/**
+ * @brief Create a switch from a snapshot JSON object.
+ * The switch has no ALSA mixer element attached until
+ * @ref sm_switch_reconcile is called.
+ * @param node The JSON object created by @ref sm_switch_to_snapshot_node.
+ * @return Pointer to new switch instance or NULL in case of an error.
+ */
+SmSwitch*        sm_switch_new_from_snapshot_node(JsonNode *node);
+
+/**
+ * @brief Reconcile a switch created from a snapshot with a live switch.
+ * If the item names match, the ALSA mixer element of the live switch
+ * is attached. The SM_SWITCH_SIGNAL_CHANGED signal is only emitted if the
+ * selected item differs from the last-known state.
+ * @param self The switch created by @ref sm_switch_new_from_snapshot_node.
+ * @param live The switch created from the ALSA mixer element.
+ * @return TRUE if the switch was reconciled, FALSE otherwise.
+ */
+gboolean         sm_switch_reconcile(SmSwitch *self, SmSwitch *live);
 G_END_DECLS
 
 #endif /* __SM_SWITCH_H__ */
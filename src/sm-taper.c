@@ -0,0 +1,197 @@
+/*
+ * sm-taper.c - Precomputed fader tapers.
+ * Copyright (c) 2016 Martin Roesch <martin.roesch79@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+
+#include "sm-taper.h"
+
+#define SM_TAPER_MAX_STEPS (4096) ///< Maximal number of table entries.
+#define SM_TAPER_DEFAULT_STEP_DB (0.5) ///< Step in dB if the hardware step is unknown.
+
+/**
+ * @brief Structure holding the precomputed tables of a taper.
+ */
+struct _SmTaper
+{
+    SmTaperLaw law; ///< Fader law.
+    gdouble min_db; ///< Minimal volume in dB.
+    gdouble max_db; ///< Maximal volume in dB.
+    gdouble step_db; ///< Volume step in dB.
+    guint n_steps; ///< Number of table entries.
+    gdouble *values; ///< Fader value of each step, ascending.
+    gchar **labels; ///< Label of each step.
+};
+
+G_LOCK_DEFINE_STATIC(sm_tapers);
+static GPtrArray *sm_tapers = NULL; ///< Shared tapers.
+static SmTaperLaw sm_taper_default_law = SM_TAPER_LAW_CUBIC; ///< Fader law of @ref sm_taper_get_default.
+
+static gdouble
+sm_taper_compute_value(SmTaperLaw law, gdouble min_db, gdouble max_db, gdouble vol_db)
+{
+    switch (law)
+    {
+        case SM_TAPER_LAW_LINEAR_DB:
+            return max_db > min_db ? (vol_db - min_db) / (max_db - min_db) : 0.0;
+        case SM_TAPER_LAW_CUBIC:
+        default:
+            return pow(10, vol_db / 60.0);
+    }
+}
+
+static SmTaper*
+sm_taper_new(SmTaperLaw law, gdouble min_db, gdouble max_db, gdouble step_db)
+{
+    SmTaper *taper;
+    gdouble vol_db;
+    guint idx;
+
+    taper = g_new0(SmTaper, 1);
+    taper->law = law;
+    taper->min_db = min_db;
+    taper->max_db = max_db;
+    if (step_db <= 0.0)
+    {
+        step_db = SM_TAPER_DEFAULT_STEP_DB;
+    }
+    if ((max_db - min_db) / step_db >= SM_TAPER_MAX_STEPS)
+    {
+        step_db = (max_db - min_db) / (SM_TAPER_MAX_STEPS - 1);
+    }
+    taper->step_db = step_db;
+    taper->n_steps = (guint)round((max_db - min_db) / step_db) + 1;
+    taper->values = g_new(gdouble, taper->n_steps);
+    taper->labels = g_new0(gchar*, taper->n_steps + 1);
+    for (idx = 0; idx < taper->n_steps; idx++)
+    {
+        vol_db = MIN(min_db + idx * step_db, max_db);
+        taper->values[idx] = sm_taper_compute_value(law, min_db, max_db, vol_db);
+        taper->labels[idx] = g_strdup_printf("%0.1f", vol_db);
+    }
+    return taper;
+}
+
+static guint
+sm_taper_find_step(const SmTaper *taper, gdouble value)
+{
+    guint low, high, mid;
+
+    // Binary search for the first step not below the value.
+    low = 0;
+    high = taper->n_steps - 1;
+    while (low < high)
+    {
+        mid = (low + high) / 2;
+        if (taper->values[mid] < value)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+    if (low > 0 && value - taper->values[low - 1] < taper->values[low] - value)
+    {
+        low--;
+    }
+    return low;
+}
+
+void
+sm_taper_set_default_law(SmTaperLaw law)
+{
+    if (law >= SM_TAPER_N_LAWS)
+    {
+        g_warning("Unknown fader law %d!", law);
+        return;
+    }
+    sm_taper_default_law = law;
+}
+
+const SmTaper*
+sm_taper_get(SmTaperLaw law, gdouble min_db, gdouble max_db, gdouble step_db)
+{
+    SmTaper *taper;
+    guint idx;
+
+    if (max_db < min_db)
+    {
+        g_warning("Invalid volume range %.2f dB .. %.2f dB!", min_db, max_db);
+        max_db = min_db;
+    }
+    G_LOCK(sm_tapers);
+    if (!sm_tapers)
+    {
+        sm_tapers = g_ptr_array_new();
+    }
+    // Cards have a handful of distinct volume ranges, a linear search is enough.
+    for (idx = 0; idx < sm_tapers->len; idx++)
+    {
+        taper = g_ptr_array_index(sm_tapers, idx);
+        if (taper->law == law && taper->min_db == min_db && taper->max_db == max_db
+                && (step_db <= 0.0 || taper->step_db == step_db))
+        {
+            G_UNLOCK(sm_tapers);
+            return taper;
+        }
+    }
+    taper = sm_taper_new(law, min_db, max_db, step_db);
+    g_ptr_array_add(sm_tapers, taper);
+    G_UNLOCK(sm_tapers);
+    return taper;
+}
+
+const SmTaper*
+sm_taper_get_default(gdouble min_db, gdouble max_db, gdouble step_db)
+{
+    return sm_taper_get(sm_taper_default_law, min_db, max_db, step_db);
+}
+
+gdouble
+sm_taper_get_lower(const SmTaper *taper)
+{
+    return taper->values[0];
+}
+
+gdouble
+sm_taper_get_upper(const SmTaper *taper)
+{
+    return taper->values[taper->n_steps - 1];
+}
+
+gdouble
+sm_taper_db_to_value(const SmTaper *taper, gdouble vol_db)
+{
+    gdouble step;
+
+    step = round((vol_db - taper->min_db) / taper->step_db);
+    return taper->values[(guint)CLAMP(step, 0, taper->n_steps - 1)];
+}
+
+gdouble
+sm_taper_value_to_db(const SmTaper *taper, gdouble value)
+{
+    return MIN(taper->min_db + sm_taper_find_step(taper, value) * taper->step_db, taper->max_db);
+}
+
+const gchar*
+sm_taper_get_label(const SmTaper *taper, gdouble value)
+{
+    return taper->labels[sm_taper_find_step(taper, value)];
+}
@@ -0,0 +1,98 @@
+#ifndef __SM_TAPER_H__
+#define __SM_TAPER_H__
+/**
+ * @file
+ * @brief Header file for the fader tapers.
+ *
+ * A taper maps the volume range of a channel in dB to the value range of a
+ * fader. The mapping is precomputed once per fader law and hardware range:
+ * one fader value and one label per hardware volume step. Conversions are
+ * table lookups and snap to the dB steps of the hardware. Tapers are shared
+ * and stay valid for the lifetime of the process.
+ */
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/**
+ * @brief Fader laws.
+ * The values match the "fader-law" GSettings key.
+ */
+typedef enum
+{
+    SM_TAPER_LAW_CUBIC, ///< The fader value is the cube root of the gain (60 dB per decade).
+    SM_TAPER_LAW_LINEAR_DB, ///< The fader value is linear in dB.
+    SM_TAPER_N_LAWS ///< Number of fader laws.
+} SmTaperLaw;
+
+/**
+ * @brief Type definition for a fader taper.
+ */
+typedef struct _SmTaper SmTaper;
+
+/**
+ * @brief Set the fader law used by @ref sm_taper_get_default.
+ * @param law The fader law.
+ */
+void           sm_taper_set_default_law(SmTaperLaw law);
+
+/**
+ * @brief Get the shared taper of a volume range.
+ * @param law The fader law.
+ * @param min_db The minimal volume in dB.
+ * @param max_db The maximal volume in dB.
+ * @param step_db The volume step of the hardware in dB, or 0 if unknown.
+ * @return The shared taper.
+ */
+const SmTaper *sm_taper_get(SmTaperLaw law, gdouble min_db, gdouble max_db, gdouble step_db);
+
+/**
+ * @brief Get the shared taper of a volume range with the default fader law.
+ * @param min_db The minimal volume in dB.
+ * @param max_db The maximal volume in dB.
+ * @param step_db The volume step of the hardware in dB, or 0 if unknown.
+ * @return The shared taper.
+ */
+const SmTaper *sm_taper_get_default(gdouble min_db, gdouble max_db, gdouble step_db);
+
+/**
+ * @brief Get the fader value of the minimal volume.
+ * @param taper The taper.
+ * @return The lower bound of the fader.
+ */
+gdouble        sm_taper_get_lower(const SmTaper *taper);
+
+/**
+ * @brief Get the fader value of the maximal volume.
+ * @param taper The taper.
+ * @return The upper bound of the fader.
+ */
+gdouble        sm_taper_get_upper(const SmTaper *taper);
+
+/**
+ * @brief Convert a volume to a fader value.
+ * @param taper The taper.
+ * @param vol_db The volume in dB, snapped to the nearest step within the range.
+ * @return The fader value.
+ */
+gdouble        sm_taper_db_to_value(const SmTaper *taper, gdouble vol_db);
+
+/**
+ * @brief Convert a fader value to a volume.
+ * @param taper The taper.
+ * @param value The fader value.
+ * @return The volume in dB of the nearest step.
+ */
+gdouble        sm_taper_value_to_db(const SmTaper *taper, gdouble value);
+
+/**
+ * @brief Get the label of a fader value.
+ * @param taper The taper.
+ * @param value The fader value.
+ * @return The volume in dB of the nearest step with one decimal, owned by the taper.
+ */
+const gchar   *sm_taper_get_label(const SmTaper *taper, gdouble value);
+
+G_END_DECLS
+
+#endif /* __SM_TAPER_H__ */
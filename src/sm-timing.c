@@ -0,0 +1,116 @@
+/*
+ * sm-timing.c - Startup timing instrumentation.
+ * Copyright (c) 2016 Martin Roesch <martin.roesch79@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdarg.h>
+
+#include "sm-timing.h"
+
+/**
+ * @brief Type definition for a recorded timing mark.
+ */
+typedef struct _SmTimingMark SmTimingMark;
+
+/**
+ * @brief Structure holding a recorded timing mark.
+ */
+struct _SmTimingMark
+{
+    gint64 time; ///< Monotonic time of the mark in microseconds.
+    gchar *phase; ///< Name of the phase that ended at this mark.
+};
+
+static gint64 sm_timing_start = 0;
+static GArray *sm_timing_marks = NULL;
+static gboolean sm_timing_report_enabled = FALSE;
+
+void
+sm_timing_init(void)
+{
+    const gchar *env;
+
+    sm_timing_start = g_get_monotonic_time();
+    if (!sm_timing_marks)
+    {
+        sm_timing_marks = g_array_sized_new(FALSE, FALSE, sizeof(SmTimingMark), 64);
+    }
+    env = g_getenv("SCARLETTMIXER_TIMING");
+    if (env && g_strcmp0(env, "0") != 0)
+    {
+        sm_timing_report_enabled = TRUE;
+    }
+}
+
+void
+sm_timing_mark(const gchar *format, ...)
+{
+    SmTimingMark mark;
+    va_list args;
+
+    if (!sm_timing_marks)
+    {
+        sm_timing_init();
+    }
+    mark.time = g_get_monotonic_time();
+    va_start(args, format);
+    mark.phase = g_strdup_vprintf(format, args);
+    va_end(args);
+    g_array_append_val(sm_timing_marks, mark);
+}
+
+gint64
+sm_timing_get_elapsed(void)
+{
+    return g_get_monotonic_time() - sm_timing_start;
+}
+
+void
+sm_timing_set_report_enabled(gboolean enabled)
+{
+    sm_timing_report_enabled = enabled;
+}
+
+gboolean
+sm_timing_get_report_enabled(void)
+{
+    return sm_timing_report_enabled;
+}
+
+void
+sm_timing_report(const gchar *title)
+{
+    SmTimingMark *mark;
+    gint64 last;
+    guint idx;
+
+    if (!sm_timing_report_enabled || !sm_timing_marks)
+    {
+        return;
+    }
+    g_printerr("%s timing (%u phases):\n", title, sm_timing_marks->len);
+    g_printerr("%10s %10s  %s\n", "t [ms]", "dt [ms]", "phase");
+    last = sm_timing_start;
+    for (idx = 0; idx < sm_timing_marks->len; idx++)
+    {
+        mark = &g_array_index(sm_timing_marks, SmTimingMark, idx);
+        g_printerr("%10.3f %10.3f  %s\n",
+                (mark->time - sm_timing_start) / 1000.0,
+                (mark->time - last) / 1000.0,
+                mark->phase);
+        last = mark->time;
+    }
+}
@@ -0,0 +1,56 @@
+#ifndef __SM_TIMING_H__
+#define __SM_TIMING_H__
+/**
+ * @file
+ * @brief Header file for the startup timing instrumentation.
+ *
+ * The timing module records a monotonic timestamp for every startup phase.
+ * Recording is always active, the report is only printed if it is requested
+ * with the `--timing` command line option or the `SCARLETTMIXER_TIMING`
+ * environment variable.
+ */
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/**
+ * @brief Initialize the timing module.
+ * The time of this call is the reference for all recorded phases.
+ * Reads the `SCARLETTMIXER_TIMING` environment variable.
+ */
+void     sm_timing_init(void);
+
+/**
+ * @brief Record the end of a startup phase.
+ * @param format printf-style format of the phase name.
+ * @param ... Arguments for the format string.
+ */
+void     sm_timing_mark(const gchar *format, ...) G_GNUC_PRINTF(1, 2);
+
+/**
+ * @brief Get the time elapsed since @ref sm_timing_init.
+ * @return The elapsed time in microseconds.
+ */
+gint64   sm_timing_get_elapsed(void);
+
+/**
+ * @brief Enable or disable printing of the timing report.
+ * @param enabled TRUE to print the report, FALSE otherwise.
+ */
+void     sm_timing_set_report_enabled(gboolean enabled);
+
+/**
+ * @brief Check whether the timing report is printed.
+ * @return TRUE if the report is printed, FALSE otherwise.
+ */
+gboolean sm_timing_get_report_enabled(void);
+
+/**
+ * @brief Print the recorded phases to stderr, if the report is enabled.
+ * @param title Title of the report (e.g. "Startup").
+ */
+void     sm_timing_report(const gchar *title);
+
+G_END_DECLS
+
+#endif /* __SM_TIMING_H__ */
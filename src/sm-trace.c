@@ -0,0 +1,558 @@
+/*
+ * sm-trace.c - Control event trace recorder and replayer.
+ * Copyright (c) 2016 Martin Roesch <martin.roesch79@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <glib/gstdio.h>
+#include <gio/gio.h>
+
+#include "sm-trace.h"
+
+#define SM_TRACE_MAGIC "SMTRACE" ///< Magic of the trace files, including the NUL byte.
+#define SM_TRACE_VERSION (1) ///< Version of the trace file format.
+#define SM_TRACE_HEADER_SIZE (16) ///< Size of the file header in bytes.
+#define SM_TRACE_RECORD_SIZE (16) ///< Size of a record in bytes.
+#define SM_TRACE_MAX_ELEMS (G_MAXUINT16 + 1) ///< Maximum number of element ids.
+
+/**
+ * @brief Type definition for a trace record.
+ */
+typedef struct _SmTraceRecord SmTraceRecord;
+
+/**
+ * @brief Structure holding a decoded trace record.
+ */
+struct _SmTraceRecord
+{
+    gint64 time; ///< Time in microseconds since the start of the recording.
+    guint16 elem; ///< Element id.
+    guint8 type; ///< Record type, see @ref SmTraceType.
+    guint8 channel; ///< Channel, or the element index for @ref SM_TRACE_ELEM.
+    gint32 value; ///< Value, or the name length for @ref SM_TRACE_ELEM.
+};
+
+/**
+ * @brief Type definition for an element of a loaded trace.
+ */
+typedef struct _SmTraceElem SmTraceElem;
+
+/**
+ * @brief Structure holding an element of a loaded trace.
+ */
+struct _SmTraceElem
+{
+    gchar *name; ///< Element name.
+    guint index; ///< Element index.
+};
+
+/**
+ * @brief Structure holding the state of the trace replayer.
+ */
+struct _SmTraceReplay
+{
+    GObject parent_instance; ///< Parent object.
+
+    /* Other members, including private data. */
+    GArray *records; ///< The @ref _SmTraceRecord event and write records.
+    GPtrArray *elems; ///< The @ref _SmTraceElem elements by id.
+    snd_mixer_t *mixer; ///< The mixer (not referenced).
+    SmFakeCard *fake; ///< The fake card.
+    gboolean fast; ///< TRUE if replaying as fast as possible.
+    guint position; ///< Index of the next record.
+    guint source; ///< Main loop source of the next step, or 0.
+    gint64 start; ///< Monotonic time of the start of the replay.
+    gint64 end; ///< Monotonic time of the end of the replay.
+    gint64 lag_sum; ///< Sum of the delays of the records behind their recorded time.
+    gint64 lag_max; ///< Maximum delay of a record behind its recorded time.
+    guint n_events; ///< Number of replayed event records.
+    guint n_writes; ///< Number of replayed write records.
+    guint n_failed; ///< Number of records which could not be replayed.
+};
+
+/**
+ * @brief Enumeration of the trace replayer signals.
+ */
+enum
+{
+    SM_TRACE_REPLAY_SIGNAL_FINISHED, ///< Replay finished signal.
+    N_SIGNALS ///< Number of signals.
+};
+
+static int sm_trace_replay_signals[N_SIGNALS] = {0};
+
+G_DEFINE_TYPE(SmTraceReplay, sm_trace_replay, G_TYPE_OBJECT);
+
+static FILE *sm_trace_file = NULL;
+static gint64 sm_trace_start_time = 0;
+static GHashTable *sm_trace_ids = NULL;
+
+static void
+sm_trace_encode(guint8 *buf, const SmTraceRecord *record)
+{
+    guint64 time;
+    guint16 elem;
+    guint32 value;
+
+    time = GUINT64_TO_LE((guint64)record->time);
+    elem = GUINT16_TO_LE(record->elem);
+    value = GUINT32_TO_LE((guint32)record->value);
+    memcpy(buf, &time, 8);
+    memcpy(buf + 8, &elem, 2);
+    buf[10] = record->type;
+    buf[11] = record->channel;
+    memcpy(buf + 12, &value, 4);
+}
+
+static void
+sm_trace_decode(const guint8 *buf, SmTraceRecord *record)
+{
+    guint64 time;
+    guint16 elem;
+    guint32 value;
+
+    memcpy(&time, buf, 8);
+    memcpy(&elem, buf + 8, 2);
+    memcpy(&value, buf + 12, 4);
+    record->time = (gint64)GUINT64_FROM_LE(time);
+    record->elem = GUINT16_FROM_LE(elem);
+    record->type = buf[10];
+    record->channel = buf[11];
+    record->value = (gint32)GUINT32_FROM_LE(value);
+}
+
+static void
+sm_trace_write_record(gint64 time, guint16 elem, SmTraceType type, guint channel, long value)
+{
+    SmTraceRecord record;
+    guint8 buf[SM_TRACE_RECORD_SIZE];
+
+    record.time = time - sm_trace_start_time;
+    record.elem = elem;
+    record.type = type;
+    record.channel = channel;
+    record.value = value;
+    sm_trace_encode(buf, &record);
+    fwrite(buf, sizeof(buf), 1, sm_trace_file);
+}
+
+/*
+ * Get the id of an element, defining it on first use. Returns FALSE if all
+ * ids are used.
+ */
+static gboolean
+sm_trace_get_elem_id(snd_mixer_elem_t *elem, gint64 time, guint16 *id)
+{
+    const gchar *name;
+    gchar *key;
+    gpointer value;
+    guint index, size;
+
+    name = snd_mixer_selem_get_name(elem);
+    index = snd_mixer_selem_get_index(elem);
+    // Keyed by name and index, the element pointers change when the mixer is reopened.
+    key = g_strdup_printf("%u:%s", index, name);
+    if (g_hash_table_lookup_extended(sm_trace_ids, key, NULL, &value))
+    {
+        g_free(key);
+        *id = GPOINTER_TO_UINT(value);
+        return TRUE;
+    }
+    size = g_hash_table_size(sm_trace_ids);
+    if (size >= SM_TRACE_MAX_ELEMS)
+    {
+        g_free(key);
+        return FALSE;
+    }
+    *id = size;
+    g_hash_table_insert(sm_trace_ids, key, GUINT_TO_POINTER(size));
+    sm_trace_write_record(time, *id, SM_TRACE_ELEM, MIN(index, G_MAXUINT8), strlen(name));
+    fwrite(name, strlen(name), 1, sm_trace_file);
+    return TRUE;
+}
+
+gboolean
+sm_trace_start(const gchar *filename, GError **err)
+{
+    guint8 header[SM_TRACE_HEADER_SIZE] = { 0 };
+    guint32 version;
+    int saved_errno;
+
+    sm_trace_stop();
+    sm_trace_file = g_fopen(filename, "wb");
+    if (!sm_trace_file)
+    {
+        saved_errno = errno;
+        g_set_error(err, G_IO_ERROR, g_io_error_from_errno(saved_errno),
+                "Cannot create trace file %s: %s", filename, g_strerror(saved_errno));
+        return FALSE;
+    }
+    memcpy(header, SM_TRACE_MAGIC, sizeof(SM_TRACE_MAGIC));
+    version = GUINT32_TO_LE(SM_TRACE_VERSION);
+    memcpy(header + 8, &version, 4);
+    fwrite(header, sizeof(header), 1, sm_trace_file);
+    sm_trace_ids = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    sm_trace_start_time = g_get_monotonic_time();
+    return TRUE;
+}
+
+void
+sm_trace_stop(void)
+{
+    if (!sm_trace_file)
+    {
+        return;
+    }
+    if (fclose(sm_trace_file) != 0)
+    {
+        g_warning("Could not write trace file: %s", g_strerror(errno));
+    }
+    sm_trace_file = NULL;
+    g_clear_pointer(&sm_trace_ids, g_hash_table_unref);
+}
+
+void
+sm_trace_record_event(snd_mixer_elem_t *elem)
+{
+    gint64 time;
+    guint16 id;
+    long volume;
+    int sw;
+    unsigned int item;
+    guint ch;
+
+    if (!sm_trace_file)
+    {
+        return;
+    }
+    time = g_get_monotonic_time();
+    if (!sm_trace_get_elem_id(elem, time, &id))
+    {
+        return;
+    }
+    for (ch = 0; ch <= SND_MIXER_SCHN_LAST; ch++)
+    {
+        if (!snd_mixer_selem_has_playback_channel(elem, ch)
+                && !snd_mixer_selem_has_capture_channel(elem, ch))
+        {
+            break;
+        }
+        if (snd_mixer_selem_has_playback_volume(elem)
+                && snd_mixer_selem_get_playback_volume(elem, ch, &volume) >= 0)
+        {
+            sm_trace_write_record(time, id, SM_TRACE_EVENT_VOLUME, ch, volume);
+        }
+        if (snd_mixer_selem_has_playback_switch(elem)
+                && snd_mixer_selem_get_playback_switch(elem, ch, &sw) >= 0)
+        {
+            sm_trace_write_record(time, id, SM_TRACE_EVENT_SWITCH, ch, sw);
+        }
+        if (snd_mixer_selem_is_enumerated(elem)
+                && snd_mixer_selem_get_enum_item(elem, ch, &item) >= 0)
+        {
+            sm_trace_write_record(time, id, SM_TRACE_EVENT_ENUM, ch, item);
+        }
+    }
+}
+
+void
+sm_trace_record_write(SmTraceType type, snd_mixer_elem_t *elem,
+        snd_mixer_selem_channel_id_t ch, long value)
+{
+    gint64 time;
+    guint16 id;
+
+    if (!sm_trace_file)
+    {
+        return;
+    }
+    time = g_get_monotonic_time();
+    if (sm_trace_get_elem_id(elem, time, &id))
+    {
+        sm_trace_write_record(time, id, type, ch, value);
+    }
+}
+
+static void
+sm_trace_elem_free(gpointer data)
+{
+    SmTraceElem *te = data;
+
+    g_free(te->name);
+    g_free(te);
+}
+
+static snd_mixer_elem_t*
+sm_trace_replay_find_elem(SmTraceReplay *self, const SmTraceElem *te)
+{
+    snd_mixer_selem_id_t *sid;
+
+    snd_mixer_selem_id_alloca(&sid);
+    snd_mixer_selem_id_set_name(sid, te->name);
+    snd_mixer_selem_id_set_index(sid, te->index);
+    return snd_mixer_find_selem(self->mixer, sid);
+}
+
+static gboolean
+sm_trace_replay_apply(SmTraceReplay *self, const SmTraceRecord *record)
+{
+    const SmTraceElem *te;
+    snd_mixer_elem_t *elem;
+
+    te = g_ptr_array_index(self->elems, record->elem);
+    switch (record->type)
+    {
+    case SM_TRACE_EVENT_VOLUME:
+        self->n_events++;
+        return sm_fake_card_set_volume(self->fake, te->name, te->index, record->channel, record->value);
+    case SM_TRACE_EVENT_SWITCH:
+        self->n_events++;
+        return sm_fake_card_set_switch(self->fake, te->name, te->index, record->channel, record->value);
+    case SM_TRACE_EVENT_ENUM:
+        self->n_events++;
+        return sm_fake_card_set_enum_item(self->fake, te->name, te->index, record->channel, record->value);
+    default:
+        break;
+    }
+    self->n_writes++;
+    elem = sm_trace_replay_find_elem(self, te);
+    if (!elem)
+    {
+        return FALSE;
+    }
+    switch (record->type)
+    {
+    case SM_TRACE_WRITE_DB:
+        return snd_mixer_selem_set_playback_dB(elem, record->channel, record->value, -1) >= 0;
+    case SM_TRACE_WRITE_SWITCH:
+        return snd_mixer_selem_set_playback_switch(elem, record->channel, record->value) >= 0;
+    case SM_TRACE_WRITE_ENUM:
+        return snd_mixer_selem_set_enum_item(elem, record->channel, record->value) >= 0;
+    default:
+        return FALSE;
+    }
+}
+
+static gboolean
+sm_trace_replay_step_cb(gpointer user_data)
+{
+    SmTraceReplay *self = SM_TRACE_REPLAY(user_data);
+    SmTraceRecord *record;
+    gint64 now, time, lag;
+
+    now = g_get_monotonic_time() - self->start;
+    time = g_array_index(self->records, SmTraceRecord, self->position).time;
+    while (self->position < self->records->len)
+    {
+        record = &g_array_index(self->records, SmTraceRecord, self->position);
+        if (self->fast ? record->time != time : record->time > now)
+        {
+            break;
+        }
+        if (!self->fast)
+        {
+            lag = now - record->time;
+            self->lag_sum += lag;
+            self->lag_max = MAX(self->lag_max, lag);
+        }
+        if (!sm_trace_replay_apply(self, record))
+        {
+            self->n_failed++;
+        }
+        self->position++;
+    }
+    if (self->position >= self->records->len)
+    {
+        self->source = 0;
+        self->end = g_get_monotonic_time();
+        g_signal_emit(self, sm_trace_replay_signals[SM_TRACE_REPLAY_SIGNAL_FINISHED], 0);
+        return G_SOURCE_REMOVE;
+    }
+    if (self->fast)
+    {
+        return G_SOURCE_CONTINUE;
+    }
+    record = &g_array_index(self->records, SmTraceRecord, self->position);
+    now = g_get_monotonic_time() - self->start;
+    self->source = g_timeout_add(MAX(record->time - now, 0) / 1000, sm_trace_replay_step_cb, self);
+    return G_SOURCE_REMOVE;
+}
+
+static void
+sm_trace_replay_dispose(GObject *object)
+{
+    SmTraceReplay *self = SM_TRACE_REPLAY(object);
+
+    if (self->source)
+    {
+        g_source_remove(self->source);
+        self->source = 0;
+    }
+    g_clear_object(&self->fake);
+    G_OBJECT_CLASS(sm_trace_replay_parent_class)->dispose(object);
+}
+
+static void
+sm_trace_replay_finalize(GObject *object)
+{
+    SmTraceReplay *self = SM_TRACE_REPLAY(object);
+
+    g_array_unref(self->records);
+    g_ptr_array_unref(self->elems);
+    G_OBJECT_CLASS(sm_trace_replay_parent_class)->finalize(object);
+}
+
+static void
+sm_trace_replay_class_init(SmTraceReplayClass *klass)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS(klass);
+
+    object_class->dispose = sm_trace_replay_dispose;
+    object_class->finalize = sm_trace_replay_finalize;
+
+    /* init signals */
+    sm_trace_replay_signals[SM_TRACE_REPLAY_SIGNAL_FINISHED] =
+        g_signal_newv("finished",
+                      G_TYPE_FROM_CLASS(object_class),
+                      G_SIGNAL_RUN_LAST | G_SIGNAL_NO_RECURSE | G_SIGNAL_NO_HOOKS,
+                      NULL /* closure */,
+                      NULL /* accumulator */,
+                      NULL /* accumulator data */,
+                      NULL /* C marshaller */,
+                      G_TYPE_NONE /* return_type */,
+                      0     /* n_params */,
+                      NULL  /* param_types */);
+}
+
+static void
+sm_trace_replay_init(SmTraceReplay *self)
+{
+    self->records = g_array_new(FALSE, FALSE, sizeof(SmTraceRecord));
+    self->elems = g_ptr_array_new_with_free_func(sm_trace_elem_free);
+}
+
+SmTraceReplay*
+sm_trace_replay_new_from_file(const gchar *filename, GError **err)
+{
+    SmTraceReplay *self;
+    SmTraceRecord record;
+    SmTraceElem *te;
+    gchar *data;
+    gsize length, offset;
+    guint32 version;
+
+    if (!g_file_get_contents(filename, &data, &length, err))
+    {
+        return NULL;
+    }
+    if (length < SM_TRACE_HEADER_SIZE || memcmp(data, SM_TRACE_MAGIC, sizeof(SM_TRACE_MAGIC)) != 0)
+    {
+        g_set_error(err, G_IO_ERROR, G_IO_ERROR_INVALID_DATA, "%s is no trace file", filename);
+        g_free(data);
+        return NULL;
+    }
+    memcpy(&version, data + 8, 4);
+    if (GUINT32_FROM_LE(version) != SM_TRACE_VERSION)
+    {
+        g_set_error(err, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                "%s has the unsupported version %u", filename, GUINT32_FROM_LE(version));
+        g_free(data);
+        return NULL;
+    }
+    self = g_object_new(SM_TYPE_TRACE_REPLAY, NULL);
+    offset = SM_TRACE_HEADER_SIZE;
+    while (offset + SM_TRACE_RECORD_SIZE <= length)
+    {
+        sm_trace_decode((guint8*)data + offset, &record);
+        offset += SM_TRACE_RECORD_SIZE;
+        if (record.type == SM_TRACE_ELEM)
+        {
+            if (record.elem != self->elems->len || record.value < 0
+                    || offset + record.value > length)
+            {
+                break;
+            }
+            te = g_new0(SmTraceElem, 1);
+            te->name = g_strndup(data + offset, record.value);
+            te->index = record.channel;
+            g_ptr_array_add(self->elems, te);
+            offset += record.value;
+        }
+        else if (record.type < SM_TRACE_N_TYPES && record.elem < self->elems->len)
+        {
+            g_array_append_val(self->records, record);
+        }
+        else
+        {
+            break;
+        }
+    }
+    g_free(data);
+    if (offset != length)
+    {
+        // A recording which was not stopped may end with a partial record.
+        g_debug("sm_trace_replay_new_from_file: Ignoring %" G_GSIZE_FORMAT " bytes at the end of %s.",
+                length - offset, filename);
+    }
+    if (self->records->len == 0)
+    {
+        g_set_error(err, G_IO_ERROR, G_IO_ERROR_INVALID_DATA, "%s holds no records", filename);
+        g_object_unref(self);
+        return NULL;
+    }
+    return self;
+}
+
+void
+sm_trace_replay_start(SmTraceReplay *self, snd_mixer_t *mixer, SmFakeCard *fake, gboolean fast)
+{
+    if (self->source)
+    {
+        g_source_remove(self->source);
+    }
+    self->mixer = mixer;
+    g_set_object(&self->fake, fake);
+    self->fast = fast;
+    self->position = 0;
+    self->lag_sum = 0;
+    self->lag_max = 0;
+    self->n_events = 0;
+    self->n_writes = 0;
+    self->n_failed = 0;
+    self->start = g_get_monotonic_time();
+    self->end = 0;
+    self->source = fast
+        ? g_idle_add_full(G_PRIORITY_DEFAULT_IDLE, sm_trace_replay_step_cb, self, NULL)
+        : g_timeout_add(g_array_index(self->records, SmTraceRecord, 0).time / 1000, sm_trace_replay_step_cb, self);
+}
+
+void
+sm_trace_replay_report(SmTraceReplay *self)
+{
+    guint n_records;
+
+    n_records = self->n_events + self->n_writes;
+    g_printerr("Replayed %u records (%u events, %u writes, %u failed) in %.3f ms.\n",
+            n_records, self->n_events, self->n_writes, self->n_failed,
+            ((self->end ? self->end : g_get_monotonic_time()) - self->start) / 1000.0);
+    if (!self->fast && n_records > 0)
+    {
+        g_printerr("Delay behind the recorded times: %.3f ms mean, %.3f ms max.\n",
+                self->lag_sum / 1000.0 / n_records, self->lag_max / 1000.0);
+    }
+}
@@ -0,0 +1,119 @@
+#ifndef __SM_TRACE_H__
+#define __SM_TRACE_H__
+/**
+ * @file
+ * @brief Header file for the control event trace recorder and replayer.
+ *
+ * The recorder logs every value change event received from the mixer and
+ * every write to the mixer with a monotonic timestamp. A trace file starts
+ * with the 8 byte magic `SMTRACE` (NUL terminated), a 32 bit version and 32
+ * reserved bits, followed by records of 16 bytes: the time in microseconds
+ * since the start of the recording (64 bit), the element id (16 bit), the
+ * @ref SmTraceType (8 bit), the channel (8 bit) and the value (32 bit). All
+ * numbers are little endian. An element id is defined by a record of type
+ * @ref SM_TRACE_ELEM before its first use; its channel holds the element
+ * index, its value the length of the element name which follows the record.
+ *
+ * An event is recorded as the values of all channels of the element after
+ * the event. Volumes written in dB are recorded in hundredths of a dB, like
+ * they are passed to alsa-lib.
+ *
+ * The replayer feeds a trace to a fake card (see sm-fake-card.h): recorded
+ * events change the fake card like changes made on the interface, recorded
+ * writes are written to the mixer. The records are replayed at their
+ * recorded time or as fast as possible; in the latter case the records of
+ * one timestamp are replayed per idle step. The fake card dispatches its
+ * events at the default priority, ahead of the next step, so every step
+ * gets its own events.
+ */
+#include <glib-object.h>
+#include <alsa/asoundlib.h>
+
+#include "sm-fake-card.h"
+
+G_BEGIN_DECLS
+
+/**
+ * @brief Enumeration of the trace record types.
+ */
+typedef enum
+{
+    SM_TRACE_ELEM, ///< Definition of an element id, followed by the element name.
+    SM_TRACE_EVENT_VOLUME, ///< Raw volume of a channel after an event.
+    SM_TRACE_EVENT_SWITCH, ///< Switch of a channel after an event.
+    SM_TRACE_EVENT_ENUM, ///< Selected item of a channel after an event.
+    SM_TRACE_WRITE_DB, ///< Write of a volume in hundredths of a dB.
+    SM_TRACE_WRITE_SWITCH, ///< Write of a switch.
+    SM_TRACE_WRITE_ENUM, ///< Write of a selected item.
+    SM_TRACE_N_TYPES ///< Number of record types.
+} SmTraceType;
+
+/**
+ * @brief Start recording to a trace file.
+ * A recording in progress is stopped first.
+ * @param filename Path of the trace file.
+ * @param err The GError that will be initialized in case of an error.
+ * @return TRUE on success, FALSE otherwise.
+ */
+gboolean       sm_trace_start(const gchar *filename, GError **err);
+
+/**
+ * @brief Stop recording and close the trace file.
+ */
+void           sm_trace_stop(void);
+
+/**
+ * @brief Record the values of an element after a value change event.
+ * Does nothing unless recording.
+ * @param elem The mixer element.
+ */
+void           sm_trace_record_event(snd_mixer_elem_t *elem);
+
+/**
+ * @brief Record a write to an element.
+ * Does nothing unless recording.
+ * @param type One of the write types.
+ * @param elem The mixer element.
+ * @param ch The written channel.
+ * @param value The written value.
+ */
+void           sm_trace_record_write(SmTraceType type, snd_mixer_elem_t *elem,
+        snd_mixer_selem_channel_id_t ch, long value);
+
+/**
+ * @brief Macro to get the type information of the trace replayer.
+ */
+#define SM_TYPE_TRACE_REPLAY sm_trace_replay_get_type()
+/**
+ * @brief Macro declaring the final trace replayer type.
+ */
+G_DECLARE_FINAL_TYPE(SmTraceReplay, sm_trace_replay, SM, TRACE_REPLAY, GObject);
+
+/**
+ * @brief Load a trace file for replaying.
+ * @param filename Path of the trace file.
+ * @param err The GError that will be initialized in case of an error.
+ * @return Pointer to new trace replayer instance, or NULL on error.
+ */
+SmTraceReplay *sm_trace_replay_new_from_file(const gchar *filename, GError **err);
+
+/**
+ * @brief Start replaying the trace from the main loop.
+ * The "finished" signal is emitted after the last record.
+ * @param self The trace replayer.
+ * @param mixer The mixer with the elements of the fake card.
+ * @param fake The fake card.
+ * @param fast TRUE to replay as fast as possible, FALSE to keep the recorded times.
+ */
+void           sm_trace_replay_start(SmTraceReplay *self, snd_mixer_t *mixer,
+        SmFakeCard *fake, gboolean fast);
+
+/**
+ * @brief Print the number of replayed records and the replay timing to stderr.
+ * @param self The trace replayer.
+ */
+void           sm_trace_replay_report(SmTraceReplay *self);
+
+G_END_DECLS
+
+#endif /* __SM_TRACE_H__ */
@@ -0,0 +1,208 @@
+/*
+ * test-fake-card.c - Tests of the model on the fake card.
+ * Copyright (c) 2016 Martin Roesch <martin.roesch79@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <unistd.h>
+#include <glib/gstdio.h>
+
+#include "sm-app.h"
+#include "sm-channel.h"
+#include "sm-fake-card.h"
+#include "sm-trace.h"
+
+/*
+ * SCARLETTMIXER_FAKE_CARD names the topology file src/fake-6i6.json.
+ */
+static SmApp *app = NULL;
+
+static void
+test_fake_card_flush_events(void)
+{
+    while (g_main_context_iteration(NULL, FALSE))
+    {
+    }
+}
+
+static SmChannel*
+test_fake_card_find_channel(const gchar *name)
+{
+    GList *item;
+
+    for (item = sm_app_get_channels(app); item; item = g_list_next(item))
+    {
+        if (g_strcmp0(sm_channel_get_name(SM_CHANNEL(item->data)), name) == 0)
+        {
+            return SM_CHANNEL(item->data);
+        }
+    }
+    return NULL;
+}
+
+static void
+test_fake_card_changed_cb(SmChannel *ch, gpointer user_data)
+{
+    (*(guint*)user_data)++;
+}
+
+static void
+test_fake_card_open(void)
+{
+    g_assert_nonnull(sm_fake_card_get_default());
+    g_assert_cmpint(sm_app_find_card(SM_APP_CARD_PREFIX), ==, 0);
+    g_assert_cmpstr(sm_app_open_mixer(app, 0), ==, "Scarlett 6i6 USB");
+    g_assert_cmpint(sm_app_get_card_number(app), ==, 0);
+    g_assert_nonnull(test_fake_card_find_channel("Master"));
+    g_assert_nonnull(test_fake_card_find_channel("Master 1 (Monitor)"));
+    g_assert_nonnull(test_fake_card_find_channel("Matrix 01 Mix A"));
+    g_assert_cmpuint(g_list_length(sm_app_get_input_sources(app)), ==, 2);
+    g_assert_nonnull(sm_app_get_clock_source(app));
+}
+
+static void
+test_fake_card_write_db(void)
+{
+    SmChannel *ch;
+    gdouble vol_db;
+
+    ch = test_fake_card_find_channel("Matrix 01 Mix A");
+    g_assert_nonnull(ch);
+    g_assert_true(sm_channel_volume_get_db(ch, SND_MIXER_SCHN_MONO, &vol_db));
+    g_assert_cmpfloat(vol_db, ==, 0.0);
+    g_assert_true(sm_channel_volume_set_db(ch, SND_MIXER_SCHN_MONO, -10.0));
+    g_assert_true(sm_channel_volume_get_db(ch, SND_MIXER_SCHN_MONO, &vol_db));
+    g_assert_cmpfloat(vol_db, ==, -10.0);
+    // The steps are 0.5 dB apart, a value in between is rounded down.
+    g_assert_true(sm_channel_volume_set_db(ch, SND_MIXER_SCHN_MONO, -10.2));
+    g_assert_true(sm_channel_volume_get_db(ch, SND_MIXER_SCHN_MONO, &vol_db));
+    g_assert_cmpfloat(vol_db, ==, -10.5);
+    // Out of range values are clamped.
+    g_assert_true(sm_channel_volume_set_db(ch, SND_MIXER_SCHN_MONO, 20.0));
+    g_assert_true(sm_channel_volume_get_db(ch, SND_MIXER_SCHN_MONO, &vol_db));
+    g_assert_cmpfloat(vol_db, ==, 6.0);
+    test_fake_card_flush_events();
+}
+
+static void
+test_fake_card_external_change(void)
+{
+    SmFakeCard *fake;
+    SmChannel *ch;
+    gdouble vol_db;
+    guint changed = 0;
+    int mute;
+
+    fake = sm_fake_card_get_default();
+    ch = test_fake_card_find_channel("Master 1 (Monitor)");
+    g_assert_nonnull(ch);
+    test_fake_card_flush_events();
+    g_signal_connect(ch, "changed", G_CALLBACK(test_fake_card_changed_cb), &changed);
+
+    g_assert_true(sm_fake_card_set_volume(fake, "Master 1 (Monitor)", 0, SND_MIXER_SCHN_FRONT_RIGHT, 27));
+    g_assert_cmpuint(changed, ==, 0);
+    test_fake_card_flush_events();
+    g_assert_cmpuint(changed, ==, 1);
+    g_assert_true(sm_channel_volume_get_db(ch, SND_MIXER_SCHN_FRONT_RIGHT, &vol_db));
+    g_assert_cmpfloat(vol_db, ==, -100.0);
+
+    g_assert_true(sm_fake_card_set_switch(fake, "Master 1 (Monitor)", 0, SND_MIXER_SCHN_FRONT_LEFT, 0));
+    test_fake_card_flush_events();
+    g_assert_cmpuint(changed, ==, 2);
+    // The mute state is the playback switch of the element.
+    g_assert_true(sm_channel_volume_get_mute(ch, SND_MIXER_SCHN_FRONT_LEFT, &mute));
+    g_assert_cmpint(mute, ==, 0);
+
+    // Setting the current value is no change.
+    g_assert_true(sm_fake_card_set_volume(fake, "Master 1 (Monitor)", 0, SND_MIXER_SCHN_FRONT_RIGHT, 27));
+    test_fake_card_flush_events();
+    g_assert_cmpuint(changed, ==, 2);
+    g_signal_handlers_disconnect_by_data(ch, &changed);
+}
+
+static void
+test_fake_card_finished_cb(SmTraceReplay *replay, gpointer user_data)
+{
+    *(gboolean*)user_data = TRUE;
+}
+
+static void
+test_fake_card_replay_fast(void)
+{
+    static const long volumes[] = { 10, 20, 30 };
+    SmFakeCard *fake;
+    SmTraceReplay *replay;
+    SmChannel *ch;
+    gchar *filename;
+    gboolean finished = FALSE;
+    guint changed = 0;
+    guint idx;
+    gint fd;
+
+    fake = sm_fake_card_get_default();
+    ch = test_fake_card_find_channel("Matrix 01 Mix B");
+    g_assert_nonnull(ch);
+    test_fake_card_flush_events();
+    fd = g_file_open_tmp("test-fake-card-XXXXXX.trace", &filename, NULL);
+    g_assert_cmpint(fd, >=, 0);
+    close(fd);
+
+    // Record one event per volume, each with its own timestamp.
+    g_assert_true(sm_trace_start(filename, NULL));
+    for (idx = 0; idx < G_N_ELEMENTS(volumes); idx++)
+    {
+        g_usleep(1000);
+        g_assert_true(sm_fake_card_set_volume(fake, "Matrix 01 Mix B", 0, SND_MIXER_SCHN_MONO, volumes[idx]));
+        test_fake_card_flush_events();
+    }
+    sm_trace_stop();
+    g_assert_true(sm_fake_card_set_volume(fake, "Matrix 01 Mix B", 0, SND_MIXER_SCHN_MONO, 0));
+    test_fake_card_flush_events();
+
+    // Every step must be dispatched before the next one, or the events of an element merge.
+    replay = sm_trace_replay_new_from_file(filename, NULL);
+    g_assert_nonnull(replay);
+    g_signal_connect(ch, "changed", G_CALLBACK(test_fake_card_changed_cb), &changed);
+    g_signal_connect(replay, "finished", G_CALLBACK(test_fake_card_finished_cb), &finished);
+    // The trace holds only events, which go to the fake card and need no mixer.
+    sm_trace_replay_start(replay, NULL, fake, TRUE);
+    while (!finished)
+    {
+        g_main_context_iteration(NULL, TRUE);
+    }
+    test_fake_card_flush_events();
+    g_assert_cmpuint(changed, ==, G_N_ELEMENTS(volumes));
+    g_signal_handlers_disconnect_by_data(ch, &changed);
+    g_object_unref(replay);
+    g_remove(filename);
+    g_free(filename);
+}
+
+int
+main(int argc, char **argv)
+{
+    int ret;
+
+    g_test_init(&argc, &argv, NULL);
+    app = sm_app_new();
+    g_test_add_func("/fake-card/open", test_fake_card_open);
+    g_test_add_func("/fake-card/write-db", test_fake_card_write_db);
+    g_test_add_func("/fake-card/external-change", test_fake_card_external_change);
+    g_test_add_func("/fake-card/replay-fast", test_fake_card_replay_fast);
+    ret = g_test_run();
+    sm_app_close_mixer(app);
+    g_object_unref(app);
+    return ret;
+}
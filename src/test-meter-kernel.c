@@ -0,0 +1,181 @@
+/*
+ * test-meter-kernel.c - Tests of the level meter sample kernels.
+ * Copyright (c) 2016 Martin Roesch <martin.roesch79@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "sm-meter-kernel.h"
+
+/*
+ * The kernel is selected once per process, so the test is run for every
+ * kernel with SCARLETTMIXER_METER_KERNEL set. A kernel the CPU does not
+ * support is skipped.
+ */
+static gboolean
+test_meter_kernel_selected(void)
+{
+    const gchar *env;
+
+    env = g_getenv("SCARLETTMIXER_METER_KERNEL");
+    if (env && g_strcmp0(env, sm_meter_kernel_get_name()) != 0)
+    {
+        g_test_skip("The requested kernel is not supported.");
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static gint32
+test_meter_kernel_random_sample(void)
+{
+    static const gint32 special[] = {
+        G_MININT32, G_MAXINT32, 0x7fffff00, -0x7fffff00, 0x7ffffe00, -0x7ffffe00, 0
+    };
+
+    // Mix in full scale and near full scale samples for the clip counter.
+    if (g_test_rand_int_range(0, 8) == 0)
+    {
+        return special[g_test_rand_int_range(0, G_N_ELEMENTS(special))];
+    }
+    return (gint32)g_test_rand_int();
+}
+
+static void
+test_meter_kernel_s32(void)
+{
+    static const gsize n_frames[] = { 1, 3, 7, 255, 257, 1001 };
+    SmMeterAccu expected[SM_METER_KERNEL_MAX_CHANNELS];
+    SmMeterAccu actual[SM_METER_KERNEL_MAX_CHANNELS];
+    gint32 *buffer;
+    gsize n, idx;
+    guint channels, ch;
+
+    if (!test_meter_kernel_selected())
+    {
+        return;
+    }
+    for (channels = 1; channels <= SM_METER_KERNEL_MAX_CHANNELS; channels++)
+    {
+        for (n = 0; n < G_N_ELEMENTS(n_frames); n++)
+        {
+            // The frames start one sample after the allocation to test unaligned loads.
+            buffer = g_new(gint32, n_frames[n] * channels + 1);
+            for (idx = 0; idx < n_frames[n] * channels + 1; idx++)
+            {
+                buffer[idx] = test_meter_kernel_random_sample();
+            }
+            memset(expected, 0, sizeof(expected));
+            memset(actual, 0, sizeof(actual));
+            sm_meter_kernel_scan_s32_reference(buffer + 1, channels, n_frames[n], expected);
+            sm_meter_kernel_scan_s32(buffer + 1, channels, n_frames[n], actual);
+            for (ch = 0; ch < channels; ch++)
+            {
+                g_assert_cmpfloat(actual[ch].peak, ==, expected[ch].peak);
+                g_assert_cmpfloat(fabs(actual[ch].sum - expected[ch].sum), <=,
+                        1e-5 * MAX(1.0, expected[ch].sum));
+                g_assert_cmpuint(actual[ch].count, ==, expected[ch].count);
+                g_assert_cmpuint(actual[ch].clips, ==, expected[ch].clips);
+            }
+            g_free(buffer);
+        }
+    }
+}
+
+static void
+test_meter_kernel_s16_clip(void)
+{
+    static const gint16 samples[] = { 32767, -32768, -32767, 32766, -32766, 0, 16384 };
+    SmMeterAccu accu[SM_METER_KERNEL_MAX_CHANNELS];
+    gint16 *buffer;
+    gsize frame;
+    guint channels, ch;
+
+    if (!test_meter_kernel_selected())
+    {
+        return;
+    }
+    for (channels = 1; channels <= SM_METER_KERNEL_MAX_CHANNELS; channels++)
+    {
+        buffer = g_new(gint16, G_N_ELEMENTS(samples) * channels);
+        for (frame = 0; frame < G_N_ELEMENTS(samples); frame++)
+        {
+            for (ch = 0; ch < channels; ch++)
+            {
+                buffer[frame * channels + ch] = samples[(frame + ch) % G_N_ELEMENTS(samples)];
+            }
+        }
+        memset(accu, 0, sizeof(accu));
+        sm_meter_kernel_scan_s16(buffer, channels, G_N_ELEMENTS(samples), accu);
+        for (ch = 0; ch < channels; ch++)
+        {
+            // Both +32767 and -32768 are full scale, -32767 is the negated +32767.
+            g_assert_cmpuint(accu[ch].clips, ==, 3);
+            g_assert_cmpfloat(accu[ch].peak, ==, 1.0f);
+            g_assert_cmpuint(accu[ch].count, ==, G_N_ELEMENTS(samples));
+        }
+        g_free(buffer);
+    }
+}
+
+static void
+test_meter_kernel_s24_clip(void)
+{
+    static const guint8 samples[][3] = {
+        { 0xff, 0xff, 0x7f }, { 0x00, 0x00, 0x80 }, { 0x01, 0x00, 0x80 },
+        { 0xfe, 0xff, 0x7f }, { 0x00, 0x00, 0x00 }
+    };
+    SmMeterAccu accu[SM_METER_KERNEL_MAX_CHANNELS];
+    guint8 *buffer;
+    gsize frame;
+    guint channels, ch;
+
+    if (!test_meter_kernel_selected())
+    {
+        return;
+    }
+    for (channels = 1; channels <= SM_METER_KERNEL_MAX_CHANNELS; channels++)
+    {
+        buffer = g_new(guint8, G_N_ELEMENTS(samples) * channels * 3);
+        for (frame = 0; frame < G_N_ELEMENTS(samples); frame++)
+        {
+            for (ch = 0; ch < channels; ch++)
+            {
+                memcpy(buffer + (frame * channels + ch) * 3,
+                        samples[(frame + ch) % G_N_ELEMENTS(samples)], 3);
+            }
+        }
+        memset(accu, 0, sizeof(accu));
+        sm_meter_kernel_scan_s24_3le(buffer, channels, G_N_ELEMENTS(samples), accu);
+        for (ch = 0; ch < channels; ch++)
+        {
+            g_assert_cmpuint(accu[ch].clips, ==, 3);
+            g_assert_cmpuint(accu[ch].count, ==, G_N_ELEMENTS(samples));
+        }
+        g_free(buffer);
+    }
+}
+
+int
+main(int argc, char **argv)
+{
+    g_test_init(&argc, &argv, NULL);
+    g_test_add_func("/meter-kernel/s32", test_meter_kernel_s32);
+    g_test_add_func("/meter-kernel/s16-clip", test_meter_kernel_s16_clip);
+    g_test_add_func("/meter-kernel/s24-clip", test_meter_kernel_s24_clip);
+    return g_test_run();
+}
@@ -0,0 +1,131 @@
+/*
+ * test-midi.c - Tests of the MIDI controller handling on the fake card.
+ * Copyright (c) 2016 Martin Roesch <martin.roesch79@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib/gstdio.h>
+
+#include "config.h"
+#include "sm-app.h"
+#include "sm-channel.h"
+#include "sm-midi.h"
+
+/*
+ * SCARLETTMIXER_FAKE_CARD names the topology file src/fake-6i6.json and
+ * XDG_CONFIG_HOME a directory in the build tree for the mappings.
+ */
+static SmApp *app = NULL;
+
+/*
+ * Writes are at least 20 ms apart, so wait for the queued write before
+ * dispatching the pending sources.
+ */
+static void
+test_midi_flush_events(void)
+{
+    g_usleep(50000);
+    while (g_main_context_iteration(NULL, FALSE))
+    {
+    }
+}
+
+static SmChannel*
+test_midi_find_channel(const gchar *name)
+{
+    GList *item;
+
+    for (item = sm_app_get_channels(app); item; item = g_list_next(item))
+    {
+        if (g_strcmp0(sm_channel_get_name(SM_CHANNEL(item->data)), name) == 0)
+        {
+            return SM_CHANNEL(item->data);
+        }
+    }
+    return NULL;
+}
+
+static void
+test_midi_nrpn(void)
+{
+    SmMidiClient *client;
+    SmChannel *ch;
+    GKeyFile *keyfile;
+    gchar *filename, *type;
+    gdouble vol_db, min_db, max_db;
+
+    filename = g_build_filename(g_get_user_config_dir(), PACKAGE, "midi-mappings", NULL);
+    g_remove(filename);
+    ch = test_midi_find_channel("Matrix 01 Mix A");
+    g_assert_nonnull(ch);
+    g_assert_true(sm_channel_volume_get_range_db(ch, &min_db, &max_db));
+
+    client = sm_midi_client_new(app);
+    sm_midi_client_learn(client, "Matrix 01 Mix A/volume");
+    // Select NRPN 0x105 on channel 3 and enter the maximum.
+    sm_midi_client_handle_controller(client, 2, 99, 0x02);
+    sm_midi_client_handle_controller(client, 2, 98, 0x05);
+    sm_midi_client_handle_controller(client, 2, 6, 0x7f);
+    sm_midi_client_handle_controller(client, 2, 38, 0x7f);
+    test_midi_flush_events();
+
+    keyfile = g_key_file_new();
+    g_assert_true(g_key_file_load_from_file(keyfile, filename, G_KEY_FILE_NONE, NULL));
+    type = g_key_file_get_string(keyfile, "Matrix 01 Mix A/volume", "type", NULL);
+    g_assert_cmpstr(type, ==, "nrpn");
+    g_assert_cmpint(g_key_file_get_integer(keyfile, "Matrix 01 Mix A/volume", "channel", NULL), ==, 3);
+    g_assert_cmpint(g_key_file_get_integer(keyfile, "Matrix 01 Mix A/volume", "number", NULL), ==, 0x105);
+    g_free(type);
+    g_key_file_free(keyfile);
+    g_assert_true(sm_channel_volume_get_db(ch, SND_MIXER_SCHN_MONO, &vol_db));
+    g_assert_cmpfloat(vol_db, ==, max_db);
+
+    // Data entry of the mapped NRPN moves the control, the MSB alone is a coarse value.
+    sm_midi_client_handle_controller(client, 2, 6, 0x00);
+    test_midi_flush_events();
+    g_assert_true(sm_channel_volume_get_db(ch, SND_MIXER_SCHN_MONO, &vol_db));
+    g_assert_cmpfloat(vol_db, ==, min_db);
+
+    // An RPN deselects the NRPN, so CC 6 is a plain controller again and learned as such.
+    sm_midi_client_learn(client, "Matrix 01 Mix B/volume");
+    sm_midi_client_handle_controller(client, 2, 101, 0x00);
+    sm_midi_client_handle_controller(client, 2, 6, 0x40);
+    keyfile = g_key_file_new();
+    g_assert_true(g_key_file_load_from_file(keyfile, filename, G_KEY_FILE_NONE, NULL));
+    type = g_key_file_get_string(keyfile, "Matrix 01 Mix B/volume", "type", NULL);
+    g_assert_cmpstr(type, ==, "cc");
+    g_assert_cmpint(g_key_file_get_integer(keyfile, "Matrix 01 Mix B/volume", "number", NULL), ==, 6);
+    g_free(type);
+    g_key_file_free(keyfile);
+
+    test_midi_flush_events();
+    g_object_unref(client);
+    g_free(filename);
+}
+
+int
+main(int argc, char **argv)
+{
+    int ret;
+
+    g_test_init(&argc, &argv, NULL);
+    app = sm_app_new();
+    g_assert_nonnull(sm_app_open_mixer(app, 0));
+    g_test_add_func("/midi/nrpn", test_midi_nrpn);
+    ret = g_test_run();
+    sm_app_close_mixer(app);
+    g_object_unref(app);
+    return ret;
+}